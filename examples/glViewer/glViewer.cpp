@@ -41,6 +41,10 @@ GLFWmonitor* g_primary=0;
     #include <osd/tbbEvaluator.h>
 #endif
 
+#ifdef OPENSUBDIV_HAS_THREADPOOL
+    #include <osd/threadPoolEvaluator.h>
+#endif
+
 #ifdef OPENSUBDIV_HAS_OPENCL
     #include <osd/clGLVertexBuffer.h>
     #include <osd/clEvaluator.h>
@@ -133,7 +137,8 @@ enum KernelType { kCPU = 0,
                   kCUDA = 3,
                   kCL = 4,
                   kGLSL = 5,
-                  kGLSLCompute = 6 };
+                  kGLSLCompute = 6,
+                  kTHREADPOOL = 7 };
 
 enum DisplayStyle { kDisplayStyleWire,
                     kDisplayStyleShaded,
@@ -396,6 +401,8 @@ getKernelName(int kernel) {
         return "OpenMP";
     else if (kernel == kTBB)
         return "TBB";
+    else if (kernel == kTHREADPOOL)
+        return "Thread Pool";
     else if (kernel == kCUDA)
         return "Cuda";
     else if (kernel == kGLSL)
@@ -492,6 +499,17 @@ rebuildMesh() {
                                    numVaryingElements,
                                    level, bits);
 #endif
+#ifdef OPENSUBDIV_HAS_THREADPOOL
+    } else if (kernel == kTHREADPOOL) {
+        g_mesh = new Osd::Mesh<Osd::CpuGLVertexBuffer,
+                               Far::StencilTable,
+                               Osd::ThreadPoolEvaluator,
+                               Osd::GLPatchTable>(
+                                   refiner,
+                                   numVertexElements,
+                                   numVaryingElements,
+                                   level, bits);
+#endif
 #ifdef OPENSUBDIV_HAS_OPENCL
     } else if(kernel == kCL) {
         // CLKernel
@@ -1512,6 +1530,9 @@ initHUD() {
 #ifdef OPENSUBDIV_HAS_TBB
     g_hud.AddPullDownButton(compute_pulldown, "TBB", kTBB);
 #endif
+#ifdef OPENSUBDIV_HAS_THREADPOOL
+    g_hud.AddPullDownButton(compute_pulldown, "Thread Pool", kTHREADPOOL);
+#endif
 #ifdef OPENSUBDIV_HAS_CUDA
     g_hud.AddPullDownButton(compute_pulldown, "CUDA", kCUDA);
 #endif
@@ -0,0 +1,185 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#include "../far/allocator.h"
+
+#include <cstdlib>
+
+#if defined(_WIN32)
+    #include <malloc.h>
+#endif
+
+#if defined(__linux__)
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+namespace {
+
+    // large buffers and tables are backed by huge pages (2MB on x86-64 and
+    // most other Linux configurations)
+    const size_t hugePageSize = 2 * 1024 * 1024;
+
+    void *
+    defaultAllocate(size_t size, size_t alignment) {
+#if defined(_WIN32)
+        return _aligned_malloc(size, alignment);
+#else
+        void * ptr = 0;
+        return posix_memalign(&ptr, alignment, size) == 0 ? ptr : 0;
+#endif
+    }
+
+    void
+    defaultFree(void * ptr, size_t /* size */) {
+#if defined(_WIN32)
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+
+    AllocateCallbackFunc allocateFunc = defaultAllocate;
+    FreeCallbackFunc freeFunc = defaultFree;
+
+    HugePagesMode hugePagesMode = HUGE_PAGES_NONE;
+
+    // Header stored in the ALLOCATION_ALIGNMENT bytes preceding each buffer,
+    // which records how to release it
+    struct Header {
+        FreeCallbackFunc freeFunc;  // NULL for mapped huge pages
+        size_t size;                // size of the allocation, header included
+    };
+
+#if defined(__linux__)
+    size_t
+    getPageSize() {
+        static size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        return pageSize;
+    }
+#endif
+}
+
+void
+SetAllocatorCallbacks(AllocateCallbackFunc allocate, FreeCallbackFunc free) {
+    if (allocate and free) {
+        allocateFunc = allocate;
+        freeFunc = free;
+    } else {
+        allocateFunc = defaultAllocate;
+        freeFunc = defaultFree;
+    }
+}
+
+void
+SetHugePagesMode(HugePagesMode mode) {
+    hugePagesMode = mode;
+}
+
+HugePagesMode
+GetHugePagesMode() {
+    return hugePagesMode;
+}
+
+void *
+Allocate(size_t size) {
+
+    size_t totalSize = size + ALLOCATION_ALIGNMENT;
+
+    char * base = 0;
+    Header header = { freeFunc, totalSize };
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    if (hugePagesMode == HUGE_PAGES_EXPLICIT and totalSize >= hugePageSize) {
+        size_t mappedSize = (totalSize + hugePageSize - 1) & ~(hugePageSize - 1);
+        void * mapped = mmap(0, mappedSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        // fails when not enough huge pages are reserved
+        if (mapped != MAP_FAILED) {
+            base = static_cast<char *>(mapped);
+            header.freeFunc = 0;
+            header.size = mappedSize;
+        }
+    }
+#endif
+
+    if (not base) {
+        base = static_cast<char *>(
+            allocateFunc(totalSize, ALLOCATION_ALIGNMENT));
+        if (not base) return 0;
+
+        AdviseHugePages(base, totalSize);
+    }
+
+    *reinterpret_cast<Header *>(base) = header;
+    return base + ALLOCATION_ALIGNMENT;
+}
+
+void
+Free(void * ptr) {
+
+    if (not ptr) return;
+
+    char * base = static_cast<char *>(ptr) - ALLOCATION_ALIGNMENT;
+    Header header = *reinterpret_cast<Header *>(base);
+
+    if (header.freeFunc) {
+        header.freeFunc(base, header.size);
+    } else {
+#if defined(__linux__)
+        munmap(base, header.size);
+#endif
+    }
+}
+
+void
+AdviseHugePages(void const * ptr, size_t size) {
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (hugePagesMode == HUGE_PAGES_NONE or size < hugePageSize) return;
+
+    // advise the whole pages of the range : the kernel backs the 2MB aligned
+    // regions that they cover with huge pages
+    size_t pageSize = getPageSize(),
+           begin = ((size_t)ptr + pageSize - 1) & ~(pageSize - 1),
+           end = ((size_t)ptr + size) & ~(pageSize - 1);
+    if (end > begin) {
+        madvise((void *)begin, end - begin, MADV_HUGEPAGE);
+    }
+#else
+    (void)ptr;
+    (void)size;
+#endif
+}
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
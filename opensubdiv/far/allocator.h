@@ -0,0 +1,143 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#ifndef OPENSUBDIV3_FAR_ALLOCATOR_H
+#define OPENSUBDIV3_FAR_ALLOCATOR_H
+
+#include "../version.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+/// \brief Alignment in bytes of the buffers returned by Allocate() (a cache
+///        line, and the widest SIMD register)
+enum { ALLOCATION_ALIGNMENT = 64 };
+
+/// \brief The allocation callback function type : returns 'size' bytes
+///        aligned to 'alignment' (a power of two), or NULL on failure
+typedef void * (*AllocateCallbackFunc)(size_t size, size_t alignment);
+
+/// \brief The deallocation callback function type, which releases the
+///        'size' bytes returned by the matching allocation callback
+typedef void (*FreeCallbackFunc)(void * ptr, size_t size);
+
+/// \brief Sets the allocation callback functions used for the primvar
+///        buffers of the CPU evaluators (default is the aligned system
+///        allocator)
+///
+/// The buffers remember the callbacks which allocated them, so the
+/// callbacks can be changed at any time.
+///
+/// \note This function is not thread-safe !
+///
+/// @param allocateFunc  function pointer to the allocation callback, or NULL
+///                      to restore the default
+///
+/// @param freeFunc      function pointer to the matching deallocation
+///                      callback
+///
+void SetAllocatorCallbacks(AllocateCallbackFunc allocateFunc,
+                           FreeCallbackFunc freeFunc);
+
+
+/// \brief Use of huge pages for large allocations (Linux only, ignored on
+///        other platforms)
+typedef enum {
+    HUGE_PAGES_NONE,         ///< Default pages
+    HUGE_PAGES_TRANSPARENT,  ///< Advise the kernel to back large buffers and
+                             ///< tables with transparent huge pages
+    HUGE_PAGES_EXPLICIT      ///< Map the large buffers from the reserved huge
+                             ///< pages (see /proc/sys/vm/nr_hugepages) when
+                             ///< available, and advise transparent huge pages
+                             ///< otherwise
+} HugePagesMode;
+
+/// \brief Sets the use of huge pages for the allocations and the tables
+///        created from then on (default is HUGE_PAGES_NONE)
+///
+/// \note This function is not thread-safe !
+///
+void SetHugePagesMode(HugePagesMode mode);
+
+/// \brief Returns the use of huge pages
+HugePagesMode GetHugePagesMode();
+
+
+//
+//  The following are intended for internal use only
+//
+
+/// \brief Allocates a buffer aligned to ALLOCATION_ALIGNMENT with the
+///        allocation callback (internal use only)
+///
+/// Returns NULL if the allocation failed.
+///
+void * Allocate(size_t size);
+
+/// \brief Releases a buffer returned by Allocate() (internal use only)
+void Free(void * ptr);
+
+/// \brief Advises the kernel to back the pages of a large memory range with
+///        transparent huge pages, as set by SetHugePagesMode() (internal use
+///        only)
+void AdviseHugePages(void const * ptr, size_t size);
+
+/// \brief Advises huge pages for the storage of a vector (internal use only)
+template <class T>
+inline void AdviseHugePages(std::vector<T> const & v) {
+    if (not v.empty()) {
+        AdviseHugePages(&v[0], v.size() * sizeof(T));
+    }
+}
+
+/// \brief Reserves the storage of a vector and advises huge pages for it
+///        before it is filled, so that its pages are backed by huge pages as
+///        they are first written (internal use only)
+template <class T>
+inline void ReserveHugePages(std::vector<T> & v, size_t size) {
+    if (GetHugePagesMode() == HUGE_PAGES_NONE or size == 0) return;
+    v.reserve(size);
+    if (v.empty()) {
+        v.push_back(T());
+        AdviseHugePages(&v[0], v.capacity() * sizeof(T));
+        v.clear();
+    } else {
+        AdviseHugePages(&v[0], v.capacity() * sizeof(T));
+    }
+}
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // OPENSUBDIV3_FAR_ALLOCATOR_H
@@ -0,0 +1,369 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../far/binaryFile.h"
+#include "../far/error.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+namespace internal {
+
+namespace {
+
+    // The version of the format is incremented by any change to the layout
+    // of the files or of their contents.
+    const unsigned int formatVersion = 2;
+
+    const unsigned int byteOrderTag = 0x01020304,
+                       swappedByteOrderTag = 0x04030201;
+
+    const char magic[8] = { 'O', 'S', 'D', 'F', 'A', 'R', '\r', '\n' };
+
+    // Sections are aligned to (and offsets are counted in) 64 byte blocks,
+    // so that 32 bit offsets address files up to 256GB.
+    const size_t blockSize = 64;
+
+    struct FileHeader {
+        char         magic[8];
+        unsigned int byteOrder,
+                     version,
+                     content,
+                     realSize,
+                     numSections,
+                     numBlocks,     // size of the file
+                     layout;        // stamp of the layout of the content
+        unsigned int reserved[7];
+    };
+
+    struct SectionHeader {
+        unsigned int tag,
+                     elementSize,
+                     offset,        // in blocks, from the start of the file
+                     count;
+    };
+
+    typedef char checkFileHeaderSize[sizeof(FileHeader) == blockSize ? 1 : -1];
+
+    size_t
+    numBlocks(size_t size) {
+        return (size + blockSize - 1) / blockSize;
+    }
+}
+
+//
+//  BinaryFileWriter
+//
+BinaryFileWriter::BinaryFileWriter(BinaryFileContent content, int realSize,
+    unsigned int layout)
+    : _content(content), _realSize(realSize), _layout(layout) {
+}
+
+void
+BinaryFileWriter::AddSection(int tag, int elementSize, size_t count,
+    void const * data) {
+
+    Section section = { tag, elementSize, count, data, -1 };
+    _sections.push_back(section);
+}
+
+void
+BinaryFileWriter::addSectionCopy(int tag, int elementSize, size_t count,
+    void const * data) {
+
+    char const * bytes = static_cast<char const *>(data);
+
+    Section section = { tag, elementSize, count, 0, (int)_copies.size() };
+    _sections.push_back(section);
+    _copies.push_back(std::vector<char>(bytes, bytes + count * elementSize));
+}
+
+bool
+BinaryFileWriter::Write(char const * path) const {
+
+    int numSections = (int)_sections.size();
+
+    // lay the sections out after the headers
+    std::vector<SectionHeader> sections(numSections);
+
+    size_t block = numBlocks(sizeof(FileHeader) +
+                             numSections * sizeof(SectionHeader));
+    for (int i = 0; i < numSections; ++i) {
+        Section const & section = _sections[i];
+        if (section.count > (size_t)INT_MAX) {
+            Error(FAR_RUNTIME_ERROR, "Failure in BinaryFileWriter::Write() -- "
+                "section of %lu elements is too large",
+                (unsigned long)section.count);
+            return false;
+        }
+        sections[i].tag = (unsigned int)section.tag;
+        sections[i].elementSize = (unsigned int)section.elementSize;
+        sections[i].offset = (unsigned int)block;
+        sections[i].count = (unsigned int)section.count;
+
+        block += numBlocks(section.count * section.elementSize);
+    }
+    if (block > (size_t)UINT_MAX) {
+        Error(FAR_RUNTIME_ERROR, "Failure in BinaryFileWriter::Write() -- "
+            "file \"%s\" is too large", path);
+        return false;
+    }
+
+    FileHeader header;
+    memset(&header, 0, sizeof(FileHeader));
+    memcpy(header.magic, magic, sizeof(magic));
+    header.byteOrder = byteOrderTag;
+    header.version = formatVersion;
+    header.content = (unsigned int)_content;
+    header.realSize = (unsigned int)_realSize;
+    header.numSections = (unsigned int)numSections;
+    header.numBlocks = (unsigned int)block;
+    header.layout = _layout;
+
+    // the file is written aside and renamed over the destination once
+    // complete : the destination may be mapped by other processes, which
+    // keep the pages of the previous file until they unmap it
+    std::string tmpPath = std::string(path) + ".tmp";
+
+    FILE * file = fopen(tmpPath.c_str(), "wb");
+    if (not file) {
+        Error(FAR_RUNTIME_ERROR, "Failure in BinaryFileWriter::Write() -- "
+            "cannot open \"%s\" for writing", tmpPath.c_str());
+        return false;
+    }
+
+    static const char padding[blockSize] = { 0 };
+
+    bool written = fwrite(&header, sizeof(FileHeader), 1, file) == 1;
+    if (numSections > 0) {
+        written = written and fwrite(&sections[0], sizeof(SectionHeader),
+                                     numSections, file) == (size_t)numSections;
+    }
+    size_t size = sizeof(FileHeader) + numSections * sizeof(SectionHeader);
+    for (int i = 0; written and i < numSections; ++i) {
+        size_t padSize = sections[i].offset * blockSize - size;
+        if (padSize > 0) {
+            written = fwrite(padding, 1, padSize, file) == padSize;
+        }
+        size_t dataSize = _sections[i].count * _sections[i].elementSize;
+        if (dataSize > 0) {
+            void const * data = _sections[i].copyIndex < 0 ?
+                _sections[i].data : &_copies[_sections[i].copyIndex][0];
+            written = written and
+                fwrite(data, 1, dataSize, file) == dataSize;
+        }
+        size = sections[i].offset * blockSize + dataSize;
+    }
+    if (written and size < block * blockSize) {
+        size_t padSize = block * blockSize - size;
+        written = fwrite(padding, 1, padSize, file) == padSize;
+    }
+
+    // the data must reach the disk before the rename does
+    written = written and fflush(file) == 0;
+#if defined(_WIN32)
+    written = written and _commit(_fileno(file)) == 0;
+#else
+    written = written and fsync(fileno(file)) == 0;
+#endif
+    written = (fclose(file) == 0) and written;
+
+    if (written) {
+#if defined(_WIN32)
+        written = MoveFileExA(tmpPath.c_str(), path,
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        written = rename(tmpPath.c_str(), path) == 0;
+#endif
+    }
+
+    if (not written) {
+        remove(tmpPath.c_str());
+        Error(FAR_RUNTIME_ERROR, "Failure in BinaryFileWriter::Write() -- "
+            "cannot write \"%s\"", path);
+    }
+    return written;
+}
+
+//
+//  MappedBinaryFile
+//
+MappedBinaryFile *
+MappedBinaryFile::Open(char const * path, BinaryFileContent content,
+    int realSize, unsigned int layout) {
+
+    char const * data = 0;
+    size_t size = 0;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) and
+                fileSize.QuadPart >= (LONGLONG)sizeof(FileHeader)) {
+            size = (size_t)fileSize.QuadPart;
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY,
+                                                0, 0, NULL);
+            if (mapping) {
+                data = static_cast<char const *>(
+                    MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 and
+                st.st_size >= (off_t)sizeof(FileHeader)) {
+            size = (size_t)st.st_size;
+            // shared mappings let the processes that open the same file share
+            // the pages of the file cache
+            void * mapped = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<char const *>(mapped);
+            }
+        }
+        close(fd);
+    }
+#endif
+
+    if (not data) {
+        Error(FAR_RUNTIME_ERROR, "Failure in MappedBinaryFile::Open() -- "
+            "cannot map \"%s\"", path);
+        return 0;
+    }
+
+    MappedBinaryFile * mappedFile = new MappedBinaryFile(data, size);
+
+    // validate the headers : the sections must fit in the file
+    FileHeader const & header = *reinterpret_cast<FileHeader const *>(data);
+
+    char const * reason = 0;
+    if (memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        reason = "not an OpenSubdiv file";
+    } else if (header.byteOrder == swappedByteOrderTag) {
+        reason = "written on a host of different byte order";
+    } else if (header.byteOrder != byteOrderTag) {
+        reason = "corrupted header";
+    } else if (header.version != formatVersion) {
+        reason = "unsupported version";
+    } else if (header.content != (unsigned int)content) {
+        reason = "unexpected content";
+    } else if (header.realSize != (unsigned int)realSize) {
+        reason = "unexpected floating point precision";
+    } else if (header.layout != layout) {
+        reason = "unsupported layout";
+    } else if ((size_t)header.numBlocks * blockSize > size or
+               sizeof(FileHeader) + (size_t)header.numSections *
+                   sizeof(SectionHeader) > size) {
+        reason = "truncated file";
+    } else {
+        SectionHeader const * sections =
+            reinterpret_cast<SectionHeader const *>(data + sizeof(FileHeader));
+        for (unsigned int i = 0; i < header.numSections; ++i) {
+            if (sections[i].count > (unsigned int)INT_MAX or
+                    sections[i].offset * blockSize +
+                    (size_t)sections[i].count * sections[i].elementSize >
+                    (size_t)header.numBlocks * blockSize) {
+                reason = "corrupted section";
+                break;
+            }
+        }
+    }
+
+    if (reason) {
+        Error(FAR_RUNTIME_ERROR, "Failure in MappedBinaryFile::Open() -- "
+            "\"%s\": %s", path, reason);
+        delete mappedFile;
+        return 0;
+    }
+    return mappedFile;
+}
+
+MappedBinaryFile::~MappedBinaryFile() {
+#if defined(_WIN32)
+    UnmapViewOfFile(_data);
+#else
+    munmap(const_cast<char *>(_data), _size);
+#endif
+}
+
+int
+MappedBinaryFile::findSection(int tag, int elementSize) const {
+
+    FileHeader const & header = *reinterpret_cast<FileHeader const *>(_data);
+    SectionHeader const * sections =
+        reinterpret_cast<SectionHeader const *>(_data + sizeof(FileHeader));
+
+    for (unsigned int i = 0; i < header.numSections; ++i) {
+        if (sections[i].tag == (unsigned int)tag and
+                sections[i].elementSize == (unsigned int)elementSize) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void const *
+MappedBinaryFile::getSection(int tag, int elementSize, int * count) const {
+
+    int i = findSection(tag, elementSize);
+    if (i < 0) {
+        *count = 0;
+        return 0;
+    }
+
+    SectionHeader const & section = reinterpret_cast<SectionHeader const *>(
+        _data + sizeof(FileHeader))[i];
+
+    *count = (int)section.count;
+    return section.count ? _data + section.offset * blockSize : 0;
+}
+
+} // end namespace internal
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
@@ -0,0 +1,269 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OPENSUBDIV3_FAR_BINARY_FILE_H
+#define OPENSUBDIV3_FAR_BINARY_FILE_H
+
+#include "../version.h"
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+namespace internal {
+
+//
+//  Binary files of Far tables
+//
+//  A file is made of a 64 byte header, followed by the headers of its
+//  sections and by their data. Each section is an array of elements of a
+//  fixed size, tagged with an identifier specific to the content of the file.
+//  The data of the sections is aligned to 64 bytes, so that the arrays can be
+//  used in place once the file is mapped in memory (see MappedBinaryFile).
+//
+//  The header records the byte order of the writer (files are only read on
+//  hosts of the same byte order), the version of the format, the type of the
+//  content, the size of its floating point values and a stamp of the layout of
+//  the content, for the contents whose layout depends on the library build.
+//
+enum BinaryFileContent {
+    BINARY_FILE_STENCIL_TABLE = 1,
+    BINARY_FILE_LIMIT_STENCIL_TABLE = 2,
+    BINARY_FILE_PATCH_TABLE = 3,
+    BINARY_FILE_TOPOLOGY_REFINER = 4
+};
+
+// Sections of the patch table files
+enum PatchTableFileSection {
+    PATCH_TABLE_COUNTS,
+    PATCH_TABLE_ARRAYS,
+    PATCH_TABLE_VERTICES,
+    PATCH_TABLE_PARAMS,
+    PATCH_TABLE_QUAD_OFFSETS,
+    PATCH_TABLE_VALENCES,
+    PATCH_TABLE_SHARPNESS_INDICES,
+    PATCH_TABLE_SHARPNESS_VALUES,
+    PATCH_TABLE_FVAR_CHANNELS,
+
+    PATCH_TABLE_LOCAL_POINTS = 16,          // 5 sections of stencils
+    PATCH_TABLE_LOCAL_VARYING_POINTS = 24,  // 5 sections of stencils
+
+    PATCH_MAP_HANDLES = 32,
+    PATCH_MAP_QUADTREE,
+
+    PATCH_TABLE_FVAR_CHANNEL_DATA = 64      // 3 sections per channel
+};
+
+class BinaryFileWriter {
+public:
+    BinaryFileWriter(BinaryFileContent content, int realSize,
+        unsigned int layout = 0);
+
+    // Adds a section of count elements : the data is only read by Write(),
+    // so it must remain valid until then
+    void AddSection(int tag, int elementSize, size_t count, void const * data);
+
+    template <class T>
+    void AddSection(int tag, std::vector<T> const & data) {
+        AddSection(tag, (int)sizeof(T), data.size(),
+                   data.empty() ? 0 : &data[0]);
+    }
+
+    template <class T>
+    void AddSection(int tag, std::vector<T> const & data, size_t count) {
+        AddSection(tag, (int)sizeof(T), count,
+                   count == 0 ? 0 : &data[0]);
+    }
+
+    // Adds a section holding a copy of the data, for the small arrays that
+    // the writers assemble on the fly
+    template <class T>
+    void AddSectionCopy(int tag, std::vector<T> const & data) {
+        addSectionCopy(tag, (int)sizeof(T), data.size(),
+                       data.empty() ? 0 : &data[0]);
+    }
+
+    // Writes the file : returns false (and reports an error) on failure.
+    // The file is written to "<path>.tmp" and renamed to path once complete,
+    // so that the processes that mapped a previous file keep a valid mapping.
+    bool Write(char const * path) const;
+
+private:
+    struct Section {
+        int tag,
+            elementSize;
+        size_t count;
+        void const * data;
+        int copyIndex;      // index of the copy of the data, or -1
+    };
+
+    void addSectionCopy(int tag, int elementSize, size_t count,
+        void const * data);
+
+    BinaryFileContent _content;
+    int _realSize;
+    unsigned int _layout;
+
+    std::vector<Section> _sections;
+    std::vector<std::vector<char> > _copies;
+};
+
+class MappedBinaryFile {
+public:
+    // Maps a file into memory : returns NULL (and reports an error) when the
+    // file can't be mapped or isn't a valid file of the expected content
+    static MappedBinaryFile * Open(char const * path,
+        BinaryFileContent content, int realSize, unsigned int layout = 0);
+
+    ~MappedBinaryFile();
+
+    // Returns the elements of a section and their number (NULL and 0 when
+    // the file has no such section)
+    template <class T>
+    T const * GetSection(int tag, int * count) const {
+        return static_cast<T const *>(
+            getSection(tag, (int)sizeof(T), count));
+    }
+
+    // Returns true if the file has a section (possibly empty) of the type
+    template <class T>
+    bool HasSection(int tag) const {
+        return findSection(tag, (int)sizeof(T)) >= 0;
+    }
+
+    // Returns the size of the mapped file in bytes
+    size_t GetSize() const { return _size; }
+
+private:
+    MappedBinaryFile(char const * data, size_t size)
+        : _data(data), _size(size) { }
+
+    int findSection(int tag, int elementSize) const;
+    void const * getSection(int tag, int elementSize, int * count) const;
+
+    char const * _data;
+    size_t _size;
+};
+
+//
+//  Archives of the binary files, for the classes that serialize their members
+//  with a single method for both directions (see Vtr::internal::Level).
+//
+//  The values visited are packed in the first section (tag 0) and each array
+//  is written to a section of its own, tagged in the order of the visit.
+//
+class BinaryFileOutputArchive {
+public:
+    BinaryFileOutputArchive(BinaryFileWriter & writer)
+        : _writer(writer), _nextTag(1) { }
+
+    bool isReading() const { return false; }
+
+    template <class T>
+    void value(T const & data) {
+        char const * bytes = reinterpret_cast<char const *>(&data);
+        _values.insert(_values.end(), bytes, bytes + sizeof(T));
+    }
+
+    // The arrays are only read by BinaryFileWriter::Write()
+    template <class T>
+    void array(std::vector<T> const & values) {
+        _writer.AddSection(_nextTag++, values);
+    }
+
+    // Adds the section of the values, once all of them have been visited
+    void Finish() {
+        _writer.AddSectionCopy(0, _values);
+    }
+
+private:
+    BinaryFileWriter & _writer;
+    int _nextTag;
+
+    std::vector<char> _values;
+};
+
+class BinaryFileInputArchive {
+public:
+    BinaryFileInputArchive(MappedBinaryFile const & file)
+        : _file(file), _nextTag(1), _valueOffset(0), _valid(true) {
+
+        _values = file.GetSection<char>(0, &_numValueBytes);
+    }
+
+    bool isReading() const { return true; }
+
+    // Values and arrays missing from the file are left unchanged and make
+    // the archive invalid
+    template <class T>
+    void value(T & data) {
+        if (_valueOffset + (int)sizeof(T) > _numValueBytes) {
+            _valid = false;
+            return;
+        }
+        std::memcpy(&data, _values + _valueOffset, sizeof(T));
+        _valueOffset += (int)sizeof(T);
+    }
+
+    template <class T>
+    void array(std::vector<T> & values) {
+        int tag = _nextTag++,
+            count = 0;
+        if (not _file.HasSection<T>(tag)) {
+            _valid = false;
+            return;
+        }
+        T const * data = _file.GetSection<T>(tag, &count);
+        values.assign(data, data + count);
+    }
+
+    // Returns true if all values and arrays visited were read
+    bool IsValid() const { return _valid; }
+
+    // Returns true if all values of the file were read
+    bool IsComplete() const { return _valid and _valueOffset == _numValueBytes; }
+
+private:
+    MappedBinaryFile const & _file;
+    int _nextTag;
+
+    char const * _values;
+    int _numValueBytes,
+        _valueOffset;
+    bool _valid;
+};
+
+} // end namespace internal
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // OPENSUBDIV3_FAR_BINARY_FILE_H
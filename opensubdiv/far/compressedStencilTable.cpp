@@ -0,0 +1,244 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../far/compressedStencilTable.h"
+#include "../far/allocator.h"
+#include "../far/stencilTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+namespace {
+
+    const int maxQuantizedWeight = 32767;
+
+    void
+    encodeVarint(std::vector<unsigned char> & stream, unsigned int value) {
+        while (value >= 0x80) {
+            stream.push_back((unsigned char)(value | 0x80));
+            value >>= 7;
+        }
+        stream.push_back((unsigned char)value);
+    }
+
+    unsigned int
+    encodeZigZag(int value) {
+        return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+    }
+
+    // a stencil entry, sorted by control vertex index
+    struct Entry {
+        Index index;
+        float weight;
+
+        bool operator < (Entry const & other) const {
+            return index < other.index;
+        }
+    };
+
+    // orders the entries of a stencil by decreasing (or increasing)
+    // quantization residual
+    struct ResidualCompare {
+        ResidualCompare(double const * residuals, bool decreasing) :
+            _residuals(residuals), _decreasing(decreasing) { }
+
+        bool operator () (int a, int b) const {
+            return _decreasing ? _residuals[a] > _residuals[b] :
+                                 _residuals[a] < _residuals[b];
+        }
+
+        double const * _residuals;
+        bool _decreasing;
+    };
+}
+
+size_t
+CompressedStencilTable::GetMemoryUsage() const {
+
+    return _sizes.size() * sizeof(unsigned char) +
+           _scales.size() * sizeof(float) +
+           _indices.size() * sizeof(unsigned char) +
+           _weights.size() * sizeof(short) +
+           _blockIndexOffsets.size() * sizeof(int) +
+           _blockWeightOffsets.size() * sizeof(int);
+}
+
+CompressedStencilTable const *
+CompressedStencilTableFactory::Create(StencilTable const & stencilTable) {
+
+    CompressedStencilTable * result = new CompressedStencilTable;
+
+    int numStencils = stencilTable.GetNumStencils();
+
+    result->_numControlVertices = stencilTable.GetNumControlVertices();
+
+    result->_sizes.resize(numStencils);
+    result->_scales.resize(numStencils);
+    result->_weights.reserve(stencilTable.GetWeights().size());
+    // most deltas fit in one or two bytes
+    result->_indices.reserve(stencilTable.GetControlIndices().size() * 2);
+
+    int numBlocks = (numStencils + CompressedStencilTable::BLOCK_SIZE - 1) /
+                    CompressedStencilTable::BLOCK_SIZE;
+    result->_blockIndexOffsets.reserve(numBlocks);
+    result->_blockWeightOffsets.reserve(numBlocks);
+
+    std::vector<Entry> entries;
+    std::vector<int> quantized, order;
+    std::vector<double> residuals;
+
+    double maxWeightError = 0.0,
+           maxStencilError = 0.0,
+           maxSumError = 0.0;
+
+    Index const * indices = stencilTable.GetControlIndices().empty() ? 0 :
+                            &stencilTable.GetControlIndices()[0];
+    float const * weights = stencilTable.GetWeights().empty() ? 0 :
+                            &stencilTable.GetWeights()[0];
+
+    int firstIndex = 0;
+    for (int i = 0; i < numStencils; ++i) {
+
+        if (i % CompressedStencilTable::BLOCK_SIZE == 0) {
+            result->_blockIndexOffsets.push_back(
+                (int)result->_indices.size());
+            result->_blockWeightOffsets.push_back(
+                (int)result->_weights.size());
+            firstIndex = 0;
+        }
+
+        int size = stencilTable.GetSizes()[i];
+
+        entries.resize(size);
+        double sum = 0.0;
+        float maxWeight = 0.0f;
+        for (int j = 0; j < size; ++j) {
+            entries[j].index = indices[j];
+            entries[j].weight = weights[j];
+            sum += weights[j];
+            maxWeight = std::max(maxWeight, std::abs(weights[j]));
+        }
+        indices += size;
+        weights += size;
+
+        std::sort(entries.begin(), entries.end());
+
+        // sizes
+        if (size < 255) {
+            result->_sizes[i] = (unsigned char)size;
+        } else {
+            result->_sizes[i] = 255;
+            encodeVarint(result->_indices, size - 255);
+        }
+
+        // indices
+        for (int j = 0; j < size; ++j) {
+            if (j == 0) {
+                encodeVarint(result->_indices,
+                    encodeZigZag(entries[0].index - firstIndex));
+                firstIndex = entries[0].index;
+            } else {
+                encodeVarint(result->_indices,
+                    entries[j].index - entries[j-1].index);
+            }
+        }
+
+        // weights : rounded to the nearest multiple of the scale, then the
+        // roundings with the largest residuals are flipped so that the sum
+        // of the quantized weights is as close as possible to the original
+        float scale = maxWeight / maxQuantizedWeight;
+        result->_scales[i] = scale;
+
+        quantized.resize(size);
+        residuals.resize(size);
+        double quantizedSum = 0.0;
+        for (int j = 0; j < size; ++j) {
+            double q = scale > 0.0f ? entries[j].weight / (double)scale : 0.0;
+            quantized[j] = (int)std::floor(q + 0.5);
+            residuals[j] = q - quantized[j];
+            quantizedSum += quantized[j];
+        }
+
+        if (scale > 0.0f) {
+            int correction =
+                (int)std::floor(sum / (double)scale - quantizedSum + 0.5);
+            if (correction != 0) {
+                order.resize(size);
+                for (int j = 0; j < size; ++j) {
+                    order[j] = j;
+                }
+                std::sort(order.begin(), order.end(),
+                          ResidualCompare(&residuals[0], correction > 0));
+
+                int step = correction > 0 ? 1 : -1;
+                for (int j = 0; j < size and correction != 0; ++j) {
+                    int & q = quantized[order[j]];
+                    if (std::abs(q + step) <= maxQuantizedWeight) {
+                        q += step;
+                        correction -= step;
+                    }
+                }
+            }
+        }
+
+        double stencilError = 0.0,
+               stencilSum = 0.0;
+        for (int j = 0; j < size; ++j) {
+            result->_weights.push_back((short)quantized[j]);
+
+            double w = quantized[j] * (double)scale,
+                   error = std::abs(w - entries[j].weight);
+            maxWeightError = std::max(maxWeightError, error);
+            stencilError += error;
+            stencilSum += w;
+        }
+        maxStencilError = std::max(maxStencilError, stencilError);
+        maxSumError = std::max(maxSumError, std::abs(stencilSum - sum));
+    }
+
+    result->_maxWeightError = (float)maxWeightError;
+    result->_maxStencilError = (float)maxStencilError;
+    result->_maxSumError = (float)maxSumError;
+
+    // reallocate the encoded indices to remove excess capacity
+    std::vector<unsigned char>(result->_indices).swap(result->_indices);
+
+    AdviseHugePages(result->_sizes);
+    AdviseHugePages(result->_scales);
+    AdviseHugePages(result->_indices);
+    AdviseHugePages(result->_weights);
+
+    return result;
+}
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
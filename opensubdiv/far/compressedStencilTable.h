@@ -0,0 +1,272 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OPENSUBDIV3_FAR_COMPRESSED_STENCILTABLE_H
+#define OPENSUBDIV3_FAR_COMPRESSED_STENCILTABLE_H
+
+#include "../version.h"
+
+#include "../far/types.h"
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+class StencilTable;
+class CompressedStencilTableFactory;
+
+/// \brief Table of subdivision stencils with a compressed encoding
+///
+/// A CompressedStencilTable holds the same stencils as the StencilTable it
+/// was created from, at a fraction of the memory (and of the bandwidth of
+/// the evaluation, which decodes the stencils on the fly) :
+///
+///   - the size of each stencil is an 8-bit integer (sizes from 255 on are
+///     completed by a varint at the head of the stencil's indices)
+///
+///   - the weights of each stencil are quantized to 16-bit integers of a
+///     per-stencil scale
+///
+///   - the control vertex indices of each stencil are sorted and delta-coded
+///     as unsigned LEB128 varints : the first one relative to the first index
+///     of the previous stencil (zig-zag encoded), the following ones relative
+///     to the previous index of the stencil
+///
+/// Stencils are grouped in blocks of BLOCK_SIZE stencils : the delta coding
+/// restarts on each block, so that evaluations can start at any block.
+///
+/// The quantization of the weights is lossy : the factory records the error
+/// bounds of the table (see GetMaxWeightError() and GetMaxStencilError()).
+///
+class CompressedStencilTable {
+
+public:
+
+    enum { BLOCK_SIZE = 32 };
+
+    /// \brief Returns the number of stencils in the table
+    int GetNumStencils() const {
+        return (int)_sizes.size();
+    }
+
+    /// \brief Returns the number of control vertices indexed in the table
+    int GetNumControlVertices() const {
+        return _numControlVertices;
+    }
+
+    /// \brief Returns the 8-bit sizes of the stencils
+    std::vector<unsigned char> const & GetSizes() const {
+        return _sizes;
+    }
+
+    /// \brief Returns the scale of the quantized weights of each stencil
+    std::vector<float> const & GetScales() const {
+        return _scales;
+    }
+
+    /// \brief Returns the delta-coded control vertex indices
+    std::vector<unsigned char> const & GetControlIndices() const {
+        return _indices;
+    }
+
+    /// \brief Returns the quantized stencil weights
+    std::vector<short> const & GetWeights() const {
+        return _weights;
+    }
+
+    /// \brief Returns the offset of each block of stencils in the control
+    ///        vertex indices
+    std::vector<int> const & GetBlockIndexOffsets() const {
+        return _blockIndexOffsets;
+    }
+
+    /// \brief Returns the offset of each block of stencils in the weights
+    std::vector<int> const & GetBlockWeightOffsets() const {
+        return _blockWeightOffsets;
+    }
+
+    /// \brief Returns the largest error on any stencil weight
+    float GetMaxWeightError() const {
+        return _maxWeightError;
+    }
+
+    /// \brief Returns the largest sum of the absolute errors on the weights
+    ///        of a stencil : bounds the error on any interpolated value,
+    ///        relative to the largest magnitude of the control values.
+    float GetMaxStencilError() const {
+        return _maxStencilError;
+    }
+
+    /// \brief Returns the largest error on the sum of the weights of a
+    ///        stencil, i.e. on the interpolation of a constant value (the
+    ///        quantized weights are adjusted to preserve the sums)
+    float GetMaxSumError() const {
+        return _maxSumError;
+    }
+
+    /// \brief Returns the memory used by the tables in bytes
+    size_t GetMemoryUsage() const;
+
+    /// \brief Updates point values based on the control values
+    ///
+    /// \note The destination buffers are assumed to have allocated at least
+    ///       \c GetNumStencils() elements.
+    ///
+    /// @param controlValues  Buffer with primvar data for the control vertices
+    ///
+    /// @param values         Destination buffer for the interpolated primvar
+    ///                       data
+    ///
+    /// @param start          (skip to )index of first value to update
+    ///
+    /// @param end            Index of last value to update
+    ///
+    template <class T>
+    void UpdateValues(T const *controlValues, T *values, Index start=-1, Index end=-1) const;
+
+    /// \brief Decodes an unsigned varint and advances the pointer past it
+    static unsigned int DecodeVarint(unsigned char const * & ptr) {
+        unsigned int value = *ptr++;
+        if (value < 0x80) {
+            return value;
+        }
+        value &= 0x7f;
+        for (int shift = 7; ; shift += 7) {
+            unsigned char byte = *ptr++;
+            value |= (unsigned int)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) break;
+        }
+        return value;
+    }
+
+    /// \brief Decodes a zig-zag encoded signed integer
+    static int DecodeZigZag(unsigned int value) {
+        return (int)(value >> 1) ^ -(int)(value & 1);
+    }
+
+protected:
+    CompressedStencilTable() :
+        _numControlVertices(0),
+        _maxWeightError(0.0f),
+        _maxStencilError(0.0f),
+        _maxSumError(0.0f) { }
+
+    friend class CompressedStencilTableFactory;
+
+    int _numControlVertices;    // number of control vertices
+
+    std::vector<unsigned char> _sizes;    // number of coefficients (8-bit)
+    std::vector<float>         _scales;   // scale of the quantized weights
+    std::vector<unsigned char> _indices;  // delta-coded control vertex indices
+    std::vector<short>         _weights;  // quantized weights
+
+    std::vector<int> _blockIndexOffsets,  // offsets of the stencil blocks
+                     _blockWeightOffsets;
+
+    float _maxWeightError,
+          _maxStencilError,
+          _maxSumError;
+};
+
+template <class T> void
+CompressedStencilTable::UpdateValues(T const *controlValues, T *values,
+    Index start, Index end) const {
+
+    start = start < 0 ? 0 : start;
+    end = end < 0 ? GetNumStencils() : end;
+    if (start >= end) return;
+
+    // decode from the start of the block holding the first stencil
+    int i = start - start % BLOCK_SIZE;
+
+    unsigned char const * indices =
+        &_indices[0] + _blockIndexOffsets[i / BLOCK_SIZE];
+    short const * weights =
+        &_weights[0] + _blockWeightOffsets[i / BLOCK_SIZE];
+
+    int firstIndex = 0;
+    for (; i < end; ++i) {
+
+        if (i % BLOCK_SIZE == 0) {
+            firstIndex = 0;
+        }
+
+        int size = _sizes[i];
+        if (size == 255) {
+            size += DecodeVarint(indices);
+        }
+
+        float scale = _scales[i];
+
+        T * dst = values + i;
+        if (i >= start) {
+            dst->Clear();
+        }
+
+        int index = 0;
+        for (int j = 0; j < size; ++j) {
+            if (j == 0) {
+                index = firstIndex += DecodeZigZag(DecodeVarint(indices));
+            } else {
+                index += DecodeVarint(indices);
+            }
+            if (i >= start) {
+                dst->AddWithWeight(controlValues[index], weights[j] * scale);
+            }
+        }
+        weights += size;
+    }
+}
+
+/// \brief A specialized factory for CompressedStencilTable
+///
+class CompressedStencilTableFactory {
+
+public:
+
+    /// \brief Compresses the stencils of a StencilTable
+    ///
+    /// The error bounds of the compressed table are returned by its
+    /// GetMaxWeightError(), GetMaxStencilError() and GetMaxSumError().
+    ///
+    /// @param stencilTable  The stencils to compress
+    ///
+    static CompressedStencilTable const * Create(
+        StencilTable const & stencilTable);
+};
+
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // OPENSUBDIV3_FAR_COMPRESSED_STENCILTABLE_H
@@ -24,6 +24,7 @@
 
 #include "../far/patchBasis.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -42,33 +43,50 @@ enum SplineBasis {
 
 template <SplineBasis BASIS>
 class Spline {
-
 public:
 
     // curve weights
-    static void GetWeights(float t, float point[], float deriv[]);
+    template <typename REAL>
+    static void GetWeights(REAL t, REAL point[], REAL deriv[],
+        REAL deriv2[] = 0);
 
     // box-spline weights
-    static void GetWeights(float v, float w, float point[]);
+    template <typename REAL>
+    static void GetWeights(REAL v, REAL w, REAL point[]);
 
     // patch weights
+    template <typename REAL>
     static void GetPatchWeights(PatchParam const & param,
-        float s, float t, float point[], float deriv1[], float deriv2[]);
+        REAL s, REAL t, REAL point[], REAL derivS[], REAL derivT[],
+        REAL derivSS[] = 0, REAL derivST[] = 0, REAL derivTT[] = 0);
+
+    // batched patch weights (SoA)
+    template <typename REAL>
+    static void GetPatchWeights(PatchParam const & param, int count,
+        REAL const s[], REAL const t[],
+        REAL point[], REAL derivS[], REAL derivT[],
+        REAL derivSS[], REAL derivST[], REAL derivTT[], int stride);
 
     // adjust patch weights for boundary (and corner) edges
+    template <typename REAL>
     static void AdjustBoundaryWeights(PatchParam const & param,
-        float sWeights[4], float tWeights[4]);
+        REAL sWeights[4], REAL tWeights[4]);
 };
 
+//  Number of locations whose univariate weights are held on the stack by the
+//  batched evaluation:
+static int const BATCH_SIZE = 32;
+
 template <>
+template <typename REAL>
 inline void Spline<BASIS_BEZIER>::GetWeights(
-    float t, float point[4], float deriv[4]) {
+    REAL t, REAL point[4], REAL deriv[4], REAL deriv2[4]) {
 
     // The four uniform cubic Bezier basis functions (in terms of t and its
     // complement tC) evaluated at t:
-    float t2 = t*t;
-    float tC = 1.0f - t;
-    float tC2 = tC * tC;
+    REAL t2 = t*t;
+    REAL tC = 1.0f - t;
+    REAL tC2 = tC * tC;
 
     assert(point);
     point[0] = tC2 * tC;
@@ -83,17 +101,26 @@ inline void Spline<BASIS_BEZIER>::GetWeights(
        deriv[2] = -9.0f * t2 +  6.0f * t;
        deriv[3] =  3.0f * t2;
     }
+
+    // Second derivatives of the basis functions at t:
+    if (deriv2) {
+       deriv2[0] =   6.0f * tC;
+       deriv2[1] =  18.0f * t - 12.0f;
+       deriv2[2] = -18.0f * t +  6.0f;
+       deriv2[3] =   6.0f * t;
+    }
 }
 
 template <>
+template <typename REAL>
 inline void Spline<BASIS_BSPLINE>::GetWeights(
-    float t, float point[4], float deriv[4]) {
+    REAL t, REAL point[4], REAL deriv[4], REAL deriv2[4]) {
 
     // The four uniform cubic B-Spline basis functions evaluated at t:
-    float const one6th = 1.0f / 6.0f;
+    REAL const one6th = (REAL)(1.0 / 6.0);
 
-    float t2 = t * t;
-    float t3 = t * t2;
+    REAL t2 = t * t;
+    REAL t3 = t * t2;
 
     assert(point);
     point[0] = one6th * (1.0f - 3.0f*(t -      t2) -      t3);
@@ -108,13 +135,22 @@ inline void Spline<BASIS_BSPLINE>::GetWeights(
         deriv[2] = -1.5f*t2 +      t + 0.5f;
         deriv[3] =  0.5f*t2;
     }
+
+    // Second derivatives of the basis functions at t:
+    if (deriv2) {
+        deriv2[0] = -       t + 1.0f;
+        deriv2[1] =  3.0f * t - 2.0f;
+        deriv2[2] = -3.0f * t + 1.0f;
+        deriv2[3] =         t;
+    }
 }
 
 template <>
+template <typename REAL>
 inline void Spline<BASIS_BOX_SPLINE>::GetWeights(
-    float v, float w, float point[12]) {
+    REAL v, REAL w, REAL point[12]) {
 
-    float u = 1.0f - v - w;
+    REAL u = 1.0f - v - w;
 
     //
     //  The 12 basis functions of the quartic box spline (unscaled by their common
@@ -126,15 +162,15 @@ inline void Spline<BASIS_BOX_SPLINE>::GetWeights(
     //       2 terms for the 6 points on faces opposite the triangle corners
     //
     //  Powers of each variable for notational convenience:
-    float u2 = u*u;
-    float u3 = u*u2;
-    float u4 = u*u3;
-    float v2 = v*v;
-    float v3 = v*v2;
-    float v4 = v*v3;
-    float w2 = w*w;
-    float w3 = w*w2;
-    float w4 = w*w3;
+    REAL u2 = u*u;
+    REAL u3 = u*u2;
+    REAL u4 = u*u3;
+    REAL v2 = v*v;
+    REAL v3 = v*v2;
+    REAL v4 = v*v3;
+    REAL w2 = w*w;
+    REAL w3 = w*w2;
+    REAL w4 = w*w3;
 
     //  And now the basis functions:
     point[ 0] = u4 + 2.0f*u3*v;
@@ -159,17 +195,19 @@ inline void Spline<BASIS_BOX_SPLINE>::GetWeights(
                 v4 + 6*v3*u + 8*v3*w + 36*v2*u*w + 24*v2*w2 + 24*v*w3 + 6*w4 + 60*w2*u*v + 12*u2*v2;
 
     for (int i = 0; i < 12; ++i) {
-        point[i] *= 1.0f / 12.0f;
+        point[i] *= (REAL)(1.0 / 12.0);
     }
 }
 
 template <>
+template <typename REAL>
 inline void Spline<BASIS_BILINEAR>::GetPatchWeights(PatchParam const & param,
-    float s, float t, float point[4], float derivS[4], float derivT[4]) {
+    REAL s, REAL t, REAL point[4], REAL derivS[4], REAL derivT[4],
+    REAL derivSS[4], REAL derivST[4], REAL derivTT[4]) {
 
     param.Normalize(s,t);
 
-    float sC = 1.0f - s,
+    REAL sC = 1.0f - s,
           tC = 1.0f - t;
 
     if (point) {
@@ -180,7 +218,7 @@ inline void Spline<BASIS_BILINEAR>::GetPatchWeights(PatchParam const & param,
     }
     
     if (derivS and derivT) {
-        float dScale = (float)(1 << param.GetDepth());
+        REAL dScale = (REAL)(1 << param.GetDepth());
 
         derivS[0] = -tC * dScale;
         derivS[1] =  tC * dScale;
@@ -192,11 +230,27 @@ inline void Spline<BASIS_BILINEAR>::GetPatchWeights(PatchParam const & param,
         derivT[2] =   s * dScale;
         derivT[3] =  sC * dScale;
     }
+
+    if (derivSS and derivST and derivTT) {
+        // Only the mixed partial of the bilinear basis is non-zero:
+        REAL d2Scale = (REAL)(1 << param.GetDepth());
+        d2Scale *= d2Scale;
+
+        for (int i = 0; i < 4; ++i) {
+            derivSS[i] = 0.0f;
+            derivTT[i] = 0.0f;
+        }
+        derivST[0] =  d2Scale;
+        derivST[1] = -d2Scale;
+        derivST[2] =  d2Scale;
+        derivST[3] = -d2Scale;
+    }
 }
 
 template <SplineBasis BASIS>
+template <typename REAL>
 void Spline<BASIS>::AdjustBoundaryWeights(PatchParam const & param,
-    float sWeights[4], float tWeights[4]) {
+    REAL sWeights[4], REAL tWeights[4]) {
 
     int boundary = param.GetBoundary();
 
@@ -223,22 +277,39 @@ void Spline<BASIS>::AdjustBoundaryWeights(PatchParam const & param,
 }
 
 template <SplineBasis BASIS>
+template <typename REAL>
 void Spline<BASIS>::GetPatchWeights(PatchParam const & param,
-    float s, float t, float point[16], float derivS[16], float derivT[16]) {
+    REAL s, REAL t, REAL point[16], REAL derivS[16], REAL derivT[16],
+    REAL derivSS[16], REAL derivST[16], REAL derivTT[16]) {
+
+    REAL sWeights[4], tWeights[4], dsWeights[4], dtWeights[4],
+         dssWeights[4], dttWeights[4];
 
-    float sWeights[4], tWeights[4], dsWeights[4], dtWeights[4];
+    bool computeDerivs2 = (derivSS and derivST and derivTT);
 
     param.Normalize(s,t);
 
-    Spline<BASIS>::GetWeights(s, point ? sWeights : 0, derivS ? dsWeights : 0);
-    Spline<BASIS>::GetWeights(t, point ? tWeights : 0, derivT ? dtWeights : 0);
+    Spline<BASIS>::GetWeights(s, sWeights,
+        (derivS or computeDerivs2) ? dsWeights : 0,
+        computeDerivs2 ? dssWeights : 0);
+    Spline<BASIS>::GetWeights(t, tWeights,
+        (derivT or computeDerivs2) ? dtWeights : 0,
+        computeDerivs2 ? dttWeights : 0);
+
+    //  Boundary adjustments are linear and are applied to all the univariate
+    //  weights before forming the tensor products:
+    AdjustBoundaryWeights(param, sWeights, tWeights);
+    if ((derivS and derivT) or computeDerivs2) {
+        AdjustBoundaryWeights(param, dsWeights, dtWeights);
+    }
+    if (computeDerivs2) {
+        AdjustBoundaryWeights(param, dssWeights, dttWeights);
+    }
 
     if (point) {
         // Compute the tensor product weight of the (s,t) basis function
         // corresponding to each control vertex:
 
-        AdjustBoundaryWeights(param, sWeights, tWeights);
-
         for (int i = 0; i < 4; ++i) {
             for (int j = 0; j < 4; ++j) {
                 point[4*i+j] = sWeights[j] * tWeights[i];
@@ -250,9 +321,7 @@ void Spline<BASIS>::GetPatchWeights(PatchParam const & param,
         // Compute the tensor product weight of the differentiated (s,t) basis
         // function corresponding to each control vertex (scaled accordingly):
 
-        float dScale = (float)(1 << param.GetDepth());
-
-        AdjustBoundaryWeights(param, dsWeights, dtWeights);
+        REAL dScale = (REAL)(1 << param.GetDepth());
 
         for (int i = 0; i < 4; ++i) {
             for (int j = 0; j < 4; ++j) {
@@ -261,28 +330,142 @@ void Spline<BASIS>::GetPatchWeights(PatchParam const & param,
             }
         }
     }
-}
 
-void GetBilinearWeights(PatchParam const & param,
-    float s, float t, float point[4], float deriv1[4], float deriv2[4]) {
+    if (computeDerivs2) {
+        // Second derivatives are scaled by the square of the sub-patch scale:
+
+        REAL d2Scale = (REAL)(1 << param.GetDepth());
+        d2Scale *= d2Scale;
 
-    Spline<BASIS_BILINEAR>::GetPatchWeights(param, s, t, point, deriv1, deriv2);
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                derivSS[4*i+j] = dssWeights[j] * tWeights[i] * d2Scale;
+                derivST[4*i+j] = dsWeights[j] * dtWeights[i] * d2Scale;
+                derivTT[4*i+j] = sWeights[j] * dttWeights[i] * d2Scale;
+            }
+        }
+    }
 }
 
-void GetBezierWeights(PatchParam const param,
-    float s, float t, float point[16], float deriv1[16], float deriv2[16]) {
+//
+//  Batched evaluation of tensor product patches:  the univariate weights of a
+//  block of locations are computed into SoA rows and the tensor products are
+//  then formed row by row, so that the inner loops run over contiguous
+//  locations and are vectorized by the compiler.
+//
+template <SplineBasis BASIS>
+template <typename REAL>
+void Spline<BASIS>::GetPatchWeights(PatchParam const & param, int count,
+    REAL const s[], REAL const t[],
+    REAL point[], REAL derivS[], REAL derivT[],
+    REAL derivSS[], REAL derivST[], REAL derivTT[], int stride) {
 
-    Spline<BASIS_BEZIER>::GetPatchWeights(param, s, t, point, deriv1, deriv2);
-}
+    assert(point);
 
-void GetBSplineWeights(PatchParam const & param,
-    float s, float t, float point[16], float deriv1[16], float deriv2[16]) {
+    bool computeDerivs  = (derivS and derivT);
+    bool computeDerivs2 = (derivSS and derivST and derivTT);
+
+    int boundary = param.GetBoundary();
+    REAL dScale = (REAL)(1 << param.GetDepth());
+
+    REAL sWeights[4][BATCH_SIZE],  tWeights[4][BATCH_SIZE],
+          dsWeights[4][BATCH_SIZE], dtWeights[4][BATCH_SIZE],
+          dssWeights[4][BATCH_SIZE], dttWeights[4][BATCH_SIZE];
+
+    for (int base = 0; base < count; base += BATCH_SIZE) {
+
+        int n = std::min(count - base, BATCH_SIZE);
+
+        for (int k = 0; k < n; ++k) {
+            REAL sk = s[base + k],
+                  tk = t[base + k];
 
-    Spline<BASIS_BSPLINE>::GetPatchWeights(param, s, t, point, deriv1, deriv2);
+            param.Normalize(sk, tk);
+
+            bool derivs = computeDerivs or computeDerivs2;
+
+            REAL sw[4], tw[4], dsw[4], dtw[4], dssw[4], dttw[4];
+            Spline<BASIS>::GetWeights(sk, sw, derivs ? dsw : 0,
+                computeDerivs2 ? dssw : 0);
+            Spline<BASIS>::GetWeights(tk, tw, derivs ? dtw : 0,
+                computeDerivs2 ? dttw : 0);
+
+            //  Boundary adjustments only combine weights of the same
+            //  location, so they can be applied before transposing:
+            if (boundary) {
+                AdjustBoundaryWeights(param, sw, tw);
+                if (derivs) {
+                    AdjustBoundaryWeights(param, dsw, dtw);
+                }
+                if (computeDerivs2) {
+                    AdjustBoundaryWeights(param, dssw, dttw);
+                }
+            }
+            for (int i = 0; i < 4; ++i) {
+                sWeights[i][k] = sw[i];
+                tWeights[i][k] = tw[i];
+            }
+            if (derivs) {
+                for (int i = 0; i < 4; ++i) {
+                    dsWeights[i][k] = dsw[i] * dScale;
+                    dtWeights[i][k] = dtw[i] * dScale;
+                }
+            }
+            if (computeDerivs2) {
+                for (int i = 0; i < 4; ++i) {
+                    dssWeights[i][k] = dssw[i] * dScale * dScale;
+                    dttWeights[i][k] = dttw[i] * dScale * dScale;
+                }
+            }
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j) {
+                REAL * wP = point + (4*i+j)*stride + base;
+                for (int k = 0; k < n; ++k) {
+                    wP[k] = sWeights[j][k] * tWeights[i][k];
+                }
+            }
+        }
+
+        if (computeDerivs) {
+            for (int i = 0; i < 4; ++i) {
+                for (int j = 0; j < 4; ++j) {
+                    REAL * wDs = derivS + (4*i+j)*stride + base;
+                    REAL * wDt = derivT + (4*i+j)*stride + base;
+                    for (int k = 0; k < n; ++k) {
+                        wDs[k] = dsWeights[j][k] * tWeights[i][k];
+                        wDt[k] = sWeights[j][k] * dtWeights[i][k];
+                    }
+                }
+            }
+        }
+
+        if (computeDerivs2) {
+            for (int i = 0; i < 4; ++i) {
+                for (int j = 0; j < 4; ++j) {
+                    REAL * wDss = derivSS + (4*i+j)*stride + base;
+                    REAL * wDst = derivST + (4*i+j)*stride + base;
+                    REAL * wDtt = derivTT + (4*i+j)*stride + base;
+                    for (int k = 0; k < n; ++k) {
+                        wDss[k] = dssWeights[j][k] * tWeights[i][k];
+                        wDst[k] = dsWeights[j][k] * dtWeights[i][k];
+                        wDtt[k] = sWeights[j][k] * dttWeights[i][k];
+                    }
+                }
+            }
+        }
+    }
 }
 
-void GetGregoryWeights(PatchParam const & param,
-    float s, float t, float point[20], float deriv1[20], float deriv2[20]) {
+//
+//  Gregory basis patches are rational and do not fit the tensor product
+//  form of the Spline class:
+//
+template <typename REAL>
+void getGregoryWeights(PatchParam const & param,
+    REAL s, REAL t, REAL point[20], REAL deriv1[20], REAL deriv2[20],
+    REAL deriv11[20], REAL deriv12[20], REAL deriv22[20]) {
 
     //
     //  P3         e3-      e2+         P2
@@ -321,25 +504,32 @@ void GetGregoryWeights(PatchParam const & param,
     //  interior points will be denoted G -- so we have B(s), B(t) and G(s,t):
     //
     //  Directional Bezier basis functions B at s and t:
-    float Bs[4], Bds[4];
-    float Bt[4], Bdt[4];
+    REAL Bs[4], Bds[4], Bdss[4];
+    REAL Bt[4], Bdt[4], Bdtt[4];
+
+    bool computeDerivs  = (deriv1 and deriv2);
+    bool computeDerivs2 = (deriv11 and deriv12 and deriv22);
 
     param.Normalize(s,t);
 
-    Spline<BASIS_BEZIER>::GetWeights(s, Bs, deriv1 ? Bds : 0);
-    Spline<BASIS_BEZIER>::GetWeights(t, Bt, deriv2 ? Bdt : 0);
+    Spline<BASIS_BEZIER>::GetWeights(s, Bs,
+        (computeDerivs or computeDerivs2) ? Bds : 0,
+        computeDerivs2 ? Bdss : 0);
+    Spline<BASIS_BEZIER>::GetWeights(t, Bt,
+        (computeDerivs or computeDerivs2) ? Bdt : 0,
+        computeDerivs2 ? Bdtt : 0);
 
     //  Rational multipliers G at s and t:
-    float sC = 1.0f - s;
-    float tC = 1.0f - t;
+    REAL sC = 1.0f - s;
+    REAL tC = 1.0f - t;
 
     //  Use <= here to avoid compiler warnings -- the sums should always be non-negative:
-    float df0 = s  + t;   df0 = (df0 <= 0.0f) ? 1.0f : (1.0f / df0);
-    float df1 = sC + t;   df1 = (df1 <= 0.0f) ? 1.0f : (1.0f / df1);
-    float df2 = sC + tC;  df2 = (df2 <= 0.0f) ? 1.0f : (1.0f / df2);
-    float df3 = s  + tC;  df3 = (df3 <= 0.0f) ? 1.0f : (1.0f / df3);
+    REAL df0 = s  + t;   df0 = (df0 <= 0.0f) ? 1.0f : (1.0f / df0);
+    REAL df1 = sC + t;   df1 = (df1 <= 0.0f) ? 1.0f : (1.0f / df1);
+    REAL df2 = sC + tC;  df2 = (df2 <= 0.0f) ? 1.0f : (1.0f / df2);
+    REAL df3 = s  + tC;  df3 = (df3 <= 0.0f) ? 1.0f : (1.0f / df3);
 
-    float G[8] = { s*df0, t*df0,  t*df1, sC*df1,  sC*df2, tC*df2,  tC*df3, s*df3 };
+    REAL G[8] = { s*df0, t*df0,  t*df1, sC*df1,  sC*df2, tC*df2,  tC*df3, s*df3 };
 
     //  Combined weights for boundary and interior points:
     for (int i = 0; i < 12; ++i) {
@@ -360,9 +550,10 @@ void GetGregoryWeights(PatchParam const & param,
     //  unclear if the approximations will hold up under surface analysis involving higher
     //  order differentiation.
     //
-    if (deriv1 and deriv2) {
+    if (computeDerivs or computeDerivs2) {
         //  Remember to include derivative scaling in all assignments below:
-        float dScale = (float)(1 << param.GetDepth());
+        REAL dScale = (REAL)(1 << param.GetDepth());
+        REAL d2Scale = dScale * dScale;
 
         //  Combined weights for boundary points -- simple (scaled) tensor products:
         for (int i = 0; i < 12; ++i) {
@@ -370,8 +561,15 @@ void GetGregoryWeights(PatchParam const & param,
             int tRow = boundaryBezTRow[i];
             int sCol = boundaryBezSCol[i];
 
-            deriv1[iDst] = Bds[sCol] * Bt[tRow] * dScale;
-            deriv2[iDst] = Bdt[tRow] * Bs[sCol] * dScale;
+            if (computeDerivs) {
+                deriv1[iDst] = Bds[sCol] * Bt[tRow] * dScale;
+                deriv2[iDst] = Bdt[tRow] * Bs[sCol] * dScale;
+            }
+            if (computeDerivs2) {
+                deriv11[iDst] = Bdss[sCol] * Bt[tRow] * d2Scale;
+                deriv12[iDst] = Bds[sCol] * Bdt[tRow] * d2Scale;
+                deriv22[iDst] = Bs[sCol] * Bdtt[tRow] * d2Scale;
+            }
         }
 
 #define _USE_BEZIER_PSEUDO_DERIVATIVES
@@ -380,14 +578,22 @@ void GetGregoryWeights(PatchParam const & param,
         //  unique to the given (s,t), i.e. having F = (g^+ * f^+) + (g^- * f^-) as its four
         //  interior points:
         //
-        //  Combined weights for interior points -- (scaled) tensor products with G+ or G-:
+        //  Combined weights for interior points -- (scaled) tensor products with G+ or G-
+        //  (G is held constant for the second derivatives as well):
         for (int i = 0; i < 8; ++i) {
             int iDst = interiorGregory[i];
             int tRow = interiorBezTRow[i];
             int sCol = interiorBezSCol[i];
 
-            deriv1[iDst] = Bds[sCol] * Bt[tRow] * G[i] * dScale;
-            deriv2[iDst] = Bdt[tRow] * Bs[sCol] * G[i] * dScale;
+            if (computeDerivs) {
+                deriv1[iDst] = Bds[sCol] * Bt[tRow] * G[i] * dScale;
+                deriv2[iDst] = Bdt[tRow] * Bs[sCol] * G[i] * dScale;
+            }
+            if (computeDerivs2) {
+                deriv11[iDst] = Bdss[sCol] * Bt[tRow] * G[i] * d2Scale;
+                deriv12[iDst] = Bds[sCol] * Bdt[tRow] * G[i] * d2Scale;
+                deriv22[iDst] = Bs[sCol] * Bdtt[tRow] * G[i] * d2Scale;
+            }
         }
 #else
         //  True Gregory derivatives using appropriate differentiation of composite functions:
@@ -400,14 +606,14 @@ void GetGregoryWeights(PatchParam const & param,
         //  (and with 4 or 8 computations involving these constants, this is all very SIMD
         //  friendly...) but for now we treat all 8 independently for simplicity.
         //
-        //float N[8] = {   s,     t,      t,     sC,      sC,     tC,      tC,     s };
-        float D[8] = {   df0,   df0,    df1,    df1,     df2,    df2,     df3,   df3 };
+        //REAL N[8] = {   s,     t,      t,     sC,      sC,     tC,      tC,     s };
+        REAL D[8] = {   df0,   df0,    df1,    df1,     df2,    df2,     df3,   df3 };
 
-        static float const Nds[8] = { 1.0f, 0.0f,  0.0f, -1.0f, -1.0f,  0.0f,  0.0f,  1.0f };
-        static float const Ndt[8] = { 0.0f, 1.0f,  1.0f,  0.0f,  0.0f, -1.0f, -1.0f,  0.0f };
+        static REAL const Nds[8] = { 1.0f, 0.0f,  0.0f, -1.0f, -1.0f,  0.0f,  0.0f,  1.0f };
+        static REAL const Ndt[8] = { 0.0f, 1.0f,  1.0f,  0.0f,  0.0f, -1.0f, -1.0f,  0.0f };
 
-        static float const Dds[8] = { 1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f,  1.0f,  1.0f };
-        static float const Ddt[8] = { 1.0f, 1.0f,  1.0f,  1.0f, -1.0f, -1.0f, -1.0f, -1.0f };
+        static REAL const Dds[8] = { 1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f,  1.0f,  1.0f };
+        static REAL const Ddt[8] = { 1.0f, 1.0f,  1.0f,  1.0f, -1.0f, -1.0f, -1.0f, -1.0f };
 
         //  Combined weights for interior points -- (scaled) combinations of B, B', G and G':
         for (int i = 0; i < 8; ++i) {
@@ -416,17 +622,262 @@ void GetGregoryWeights(PatchParam const & param,
             int sCol = interiorBezSCol[i];
 
             //  Quotient rule for G' (re-expressed in terms of G to simplify (and D = 1/D)):
-            float Gds = (Nds[i] - Dds[i] * G[i]) * D[i];
-            float Gdt = (Ndt[i] - Ddt[i] * G[i]) * D[i];
+            REAL Gds = (Nds[i] - Dds[i] * G[i]) * D[i];
+            REAL Gdt = (Ndt[i] - Ddt[i] * G[i]) * D[i];
 
             //  Product rule combining B and B' with G and G' (and scaled):
-            deriv1[iDst] = (Bds[sCol] * G[i] + Bs[sCol] * Gds) * Bt[tRow] * dScale;
-            deriv2[iDst] = (Bdt[tRow] * G[i] + Bt[tRow] * Gdt) * Bs[sCol] * dScale;
+            if (computeDerivs) {
+                deriv1[iDst] = (Bds[sCol] * G[i] + Bs[sCol] * Gds) * Bt[tRow] * dScale;
+                deriv2[iDst] = (Bdt[tRow] * G[i] + Bt[tRow] * Gdt) * Bs[sCol] * dScale;
+            }
+            if (computeDerivs2) {
+                //  Since N'' = D'' = 0, G'' also reduces to terms of G' and D:
+                REAL Gdss = -2.0f * Dds[i] * Gds * D[i];
+                REAL Gdst = -(Dds[i] * Gdt + Ddt[i] * Gds) * D[i];
+                REAL Gdtt = -2.0f * Ddt[i] * Gdt * D[i];
+
+                deriv11[iDst] = (Bdss[sCol] * G[i] + 2.0f * Bds[sCol] * Gds +
+                                 Bs[sCol] * Gdss) * Bt[tRow] * d2Scale;
+                deriv12[iDst] = (Bds[sCol] * Bdt[tRow] * G[i] +
+                                 Bds[sCol] * Bt[tRow] * Gdt +
+                                 Bs[sCol] * Bdt[tRow] * Gds +
+                                 Bs[sCol] * Bt[tRow] * Gdst) * d2Scale;
+                deriv22[iDst] = (Bdtt[tRow] * G[i] + 2.0f * Bdt[tRow] * Gdt +
+                                 Bt[tRow] * Gdtt) * Bs[sCol] * d2Scale;
+            }
         }
 #endif
     }
 }
 
+//
+//  Batched evaluation of the remaining bases simply transposes the results of
+//  the per-location functions into SoA rows:
+//
+template <typename REAL>
+void getBilinearWeights(PatchParam const & param,
+    REAL s, REAL t, REAL point[4], REAL deriv1[4], REAL deriv2[4],
+    REAL deriv11[4], REAL deriv12[4], REAL deriv22[4]) {
+
+    Spline<BASIS_BILINEAR>::GetPatchWeights(param, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22);
+}
+
+template <typename REAL, int NUM_POINTS>
+inline void
+transposePatchWeights(void (*getWeights)(PatchParam const & param,
+        REAL s, REAL t, REAL point[], REAL deriv1[], REAL deriv2[],
+        REAL deriv11[], REAL deriv12[], REAL deriv22[]),
+    PatchParam const & param, int count, REAL const s[], REAL const t[],
+    REAL point[], REAL derivS[], REAL derivT[],
+    REAL derivSS[], REAL derivST[], REAL derivTT[], int stride) {
+
+    assert(point);
+
+    bool computeDerivs  = (derivS and derivT);
+    bool computeDerivs2 = (derivSS and derivST and derivTT);
+
+    REAL wP[NUM_POINTS], wDs[NUM_POINTS], wDt[NUM_POINTS],
+         wDss[NUM_POINTS], wDst[NUM_POINTS], wDtt[NUM_POINTS];
+
+    for (int k = 0; k < count; ++k) {
+        getWeights(param, s[k], t[k], wP,
+            computeDerivs ? wDs : 0, computeDerivs ? wDt : 0,
+            computeDerivs2 ? wDss : 0, computeDerivs2 ? wDst : 0,
+            computeDerivs2 ? wDtt : 0);
+
+        for (int j = 0; j < NUM_POINTS; ++j) {
+            point[j*stride + k] = wP[j];
+        }
+        if (computeDerivs) {
+            for (int j = 0; j < NUM_POINTS; ++j) {
+                derivS[j*stride + k] = wDs[j];
+                derivT[j*stride + k] = wDt[j];
+            }
+        }
+        if (computeDerivs2) {
+            for (int j = 0; j < NUM_POINTS; ++j) {
+                derivSS[j*stride + k] = wDss[j];
+                derivST[j*stride + k] = wDst[j];
+                derivTT[j*stride + k] = wDtt[j];
+            }
+        }
+    }
+}
+
+//
+//  Public entry points for single and double precision:
+//
+void GetBilinearWeights(PatchParam const & param,
+    float s, float t, float point[4], float deriv1[4], float deriv2[4],
+    float deriv11[4], float deriv12[4], float deriv22[4]) {
+
+    getBilinearWeights(param, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22);
+}
+
+void GetBezierWeights(PatchParam const & param,
+    float s, float t, float point[16], float deriv1[16], float deriv2[16],
+    float deriv11[16], float deriv12[16], float deriv22[16]) {
+
+    Spline<BASIS_BEZIER>::GetPatchWeights(param, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22);
+}
+
+void GetBSplineWeights(PatchParam const & param,
+    float s, float t, float point[16], float deriv1[16], float deriv2[16],
+    float deriv11[16], float deriv12[16], float deriv22[16]) {
+
+    Spline<BASIS_BSPLINE>::GetPatchWeights(param, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22);
+}
+
+void GetGregoryWeights(PatchParam const & param,
+    float s, float t, float point[20], float deriv1[20], float deriv2[20],
+    float deriv11[20], float deriv12[20], float deriv22[20]) {
+
+    getGregoryWeights(param, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22);
+}
+
+void GetBilinearWeights(PatchParam const & param, int count,
+    float const s[], float const t[],
+    float point[], float deriv1[], float deriv2[], int stride) {
+
+    GetBilinearWeights(param, count, s, t, point, deriv1, deriv2,
+        0, 0, 0, stride);
+}
+
+void GetBilinearWeights(PatchParam const & param, int count,
+    float const s[], float const t[],
+    float point[], float deriv1[], float deriv2[],
+    float deriv11[], float deriv12[], float deriv22[], int stride) {
+
+    transposePatchWeights<float, 4>(getBilinearWeights<float>,
+        param, count, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22, stride);
+}
+
+void GetBSplineWeights(PatchParam const & param, int count,
+    float const s[], float const t[],
+    float point[], float deriv1[], float deriv2[], int stride) {
+
+    GetBSplineWeights(param, count, s, t, point, deriv1, deriv2,
+        0, 0, 0, stride);
+}
+
+void GetBSplineWeights(PatchParam const & param, int count,
+    float const s[], float const t[],
+    float point[], float deriv1[], float deriv2[],
+    float deriv11[], float deriv12[], float deriv22[], int stride) {
+
+    Spline<BASIS_BSPLINE>::GetPatchWeights(param, count, s, t,
+        point, deriv1, deriv2, deriv11, deriv12, deriv22, stride);
+}
+
+void GetGregoryWeights(PatchParam const & param, int count,
+    float const s[], float const t[],
+    float point[], float deriv1[], float deriv2[], int stride) {
+
+    GetGregoryWeights(param, count, s, t, point, deriv1, deriv2,
+        0, 0, 0, stride);
+}
+
+void GetGregoryWeights(PatchParam const & param, int count,
+    float const s[], float const t[],
+    float point[], float deriv1[], float deriv2[],
+    float deriv11[], float deriv12[], float deriv22[], int stride) {
+
+    transposePatchWeights<float, 20>(getGregoryWeights<float>,
+        param, count, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22, stride);
+}
+
+void GetBilinearWeights(PatchParam const & param,
+    double s, double t, double point[4], double deriv1[4], double deriv2[4],
+    double deriv11[4], double deriv12[4], double deriv22[4]) {
+
+    getBilinearWeights(param, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22);
+}
+
+void GetBezierWeights(PatchParam const & param,
+    double s, double t, double point[16], double deriv1[16], double deriv2[16],
+    double deriv11[16], double deriv12[16], double deriv22[16]) {
+
+    Spline<BASIS_BEZIER>::GetPatchWeights(param, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22);
+}
+
+void GetBSplineWeights(PatchParam const & param,
+    double s, double t, double point[16], double deriv1[16], double deriv2[16],
+    double deriv11[16], double deriv12[16], double deriv22[16]) {
+
+    Spline<BASIS_BSPLINE>::GetPatchWeights(param, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22);
+}
+
+void GetGregoryWeights(PatchParam const & param,
+    double s, double t, double point[20], double deriv1[20], double deriv2[20],
+    double deriv11[20], double deriv12[20], double deriv22[20]) {
+
+    getGregoryWeights(param, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22);
+}
+
+void GetBilinearWeights(PatchParam const & param, int count,
+    double const s[], double const t[],
+    double point[], double deriv1[], double deriv2[], int stride) {
+
+    GetBilinearWeights(param, count, s, t, point, deriv1, deriv2,
+        0, 0, 0, stride);
+}
+
+void GetBilinearWeights(PatchParam const & param, int count,
+    double const s[], double const t[],
+    double point[], double deriv1[], double deriv2[],
+    double deriv11[], double deriv12[], double deriv22[], int stride) {
+
+    transposePatchWeights<double, 4>(getBilinearWeights<double>,
+        param, count, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22, stride);
+}
+
+void GetBSplineWeights(PatchParam const & param, int count,
+    double const s[], double const t[],
+    double point[], double deriv1[], double deriv2[], int stride) {
+
+    GetBSplineWeights(param, count, s, t, point, deriv1, deriv2,
+        0, 0, 0, stride);
+}
+
+void GetBSplineWeights(PatchParam const & param, int count,
+    double const s[], double const t[],
+    double point[], double deriv1[], double deriv2[],
+    double deriv11[], double deriv12[], double deriv22[], int stride) {
+
+    Spline<BASIS_BSPLINE>::GetPatchWeights(param, count, s, t,
+        point, deriv1, deriv2, deriv11, deriv12, deriv22, stride);
+}
+
+void GetGregoryWeights(PatchParam const & param, int count,
+    double const s[], double const t[],
+    double point[], double deriv1[], double deriv2[], int stride) {
+
+    GetGregoryWeights(param, count, s, t, point, deriv1, deriv2,
+        0, 0, 0, stride);
+}
+
+void GetGregoryWeights(PatchParam const & param, int count,
+    double const s[], double const t[],
+    double point[], double deriv1[], double deriv2[],
+    double deriv11[], double deriv12[], double deriv22[], int stride) {
+
+    transposePatchWeights<double, 20>(getGregoryWeights<double>,
+        param, count, s, t, point, deriv1, deriv2,
+        deriv11, deriv12, deriv22, stride);
+}
+
 } // end namespace internal
 } // end namespace Far
 
@@ -45,17 +45,109 @@ namespace internal {
 // So this interface will be changing in future.
 //
 
+//
+//  Second derivative weights (wrt ss, st and tt) are only computed when all of
+//  wDss, wDst and wDtt are provided.  As with the first derivatives, the
+//  weights of the interior points of Gregory patches are those of the Bezier
+//  patch defined by the rational points at (s,t).
+//
 void GetBilinearWeights(PatchParam const & patchParam,
-    float s, float t, float wP[4], float wDs[4], float wDt[4]);
+    float s, float t, float wP[4], float wDs[4], float wDt[4],
+    float wDss[4] = 0, float wDst[4] = 0, float wDtt[4] = 0);
 
 void GetBezierWeights(PatchParam const & patchParam,
-    float s, float t, float wP[16], float wDs[16], float wDt[16]);
+    float s, float t, float wP[16], float wDs[16], float wDt[16],
+    float wDss[16] = 0, float wDst[16] = 0, float wDtt[16] = 0);
 
 void GetBSplineWeights(PatchParam const & patchParam,
-    float s, float t, float wP[16], float wDs[16], float wDt[16]);
+    float s, float t, float wP[16], float wDs[16], float wDt[16],
+    float wDss[16] = 0, float wDst[16] = 0, float wDtt[16] = 0);
 
 void GetGregoryWeights(PatchParam const & patchParam,
-    float s, float t, float wP[20], float wDs[20], float wDt[20]);
+    float s, float t, float wP[20], float wDs[20], float wDt[20],
+    float wDss[20] = 0, float wDst[20] = 0, float wDtt[20] = 0);
+
+//
+// Double precision variants, for evaluation of large coordinates where the
+// rounding of float weights becomes visible.
+//
+void GetBilinearWeights(PatchParam const & patchParam,
+    double s, double t, double wP[4], double wDs[4], double wDt[4],
+    double wDss[4] = 0, double wDst[4] = 0, double wDtt[4] = 0);
+
+void GetBezierWeights(PatchParam const & patchParam,
+    double s, double t, double wP[16], double wDs[16], double wDt[16],
+    double wDss[16] = 0, double wDst[16] = 0, double wDtt[16] = 0);
+
+void GetBSplineWeights(PatchParam const & patchParam,
+    double s, double t, double wP[16], double wDs[16], double wDt[16],
+    double wDss[16] = 0, double wDst[16] = 0, double wDtt[16] = 0);
+
+void GetGregoryWeights(PatchParam const & patchParam,
+    double s, double t, double wP[20], double wDs[20], double wDt[20],
+    double wDss[20] = 0, double wDst[20] = 0, double wDtt[20] = 0);
+
+//
+// Batched variants evaluating the weights of many (s,t) locations on a single
+// patch at once.  Weights are written in SoA form : the weight of control
+// point j for location k is stored at w[j*stride + k], so that each row is
+// contiguous across locations and can be consumed with SIMD loads.  Derivative
+// weights are skipped when either wDs or wDt is NULL, and second derivative
+// weights when any of wDss, wDst or wDtt is NULL.
+//
+void GetBilinearWeights(PatchParam const & patchParam, int count,
+    float const s[], float const t[],
+    float wP[], float wDs[], float wDt[], int stride);
+
+void GetBilinearWeights(PatchParam const & patchParam, int count,
+    float const s[], float const t[],
+    float wP[], float wDs[], float wDt[],
+    float wDss[], float wDst[], float wDtt[], int stride);
+
+void GetBSplineWeights(PatchParam const & patchParam, int count,
+    float const s[], float const t[],
+    float wP[], float wDs[], float wDt[], int stride);
+
+void GetBSplineWeights(PatchParam const & patchParam, int count,
+    float const s[], float const t[],
+    float wP[], float wDs[], float wDt[],
+    float wDss[], float wDst[], float wDtt[], int stride);
+
+void GetGregoryWeights(PatchParam const & patchParam, int count,
+    float const s[], float const t[],
+    float wP[], float wDs[], float wDt[], int stride);
+
+void GetGregoryWeights(PatchParam const & patchParam, int count,
+    float const s[], float const t[],
+    float wP[], float wDs[], float wDt[],
+    float wDss[], float wDst[], float wDtt[], int stride);
+
+void GetBilinearWeights(PatchParam const & patchParam, int count,
+    double const s[], double const t[],
+    double wP[], double wDs[], double wDt[], int stride);
+
+void GetBilinearWeights(PatchParam const & patchParam, int count,
+    double const s[], double const t[],
+    double wP[], double wDs[], double wDt[],
+    double wDss[], double wDst[], double wDtt[], int stride);
+
+void GetBSplineWeights(PatchParam const & patchParam, int count,
+    double const s[], double const t[],
+    double wP[], double wDs[], double wDt[], int stride);
+
+void GetBSplineWeights(PatchParam const & patchParam, int count,
+    double const s[], double const t[],
+    double wP[], double wDs[], double wDt[],
+    double wDss[], double wDst[], double wDtt[], int stride);
+
+void GetGregoryWeights(PatchParam const & patchParam, int count,
+    double const s[], double const t[],
+    double wP[], double wDs[], double wDt[], int stride);
+
+void GetGregoryWeights(PatchParam const & patchParam, int count,
+    double const s[], double const t[],
+    double wP[], double wDs[], double wDt[],
+    double wDss[], double wDst[], double wDtt[], int stride);
 
 
 } // end namespace internal
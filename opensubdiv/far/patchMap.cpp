@@ -23,6 +23,7 @@
 //
 
 #include "../far/patchMap.h"
+#include "../far/binaryFile.h"
 
 #include <algorithm>
 
@@ -162,6 +163,64 @@ PatchMap::initialize( PatchTable const & patchTable ) {
     _quadtree = quadtree;
 }
 
+void
+PatchMap::write( internal::BinaryFileWriter & writer ) const {
+
+    // children are encoded explicitly rather than relying on the layout of
+    // their bitfields
+    std::vector<unsigned int> quadtree(4 * _quadtree.size());
+    for (int i=0; i<(int)quadtree.size(); ++i) {
+        QuadNode::Child const & child = _quadtree[i/4].children[i%4];
+        quadtree[i] = child.isSet | (child.isLeaf << 1) | (child.idx << 2);
+    }
+
+    writer.AddSection(internal::PATCH_MAP_HANDLES, _handles);
+    writer.AddSectionCopy(internal::PATCH_MAP_QUADTREE, quadtree);
+}
+
+bool
+PatchMap::read( internal::MappedBinaryFile const & file,
+    PatchTable const & patchTable ) {
+
+    int nhandles = 0,
+        nchildren = 0;
+    Handle const * handles =
+        file.GetSection<Handle>(internal::PATCH_MAP_HANDLES, &nhandles);
+    unsigned int const * children =
+        file.GetSection<unsigned int>(internal::PATCH_MAP_QUADTREE, &nchildren);
+
+    if (nhandles != patchTable.GetNumPatchesTotal() or nchildren%4 != 0) {
+        return false;
+    }
+
+    int narrays = patchTable.GetNumPatchArrays();
+    for (int i=0; i<nhandles; ++i) {
+        Handle const & h = handles[i];
+        if (h.arrayIndex<0 or h.arrayIndex>=narrays or
+            h.patchIndex<0 or h.patchIndex>=nhandles or h.vertIndex<0 or
+            h.vertIndex>=patchTable.GetNumControlVertices(h.arrayIndex)) {
+            return false;
+        }
+    }
+    _handles.assign(handles, handles + nhandles);
+
+    int nnodes = nchildren/4;
+    _quadtree.resize(nnodes);
+    for (int i=0; i<nchildren; ++i) {
+        unsigned int isSet = children[i] & 1,
+                     isLeaf = (children[i] >> 1) & 1,
+                     idx = children[i] >> 2;
+        if (isSet and idx >= (unsigned int)(isLeaf ? nhandles : nnodes)) {
+            return false;
+        }
+        QuadNode::Child & child = _quadtree[i/4].children[i%4];
+        child.isSet = isSet;
+        child.isLeaf = isLeaf;
+        child.idx = idx;
+    }
+    return true;
+}
+
 
 } // end namespace Far
 
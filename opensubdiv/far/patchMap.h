@@ -74,8 +74,20 @@ public:
 
 private:
 
+    friend class PatchTableFactory;
+
+    PatchMap() { }
+
     inline void initialize( PatchTable const & patchTable );
 
+    // Adds the handles and quadtree to a file (factory helper)
+    void write( internal::BinaryFileWriter & writer ) const;
+
+    // Reads the handles and quadtree of a file : returns false if they are
+    // inconsistent with the patch table (factory helper)
+    bool read( internal::MappedBinaryFile const & file,
+               PatchTable const & patchTable );
+
     // Quadtree node with 4 children
     struct QuadNode {
         struct Child {
@@ -115,6 +115,7 @@ struct PatchParam {
     /// @param v  v parameter
     ///
     void Normalize( float & u, float & v ) const;
+    void Normalize( double & u, double & v ) const;
 
     unsigned int field0:32;
     unsigned int field1:32;
@@ -161,6 +162,20 @@ PatchParam::Normalize( float & u, float & v ) const {
     v = (v - pv) / frac;
 }
 
+inline void
+PatchParam::Normalize( double & u, double & v ) const {
+
+    double frac = GetParamFraction();
+
+    // top left corner
+    double pu = (double)GetU()*frac;
+    double pv = (double)GetV()*frac;
+
+    // normalize u,v coordinates
+    u = (u - pu) / frac,
+    v = (v - pv) / frac;
+}
+
 } // end namespace Far
 
 } // end namespace OPENSUBDIV_VERSION
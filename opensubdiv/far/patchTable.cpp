@@ -23,6 +23,8 @@
 //
 
 #include "../far/patchTable.h"
+#include "../far/allocator.h"
+#include "../far/binaryFile.h"
 #include "../far/patchBasis.h"
 
 #include <cstring>
@@ -154,6 +156,9 @@ struct PatchTable::FVarPatchChannel {
     // Patch points values
     std::vector<Index> patchValuesOffsets; // offset to the first value of each patch
     std::vector<Index> patchValues; // point values for each patch
+
+    // Number of face-varying values indexed by the patch point values
+    int numValues;
 };
 
 inline PatchTable::FVarPatchChannel &
@@ -186,6 +191,10 @@ PatchTable::setFVarPatchChannelLinearInterpolation(
     FVarPatchChannel & c = getFVarPatchChannel(channel);
     c.interpolation = interpolation;
 }
+void
+PatchTable::setFVarPatchChannelNumValues(int numValues, int channel) {
+    getFVarPatchChannel(channel).numValues = numValues;
+}
 
 //
 // PatchTable
@@ -213,6 +222,184 @@ PatchTable::pushPatchArray(PatchDescriptor desc, int npatches,
     }
 }
 
+void
+PatchTable::adviseHugePages() const {
+    AdviseHugePages(_patchVerts);
+    AdviseHugePages(_paramTable);
+    AdviseHugePages(_quadOffsetsTable);
+    AdviseHugePages(_vertexValenceTable);
+    AdviseHugePages(_sharpnessIndices);
+    AdviseHugePages(_sharpnessValues);
+    for (int i = 0; i < (int)_fvarChannels.size(); ++i) {
+        AdviseHugePages(_fvarChannels[i].patchTypes);
+        AdviseHugePages(_fvarChannels[i].patchValues);
+    }
+}
+
+namespace {
+
+    // Assigns the elements of a section of a file to a table
+    template <class T>
+    int
+    readSection(internal::MappedBinaryFile const & file, int tag,
+        std::vector<T> & table) {
+
+        int count = 0;
+        T const * data = file.GetSection<T>(tag, &count);
+        table.assign(data, data + count);
+        return count;
+    }
+}
+
+void
+PatchTable::write(internal::BinaryFileWriter & writer) const {
+
+    int numArrays = (int)_patchArrays.size(),
+        numChannels = (int)_fvarChannels.size();
+
+    std::vector<int> counts(4);
+    counts[0] = _maxValence;
+    counts[1] = _numPtexFaces;
+    counts[2] = numArrays;
+    counts[3] = numChannels;
+    writer.AddSectionCopy(internal::PATCH_TABLE_COUNTS, counts);
+
+    std::vector<int> arrays(5 * numArrays);
+    for (int i = 0; i < numArrays; ++i) {
+        PatchArray const & pa = _patchArrays[i];
+        arrays[5*i  ] = (int)pa.desc.GetType();
+        arrays[5*i+1] = pa.numPatches;
+        arrays[5*i+2] = pa.vertIndex;
+        arrays[5*i+3] = pa.patchIndex;
+        arrays[5*i+4] = pa.quadOffsetIndex;
+    }
+    writer.AddSectionCopy(internal::PATCH_TABLE_ARRAYS, arrays);
+
+    writer.AddSection(internal::PATCH_TABLE_VERTICES, _patchVerts);
+    writer.AddSection(internal::PATCH_TABLE_PARAMS, _paramTable);
+    writer.AddSection(internal::PATCH_TABLE_QUAD_OFFSETS, _quadOffsetsTable);
+    writer.AddSection(internal::PATCH_TABLE_VALENCES, _vertexValenceTable);
+    writer.AddSection(internal::PATCH_TABLE_SHARPNESS_INDICES,
+                      _sharpnessIndices);
+    writer.AddSection(internal::PATCH_TABLE_SHARPNESS_VALUES,
+                      _sharpnessValues);
+
+    std::vector<int> channels(3 * numChannels);
+    for (int i = 0; i < numChannels; ++i) {
+        FVarPatchChannel const & c = _fvarChannels[i];
+        channels[3*i  ] = (int)c.interpolation;
+        channels[3*i+1] = (int)c.patchesType;
+        channels[3*i+2] = c.numValues;
+
+        int tag = internal::PATCH_TABLE_FVAR_CHANNEL_DATA + 3*i;
+        writer.AddSection(tag, c.patchTypes);
+        writer.AddSection(tag + 1, c.patchValuesOffsets);
+        writer.AddSection(tag + 2, c.patchValues);
+    }
+    writer.AddSectionCopy(internal::PATCH_TABLE_FVAR_CHANNELS, channels);
+}
+
+bool
+PatchTable::read(internal::MappedBinaryFile const & file) {
+
+    int numCounts = 0;
+    int const * counts =
+        file.GetSection<int>(internal::PATCH_TABLE_COUNTS, &numCounts);
+    if (numCounts != 4) {
+        return false;
+    }
+    _maxValence = counts[0];
+    _numPtexFaces = counts[1];
+
+    int numArrays = 0,
+        numChannels = 0;
+    int const * arrays =
+        file.GetSection<int>(internal::PATCH_TABLE_ARRAYS, &numArrays);
+    int const * channels =
+        file.GetSection<int>(internal::PATCH_TABLE_FVAR_CHANNELS, &numChannels);
+    numArrays /= 5;
+    numChannels /= 3;
+    if (numArrays != counts[2] or numChannels != counts[3]) {
+        return false;
+    }
+
+    int numVerts = readSection(file, internal::PATCH_TABLE_VERTICES,
+                               _patchVerts),
+        numPatches = readSection(file, internal::PATCH_TABLE_PARAMS,
+                                 _paramTable);
+    int numQuadOffsets = readSection(file, internal::PATCH_TABLE_QUAD_OFFSETS,
+                                     _quadOffsetsTable);
+    readSection(file, internal::PATCH_TABLE_VALENCES, _vertexValenceTable);
+    int numSharpnessIndices = readSection(file,
+        internal::PATCH_TABLE_SHARPNESS_INDICES, _sharpnessIndices);
+    readSection(file, internal::PATCH_TABLE_SHARPNESS_VALUES, _sharpnessValues);
+
+    if (numSharpnessIndices != 0 and numSharpnessIndices != numPatches) {
+        return false;
+    }
+
+    // the patch arrays must lie within the tables
+    _patchArrays.clear();
+    _patchArrays.reserve(numArrays);
+    for (int i = 0; i < numArrays; ++i) {
+        int const * pa = arrays + 5*i;
+        PatchDescriptor desc((PatchDescriptor::Type)pa[0]);
+        if (pa[0] < PatchDescriptor::NON_PATCH or
+                pa[0] > PatchDescriptor::GREGORY_BASIS or pa[1] < 0 or
+                pa[2] < 0 or pa[2] + pa[1] * getPatchSize(desc) > numVerts or
+                pa[3] < 0 or pa[3] + pa[1] > numPatches or
+                pa[4] < 0 or pa[4] > numQuadOffsets) {
+            return false;
+        }
+        // the quad offsets of the legacy Gregory patches follow their index
+        if ((pa[0] == PatchDescriptor::GREGORY or
+                pa[0] == PatchDescriptor::GREGORY_BOUNDARY) and
+                pa[4] + pa[1] * PatchDescriptor::GetGregoryPatchSize() >
+                numQuadOffsets) {
+            return false;
+        }
+        _patchArrays.push_back(PatchArray(desc, pa[1], pa[2], pa[3], pa[4]));
+    }
+
+    _fvarChannels.resize(numChannels);
+    for (int i = 0; i < numChannels; ++i) {
+        FVarPatchChannel & c = _fvarChannels[i];
+        c.interpolation =
+            (Sdc::Options::FVarLinearInterpolation)channels[3*i];
+        c.patchesType = (PatchDescriptor::Type)channels[3*i+1];
+        c.numValues = channels[3*i+2];
+
+        int tag = internal::PATCH_TABLE_FVAR_CHANNEL_DATA + 3*i;
+        int numTypes = readSection(file, tag, c.patchTypes),
+            numOffsets = readSection(file, tag + 1, c.patchValuesOffsets),
+            numPatchValues = readSection(file, tag + 2, c.patchValues);
+        if (numTypes != numOffsets or
+                (numOffsets != 0 and numOffsets != numPatches)) {
+            return false;
+        }
+        // the point values of each patch must lie within their table
+        for (int j = 0; j < numOffsets; ++j) {
+            PatchDescriptor::Type type = c.patchTypes[j];
+            if (type == PatchDescriptor::GREGORY or
+                    type == PatchDescriptor::GREGORY_BOUNDARY or
+                    type == PatchDescriptor::GREGORY_BASIS) {
+                return false;
+            }
+            int ncvs = PatchDescriptor::GetNumFVarControlVertices(type);
+            if (ncvs < 0 or c.patchValuesOffsets[j] < 0 or
+                    c.patchValuesOffsets[j] + ncvs > numPatchValues) {
+                return false;
+            }
+        }
+        for (int j = 0; j < numPatchValues; ++j) {
+            if (c.patchValues[j] < 0 or c.patchValues[j] >= c.numValues) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 int
 PatchTable::getPatchIndex(int arrayIndex, int patchIndex) const {
     PatchArray const & pa = getPatchArray(arrayIndex);
@@ -422,22 +609,48 @@ PatchTable::print() const {
 //
 //  Evaluate basis functions for position and first derivatives at (s,t):
 //
+namespace {
+    template <typename REAL>
+    void
+    evaluateBasis(PatchDescriptor::Type patchType, PatchParam const & param,
+        REAL s, REAL t, REAL wP[], REAL wDs[], REAL wDt[],
+        REAL wDss[], REAL wDst[], REAL wDtt[]) {
+
+        if (patchType == PatchDescriptor::REGULAR) {
+            internal::GetBSplineWeights(param, s, t, wP, wDs, wDt,
+                wDss, wDst, wDtt);
+        } else if (patchType == PatchDescriptor::GREGORY_BASIS) {
+            internal::GetGregoryWeights(param, s, t, wP, wDs, wDt,
+                wDss, wDst, wDtt);
+        } else if (patchType == PatchDescriptor::QUADS) {
+            internal::GetBilinearWeights(param, s, t, wP, wDs, wDt,
+                wDss, wDst, wDtt);
+        } else {
+            assert(0);
+        }
+    }
+}
+
 void
 PatchTable::EvaluateBasis(PatchHandle const & handle, float s, float t,
-    float wP[], float wDs[], float wDt[]) const {
+    float wP[], float wDs[], float wDt[],
+    float wDss[], float wDst[], float wDtt[]) const {
 
     PatchDescriptor::Type patchType = GetPatchArrayDescriptor(handle.arrayIndex).GetType();
     PatchParam const & param = _paramTable[handle.patchIndex];
 
-    if (patchType == PatchDescriptor::REGULAR) {
-        internal::GetBSplineWeights(param, s, t, wP, wDs, wDt);
-    } else if (patchType == PatchDescriptor::GREGORY_BASIS) {
-        internal::GetGregoryWeights(param, s, t, wP, wDs, wDt);
-    } else if (patchType == PatchDescriptor::QUADS) {
-        internal::GetBilinearWeights(param, s, t, wP, wDs, wDt);
-    } else {
-        assert(0);
-    }
+    evaluateBasis(patchType, param, s, t, wP, wDs, wDt, wDss, wDst, wDtt);
+}
+
+void
+PatchTable::EvaluateBasis(PatchHandle const & handle, double s, double t,
+    double wP[], double wDs[], double wDt[],
+    double wDss[], double wDst[], double wDtt[]) const {
+
+    PatchDescriptor::Type patchType = GetPatchArrayDescriptor(handle.arrayIndex).GetType();
+    PatchParam const & param = _paramTable[handle.patchIndex];
+
+    evaluateBasis(patchType, param, s, t, wP, wDs, wDt, wDss, wDst, wDtt);
 }
 
 
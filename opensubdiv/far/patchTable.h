@@ -41,6 +41,11 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Far {
 
+namespace internal {
+    class BinaryFileWriter;
+    class MappedBinaryFile;
+}
+
 /// \brief Container for arrays of parametric patches
 ///
 /// PatchTable contain topology and parametric information about the patches
@@ -289,8 +294,9 @@ public:
     ///  @name Evaluation methods
     ///
 
-    /// \brief Evaluate basis functions for position and first derivatives at a
-    /// given (s,t) parametric location of a patch.
+    /// \brief Evaluate basis functions for position and first derivatives (and
+    /// optionally second derivatives) at a given (s,t) parametric location of
+    /// a patch.
     ///
     /// @param handle  A patch handle indentifying the sub-patch containing the
     ///                (s,t) location
@@ -305,8 +311,23 @@ public:
     ///
     /// @param wDt     Weights (evaluated basis functions) for derivative wrt t
     ///
+    /// @param wDss    Weights (evaluated basis functions) for 2nd derivative
+    ///                wrt s (optional, computed with wDst and wDtt)
+    ///
+    /// @param wDst    Weights (evaluated basis functions) for 2nd derivative
+    ///                wrt s and t
+    ///
+    /// @param wDtt    Weights (evaluated basis functions) for 2nd derivative
+    ///                wrt t
+    ///
     void EvaluateBasis(PatchHandle const & handle, float s, float t,
-        float wP[], float wDs[], float wDt[]) const;
+        float wP[], float wDs[], float wDt[],
+        float wDss[] = 0, float wDst[] = 0, float wDtt[] = 0) const;
+
+    /// \brief Double precision variant of EvaluateBasis()
+    void EvaluateBasis(PatchHandle const & handle, double s, double t,
+        double wP[], double wDs[], double wDt[],
+        double wDss[] = 0, double wDst[] = 0, double wDtt[] = 0) const;
 
     //@}
 
@@ -324,6 +345,16 @@ protected:
     Index * getSharpnessIndices(Index arrayIndex);
     float * getSharpnessValues(Index arrayIndex);
 
+    // Advises huge pages for the large table arrays (factory helper)
+    void adviseHugePages() const;
+
+    // Adds the patch arrays and tables to a file (factory helper)
+    void write(internal::BinaryFileWriter & writer) const;
+
+    // Reads the patch arrays and tables of a file : returns false if they
+    // are inconsistent (factory helper)
+    bool read(internal::MappedBinaryFile const & file);
+
 private:
 
     //
@@ -362,6 +393,8 @@ private:
     void setFVarPatchChannelLinearInterpolation(
         Sdc::Options::FVarLinearInterpolation interpolation, int channel);
 
+    void setFVarPatchChannelNumValues(int numValues, int channel);
+
 
     PatchDescriptor::Type getFVarPatchType(int patch, int channel) const;
     Vtr::Array<PatchDescriptor::Type> getFVarPatchTypes(int channel);
@@ -22,8 +22,11 @@
 //   language governing permissions and limitations under the Apache License.
 //
 #include "../far/patchTableFactory.h"
+#include "../far/binaryFile.h"
 #include "../far/error.h"
+#include "../far/patchMap.h"
 #include "../far/ptexIndices.h"
+#include "../far/stats.h"
 #include "../far/topologyRefiner.h"
 #include "../vtr/level.h"
 #include "../vtr/fvarLevel.h"
@@ -388,6 +391,8 @@ PatchTableFactory::allocateFVarChannels(TopologyRefiner const & refiner,
             refiner.GetFVarLinearInterpolation(*fvc);
 
         table->setFVarPatchChannelLinearInterpolation(interpolation, fvc.pos());
+        table->setFVarPatchChannelNumValues(
+            refiner.GetNumFVarValuesTotal(*fvc), fvc.pos());
 
         int nverts = 0;
 
@@ -529,11 +534,147 @@ assignSharpnessIndex(float sharpness, std::vector<float> & sharpnessValues) {
 PatchTable *
 PatchTableFactory::Create(TopologyRefiner const & refiner, Options options) {
 
-    if (refiner.IsUniform()) {
-        return createUniform(refiner, options);
-    } else {
-        return createAdaptive(refiner, options);
+    internal::StatsScope stats("Far::PatchTableFactory::Create");
+
+    PatchTable * table = refiner.IsUniform() ?
+        createUniform(refiner, options) : createAdaptive(refiner, options);
+
+    if (table) {
+        table->adviseHugePages();
+
+        if (stats.IsEnabled()) {
+            // the counts cover the control vertex indices and patch params
+            size_t numPatches = table->GetNumPatchesTotal(),
+                   numCVs = table->GetNumControlVerticesTotal();
+            stats.SetCounts(numPatches, 0, 0,
+                numCVs * sizeof(Index) + numPatches * sizeof(PatchParam));
+        }
+    }
+    return table;
+}
+
+//
+//  Patch table files hold the tables of the PatchTable and of its PatchMap
+//  (see binaryFile.h) : the tables are read in a single copy from the mapped
+//  file.
+//
+bool
+PatchTableFactory::Write(char const * path, PatchTable const & table,
+    PatchMap const * patchMap) {
+
+    PatchMap * tableMap = patchMap ? 0 : new PatchMap(table);
+
+    internal::BinaryFileWriter writer(internal::BINARY_FILE_PATCH_TABLE, 0);
+
+    table.write(writer);
+    writeLocalPointStencils(writer, internal::PATCH_TABLE_LOCAL_POINTS,
+        table._localPointStencils);
+    writeLocalPointStencils(writer, internal::PATCH_TABLE_LOCAL_VARYING_POINTS,
+        table._localPointVaryingStencils);
+    (patchMap ? patchMap : tableMap)->write(writer);
+
+    bool written = writer.Write(path);
+
+    delete tableMap;
+    return written;
+}
+
+PatchTable *
+PatchTableFactory::Read(char const * path, PatchMap ** patchMap) {
+
+    internal::MappedBinaryFile * file = internal::MappedBinaryFile::Open(
+        path, internal::BINARY_FILE_PATCH_TABLE, 0);
+    if (not file) {
+        return 0;
     }
+
+    PatchTable * table = new PatchTable(0);
+    PatchMap * map = patchMap ? new PatchMap() : 0;
+
+    bool valid = table->read(*file) and
+        readLocalPointStencils(*file, internal::PATCH_TABLE_LOCAL_POINTS,
+            &table->_localPointStencils) and
+        readLocalPointStencils(*file, internal::PATCH_TABLE_LOCAL_VARYING_POINTS,
+            &table->_localPointVaryingStencils) and
+        (not map or map->read(*file, *table));
+
+    delete file;
+
+    if (not valid) {
+        Error(FAR_RUNTIME_ERROR, "Failure in PatchTableFactory::Read() -- "
+            "\"%s\": corrupted patch table", path);
+        delete table;
+        delete map;
+        return 0;
+    }
+
+    table->adviseHugePages();
+
+    if (patchMap) {
+        *patchMap = map;
+    }
+    return table;
+}
+
+void
+PatchTableFactory::writeLocalPointStencils(internal::BinaryFileWriter & writer,
+    int tag, StencilTable const * stencils) {
+
+    if (not stencils) {
+        return;
+    }
+
+    std::vector<int> counts(1, stencils->GetNumControlVertices());
+    writer.AddSectionCopy(tag, counts);
+    writer.AddSection(tag + 1, stencils->GetSizes());
+    writer.AddSection(tag + 2, stencils->GetOffsets());
+    writer.AddSection(tag + 3, stencils->GetControlIndices());
+    // the weights may have excess elements
+    writer.AddSection(tag + 4, stencils->GetWeights(),
+        stencils->GetControlIndices().size());
+}
+
+bool
+PatchTableFactory::readLocalPointStencils(
+    internal::MappedBinaryFile const & file,
+    int tag, StencilTable const ** stencils) {
+
+    int numCounts = 0,
+        numSizes = 0,
+        numOffsets = 0,
+        numIndices = 0,
+        numWeights = 0;
+
+    int const * counts = file.GetSection<int>(tag, &numCounts);
+    if (numCounts == 0) {
+        return true;
+    }
+
+    int const * sizes = file.GetSection<int>(tag + 1, &numSizes);
+    Index const * offsets = file.GetSection<Index>(tag + 2, &numOffsets);
+    Index const * indices = file.GetSection<Index>(tag + 3, &numIndices);
+    float const * weights = file.GetSection<float>(tag + 4, &numWeights);
+
+    // the stencils must cover the indices, with or without offsets
+    bool valid = numCounts == 1 and numIndices == numWeights and
+                 (numOffsets == 0 or numOffsets == numSizes);
+    size_t numStencilIndices = 0;
+    for (int i = 0; valid and i < numSizes; ++i) {
+        valid = sizes[i] >= 0 and (numOffsets == 0 or
+                (offsets[i] >= 0 and offsets[i] <= numIndices - sizes[i]));
+        numStencilIndices += (size_t)std::max(sizes[i], 0);
+    }
+    if (not valid or numStencilIndices != (size_t)numIndices) {
+        return false;
+    }
+
+    StencilTable * table = new StencilTable(counts[0]);
+    table->_sizes.assign(sizes, sizes + numSizes);
+    table->_offsets.assign(offsets, offsets + numOffsets);
+    table->_indices.assign(indices, indices + numIndices);
+    table->_weights.assign(weights, weights + numWeights);
+    *stencils = table;
+    return true;
 }
 
 PatchTable *
@@ -35,6 +35,7 @@ namespace OPENSUBDIV_VERSION {
 namespace Far {
 
 //  Forward declarations (for internal implementation purposes):
+class PatchMap;
 class PtexIndices;
 class TopologyRefiner;
 
@@ -131,6 +132,41 @@ public:
     static PatchTable * Create(TopologyRefiner const & refiner,
                                Options options=Options());
 
+    /// \brief Writes a patch table and its patch map to a file
+    ///
+    /// The file holds the patch arrays, the vertex, parameter, sharpness and
+    /// Gregory tables, the face-varying channels and the local point
+    /// stencils of the table, so that limit evaluation can start from the
+    /// file without a TopologyRefiner.
+    ///
+    /// @param path                 Path of the file
+    ///
+    /// @param table                Patch table to write
+    ///
+    /// @param patchMap             Patch map of the table (optional : the
+    ///                             map is created from the table if NULL)
+    ///
+    /// @return                     False (and reports a FAR_RUNTIME_ERROR)
+    ///                             on failure
+    ///
+    static bool Write(char const * path, PatchTable const & table,
+                      PatchMap const * patchMap=0);
+
+    /// \brief Reads a patch table file written with Write()
+    ///
+    /// The file is mapped in memory and its tables are copied in place.
+    ///
+    /// @param path                 Path of the file
+    ///
+    /// @param patchMap             Returns the patch map of the table
+    ///                             (optional)
+    ///
+    /// @return                     A new instance of PatchTable, or NULL
+    ///                             (and reports a FAR_RUNTIME_ERROR) if the
+    ///                             file can't be read
+    ///
+    static PatchTable * Read(char const * path, PatchMap ** patchMap=0);
+
 private:
     //
     // Private helper structures
@@ -165,6 +201,15 @@ private:
         int level, int face,
         int boundaryMask, int transitionMask, PatchParam * coord);
 
+    //
+    //  Methods for writing and reading the local point stencils:
+    //
+    static void writeLocalPointStencils(internal::BinaryFileWriter & writer,
+        int tag, StencilTable const * stencils);
+
+    static bool readLocalPointStencils(internal::MappedBinaryFile const & file,
+        int tag, StencilTable const ** stencils);
+
     static int gatherFVarData(AdaptiveContext & state,
         int level, Index faceIndex, Index levelFaceOffset, int rotation,
                               Index const * levelOffsets, Index fofss, Index ** fptrs);
@@ -187,9 +187,25 @@ private:
     PrimvarRefiner(PrimvarRefiner const & src) : _refiner(src._refiner) { }
     PrimvarRefiner & operator=(PrimvarRefiner const &) { return *this; }
 
-    template <Sdc::SchemeType SCHEME, class T, class U> void interpFromFaces(int, T const &, U &) const;
-    template <Sdc::SchemeType SCHEME, class T, class U> void interpFromEdges(int, T const &, U &) const;
-    template <Sdc::SchemeType SCHEME, class T, class U> void interpFromVerts(int, T const &, U &) const;
+    //  The stencil factory interpolates ranges of parent components in
+    //  parallel (see interpolateRange() below):
+    template <typename REAL> friend class StencilTableFactoryReal;
+
+    enum ParentType {
+        PARENT_FACES,
+        PARENT_EDGES,
+        PARENT_VERTICES
+    };
+
+    //  Interpolates the child vertices of the parent components [begin, end)
+    //  of the given type, with the same operations as Interpolate():
+    template <class T, class U> void interpolateRange(int level, ParentType type,
+        int begin, int end, T const & src, U & dst) const;
+
+    //  The "from" methods interpolate all parent components when end < 0:
+    template <Sdc::SchemeType SCHEME, class T, class U> void interpFromFaces(int, T const &, U &, int begin = 0, int end = -1) const;
+    template <Sdc::SchemeType SCHEME, class T, class U> void interpFromEdges(int, T const &, U &, int begin = 0, int end = -1) const;
+    template <Sdc::SchemeType SCHEME, class T, class U> void interpFromVerts(int, T const &, U &, int begin = 0, int end = -1) const;
 
     template <Sdc::SchemeType SCHEME, class T, class U> void interpFVarFromFaces(int, T const &, U &, int) const;
     template <Sdc::SchemeType SCHEME, class T, class U> void interpFVarFromEdges(int, T const &, U &, int) const;
@@ -400,6 +416,39 @@ PrimvarRefiner::InterpolateFaceUniform(int level, T const & src, U & dst) const
     }
 }
 
+template <class T, class U>
+inline void
+PrimvarRefiner::interpolateRange(int level, ParentType type,
+                                 int begin, int end,
+                                 T const & src, U & dst) const {
+
+    assert(level>0 and level<=(int)_refiner._refinements.size());
+
+    switch (_refiner._subdivType) {
+    case Sdc::SCHEME_CATMARK:
+        switch (type) {
+        case PARENT_FACES:    interpFromFaces<Sdc::SCHEME_CATMARK>(level, src, dst, begin, end); break;
+        case PARENT_EDGES:    interpFromEdges<Sdc::SCHEME_CATMARK>(level, src, dst, begin, end); break;
+        case PARENT_VERTICES: interpFromVerts<Sdc::SCHEME_CATMARK>(level, src, dst, begin, end); break;
+        }
+        break;
+    case Sdc::SCHEME_LOOP:
+        switch (type) {
+        case PARENT_FACES:    interpFromFaces<Sdc::SCHEME_LOOP>(level, src, dst, begin, end); break;
+        case PARENT_EDGES:    interpFromEdges<Sdc::SCHEME_LOOP>(level, src, dst, begin, end); break;
+        case PARENT_VERTICES: interpFromVerts<Sdc::SCHEME_LOOP>(level, src, dst, begin, end); break;
+        }
+        break;
+    case Sdc::SCHEME_BILINEAR:
+        switch (type) {
+        case PARENT_FACES:    interpFromFaces<Sdc::SCHEME_BILINEAR>(level, src, dst, begin, end); break;
+        case PARENT_EDGES:    interpFromEdges<Sdc::SCHEME_BILINEAR>(level, src, dst, begin, end); break;
+        case PARENT_VERTICES: interpFromVerts<Sdc::SCHEME_BILINEAR>(level, src, dst, begin, end); break;
+        }
+        break;
+    }
+}
+
 template <class T, class U>
 inline void
 PrimvarRefiner::InterpolateVarying(int level, T const & src, U & dst) const {
@@ -464,7 +513,7 @@ PrimvarRefiner::InterpolateVarying(int level, T const & src, U & dst) const {
 //
 template <Sdc::SchemeType SCHEME, class T, class U>
 inline void
-PrimvarRefiner::interpFromFaces(int level, T const & src, U & dst) const {
+PrimvarRefiner::interpFromFaces(int level, T const & src, U & dst, int begin, int end) const {
 
     Vtr::internal::Refinement const & refinement = _refiner.getRefinement(level-1);
     Vtr::internal::Level const &      parent     = refinement.parent();
@@ -475,7 +524,9 @@ PrimvarRefiner::interpFromFaces(int level, T const & src, U & dst) const {
 
     Vtr::internal::StackBuffer<float,16> fVertWeights(parent.getMaxValence());
 
-    for (int face = 0; face < parent.getNumFaces(); ++face) {
+    if (end < 0) end = parent.getNumFaces();
+
+    for (int face = begin; face < end; ++face) {
 
         Vtr::Index cVert = refinement.getFaceChildVertex(face);
         if (!Vtr::IndexIsValid(cVert))
@@ -501,7 +552,7 @@ PrimvarRefiner::interpFromFaces(int level, T const & src, U & dst) const {
 
 template <Sdc::SchemeType SCHEME, class T, class U>
 inline void
-PrimvarRefiner::interpFromEdges(int level, T const & src, U & dst) const {
+PrimvarRefiner::interpFromEdges(int level, T const & src, U & dst, int begin, int end) const {
 
     Vtr::internal::Refinement const & refinement = _refiner.getRefinement(level-1);
     Vtr::internal::Level const &      parent     = refinement.parent();
@@ -514,7 +565,9 @@ PrimvarRefiner::interpFromEdges(int level, T const & src, U & dst) const {
     float                               eVertWeights[2];
     Vtr::internal::StackBuffer<float,8> eFaceWeights(parent.getMaxEdgeFaces());
 
-    for (int edge = 0; edge < parent.getNumEdges(); ++edge) {
+    if (end < 0) end = parent.getNumEdges();
+
+    for (int edge = begin; edge < end; ++edge) {
 
         Vtr::Index cVert = refinement.getEdgeChildVertex(edge);
         if (!Vtr::IndexIsValid(cVert))
@@ -570,7 +623,7 @@ PrimvarRefiner::interpFromEdges(int level, T const & src, U & dst) const {
 
 template <Sdc::SchemeType SCHEME, class T, class U>
 inline void
-PrimvarRefiner::interpFromVerts(int level, T const & src, U & dst) const {
+PrimvarRefiner::interpFromVerts(int level, T const & src, U & dst, int begin, int end) const {
 
     Vtr::internal::Refinement const & refinement = _refiner.getRefinement(level-1);
     Vtr::internal::Level const &      parent     = refinement.parent();
@@ -582,7 +635,9 @@ PrimvarRefiner::interpFromVerts(int level, T const & src, U & dst) const {
 
     Vtr::internal::StackBuffer<float,32> weightBuffer(2*parent.getMaxValence());
 
-    for (int vert = 0; vert < parent.getNumVertices(); ++vert) {
+    if (end < 0) end = parent.getNumVertices();
+
+    for (int vert = begin; vert < end; ++vert) {
 
         Vtr::Index cVert = refinement.getVertexChildVertex(vert);
         if (!Vtr::IndexIsValid(cVert))
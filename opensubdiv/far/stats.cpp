@@ -0,0 +1,135 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#include "../far/stats.h"
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+//
+//  Statics for the publicly assignable callback and the method to assign it
+//  (disable static assignment warnings when doing so):
+//
+static StatsCallbackFunc statsFunc = 0;
+static void * statsClientData = 0;
+
+#ifdef __INTEL_COMPILER
+#pragma warning disable 1711
+#endif
+
+void SetStatsCallback(StatsCallbackFunc func, void * clientData) {
+    statsFunc = func;
+    statsClientData = clientData;
+}
+
+#ifdef __INTEL_COMPILER
+#pragma warning enable 1711
+#endif
+
+bool IsStatsEnabled() {
+    return statsFunc != 0;
+}
+
+namespace internal {
+
+double
+GetStatsTime() {
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + 1e-9 * (double)now.tv_nsec;
+#endif
+}
+
+void
+ReportStats(Stats const & stats) {
+    // read the callback once : it may be reset by another thread
+    StatsCallbackFunc func = statsFunc;
+    if (func) {
+        func(stats, statsClientData);
+    }
+}
+
+StatsScope::StatsScope(char const * name) :
+    _enabled(statsFunc != 0), _start(0.0), _busyTime(0.0) {
+
+    _stats.name = name;
+    _stats.wallTime = 0.0;
+    _stats.numItems = 0;
+    _stats.numWeights = 0;
+    _stats.bytesRead = 0;
+    _stats.bytesWritten = 0;
+    _stats.numThreads = 1;
+    _stats.threadUtilization = 1.0;
+
+    if (_enabled) {
+        _start = GetStatsTime();
+    }
+}
+
+StatsScope::~StatsScope() {
+
+    if (not _enabled) return;
+
+    _stats.wallTime = GetStatsTime() - _start;
+
+    // serial calls are fully utilized ; parallel ones compare the time spent
+    // in the partitions to the time available to the threads
+    if (_stats.numThreads > 1 and _stats.wallTime > 0.0) {
+        double utilization = _busyTime / (_stats.wallTime * _stats.numThreads);
+        _stats.threadUtilization = utilization < 1.0 ? utilization : 1.0;
+    }
+    ReportStats(_stats);
+}
+
+void
+StatsScope::SetThreads(int numThreads, std::vector<double> const & busyTimes) {
+
+    double busyTime = 0.0;
+    for (int i = 0; i < (int)busyTimes.size(); ++i) {
+        busyTime += busyTimes[i];
+    }
+    SetThreads(numThreads, busyTime);
+}
+
+} // end namespace internal
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
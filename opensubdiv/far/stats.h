@@ -0,0 +1,161 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#ifndef OPENSUBDIV3_FAR_STATS_H
+#define OPENSUBDIV3_FAR_STATS_H
+
+#include "../version.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+/// \brief Performance counters of a single factory or evaluator call
+///
+/// Byte counts are estimates of the traffic to the tables and primvar
+/// buffers, computed from the sizes of the inputs and outputs : they do not
+/// account for caching.
+///
+struct Stats {
+    char const * name;          ///< Name of the function (e.g. "Osd::CpuEvaluator::EvalStencils")
+    double wallTime;            ///< Elapsed time of the call, in seconds
+    size_t numItems;            ///< Number of stencils, patches or patch coords processed
+    size_t numWeights;          ///< Number of weights applied or generated
+    size_t bytesRead;           ///< Estimated number of bytes read
+    size_t bytesWritten;        ///< Estimated number of bytes written
+    int numThreads;             ///< Number of threads that took part in the call
+    double threadUtilization;   ///< Fraction of the thread time spent working [0,1]
+};
+
+
+/// \brief The stats callback function type
+typedef void (*StatsCallbackFunc)(Stats const & stats, void * clientData);
+
+/// \brief Sets the stats callback function (default is none)
+///
+/// Far factories and Osd CPU evaluators report a Stats record for each call
+/// once a callback is set, and skip all measurements otherwise. Set the
+/// callback to 0 to disable the instrumentation.
+///
+/// \note This function is not thread-safe ! The callback itself may be
+///       invoked concurrently from the threads that call the evaluators.
+///
+/// @param func        function pointer to the callback function
+///
+/// @param clientData  pointer passed back to the callback function
+///
+void SetStatsCallback(StatsCallbackFunc func, void * clientData = 0);
+
+/// \brief Returns true if a stats callback is set
+bool IsStatsEnabled();
+
+
+namespace internal {
+
+/// \brief Returns the time of a monotonic clock, in seconds (internal use only)
+double GetStatsTime();
+
+/// \brief Sends a Stats record to the callback (internal use only)
+void ReportStats(Stats const & stats);
+
+/// \brief Measures a call and reports its Stats on destruction (internal use
+///        only)
+///
+/// The scope does nothing when no callback was set at construction.
+///
+class StatsScope {
+public:
+    explicit StatsScope(char const * name);
+
+    ~StatsScope();
+
+    /// \brief Returns true if the call is being measured
+    bool IsEnabled() const { return _enabled; }
+
+    /// \brief Returns the record to fill (counts are zero initially)
+    Stats & GetStats() { return _stats; }
+
+    /// \brief Sets the counts of the call
+    void SetCounts(size_t numItems, size_t numWeights,
+                   size_t bytesRead, size_t bytesWritten) {
+        _stats.numItems = numItems;
+        _stats.numWeights = numWeights;
+        _stats.bytesRead = bytesRead;
+        _stats.bytesWritten = bytesWritten;
+    }
+
+    /// \brief Sets the number of threads and the sum of their busy times
+    ///        (the utilization is computed against the wall time)
+    void SetThreads(int numThreads, double busyTime) {
+        _stats.numThreads = numThreads;
+        _busyTime = busyTime;
+    }
+
+    /// \brief Sums the busy times recorded per partition (see StatsTimer)
+    void SetThreads(int numThreads, std::vector<double> const & busyTimes);
+
+private:
+    // not copyable
+    StatsScope(StatsScope const &);
+    StatsScope & operator=(StatsScope const &);
+
+    bool _enabled;
+    double _start,
+           _busyTime;
+    Stats _stats;
+};
+
+/// \brief Adds the time elapsed during its lifetime to a counter, if any
+///        (internal use only)
+class StatsTimer {
+public:
+    explicit StatsTimer(double * busyTime) :
+        _busyTime(busyTime), _start(busyTime ? GetStatsTime() : 0.0) { }
+
+    ~StatsTimer() {
+        if (_busyTime) {
+            *_busyTime += GetStatsTime() - _start;
+        }
+    }
+
+private:
+    double * _busyTime;
+    double _start;
+};
+
+} // end namespace internal
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // OPENSUBDIV3_FAR_STATS_H
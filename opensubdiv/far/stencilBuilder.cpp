@@ -24,6 +24,8 @@
 
 #include "../far/stencilBuilder.h"
 #include "../far/topologyRefiner.h"
+
+#include <cassert>
  
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -37,45 +39,89 @@ namespace {
 #pragma warning disable 1572
 #endif
 
-    inline bool isWeightZero(float w) { return (w == 0.0f); }
+    template <typename REAL>
+    inline bool isWeightZero(REAL w) { return (w == (REAL)0.0); }
 
 #ifdef __INTEL_COMPILER
 #pragma warning (pop)
 #endif
 }
 
+template <typename REAL>
 struct PointDerivWeight {
-    float p;
-    float du;
-    float dv;
+    REAL p;
+    REAL du;
+    REAL dv;
 
     PointDerivWeight() 
-        : p(0.0f), du(0.0f), dv(0.0f)
+        : p(0.0), du(0.0), dv(0.0)
     { }
-    PointDerivWeight(float w) 
+    PointDerivWeight(REAL w) 
         : p(w), du(w), dv(w)
     { }
-    PointDerivWeight(float w, float wDu, float wDv) 
+    PointDerivWeight(REAL w, REAL wDu, REAL wDv) 
         : p(w), du(wDu), dv(wDv)
     { }
 
-    friend PointDerivWeight operator*(PointDerivWeight lhs,
-                                      PointDerivWeight const& rhs) {
+    friend PointDerivWeight<REAL> operator*(PointDerivWeight<REAL> lhs,
+                                      PointDerivWeight<REAL> const& rhs) {
+        lhs.p *= rhs.p;
+        lhs.du *= rhs.du;
+        lhs.dv *= rhs.dv;
+        return lhs;
+    }
+    PointDerivWeight<REAL>& operator+=(PointDerivWeight<REAL> const& rhs) {
+        p += rhs.p;
+        du += rhs.du;
+        dv += rhs.dv;
+        return *this;
+    }
+};
+
+template <typename REAL>
+struct Point2ndDerivWeight {
+    REAL p;
+    REAL du;
+    REAL dv;
+    REAL duu;
+    REAL duv;
+    REAL dvv;
+
+    Point2ndDerivWeight()
+        : p(0.0), du(0.0), dv(0.0), duu(0.0), duv(0.0), dvv(0.0)
+    { }
+    Point2ndDerivWeight(REAL w)
+        : p(w), du(w), dv(w), duu(w), duv(w), dvv(w)
+    { }
+    Point2ndDerivWeight(REAL w, REAL wDu, REAL wDv,
+                        REAL wDuu, REAL wDuv, REAL wDvv)
+        : p(w), du(wDu), dv(wDv), duu(wDuu), duv(wDuv), dvv(wDvv)
+    { }
+
+    friend Point2ndDerivWeight<REAL> operator*(Point2ndDerivWeight<REAL> lhs,
+                                      Point2ndDerivWeight<REAL> const& rhs) {
         lhs.p *= rhs.p;
         lhs.du *= rhs.du;
         lhs.dv *= rhs.dv;
+        lhs.duu *= rhs.duu;
+        lhs.duv *= rhs.duv;
+        lhs.dvv *= rhs.dvv;
         return lhs;
     }
-    PointDerivWeight& operator+=(PointDerivWeight const& rhs) {
+    Point2ndDerivWeight<REAL>& operator+=(Point2ndDerivWeight<REAL> const& rhs) {
         p += rhs.p;
         du += rhs.du;
         dv += rhs.dv;
+        duu += rhs.duu;
+        duv += rhs.duv;
+        dvv += rhs.dvv;
         return *this;
     }
 };
 
 /// Stencil table constructor set.
 ///
+template <typename REAL>
 class WeightTable {
 public:
     WeightTable(int coarseVerts, 
@@ -85,6 +131,9 @@ public:
         , _lastOffset(0)
         , _coarseVertCount(coarseVerts)
         , _compactWeights(compactWeights)
+        , _source(this)
+        , _firstDest(0)
+        , _hashedOffset(-1)
     {
         // These numbers were chosen by profiling production assets at uniform
         // level 3.
@@ -117,6 +166,57 @@ public:
         _lastOffset = _size - 1;
     }
 
+    // Constructs an empty table that resolves the stencils of its source
+    // vertices in another table : tables built concurrently for disjoint
+    // ranges of destination vertices are then stitched with Append().
+    WeightTable(WeightTable const * source)
+        : _size(0)
+        , _lastOffset(0)
+        , _coarseVertCount(source->_coarseVertCount)
+        , _compactWeights(source->_compactWeights)
+        , _source(source)
+        , _firstDest(0)
+        , _hashedOffset(-1)
+    {
+        assert(source->_source == source);
+    }
+
+    // Appends the stencils of a table constructed from this one (the
+    // stencils are laid out as if they had been added to this table)
+    void Append(WeightTable const & other)
+    {
+        assert(other._source == this);
+
+        int base = static_cast<int>(_sources.size());
+
+        _dests.insert(_dests.end(), other._dests.begin(), other._dests.end());
+        _sources.insert(_sources.end(),
+                        other._sources.begin(), other._sources.end());
+        append(_weights, other._weights);
+        append(_duWeights, other._duWeights);
+        append(_dvWeights, other._dvWeights);
+        append(_duuWeights, other._duuWeights);
+        append(_duvWeights, other._duvWeights);
+        append(_dvvWeights, other._dvvWeights);
+
+        int numDests = static_cast<int>(other._indices.size());
+        if (other._firstDest + numDests > (int)_indices.size()) {
+            _indices.resize(other._firstDest + numDests);
+            _sizes.resize(other._firstDest + numDests);
+        }
+        for (int i = 0; i < numDests; ++i) {
+            if (other._sizes[i] > 0) {
+                _indices[other._firstDest + i] = base + other._indices[i];
+                _sizes[other._firstDest + i] = other._sizes[i];
+            }
+        }
+
+        if (not other._dests.empty()) {
+            _lastOffset = base + other._lastOffset;
+        }
+        _size += other._size;
+    }
+
     template <class W, class WACCUM>
     void AddWithWeight(int src, int dest, W weight, WACCUM weights) 
     {
@@ -137,18 +237,18 @@ public:
         // verts (src itself is made up of many control vert weights). 
         //
         // Find the src stencil and number of contributing CVs.
-        int len = _sizes[src];
-        int start = _indices[src];
+        int len = _source->_sizes[src];
+        int start = _source->_indices[src];
 
         for (int i = start; i < start+len; i++) {
             // Invariant: by processing each level in order and each vertex in
             // dependent order, any src stencil vertex reference is guaranteed
             // to consist only of coarse verts: therefore resolving src verts
             // must yield verts in the coarse mesh.
-            assert(_sources[i] < _coarseVertCount);
+            assert(_source->_sources[i] < _coarseVertCount);
 
             // Merge each of src's contributing verts into this stencil.
-            merge(_sources[i], dest, weights.Get(i), weight, 
+            merge(_source->_sources[i], dest, weights.Get(i), weight, 
                                 _lastOffset, _size, weights);
         }
     }
@@ -158,39 +258,74 @@ public:
     public:
         PointDerivAccumulator(WeightTable* tbl) : _tbl(tbl)
         { }
-        void PushBack(PointDerivWeight weight) {
+        void PushBack(PointDerivWeight<REAL> weight) {
             _tbl->_weights.push_back(weight.p);
             _tbl->_duWeights.push_back(weight.du);
             _tbl->_dvWeights.push_back(weight.dv);
         }
-        void Add(size_t i, PointDerivWeight weight) {
+        void Add(size_t i, PointDerivWeight<REAL> weight) {
             _tbl->_weights[i] += weight.p;
             _tbl->_duWeights[i] += weight.du;
             _tbl->_dvWeights[i] += weight.dv;
         }
-        PointDerivWeight Get(size_t index) {
-            return PointDerivWeight(_tbl->_weights[index], 
-                                    _tbl->_duWeights[index],
-                                    _tbl->_dvWeights[index]);
+        PointDerivWeight<REAL> Get(size_t index) {
+            return PointDerivWeight<REAL>(_tbl->_source->_weights[index], 
+                                    _tbl->_source->_duWeights[index],
+                                    _tbl->_source->_dvWeights[index]);
         }
     };
     PointDerivAccumulator GetPointDerivAccumulator() { 
         return PointDerivAccumulator(this);
     };
 
+    class Point2ndDerivAccumulator {
+        WeightTable* _tbl;
+    public:
+        Point2ndDerivAccumulator(WeightTable* tbl) : _tbl(tbl)
+        { }
+        void PushBack(Point2ndDerivWeight<REAL> weight) {
+            _tbl->_weights.push_back(weight.p);
+            _tbl->_duWeights.push_back(weight.du);
+            _tbl->_dvWeights.push_back(weight.dv);
+            _tbl->_duuWeights.push_back(weight.duu);
+            _tbl->_duvWeights.push_back(weight.duv);
+            _tbl->_dvvWeights.push_back(weight.dvv);
+        }
+        void Add(size_t i, Point2ndDerivWeight<REAL> weight) {
+            _tbl->_weights[i] += weight.p;
+            _tbl->_duWeights[i] += weight.du;
+            _tbl->_dvWeights[i] += weight.dv;
+            _tbl->_duuWeights[i] += weight.duu;
+            _tbl->_duvWeights[i] += weight.duv;
+            _tbl->_dvvWeights[i] += weight.dvv;
+        }
+        Point2ndDerivWeight<REAL> Get(size_t index) {
+            WeightTable const * src = _tbl->_source;
+            return Point2ndDerivWeight<REAL>(src->_weights[index],
+                                    src->_duWeights[index],
+                                    src->_dvWeights[index],
+                                    src->_duuWeights[index],
+                                    src->_duvWeights[index],
+                                    src->_dvvWeights[index]);
+        }
+    };
+    Point2ndDerivAccumulator GetPoint2ndDerivAccumulator() {
+        return Point2ndDerivAccumulator(this);
+    };
+
     class ScalarAccumulator {
         WeightTable* _tbl;
     public:
         ScalarAccumulator(WeightTable* tbl) : _tbl(tbl)
         { }
-        void PushBack(PointDerivWeight weight) {
+        void PushBack(PointDerivWeight<REAL> weight) {
             _tbl->_weights.push_back(weight.p);
         }
-        void Add(size_t i, float w) {
+        void Add(size_t i, REAL w) {
             _tbl->_weights[i] += w;
         }
-        float Get(size_t index) {
-            return _tbl->_weights[index];
+        REAL Get(size_t index) {
+            return _tbl->_source->_weights[index];
         }
     };
     ScalarAccumulator GetScalarAccumulator() { 
@@ -206,21 +341,34 @@ public:
     std::vector<int> const&
     GetSources() const { return _sources; }
 
-    std::vector<float> const&
+    std::vector<REAL> const&
     GetWeights() const { return _weights; }
 
-    std::vector<float> const&
+    std::vector<REAL> const&
     GetDuWeights() const { return _duWeights; }
 
-    std::vector<float> const&
+    std::vector<REAL> const&
     GetDvWeights() const { return _dvWeights; }
 
+    std::vector<REAL> const&
+    GetDuuWeights() const { return _duuWeights; }
+
+    std::vector<REAL> const&
+    GetDuvWeights() const { return _duvWeights; }
+
+    std::vector<REAL> const&
+    GetDvvWeights() const { return _dvvWeights; }
+
     void SetCoarseVertCount(int numVerts) {
         _coarseVertCount = numVerts;
     }
 
 private:
 
+    static void append(std::vector<REAL> & dst, std::vector<REAL> const & src) {
+        dst.insert(dst.end(), src.begin(), src.end());
+    }
+
     // Merge a vertex weight into the stencil table, if there is an existing
     // weight for a given source vertex it will be combined.
     //
@@ -241,6 +389,18 @@ private:
         // compacted, do not attempt to combine weights.
         if (_compactWeights and !_dests.empty() and _dests[lastOffset] == dst) {
 
+            // Large stencils (e.g. around high valence vertices) look their
+            // sources up in a hash table rather than scanning their entries.
+            if (tableSize - lastOffset >= hashedStencilSize) {
+                int i = findSource(src, lastOffset, tableSize);
+                if (i >= 0) {
+                    weights.Add(i, weight*weightFactor);
+                    return;
+                }
+                add(src, dst, weight*weightFactor, weights);
+                return;
+            }
+
             // tableSize is exactly _sources.size(), but using tableSize is
             // significantly faster.
             for (int i = lastOffset; i < tableSize; i++) {
@@ -258,6 +418,60 @@ private:
         add(src, dst, weight*weightFactor, weights);
     }
 
+    // Returns the entry of src in the stencil starting at lastOffset, or
+    // records that src is about to be added at tableSize and returns -1.
+    //
+    // The hash table is rebuilt from the entries of the stencil the first
+    // time that it is searched (or when it fills up) : the entries of a
+    // stencil are unique, so that the lookups find the same entries as the
+    // linear search.
+    int findSource(int src, int lastOffset, int tableSize)
+    {
+        if (_hashedOffset != lastOffset or
+                4*(tableSize - lastOffset + 1) > 2*(int)_hashTable.size()) {
+            hashSources(lastOffset, tableSize);
+        }
+
+        unsigned int mask = (unsigned int)_hashTable.size() - 1;
+        for (unsigned int slot = hashSource(src) & mask; ;
+                slot = (slot + 1) & mask) {
+            int i = _hashTable[slot];
+            if (i < 0) {
+                _hashTable[slot] = tableSize;
+                return -1;
+            }
+            if (_sources[i] == src) {
+                return i;
+            }
+        }
+    }
+
+    void hashSources(int lastOffset, int tableSize)
+    {
+        // keep the table at most half full
+        size_t size = 2 * hashedStencilSize;
+        while (size < 4 * (size_t)(tableSize - lastOffset + 1)) {
+            size *= 2;
+        }
+        _hashTable.assign(size, -1);
+        _hashedOffset = lastOffset;
+
+        unsigned int mask = (unsigned int)size - 1;
+        for (int i = lastOffset; i < tableSize; ++i) {
+            unsigned int slot = hashSource(_sources[i]) & mask;
+            while (_hashTable[slot] >= 0) {
+                slot = (slot + 1) & mask;
+            }
+            _hashTable[slot] = i;
+        }
+    }
+
+    static unsigned int hashSource(int src)
+    {
+        // Fibonacci hashing : consecutive sources are spread over the table
+        return ((unsigned int)src * 2654435769u) >> 7;
+    }
+
     // Add a new vertex weight to the stencil table.
     template <class W, class WACCUM>
     void add(int src, int dst, W weight, WACCUM weights)
@@ -272,13 +486,24 @@ private:
             // stencils can be directly looked up by their index in these
             // arrays. So here, ensure that they are large enough to hold the
             // new stencil about to be built.
-            if (dst+1 > (int)_indices.size()) {
-                _indices.resize(dst+1);
-                _sizes.resize(dst+1);
+            //
+            // Tables stitched with Append() start at their first stencil.
+            if (_source != this) {
+                if (_indices.empty()) {
+                    _firstDest = dst;
+                } else if (dst < _firstDest) {
+                    _indices.insert(_indices.begin(), _firstDest - dst, 0);
+                    _sizes.insert(_sizes.begin(), _firstDest - dst, 0);
+                    _firstDest = dst;
+                }
+            }
+            if (dst-_firstDest+1 > (int)_indices.size()) {
+                _indices.resize(dst-_firstDest+1);
+                _sizes.resize(dst-_firstDest+1);
             }
             // Initialize the new stencil's meta-data (offset, size).
-            _indices[dst] = static_cast<int>(_sources.size());
-            _sizes[dst] = 0;
+            _indices[dst-_firstDest] = static_cast<int>(_sources.size());
+            _sizes[dst-_firstDest] = 0;
             // Keep track of where the current stencil begins, which lets us
             // avoid having to look it up later.
             _lastOffset = static_cast<int>(_sources.size());
@@ -288,7 +513,7 @@ private:
         _size++;
 
         // Increment the current stencil element size.
-        _sizes[dst]++;
+        _sizes[dst-_firstDest]++;
         // Track this element as belonging to the stencil "dst".
         _dests.push_back(dst);
 
@@ -305,9 +530,12 @@ private:
 
     // The actual stencil data.
     std::vector<int> _sources;
-    std::vector<float> _weights;
-    std::vector<float> _duWeights;
-    std::vector<float> _dvWeights;
+    std::vector<REAL> _weights;
+    std::vector<REAL> _duWeights;
+    std::vector<REAL> _dvWeights;
+    std::vector<REAL> _duuWeights;
+    std::vector<REAL> _duvWeights;
+    std::vector<REAL> _dvvWeights;
 
     // Index data used to recover stencil-to-vertex mapping.
     std::vector<int> _indices;
@@ -318,31 +546,61 @@ private:
     int _lastOffset;
     int _coarseVertCount;
     bool _compactWeights;
+
+    // Table holding the stencils of the source vertices (this table, unless
+    // it is stitched to another one) and index of the first stencil.
+    WeightTable const * _source;
+    int _firstDest;
+
+    // Hash table of the sources of the current stencil, once it holds
+    // hashedStencilSize entries : entries are indices in _sources (or -1)
+    // and _hashedOffset is the offset of the stencil that they index.
+    static const int hashedStencilSize = 32;
+
+    std::vector<int> _hashTable;
+    int _hashedOffset;
 };
 
-StencilBuilder::StencilBuilder(int coarseVertCount, 
+template <typename REAL>
+StencilBuilder<REAL>::StencilBuilder(int coarseVertCount, 
                                bool genCtrlVertStencils, 
                                bool compactWeights)
-        : _weightTable(new WeightTable(coarseVertCount, 
+        : _weightTable(new WeightTable<REAL>(coarseVertCount, 
                                    genCtrlVertStencils, 
                                    compactWeights))
 {
 }
 
-StencilBuilder::~StencilBuilder()
+template <typename REAL>
+StencilBuilder<REAL>::StencilBuilder(StencilBuilder const * source)
+        : _weightTable(new WeightTable<REAL>(source->_weightTable))
+{
+}
+
+template <typename REAL>
+void
+StencilBuilder<REAL>::Append(StencilBuilder const & other)
+{
+    _weightTable->Append(*other._weightTable);
+}
+
+template <typename REAL>
+StencilBuilder<REAL>::~StencilBuilder()
 {
     delete _weightTable;
 }
 
+template <typename REAL>
 size_t
-StencilBuilder::GetNumVerticesTotal() const
+StencilBuilder<REAL>::GetNumVerticesTotal() const
 {
     return _weightTable->GetWeights().size();
 }
 
 
+template <typename REAL>
 int 
-StencilBuilder::GetNumVertsInStencil(size_t stencilIndex) const
+StencilBuilder<REAL>::GetNumVertsInStencil(size_t stencilIndex) const
 {
     if (stencilIndex > _weightTable->GetSizes().size() - 1)
         return 0;
@@ -350,44 +608,70 @@ StencilBuilder::GetNumVertsInStencil(size_t stencilIndex) const
     return (int)_weightTable->GetSizes()[stencilIndex];
 }
 
+template <typename REAL>
 void
-StencilBuilder::SetCoarseVertCount(int numVerts)
+StencilBuilder<REAL>::SetCoarseVertCount(int numVerts)
 {
     _weightTable->SetCoarseVertCount(numVerts);
 }
 
+template <typename REAL>
 std::vector<int> const&
-StencilBuilder::GetStencilOffsets() const { 
+StencilBuilder<REAL>::GetStencilOffsets() const { 
     return _weightTable->GetOffsets();
 }
 
+template <typename REAL>
 std::vector<int> const& 
-StencilBuilder::GetStencilSizes() const {
+StencilBuilder<REAL>::GetStencilSizes() const {
     return _weightTable->GetSizes();
 }
 
+template <typename REAL>
 std::vector<int> const&
-StencilBuilder::GetStencilSources() const {
+StencilBuilder<REAL>::GetStencilSources() const {
     return _weightTable->GetSources();
 }
 
-std::vector<float> const&
-StencilBuilder::GetStencilWeights() const {
+template <typename REAL>
+std::vector<REAL> const&
+StencilBuilder<REAL>::GetStencilWeights() const {
     return _weightTable->GetWeights();
 }
 
-std::vector<float> const&
-StencilBuilder::GetStencilDuWeights() const {
+template <typename REAL>
+std::vector<REAL> const&
+StencilBuilder<REAL>::GetStencilDuWeights() const {
     return _weightTable->GetDuWeights();
 }
 
-std::vector<float> const&
-StencilBuilder::GetStencilDvWeights() const {
+template <typename REAL>
+std::vector<REAL> const&
+StencilBuilder<REAL>::GetStencilDvWeights() const {
     return _weightTable->GetDvWeights();
 }
 
+template <typename REAL>
+std::vector<REAL> const&
+StencilBuilder<REAL>::GetStencilDuuWeights() const {
+    return _weightTable->GetDuuWeights();
+}
+
+template <typename REAL>
+std::vector<REAL> const&
+StencilBuilder<REAL>::GetStencilDuvWeights() const {
+    return _weightTable->GetDuvWeights();
+}
+
+template <typename REAL>
+std::vector<REAL> const&
+StencilBuilder<REAL>::GetStencilDvvWeights() const {
+    return _weightTable->GetDvvWeights();
+}
+
+template <typename REAL>
 void
-StencilBuilder::Index::AddWithWeight(Index const & src, float weight)
+StencilBuilder<REAL>::Index::AddWithWeight(Index const & src, REAL weight)
 {
     // Ignore no-op weights.
     if (isWeightZero(weight)) {
@@ -397,8 +681,9 @@ StencilBuilder::Index::AddWithWeight(Index const & src, float weight)
                                 _owner->_weightTable->GetScalarAccumulator());
 }
 
+template <typename REAL>
 void
-StencilBuilder::Index::AddWithWeight(Stencil const& src, float weight)
+StencilBuilder<REAL>::Index::AddWithWeight(StencilReal<REAL> const& src, REAL weight)
 {
     if (isWeightZero(weight)) {
         return;
@@ -406,25 +691,26 @@ StencilBuilder::Index::AddWithWeight(Stencil const& src, float weight)
 
     int srcSize = *src.GetSizePtr();
     Vtr::Index const * srcIndices = src.GetVertexIndices();
-    float const * srcWeights = src.GetWeights();
+    REAL const * srcWeights = src.GetWeights();
 
     for (int i = 0; i < srcSize; ++i) {
-        float w = srcWeights[i];
+        REAL w = srcWeights[i];
         if (isWeightZero(w)) {
             continue;
         }
 
         Vtr::Index srcIndex = srcIndices[i];
 
-        float wgt = weight * w;
+        REAL wgt = weight * w;
         _owner->_weightTable->AddWithWeight(srcIndex, _index, wgt,
                             _owner->_weightTable->GetScalarAccumulator());
     }  
 }
 
+template <typename REAL>
 void
-StencilBuilder::Index::AddWithWeight(Stencil const& src,
-                                     float weight, float du, float dv)
+StencilBuilder<REAL>::Index::AddWithWeight(StencilReal<REAL> const& src,
+                                     REAL weight, REAL du, REAL dv)
 {
     if (isWeightZero(weight) and isWeightZero(du) and isWeightZero(dv)) {
         return;
@@ -432,22 +718,58 @@ StencilBuilder::Index::AddWithWeight(Stencil const& src,
 
     int srcSize = *src.GetSizePtr();
     Vtr::Index const * srcIndices = src.GetVertexIndices();
-    float const * srcWeights = src.GetWeights();
+    REAL const * srcWeights = src.GetWeights();
 
     for (int i = 0; i < srcSize; ++i) {
-        float w = srcWeights[i];
+        REAL w = srcWeights[i];
         if (isWeightZero(w)) {
             continue;
         }
 
         Vtr::Index srcIndex = srcIndices[i];
 
-        PointDerivWeight wgt = PointDerivWeight(weight, du, dv) * w;
+        PointDerivWeight<REAL> wgt = PointDerivWeight<REAL>(weight, du, dv) * w;
         _owner->_weightTable->AddWithWeight(srcIndex, _index, wgt,
                            _owner->_weightTable->GetPointDerivAccumulator());
     }
 }
 
+template <typename REAL>
+void
+StencilBuilder<REAL>::Index::AddWithWeight(StencilReal<REAL> const& src,
+                                     REAL weight, REAL du, REAL dv,
+                                     REAL duu, REAL duv, REAL dvv)
+{
+    if (isWeightZero(weight) and isWeightZero(du) and isWeightZero(dv) and
+        isWeightZero(duu) and isWeightZero(duv) and isWeightZero(dvv)) {
+        return;
+    }
+
+    int srcSize = *src.GetSizePtr();
+    Vtr::Index const * srcIndices = src.GetVertexIndices();
+    REAL const * srcWeights = src.GetWeights();
+
+    for (int i = 0; i < srcSize; ++i) {
+        REAL w = srcWeights[i];
+        if (isWeightZero(w)) {
+            continue;
+        }
+
+        Vtr::Index srcIndex = srcIndices[i];
+
+        Point2ndDerivWeight<REAL> wgt =
+            Point2ndDerivWeight<REAL>(weight, du, dv, duu, duv, dvv) * w;
+        _owner->_weightTable->AddWithWeight(srcIndex, _index, wgt,
+           _owner->_weightTable->GetPoint2ndDerivAccumulator());
+    }
+}
+
+//
+//  Explicit instantiation for single and double precision stencils:
+//
+template class StencilBuilder<float>;
+template class StencilBuilder<double>;
+
 } // end namespace internal
 } // end namespace Far
 } // end namespace OPENSUBDIV_VERSION
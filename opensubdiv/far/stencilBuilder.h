@@ -36,15 +36,28 @@ namespace OPENSUBDIV_VERSION {
 namespace Far {
 namespace internal {
 
+template <typename REAL>
 class WeightTable;
 
+template <typename REAL>
 class StencilBuilder {
 public:
     StencilBuilder(int coarseVertCount, 
                    bool genCtrlVertStencils=true,
                    bool compactWeights=true);
+
+    // Constructs an empty builder that reads the stencils of its source
+    // vertices from another builder. Builders constructed from the same
+    // source can run concurrently on disjoint sets of vertices : their
+    // stencils are then appended to the source with Append(), in the order
+    // in which they would have been added to it.
+    StencilBuilder(StencilBuilder const * source);
+
     ~StencilBuilder();
 
+    // Appends the stencils of a builder constructed from this one.
+    void Append(StencilBuilder const & other);
+
     // TODO: noncopyable.
 
     size_t GetNumVerticesTotal() const;
@@ -63,9 +76,12 @@ public:
     std::vector<int> const& GetStencilSources() const;
 
     // The individual vertex weights, each weight is paired with one source.
-    std::vector<float> const& GetStencilWeights() const;
-    std::vector<float> const& GetStencilDuWeights() const;
-    std::vector<float> const& GetStencilDvWeights() const;
+    std::vector<REAL> const& GetStencilWeights() const;
+    std::vector<REAL> const& GetStencilDuWeights() const;
+    std::vector<REAL> const& GetStencilDvWeights() const;
+    std::vector<REAL> const& GetStencilDuuWeights() const;
+    std::vector<REAL> const& GetStencilDuvWeights() const;
+    std::vector<REAL> const& GetStencilDvvWeights() const;
 
     // Vertex Facade.
     class Index {
@@ -76,12 +92,17 @@ public:
         {}
 
         // Add with point/vertex weight only.
-        void AddWithWeight(Index const & src, float weight);
-        void AddWithWeight(Stencil const& src, float weight);
+        void AddWithWeight(Index const & src, REAL weight);
+        void AddWithWeight(StencilReal<REAL> const& src, REAL weight);
 
         // Add with first derivative.
-        void AddWithWeight(Stencil const& src,
-                                     float weight, float du, float dv);
+        void AddWithWeight(StencilReal<REAL> const& src,
+                                     REAL weight, REAL du, REAL dv);
+
+        // Add with first and second derivatives.
+        void AddWithWeight(StencilReal<REAL> const& src,
+                                     REAL weight, REAL du, REAL dv,
+                                     REAL duu, REAL duv, REAL dvv);
 
         Index operator[](int index) const {
             return Index(_owner, index+_index);
@@ -96,7 +117,7 @@ public:
     };
 
 private:
-    WeightTable* _weightTable;
+    WeightTable<REAL>* _weightTable;
 };
 
 } // end namespace internal
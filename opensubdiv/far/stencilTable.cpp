@@ -32,6 +32,7 @@ namespace Far {
 
 
 namespace {
+    template <typename REAL>
     void
     copyStencilData(int numControlVerts,
                     bool includeCoarseVerts,
@@ -42,14 +43,35 @@ namespace {
                     std::vector<int> *        _sizes,
                     std::vector<int> const*    sources,
                     std::vector<int> *        _sources,
-                    std::vector<float> const*  weights,
-                    std::vector<float> *      _weights,
-                    std::vector<float> const*  duWeights=NULL,
-                    std::vector<float> *      _duWeights=NULL,
-                    std::vector<float> const*  dvWeights=NULL,
-                    std::vector<float> *      _dvWeights=NULL) {
+                    std::vector<REAL> const*  weights,
+                    std::vector<REAL> *      _weights,
+                    std::vector<REAL> const*  duWeights=NULL,
+                    std::vector<REAL> *      _duWeights=NULL,
+                    std::vector<REAL> const*  dvWeights=NULL,
+                    std::vector<REAL> *      _dvWeights=NULL,
+                    std::vector<REAL> const*  duuWeights=NULL,
+                    std::vector<REAL> *      _duuWeights=NULL,
+                    std::vector<REAL> const*  duvWeights=NULL,
+                    std::vector<REAL> *      _duvWeights=NULL,
+                    std::vector<REAL> const*  dvvWeights=NULL,
+                    std::vector<REAL> *      _dvvWeights=NULL) {
         size_t start = includeCoarseVerts ? 0 : firstOffset;
 
+        ReserveHugePages(*_offsets, offsets->size());
+        ReserveHugePages(*_sizes, sizes->size());
+        ReserveHugePages(*_sources, sources->size());
+        ReserveHugePages(*_weights, weights->size());
+        if (_duWeights)
+            ReserveHugePages(*_duWeights, duWeights->size());
+        if (_dvWeights)
+            ReserveHugePages(*_dvWeights, dvWeights->size());
+        if (_duuWeights)
+            ReserveHugePages(*_duuWeights, duuWeights->size());
+        if (_duvWeights)
+            ReserveHugePages(*_duvWeights, duvWeights->size());
+        if (_dvvWeights)
+            ReserveHugePages(*_dvvWeights, dvvWeights->size());
+
         _offsets->resize(offsets->size());
         _sizes->resize(sizes->size());
         _sources->resize(sources->size());
@@ -58,6 +80,12 @@ namespace {
             _duWeights->resize(duWeights->size());
         if (_dvWeights)
             _dvWeights->resize(dvWeights->size());
+        if (_duuWeights)
+            _duuWeights->resize(duuWeights->size());
+        if (_duvWeights)
+            _duvWeights->resize(duvWeights->size());
+        if (_dvvWeights)
+            _dvvWeights->resize(dvvWeights->size());
 
         // The stencils are probably not in order, so we must copy/sort them.
         // Note here that loop index 'i' represents stencil_i for vertex_i.
@@ -82,15 +110,27 @@ namespace {
             std::memcpy(&(*_sources)[curOffset],
                         &(*sources)[off], sz*sizeof(int));
             std::memcpy(&(*_weights)[curOffset],
-                        &(*weights)[off], sz*sizeof(float));
+                        &(*weights)[off], sz*sizeof(REAL));
 
             if (_duWeights) {
                 std::memcpy(&(*_duWeights)[curOffset],
-                            &(*duWeights)[off], sz*sizeof(float));
+                            &(*duWeights)[off], sz*sizeof(REAL));
             }
             if (_dvWeights) {
                 std::memcpy(&(*_dvWeights)[curOffset],
-                        &(*dvWeights)[off], sz*sizeof(float));
+                        &(*dvWeights)[off], sz*sizeof(REAL));
+            }
+            if (_duuWeights) {
+                std::memcpy(&(*_duuWeights)[curOffset],
+                        &(*duuWeights)[off], sz*sizeof(REAL));
+            }
+            if (_duvWeights) {
+                std::memcpy(&(*_duvWeights)[curOffset],
+                        &(*duvWeights)[off], sz*sizeof(REAL));
+            }
+            if (_dvvWeights) {
+                std::memcpy(&(*_dvvWeights)[curOffset],
+                        &(*dvvWeights)[off], sz*sizeof(REAL));
             }
 
             curOffset += sz;
@@ -106,14 +146,21 @@ namespace {
             _duWeights->resize(weightCount);
         if (_dvWeights)
             _dvWeights->resize(weightCount);
+        if (_duuWeights)
+            _duuWeights->resize(weightCount);
+        if (_duvWeights)
+            _duvWeights->resize(weightCount);
+        if (_dvvWeights)
+            _dvvWeights->resize(weightCount);
     }
 };
 
-StencilTable::StencilTable(int numControlVerts,
+template <typename REAL>
+StencilTableReal<REAL>::StencilTableReal(int numControlVerts,
                            std::vector<int> const& offsets,
                            std::vector<int> const& sizes,
                            std::vector<int> const& sources,
-                           std::vector<float> const& weights,
+                           std::vector<REAL> const& weights,
                            bool includeCoarseVerts,
                            size_t firstOffset)
     : _numControlVertices(numControlVerts) {
@@ -126,8 +173,9 @@ StencilTable::StencilTable(int numControlVerts,
                     &weights, &_weights);
 }
 
+template <typename REAL>
 void
-StencilTable::Clear() {
+StencilTableReal<REAL>::Clear() {
     _numControlVertices=0;
     _sizes.clear();
     _offsets.clear();
@@ -135,34 +183,55 @@ StencilTable::Clear() {
     _weights.clear();
 }
 
-LimitStencilTable::LimitStencilTable(int numControlVerts,
+template <typename REAL>
+LimitStencilTableReal<REAL>::LimitStencilTableReal(int numControlVerts,
                                      std::vector<int> const& offsets,
                                      std::vector<int> const& sizes,
                                      std::vector<int> const& sources,
-                                     std::vector<float> const& weights,
-                                     std::vector<float> const& duWeights,
-                                     std::vector<float> const& dvWeights,
+                                     std::vector<REAL> const& weights,
+                                     std::vector<REAL> const& duWeights,
+                                     std::vector<REAL> const& dvWeights,
+                                     std::vector<REAL> const& duuWeights,
+                                     std::vector<REAL> const& duvWeights,
+                                     std::vector<REAL> const& dvvWeights,
                                      bool includeCoarseVerts,
                                      size_t firstOffset)
-    : StencilTable(numControlVerts) {
+    : StencilTableReal<REAL>(numControlVerts) {
+    // derivative weights that were not generated are left empty
     copyStencilData(numControlVerts,
                     includeCoarseVerts,
                     firstOffset,
-                    &offsets, &_offsets,
-                    &sizes, &_sizes,
-                    &sources, &_indices,
-                    &weights, &_weights,
-                    &duWeights, &_duWeights,
-                    &dvWeights, &_dvWeights);
+                    &offsets, &this->_offsets,
+                    &sizes, &this->_sizes,
+                    &sources, &this->_indices,
+                    &weights, &this->_weights,
+                    &duWeights, duWeights.empty() ? NULL : &_duWeights,
+                    &dvWeights, dvWeights.empty() ? NULL : &_dvWeights,
+                    &duuWeights, duuWeights.empty() ? NULL : &_duuWeights,
+                    &duvWeights, duvWeights.empty() ? NULL : &_duvWeights,
+                    &dvvWeights, dvvWeights.empty() ? NULL : &_dvvWeights);
 }
 
+template <typename REAL>
 void
-LimitStencilTable::Clear() {
-    StencilTable::Clear();
+LimitStencilTableReal<REAL>::Clear() {
+    StencilTableReal<REAL>::Clear();
     _duWeights.clear();
     _dvWeights.clear();
+    _duuWeights.clear();
+    _duvWeights.clear();
+    _dvvWeights.clear();
 }
 
+//
+//  Explicit instantiation for single and double precision tables:
+//
+template class StencilTableReal<float>;
+template class StencilTableReal<double>;
+
+template class LimitStencilTableReal<float>;
+template class LimitStencilTableReal<double>;
+
 
 } // end namespace Far
 
@@ -27,6 +27,7 @@
 
 #include "../version.h"
 
+#include "../far/allocator.h"
 #include "../far/types.h"
 
 #include <cassert>
@@ -39,16 +40,25 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Far {
 
+// Forward declarations for friends:
+class PatchTableFactory;
+template <typename REAL> class StencilTableFactoryReal;
+template <typename REAL> class LimitStencilTableFactoryReal;
+
 /// \brief Vertex stencil descriptor
 ///
 /// Allows access and manipulation of a single stencil in a StencilTable.
 ///
-class Stencil {
+/// The precision of the weights is given by the REAL template parameter :
+/// Stencil is the single precision descriptor.
+///
+template <typename REAL>
+class StencilReal {
 
 public:
 
     /// \brief Default constructor
-    Stencil() {}
+    StencilReal() {}
 
     /// \brief Constructor
     ///
@@ -58,16 +68,16 @@ public:
     ///
     /// @param weights  Table pointer to the vertex weights of the stencil
     ///
-    Stencil(int * size,
-            Index * indices,
-            float * weights)
+    StencilReal(int * size,
+                Index * indices,
+                REAL * weights)
         : _size(size),
           _indices(indices),
           _weights(weights) {
     }
 
     /// \brief Copy constructor
-    Stencil(Stencil const & other) {
+    StencilReal(StencilReal const & other) {
         _size = other._size;
         _indices = other._indices;
         _weights = other._weights;
@@ -89,7 +99,7 @@ public:
     }
 
     /// \brief Returns the interpolation weights
-    float const * GetWeights() const {
+    REAL const * GetWeights() const {
         return _weights;
     }
 
@@ -102,12 +112,43 @@ public:
     }
 
 protected:
-    friend class StencilTableFactory;
-    friend class LimitStencilTableFactory;
+    friend class StencilTableFactoryReal<REAL>;
+    friend class LimitStencilTableFactoryReal<REAL>;
 
     int * _size;
     Index         * _indices;
-    float         * _weights;
+    REAL          * _weights;
+};
+
+/// \brief Vertex stencil descriptor (single precision)
+///
+class Stencil : public StencilReal<float> {
+protected:
+    typedef StencilReal<float> BaseStencil;
+
+public:
+
+    /// \brief Default constructor
+    Stencil() : BaseStencil() {}
+
+    /// \brief Constructor
+    ///
+    /// @param size     Table pointer to the size of the stencil
+    ///
+    /// @param indices  Table pointer to the vertex indices of the stencil
+    ///
+    /// @param weights  Table pointer to the vertex weights of the stencil
+    ///
+    Stencil(int * size,
+            Index * indices,
+            float * weights)
+        : BaseStencil(size, indices, weights) {
+    }
+
+    /// \brief Conversion from the base class
+    Stencil(BaseStencil const & other)
+        : BaseStencil(other) {
+    }
 };
 
 /// \brief Table of subdivision stencils.
@@ -122,19 +163,26 @@ protected:
 /// recomputed simply by applying the blending weights to the series of coarse
 /// control vertices.
 ///
-class StencilTable {
-    StencilTable(int numControlVerts,
+/// The precision of the weights is given by the REAL template parameter :
+/// StencilTable is the single precision table, StencilTableReal<double> can be
+/// created with StencilTableFactoryReal<double> for assets whose coordinates
+/// exceed the precision of floats.
+///
+template <typename REAL>
+class StencilTableReal {
+protected:
+    StencilTableReal(int numControlVerts,
                     std::vector<int> const& offsets,
                     std::vector<int> const& sizes,
                     std::vector<int> const& sources,
-                    std::vector<float> const& weights,
+                    std::vector<REAL> const& weights,
                     bool includeCoarseVerts,
                     size_t firstOffset);
 
 public:
 
-    virtual ~StencilTable() {};
-    
+    virtual ~StencilTableReal() {};
+
     /// \brief Returns the number of stencils in the table
     int GetNumStencils() const {
         return (int)_sizes.size();
@@ -146,7 +194,7 @@ public:
     }
 
     /// \brief Returns a Stencil at index i in the table
-    Stencil GetStencil(Index i) const;
+    StencilReal<REAL> GetStencil(Index i) const;
 
     /// \brief Returns the number of control vertices of each stencil in the table
     std::vector<int> const & GetSizes() const {
@@ -164,12 +212,12 @@ public:
     }
 
     /// \brief Returns the stencil interpolation weights
-    std::vector<float> const & GetWeights() const {
+    std::vector<REAL> const & GetWeights() const {
         return _weights;
     }
 
     /// \brief Returns the stencil at index i in the table
-    Stencil operator[] (Index index) const;
+    StencilReal<REAL> operator[] (Index index) const;
 
     /// \brief Updates point values based on the control values
     ///
@@ -197,7 +245,7 @@ protected:
 
     // Update values by applying cached stencil weights to new control values
     template <class T> void update( T const *controlValues, T *values,
-        std::vector<float> const & valueWeights, Index start, Index end) const;
+        std::vector<REAL> const & valueWeights, Index start, Index end) const;
 
     // Populate the offsets table from the stencil sizes in _sizes (factory helper)
     void generateOffsets();
@@ -214,13 +262,16 @@ protected:
     // Performs any final operations on internal tables (factory helper)
     void finalize();
 
+    // Advises huge pages for the large table arrays (factory helper)
+    void adviseHugePages() const;
+
 protected:
-    StencilTable() : _numControlVertices(0) {}
-    StencilTable(int numControlVerts)
-        : _numControlVertices(numControlVerts) 
+    StencilTableReal() : _numControlVertices(0) {}
+    StencilTableReal(int numControlVerts)
+        : _numControlVertices(numControlVerts)
     { }
 
-    friend class StencilTableFactory;
+    friend class StencilTableFactoryReal<REAL>;
     friend class PatchTableFactory;
     // XXX: temporarily, GregoryBasis class will go away.
     friend class GregoryBasis;
@@ -233,13 +284,54 @@ protected:
     std::vector<int> _sizes;    // number of coeffiecient for each stencil
     std::vector<Index>         _offsets,  // offset to the start of each stencil
                                _indices;  // indices of contributing coarse vertices
-    std::vector<float>         _weights;  // stencil weight coefficients
+    std::vector<REAL>          _weights;  // stencil weight coefficients
+};
+
+/// \brief Table of subdivision stencils (single precision)
+///
+class StencilTable : public StencilTableReal<float> {
+protected:
+    typedef StencilTableReal<float> BaseTable;
+
+public:
+
+    /// \brief Returns a Stencil at index i in the table
+    Stencil GetStencil(Index index) const {
+        return Stencil(BaseTable::GetStencil(index));
+    }
+
+    /// \brief Returns the stencil at index i in the table
+    Stencil operator[] (Index index) const {
+        return Stencil(BaseTable::GetStencil(index));
+    }
+
+protected:
+    StencilTable() : BaseTable() {}
+    StencilTable(int numControlVerts) : BaseTable(numControlVerts) {}
+    StencilTable(int numControlVerts,
+                    std::vector<int> const& offsets,
+                    std::vector<int> const& sizes,
+                    std::vector<int> const& sources,
+                    std::vector<float> const& weights,
+                    bool includeCoarseVerts,
+                    size_t firstOffset)
+        : BaseTable(numControlVerts, offsets, sizes, sources, weights,
+                    includeCoarseVerts, firstOffset) {}
+
+    friend class StencilTableFactoryReal<float>;
+    friend class PatchTableFactory;
+    // XXX: temporarily, GregoryBasis class will go away.
+    friend class GregoryBasis;
+    // XXX: needed to call reserve().
+    friend class EndCapBSplineBasisPatchFactory;
+    friend class EndCapGregoryBasisPatchFactory;
 };
 
 
 /// \brief Limit point stencil descriptor
 ///
-class LimitStencil : public Stencil {
+template <typename REAL>
+class LimitStencilReal : public StencilReal<REAL> {
 
 public:
 
@@ -255,77 +347,157 @@ public:
     ///
     /// @param dvWeights Table pointer to the 'v' derivative weights
     ///
-    LimitStencil( int* size,
-                  Index * indices,
-                  float * weights,
-                  float * duWeights,
-                  float * dvWeights )
-        : Stencil(size, indices, weights),
+    /// @param duuWeights Table pointer to the 'uu' derivative weights
+    ///
+    /// @param duvWeights Table pointer to the 'uv' derivative weights
+    ///
+    /// @param dvvWeights Table pointer to the 'vv' derivative weights
+    ///
+    LimitStencilReal( int* size,
+                      Index * indices,
+                      REAL * weights,
+                      REAL * duWeights=0,
+                      REAL * dvWeights=0,
+                      REAL * duuWeights=0,
+                      REAL * duvWeights=0,
+                      REAL * dvvWeights=0 )
+        : StencilReal<REAL>(size, indices, weights),
           _duWeights(duWeights),
-          _dvWeights(dvWeights) {
+          _dvWeights(dvWeights),
+          _duuWeights(duuWeights),
+          _duvWeights(duvWeights),
+          _dvvWeights(dvvWeights) {
     }
 
     /// \brief
-    float const * GetDuWeights() const {
+    REAL const * GetDuWeights() const {
         return _duWeights;
     }
 
     /// \brief
-    float const * GetDvWeights() const {
+    REAL const * GetDvWeights() const {
         return _dvWeights;
     }
 
+    /// \brief
+    REAL const * GetDuuWeights() const {
+        return _duuWeights;
+    }
+
+    /// \brief
+    REAL const * GetDuvWeights() const {
+        return _duvWeights;
+    }
+
+    /// \brief
+    REAL const * GetDvvWeights() const {
+        return _dvvWeights;
+    }
+
     /// \brief Advance to the next stencil in the table
     void Next() {
-       int stride = *_size;
-       ++_size;
-       _indices += stride;
-       _weights += stride;
-       _duWeights += stride;
-       _dvWeights += stride;
+       int stride = *this->_size;
+       ++this->_size;
+       this->_indices += stride;
+       this->_weights += stride;
+       if (_duWeights) _duWeights += stride;
+       if (_dvWeights) _dvWeights += stride;
+       if (_duuWeights) _duuWeights += stride;
+       if (_duvWeights) _duvWeights += stride;
+       if (_dvvWeights) _dvvWeights += stride;
     }
 
 private:
 
-    friend class StencilTableFactory;
-    friend class LimitStencilTableFactory;
+    friend class StencilTableFactoryReal<REAL>;
+    friend class LimitStencilTableFactoryReal<REAL>;
 
-    float * _duWeights,  // pointer to stencil u derivative limit weights
-          * _dvWeights;  // pointer to stencil v derivative limit weights
+    REAL * _duWeights,  // pointer to stencil u derivative limit weights
+         * _dvWeights,  // pointer to stencil v derivative limit weights
+         * _duuWeights, // pointer to stencil uu derivative limit weights
+         * _duvWeights, // pointer to stencil uv derivative limit weights
+         * _dvvWeights; // pointer to stencil vv derivative limit weights
+};
+
+/// \brief Limit point stencil descriptor (single precision)
+///
+class LimitStencil : public LimitStencilReal<float> {
+protected:
+    typedef LimitStencilReal<float> BaseStencil;
+
+public:
+
+    /// \brief Constructor
+    LimitStencil( int* size,
+                  Index * indices,
+                  float * weights,
+                  float * duWeights=0,
+                  float * dvWeights=0,
+                  float * duuWeights=0,
+                  float * duvWeights=0,
+                  float * dvvWeights=0 )
+        : BaseStencil(size, indices, weights, duWeights, dvWeights,
+                      duuWeights, duvWeights, dvvWeights) {
+    }
+
+    /// \brief Conversion from the base class
+    LimitStencil(BaseStencil const & other)
+        : BaseStencil(other) {
+    }
 };
 
 /// \brief Table of limit subdivision stencils.
 ///
 ///
-class LimitStencilTable : public StencilTable {
-    LimitStencilTable(int numControlVerts,
+template <typename REAL>
+class LimitStencilTableReal : public StencilTableReal<REAL> {
+protected:
+    LimitStencilTableReal(int numControlVerts,
                     std::vector<int> const& offsets,
                     std::vector<int> const& sizes,
                     std::vector<int> const& sources,
-                    std::vector<float> const& weights,
-                    std::vector<float> const& duWeights,
-                    std::vector<float> const& dvWeights,
+                    std::vector<REAL> const& weights,
+                    std::vector<REAL> const& duWeights,
+                    std::vector<REAL> const& dvWeights,
+                    std::vector<REAL> const& duuWeights,
+                    std::vector<REAL> const& duvWeights,
+                    std::vector<REAL> const& dvvWeights,
                     bool includeCoarseVerts,
                     size_t firstOffset);
 
 public:
 
     /// \brief Returns a LimitStencil at index i in the table
-    LimitStencil GetLimitStencil(Index i) const;
+    LimitStencilReal<REAL> GetLimitStencil(Index i) const;
 
     /// \brief Returns the limit stencil at index i in the table
-    LimitStencil operator[] (Index index) const;
+    LimitStencilReal<REAL> operator[] (Index index) const;
 
     /// \brief Returns the 'u' derivative stencil interpolation weights
-    std::vector<float> const & GetDuWeights() const {
+    std::vector<REAL> const & GetDuWeights() const {
         return _duWeights;
     }
 
     /// \brief Returns the 'v' derivative stencil interpolation weights
-    std::vector<float> const & GetDvWeights() const {
+    std::vector<REAL> const & GetDvWeights() const {
         return _dvWeights;
     }
 
+    /// \brief Returns the 'uu' derivative stencil interpolation weights
+    std::vector<REAL> const & GetDuuWeights() const {
+        return _duuWeights;
+    }
+
+    /// \brief Returns the 'uv' derivative stencil interpolation weights
+    std::vector<REAL> const & GetDuvWeights() const {
+        return _duvWeights;
+    }
+
+    /// \brief Returns the 'vv' derivative stencil interpolation weights
+    std::vector<REAL> const & GetDvvWeights() const {
+        return _dvvWeights;
+    }
+
     /// \brief Updates derivative values based on the control values
     ///
     /// \note The destination buffers ('uderivs' & 'vderivs') are assumed to
@@ -347,33 +519,113 @@ public:
     void UpdateDerivs(T const *controlValues, T *uderivs, T *vderivs,
         int start=-1, int end=-1) const {
 
-        update(controlValues, uderivs, _duWeights, start, end);
-        update(controlValues, vderivs, _dvWeights, start, end);
+        this->update(controlValues, uderivs, _duWeights, start, end);
+        this->update(controlValues, vderivs, _dvWeights, start, end);
+    }
+
+    /// \brief Updates 2nd derivative values based on the control values
+    ///
+    /// \note The destination buffers ('uuderivs', 'uvderivs', & 'vvderivs')
+    ///       are assumed to have allocated at least \c GetNumStencils()
+    ///       elements, and the table must have been created with
+    ///       second derivatives (see LimitStencilTableFactory::Options).
+    ///
+    /// @param controlValues  Buffer with primvar data for the control vertices
+    ///
+    /// @param uuderivs       Destination buffer for the interpolated 'uu'
+    ///                       derivative primvar data
+    ///
+    /// @param uvderivs       Destination buffer for the interpolated 'uv'
+    ///                       derivative primvar data
+    ///
+    /// @param vvderivs       Destination buffer for the interpolated 'vv'
+    ///                       derivative primvar data
+    ///
+    /// @param start          (skip to )index of first value to update
+    ///
+    /// @param end            Index of last value to update
+    ///
+    template <class T>
+    void Update2ndDerivs(T const *controlValues,
+        T *uuderivs, T *uvderivs, T *vvderivs,
+        int start=-1, int end=-1) const {
+
+        this->update(controlValues, uuderivs, _duuWeights, start, end);
+        this->update(controlValues, uvderivs, _duvWeights, start, end);
+        this->update(controlValues, vvderivs, _dvvWeights, start, end);
     }
 
     /// \brief Clears the stencils from the table
     void Clear();
 
 private:
-    friend class LimitStencilTableFactory;
+    friend class StencilTableFactoryReal<REAL>;
+    friend class LimitStencilTableFactoryReal<REAL>;
 
     // Resize the table arrays (factory helper)
     void resize(int nstencils, int nelems);
 
+    // Advises huge pages for the large table arrays (factory helper)
+    void adviseHugePages() const;
+
 private:
-    std::vector<float>  _duWeights,  // u derivative limit stencil weights
-                        _dvWeights;  // v derivative limit stencil weights
+    std::vector<REAL>   _duWeights,  // u derivative limit stencil weights
+                        _dvWeights,  // v derivative limit stencil weights
+                        _duuWeights, // uu derivative limit stencil weights
+                        _duvWeights, // uv derivative limit stencil weights
+                        _dvvWeights; // vv derivative limit stencil weights
+};
+
+/// \brief Table of limit subdivision stencils (single precision)
+///
+class LimitStencilTable : public LimitStencilTableReal<float> {
+protected:
+    typedef LimitStencilTableReal<float> BaseTable;
+
+public:
+
+    /// \brief Returns a LimitStencil at index i in the table
+    LimitStencil GetLimitStencil(Index index) const {
+        return LimitStencil(BaseTable::GetLimitStencil(index));
+    }
+
+    /// \brief Returns the limit stencil at index i in the table
+    LimitStencil operator[] (Index index) const {
+        return LimitStencil(BaseTable::GetLimitStencil(index));
+    }
+
+protected:
+    LimitStencilTable(int numControlVerts,
+                    std::vector<int> const& offsets,
+                    std::vector<int> const& sizes,
+                    std::vector<int> const& sources,
+                    std::vector<float> const& weights,
+                    std::vector<float> const& duWeights,
+                    std::vector<float> const& dvWeights,
+                    std::vector<float> const& duuWeights,
+                    std::vector<float> const& duvWeights,
+                    std::vector<float> const& dvvWeights,
+                    bool includeCoarseVerts,
+                    size_t firstOffset)
+        : BaseTable(numControlVerts, offsets, sizes, sources,
+                    weights, duWeights, dvWeights,
+                    duuWeights, duvWeights, dvvWeights,
+                    includeCoarseVerts, firstOffset) {}
+
+    friend class StencilTableFactoryReal<float>;
+    friend class LimitStencilTableFactoryReal<float>;
 };
 
 
 // Update values by appling cached stencil weights to new control values
+template <typename REAL>
 template <class T> void
-StencilTable::update(T const *controlValues, T *values,
-    std::vector<float> const &valueWeights, Index start, Index end) const {
+StencilTableReal<REAL>::update(T const *controlValues, T *values,
+    std::vector<REAL> const &valueWeights, Index start, Index end) const {
 
     int const * sizes = &_sizes.at(0);
     Index const * indices = &_indices.at(0);
-    float const * weights = &valueWeights.at(0);
+    REAL const * weights = &valueWeights.at(0);
 
     if (start>0) {
         assert(start<(Index)_offsets.size());
@@ -400,8 +652,9 @@ StencilTable::update(T const *controlValues, T *values,
     }
 }
 
+template <typename REAL>
 inline void
-StencilTable::generateOffsets() {
+StencilTableReal<REAL>::generateOffsets() {
     Index offset=0;
     int noffsets = (int)_sizes.size();
     _offsets.resize(noffsets);
@@ -411,73 +664,108 @@ StencilTable::generateOffsets() {
     }
 }
 
+template <typename REAL>
 inline void
-StencilTable::resize(int nstencils, int nelems) {
+StencilTableReal<REAL>::resize(int nstencils, int nelems) {
     _sizes.resize(nstencils);
     _indices.resize(nelems);
     _weights.resize(nelems);
 }
 
+template <typename REAL>
 inline void
-StencilTable::reserve(int nstencils, int nelems) {
+StencilTableReal<REAL>::reserve(int nstencils, int nelems) {
     _sizes.reserve(nstencils);
     _indices.reserve(nelems);
     _weights.reserve(nelems);
 }
 
+template <typename REAL>
 inline void
-StencilTable::shrinkToFit() {
+StencilTableReal<REAL>::shrinkToFit() {
     std::vector<int>(_sizes).swap(_sizes);
     std::vector<Index>(_indices).swap(_indices);
-    std::vector<float>(_weights).swap(_weights);
+    std::vector<REAL>(_weights).swap(_weights);
 }
 
+template <typename REAL>
 inline void
-StencilTable::finalize() {
+StencilTableReal<REAL>::finalize() {
     shrinkToFit();
     generateOffsets();
 }
 
+template <typename REAL>
+inline void
+StencilTableReal<REAL>::adviseHugePages() const {
+    AdviseHugePages(_sizes);
+    AdviseHugePages(_offsets);
+    AdviseHugePages(_indices);
+    AdviseHugePages(_weights);
+}
+
 // Returns a Stencil at index i in the table
-inline Stencil
-StencilTable::GetStencil(Index i) const {
+template <typename REAL>
+inline StencilReal<REAL>
+StencilTableReal<REAL>::GetStencil(Index i) const {
     assert((not _offsets.empty()) and i<(int)_offsets.size());
 
     Index ofs = _offsets[i];
 
-    return Stencil( const_cast<int*>(&_sizes[i]),
-                    const_cast<Index *>(&_indices[ofs]),
-                    const_cast<float *>(&_weights[ofs]) );
+    return StencilReal<REAL>( const_cast<int*>(&_sizes[i]),
+                              const_cast<Index *>(&_indices[ofs]),
+                              const_cast<REAL *>(&_weights[ofs]) );
 }
 
-inline Stencil
-StencilTable::operator[] (Index index) const {
+template <typename REAL>
+inline StencilReal<REAL>
+StencilTableReal<REAL>::operator[] (Index index) const {
     return GetStencil(index);
 }
 
+template <typename REAL>
 inline void
-LimitStencilTable::resize(int nstencils, int nelems) {
-    StencilTable::resize(nstencils, nelems);
+LimitStencilTableReal<REAL>::resize(int nstencils, int nelems) {
+    StencilTableReal<REAL>::resize(nstencils, nelems);
     _duWeights.resize(nelems);
     _dvWeights.resize(nelems);
 }
 
-// Returns a LimitStencil at index i in the table
-inline LimitStencil
-LimitStencilTable::GetLimitStencil(Index i) const {
-    assert((not GetOffsets().empty()) and i<(int)GetOffsets().size());
-
-    Index ofs = GetOffsets()[i];
+template <typename REAL>
+inline void
+LimitStencilTableReal<REAL>::adviseHugePages() const {
+    StencilTableReal<REAL>::adviseHugePages();
+    AdviseHugePages(_duWeights);
+    AdviseHugePages(_dvWeights);
+    AdviseHugePages(_duuWeights);
+    AdviseHugePages(_duvWeights);
+    AdviseHugePages(_dvvWeights);
+}
 
-    return LimitStencil( const_cast<int *>(&GetSizes()[i]),
-                         const_cast<Index *>(&GetControlIndices()[ofs]),
-                         const_cast<float *>(&GetWeights()[ofs]),
-                         const_cast<float *>(&GetDuWeights()[ofs]),
-                         const_cast<float *>(&GetDvWeights()[ofs]) );
+// Returns a LimitStencil at index i in the table
+template <typename REAL>
+inline LimitStencilReal<REAL>
+LimitStencilTableReal<REAL>::GetLimitStencil(Index i) const {
+    assert((not this->GetOffsets().empty()) and i<(int)this->GetOffsets().size());
+
+    Index ofs = this->GetOffsets()[i];
+
+    // derivative weights are optional (see LimitStencilTableFactory::Options)
+    REAL * du  = _duWeights.empty()  ? 0 : const_cast<REAL *>(&_duWeights[ofs]);
+    REAL * dv  = _dvWeights.empty()  ? 0 : const_cast<REAL *>(&_dvWeights[ofs]);
+    REAL * duu = _duuWeights.empty() ? 0 : const_cast<REAL *>(&_duuWeights[ofs]);
+    REAL * duv = _duvWeights.empty() ? 0 : const_cast<REAL *>(&_duvWeights[ofs]);
+    REAL * dvv = _dvvWeights.empty() ? 0 : const_cast<REAL *>(&_dvvWeights[ofs]);
+
+    return LimitStencilReal<REAL>( const_cast<int *>(&this->GetSizes()[i]),
+                                   const_cast<Index *>(&this->GetControlIndices()[ofs]),
+                                   const_cast<REAL *>(&this->GetWeights()[ofs]),
+                                   du, dv, duu, duv, dvv );
 }
 
-inline LimitStencil
-LimitStencilTable::operator[] (Index index) const {
+template <typename REAL>
+inline LimitStencilReal<REAL>
+LimitStencilTableReal<REAL>::operator[] (Index index) const {
     return GetLimitStencil(index);
 }
 
@@ -30,11 +30,16 @@
 #include "../far/patchMap.h"
 #include "../far/topologyRefiner.h"
 #include "../far/primvarRefiner.h"
+#include "../far/stats.h"
 
 #include <cassert>
 #include <algorithm>
 #include <iostream>
 
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #include <omp.h>
+#endif
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -46,44 +51,171 @@ namespace {
 #pragma warning disable 1572
 #endif
 
-    inline bool isWeightZero(float w) { return (w == 0.0f); }
+    template <typename REAL>
+    inline bool isWeightZero(REAL w) { return (w == (REAL)0.0); }
 
 #ifdef __INTEL_COMPILER
 #pragma warning (pop)
 #endif
+
+    //
+    // The single precision factories instantiate the StencilTable and
+    // LimitStencilTable classes, so that their results can be returned
+    // by the non-template factories.
+    //
+    template <typename REAL>
+    struct StencilTableTypes {
+        typedef StencilTableReal<REAL>      Table;
+        typedef LimitStencilTableReal<REAL> LimitTable;
+    };
+
+    template <>
+    struct StencilTableTypes<float> {
+        typedef StencilTable      Table;
+        typedef LimitStencilTable LimitTable;
+    };
+
+    //
+    // Reports the size of the generated tables (see SetStatsCallback())
+    //
+    template <typename REAL>
+    void setTableStats(internal::StatsScope & stats,
+                       StencilTableReal<REAL> const & table,
+                       size_t numWeightArrays = 1) {
+        if (not stats.IsEnabled()) return;
+
+        size_t numStencils = table.GetNumStencils(),
+               numWeights = table.GetControlIndices().size();
+        stats.SetCounts(numStencils, numWeights * numWeightArrays, 0,
+            numStencils * 2 * sizeof(int) +
+            numWeights * (sizeof(Index) + numWeightArrays * sizeof(REAL)));
+    }
+
+    template <typename REAL>
+    void setTableStats(internal::StatsScope & stats,
+                       LimitStencilTableReal<REAL> const & table) {
+        size_t numWeightArrays = 1;
+        if (not table.GetDuWeights().empty()) numWeightArrays += 2;
+        if (not table.GetDuuWeights().empty()) numWeightArrays += 3;
+        setTableStats(stats, (StencilTableReal<REAL> const &)table,
+                      numWeightArrays);
+    }
 }
 
 //------------------------------------------------------------------------------
 
+template <typename REAL>
 void
-StencilTableFactory::generateControlVertStencils(
-    int numControlVerts, Stencil & dst) {
+StencilTableFactoryReal<REAL>::generateControlVertStencils(
+    int numControlVerts, StencilReal<REAL> & dst) {
 
     // Control vertices contribute a single index with a weight of 1.0
     for (int i=0; i<numControlVerts; ++i) {
         *dst._size = 1;
         *dst._indices = i;
-        *dst._weights = 1.0f;
+        *dst._weights = (REAL)1.0;
         dst.Next();
     }
 }
 
+//
+// Parallel interpolation of the levels
+//
+// The stencils of the child vertices are built concurrently for chunks of
+// parent components, into builders that read the source stencils from the
+// main one, and the chunks are appended in order. The stencils of the
+// children of faces are completed first : those of the children of edges and
+// vertices may refer to them.
+//
+
+// Number of parent components interpolated by each task
+static const int interpolateGrainSize = 1024;
+
+template <typename REAL>
+void
+StencilTableFactoryReal<REAL>::interpolateLevel(
+    TopologyRefiner const & refiner, PrimvarRefiner const & primvarRefiner,
+        int level, internal::StencilBuilder<REAL> & builder,
+            int srcOffset, int dstOffset) {
+
+    typedef internal::StencilBuilder<REAL> Builder;
+
+    typename Builder::Index srcIndex(&builder, srcOffset),
+                            dstIndex(&builder, dstOffset);
+
+    TopologyLevel const & parent = refiner.GetLevel(level-1);
+
+    int numThreads = 1;
+#ifdef OPENSUBDIV_HAS_OPENMP
+    numThreads = omp_in_parallel() ? 1 : omp_get_max_threads();
+#endif
+    if (numThreads < 2 or parent.GetNumEdges() < 2*interpolateGrainSize) {
+        primvarRefiner.Interpolate(level, srcIndex, dstIndex);
+        return;
+    }
+
+    for (int phase = 0; phase < 2; ++phase) {
+
+        // chunks of faces, then chunks of edges and vertices
+        std::vector<PrimvarRefiner::ParentType> chunkTypes;
+        std::vector<int> chunkBegins,
+                         chunkEnds;
+        for (int i = 0; i < (phase == 0 ? 1 : 2); ++i) {
+            PrimvarRefiner::ParentType type = phase == 0 ?
+                PrimvarRefiner::PARENT_FACES : (i == 0 ?
+                PrimvarRefiner::PARENT_EDGES : PrimvarRefiner::PARENT_VERTICES);
+            int count = phase == 0 ? parent.GetNumFaces() :
+                (i == 0 ? parent.GetNumEdges() : parent.GetNumVertices());
+            for (int begin = 0; begin < count; begin += interpolateGrainSize) {
+                chunkTypes.push_back(type);
+                chunkBegins.push_back(begin);
+                chunkEnds.push_back(
+                    std::min(begin + interpolateGrainSize, count));
+            }
+        }
+        int numChunks = (int)chunkTypes.size();
+
+        std::vector<Builder *> chunkBuilders(numChunks, (Builder *)0);
+
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int i = 0; i < numChunks; ++i) {
+            Builder * chunkBuilder = new Builder(&builder);
+
+            typename Builder::Index chunkIndex(chunkBuilder, dstOffset);
+            primvarRefiner.interpolateRange(level, chunkTypes[i],
+                chunkBegins[i], chunkEnds[i], srcIndex, chunkIndex);
+
+            chunkBuilders[i] = chunkBuilder;
+        }
+
+        for (int i = 0; i < numChunks; ++i) {
+            builder.Append(*chunkBuilders[i]);
+            delete chunkBuilders[i];
+        }
+    }
+}
+
 //
 // StencilTable factory
 //
-StencilTable const *
-StencilTableFactory::Create(TopologyRefiner const & refiner,
+template <typename REAL>
+StencilTableReal<REAL> const *
+StencilTableFactoryReal<REAL>::Create(TopologyRefiner const & refiner,
     Options options) {
 
+    typedef typename StencilTableTypes<REAL>::Table Table;
+
+    internal::StatsScope stats("Far::StencilTableFactory::Create");
+
     int maxlevel = std::min(int(options.maxLevel), refiner.GetMaxLevel());
     if (maxlevel==0 and (not options.generateControlVerts)) {
-        StencilTable * result = new StencilTable;
+        Table * result = new Table;
         result->_numControlVertices = refiner.GetLevel(0).GetNumVertices();
         return result;
     }
 
     bool interpolateVarying = options.interpolationMode==INTERPOLATE_VARYING;
-    internal::StencilBuilder builder(refiner.GetLevel(0).GetNumVertices(),
+    internal::StencilBuilder<REAL> builder(refiner.GetLevel(0).GetNumVertices(),
                                 /*genControlVerts*/ true,
                                 /*compactWeights*/  true);
 
@@ -93,13 +225,14 @@ StencilTableFactory::Create(TopologyRefiner const & refiner,
     //
     PrimvarRefiner primvarRefiner(refiner);
 
-    internal::StencilBuilder::Index srcIndex(&builder, 0);
-    internal::StencilBuilder::Index dstIndex(&builder, 
+    typename internal::StencilBuilder<REAL>::Index srcIndex(&builder, 0);
+    typename internal::StencilBuilder<REAL>::Index dstIndex(&builder, 
                                     refiner.GetLevel(0).GetNumVertices());
 
     for (int level=1; level<=maxlevel; ++level) {
         if (not interpolateVarying) {
-            primvarRefiner.Interpolate(level, srcIndex, dstIndex);
+            interpolateLevel(refiner, primvarRefiner, level, builder,
+                             srcIndex.GetOffset(), dstIndex.GetOffset());
         } else {
             primvarRefiner.InterpolateVarying(level, srcIndex, dstIndex);
         }
@@ -124,21 +257,26 @@ StencilTableFactory::Create(TopologyRefiner const & refiner,
  
     // Copy stencils from the StencilBuilder into the StencilTable.
     // Always initialize numControlVertices (useful for torus case)
-    StencilTable * result = 
-                        new StencilTable(refiner.GetLevel(0).GetNumVertices(),
+    Table * result = new Table(refiner.GetLevel(0).GetNumVertices(),
                                           builder.GetStencilOffsets(),
                                           builder.GetStencilSizes(),
                                           builder.GetStencilSources(),
                                           builder.GetStencilWeights(),
                                           options.generateControlVerts,
                                           firstOffset);
+    result->adviseHugePages();
+    setTableStats(stats, *result);
     return result;
 }
 
 //------------------------------------------------------------------------------
 
-StencilTable const *
-StencilTableFactory::Create(int numTables, StencilTable const ** tables) {
+template <typename REAL>
+StencilTableReal<REAL> const *
+StencilTableFactoryReal<REAL>::Create(int numTables,
+    StencilTableReal<REAL> const ** tables) {
+
+    typedef typename StencilTableTypes<REAL>::Table Table;
 
     // XXXtakahito:
     // This function returns NULL for empty inputs or erroneous condition.
@@ -156,7 +294,7 @@ StencilTableFactory::Create(int numTables, StencilTable const ** tables) {
 
     for (int i=0; i<numTables; ++i) {
 
-        StencilTable const * st = tables[i];
+        StencilTableReal<REAL> const * st = tables[i];
         // allow the tables could have a null entry.
         if (!st) continue;
 
@@ -172,21 +310,21 @@ StencilTableFactory::Create(int numTables, StencilTable const ** tables) {
         return NULL;
     }
 
-    StencilTable * result = new StencilTable;
+    Table * result = new Table;
     result->resize(nstencils, nelems);
 
     int * sizes = &result->_sizes[0];
     Index * indices = &result->_indices[0];
-    float * weights = &result->_weights[0];
+    REAL * weights = &result->_weights[0];
     for (int i=0; i<numTables; ++i) {
-        StencilTable const * st = tables[i];
+        StencilTableReal<REAL> const * st = tables[i];
         if (!st) continue;
 
         int st_nstencils = st->GetNumStencils(),
             st_nelems = (int)st->_indices.size();
         memcpy(sizes, &st->_sizes[0], st_nstencils*sizeof(int));
         memcpy(indices, &st->_indices[0], st_nelems*sizeof(Index));
-        memcpy(weights, &st->_weights[0], st_nelems*sizeof(float));
+        memcpy(weights, &st->_weights[0], st_nelems*sizeof(REAL));
 
         sizes += st_nstencils;
         indices += st_nelems;
@@ -197,19 +335,23 @@ StencilTableFactory::Create(int numTables, StencilTable const ** tables) {
 
     // have to re-generate offsets from scratch
     result->generateOffsets();
+    result->adviseHugePages();
 
     return result;
 }
 
 //------------------------------------------------------------------------------
 
-StencilTable const *
-StencilTableFactory::AppendLocalPointStencilTable(
+template <typename REAL>
+StencilTableReal<REAL> const *
+StencilTableFactoryReal<REAL>::AppendLocalPointStencilTable(
     TopologyRefiner const &refiner,
-    StencilTable const * baseStencilTable,
-    StencilTable const * localPointStencilTable,
+    StencilTableReal<REAL> const * baseStencilTable,
+    StencilTableReal<float> const * localPointStencilTable,
     bool factorize) {
 
+    typedef typename StencilTableTypes<REAL>::Table Table;
+
     // factorize and append.
     if (baseStencilTable == NULL or
         localPointStencilTable == NULL or
@@ -269,19 +411,19 @@ StencilTableFactory::AppendLocalPointStencilTable(
     int nLocalPointStencils = localPointStencilTable->GetNumStencils();
     int nLocalPointStencilsElements = 0;
 
-    internal::StencilBuilder builder(refiner.GetLevel(0).GetNumVertices(),
+    internal::StencilBuilder<REAL> builder(refiner.GetLevel(0).GetNumVertices(),
                                 /*genControlVerts*/ false,
                                 /*compactWeights*/  factorize);
-    internal::StencilBuilder::Index origin(&builder, 0);
-    internal::StencilBuilder::Index dst = origin;
-    internal::StencilBuilder::Index srcIdx = origin;
+    typename internal::StencilBuilder<REAL>::Index origin(&builder, 0);
+    typename internal::StencilBuilder<REAL>::Index dst = origin;
+    typename internal::StencilBuilder<REAL>::Index srcIdx = origin;
 
     for (int i = 0 ; i < nLocalPointStencils; ++i) {
-        Stencil src = localPointStencilTable->GetStencil(i);
+        StencilReal<float> src = localPointStencilTable->GetStencil(i);
         dst = origin[i];
         for (int j = 0; j < src.GetSize(); ++j) {
             Index index = src.GetVertexIndices()[j];
-            float weight = src.GetWeights()[j];
+            REAL weight = src.GetWeights()[j];
             if (isWeightZero(weight)) continue;
 
             if (factorize) {
@@ -301,14 +443,14 @@ StencilTableFactory::AppendLocalPointStencilTable(
     }
 
     // create new stencil table
-    StencilTable * result = new StencilTable;
+    Table * result = new Table;
     result->_numControlVertices = refiner.GetLevel(0).GetNumVertices();
     result->resize(nBaseStencils + nLocalPointStencils,
                    nBaseStencilsElements + nLocalPointStencilsElements);
 
     int* sizes = &result->_sizes[0];
     Index * indices = &result->_indices[0];
-    float * weights = &result->_weights[0];
+    REAL * weights = &result->_weights[0];
 
     // put base stencils first
     memcpy(sizes, &baseStencilTable->_sizes[0],
@@ -316,7 +458,7 @@ StencilTableFactory::AppendLocalPointStencilTable(
     memcpy(indices, &baseStencilTable->_indices[0],
            nBaseStencilsElements*sizeof(Index));
     memcpy(weights, &baseStencilTable->_weights[0],
-           nBaseStencilsElements*sizeof(float));
+           nBaseStencilsElements*sizeof(REAL));
 
     sizes += nBaseStencils;
     indices += nBaseStencilsElements;
@@ -335,15 +477,23 @@ StencilTableFactory::AppendLocalPointStencilTable(
 
     // have to re-generate offsets from scratch
     result->generateOffsets();
+    result->adviseHugePages();
 
     return result;
 }
 
 //------------------------------------------------------------------------------
-LimitStencilTable const *
-LimitStencilTableFactory::Create(TopologyRefiner const & refiner,
-    LocationArrayVec const & locationArrays, StencilTable const * cvStencilsIn,
-        PatchTable const * patchTableIn) {
+template <typename REAL>
+LimitStencilTableReal<REAL> const *
+LimitStencilTableFactoryReal<REAL>::Create(TopologyRefiner const & refiner,
+    LocationArrayVec const & locationArrays,
+        StencilTableReal<REAL> const * cvStencilsIn,
+            PatchTable const * patchTableIn,
+                Options options) {
+
+    typedef typename StencilTableTypes<REAL>::LimitTable LimitTable;
+
+    internal::StatsScope stats("Far::LimitStencilTableFactory::Create");
 
     // Compute the total number of stencils to generate
     int numStencils=0, numLimitStencils=0;
@@ -359,14 +509,14 @@ LimitStencilTableFactory::Create(TopologyRefiner const & refiner,
 
     int maxlevel = refiner.GetMaxLevel();
 
-    StencilTable const * cvstencils = cvStencilsIn;
+    StencilTableReal<REAL> const * cvstencils = cvStencilsIn;
     if (not cvstencils) {
         // Generate stencils for the control vertices - this is necessary to
         // properly factorize patches with control vertices at level 0 (natural
         // regular patches, such as in a torus)
         // note: the control vertices of the mesh are added as single-index
         //       stencils of weight 1.0f
-        StencilTableFactory::Options options;
+        typename StencilTableFactoryReal<REAL>::Options options;
         options.generateIntermediateLevels = uniform ? false :true;
         options.generateControlVerts = true;
         options.generateOffsets = true;
@@ -374,7 +524,7 @@ LimitStencilTableFactory::Create(TopologyRefiner const & refiner,
         // PERFORMANCE: We could potentially save some mem-copies by not
         // instanciating the stencil tables and work directly off the source
         // data.
-        cvstencils = StencilTableFactory::Create(refiner, options);
+        cvstencils = StencilTableFactoryReal<REAL>::Create(refiner, options);
     } else {
         // Sanity checks
         //
@@ -406,8 +556,8 @@ LimitStencilTableFactory::Create(TopologyRefiner const & refiner,
             // if cvstencils is just created above, append endcap stencils
             if (StencilTable const *localPointStencilTable =
                 patchtable->GetLocalPointStencilTable()) {
-                StencilTable const *table =
-                    StencilTableFactory::AppendLocalPointStencilTable(
+                StencilTableReal<REAL> const *table =
+                    StencilTableFactoryReal<REAL>::AppendLocalPointStencilTable(
                         refiner, cvstencils, localPointStencilTable);
                 delete cvstencils;
                 cvstencils = table;
@@ -433,35 +583,51 @@ LimitStencilTableFactory::Create(TopologyRefiner const & refiner,
     // Generate limit stencils for locations
     //
 
-    internal::StencilBuilder builder(refiner.GetLevel(0).GetNumVertices(),
+    internal::StencilBuilder<REAL> builder(refiner.GetLevel(0).GetNumVertices(),
                                 /*genControlVerts*/ false,
                                 /*compactWeights*/  true);
-    internal::StencilBuilder::Index origin(&builder, 0);
-    internal::StencilBuilder::Index dst = origin;
+    typename internal::StencilBuilder<REAL>::Index origin(&builder, 0);
+    typename internal::StencilBuilder<REAL>::Index dst = origin;
+
+    bool uderivs  = options.generate1stDerivatives,
+         u2derivs = options.generate2ndDerivatives;
 
-    float wP[20], wDs[20], wDt[20];
+    REAL wP[20], wDs[20], wDt[20], wDss[20], wDst[20], wDtt[20];
 
     for (size_t i=0; i<locationArrays.size(); ++i) {
         LocationArray const & array = locationArrays[i];
         assert(array.ptexIdx>=0);
 
         for (int j=0; j<array.numLocations; ++j) {
-            float s = array.s[j],
-                  t = array.t[j];
+            REAL s = array.s[j],
+                 t = array.t[j];
 
-            PatchMap::Handle const * handle = 
-                                        patchmap.FindPatch(array.ptexIdx, s, t);
+            PatchMap::Handle const * handle =
+                patchmap.FindPatch(array.ptexIdx, (float)s, (float)t);
             if (handle) {
                 ConstIndexArray cvs = patchtable->GetPatchVertices(*handle);
 
-                patchtable->EvaluateBasis(*handle, s, t, wP, wDs, wDt);
-
-                StencilTable const & src = *cvstencils;
+                StencilTableReal<REAL> const & src = *cvstencils;
                 dst = origin[numLimitStencils];
 
                 dst.Clear();
-                for (int k = 0; k < cvs.size(); ++k) {
-                    dst.AddWithWeight(src[cvs[k]], wP[k], wDs[k], wDt[k]);
+                if (u2derivs) {
+                    patchtable->EvaluateBasis(*handle, s, t, wP, wDs, wDt,
+                                              wDss, wDst, wDtt);
+                    for (int k = 0; k < cvs.size(); ++k) {
+                        dst.AddWithWeight(src[cvs[k]], wP[k], wDs[k], wDt[k],
+                                          wDss[k], wDst[k], wDtt[k]);
+                    }
+                } else if (uderivs) {
+                    patchtable->EvaluateBasis(*handle, s, t, wP, wDs, wDt);
+                    for (int k = 0; k < cvs.size(); ++k) {
+                        dst.AddWithWeight(src[cvs[k]], wP[k], wDs[k], wDt[k]);
+                    }
+                } else {
+                    patchtable->EvaluateBasis(*handle, s, t, wP, 0, 0);
+                    for (int k = 0; k < cvs.size(); ++k) {
+                        dst.AddWithWeight(src[cvs[k]], wP[k]);
+                    }
                 }
 
                 ++numLimitStencils;
@@ -478,21 +644,294 @@ LimitStencilTableFactory::Create(TopologyRefiner const & refiner,
     }
 
     //
-    // Copy the proto-stencils into the limit stencil table
+    // Copy the proto-stencils into the limit stencil table : the 1st
+    // derivatives accumulated along with the 2nd ones are dropped unless
+    // they were requested as well
     //
-    LimitStencilTable * result = new LimitStencilTable(
+    std::vector<REAL> noWeights;
+
+    LimitTable * result = new LimitTable(
                                           refiner.GetLevel(0).GetNumVertices(),
                                           builder.GetStencilOffsets(),
                                           builder.GetStencilSizes(),
                                           builder.GetStencilSources(),
                                           builder.GetStencilWeights(),
-                                          builder.GetStencilDuWeights(),
-                                          builder.GetStencilDvWeights(),
+                                          uderivs ?
+                                              builder.GetStencilDuWeights() :
+                                              noWeights,
+                                          uderivs ?
+                                              builder.GetStencilDvWeights() :
+                                              noWeights,
+                                          builder.GetStencilDuuWeights(),
+                                          builder.GetStencilDuvWeights(),
+                                          builder.GetStencilDvvWeights(),
                                           /*ctrlVerts*/false,
                                           /*fristOffset*/0);
+    result->adviseHugePages();
+    setTableStats(stats, *result);
+    return result;
+}
+
+//------------------------------------------------------------------------------
+
+namespace {
+    // orders the control vertices by increasing number of stencils
+    struct DegreeCompare {
+        DegreeCompare(std::vector<int> const & offsets) : _offsets(offsets) { }
+
+        bool operator () (Index a, Index b) const {
+            int degreeA = _offsets[a+1] - _offsets[a],
+                degreeB = _offsets[b+1] - _offsets[b];
+            return degreeA < degreeB or (degreeA == degreeB and a < b);
+        }
+
+        std::vector<int> const & _offsets;
+    };
+}
+
+template <typename REAL>
+StencilTableReal<REAL> const *
+StencilTableFactoryReal<REAL>::ReorderStencilTable(
+    StencilTableReal<REAL> const &stencilTable,
+    std::vector<Index> *controlVertexOrder,
+    std::vector<Index> *stencilOrder) {
+
+    typedef typename StencilTableTypes<REAL>::Table Table;
+
+    int ncvs = stencilTable.GetNumControlVertices(),
+        nstencils = stencilTable.GetNumStencils(),
+        nelems = (int)stencilTable._indices.size();
+
+    std::vector<int> const & sizes = stencilTable._sizes;
+    std::vector<Index> const & indices = stencilTable._indices;
+
+    // the offsets are optional in the source table
+    std::vector<int> offsets(nstencils + 1, 0);
+    for (int i = 0; i < nstencils; ++i) {
+        offsets[i+1] = offsets[i] + sizes[i];
+    }
+
+    // transpose the table : stencils supported by each control vertex
+    std::vector<int> cvOffsets(ncvs + 1, 0);
+    for (int i = 0; i < nelems; ++i) {
+        if (indices[i] < 0 or indices[i] >= ncvs) {
+            return NULL;
+        }
+        ++cvOffsets[indices[i] + 1];
+    }
+    for (int i = 0; i < ncvs; ++i) {
+        cvOffsets[i+1] += cvOffsets[i];
+    }
+    std::vector<int> cvStencils(nelems);
+    {
+        std::vector<int> fill(cvOffsets.begin(), cvOffsets.end() - 1);
+        for (int i = 0; i < nstencils; ++i) {
+            for (int j = offsets[i]; j < offsets[i+1]; ++j) {
+                cvStencils[fill[indices[j]]++] = i;
+            }
+        }
+    }
+
+    // Cuthill-McKee traversal of the control vertices : each connected set
+    // starts from its vertex of lowest degree, and the neighbors (the control
+    // vertices of the stencils of a vertex) are queued by increasing degree.
+    DegreeCompare byDegree(cvOffsets);
+
+    std::vector<Index> seeds(ncvs);
+    for (int i = 0; i < ncvs; ++i) {
+        seeds[i] = i;
+    }
+    std::sort(seeds.begin(), seeds.end(), byDegree);
+
+    std::vector<Index> cvOrder;
+    cvOrder.reserve(ncvs);
+
+    std::vector<bool> cvVisited(ncvs, false),
+                      stencilVisited(nstencils, false);
+
+    for (int seed = 0; seed < ncvs; ++seed) {
+
+        if (cvVisited[seeds[seed]]) continue;
+
+        size_t head = cvOrder.size();
+        cvOrder.push_back(seeds[seed]);
+        cvVisited[seeds[seed]] = true;
+
+        for (; head < cvOrder.size(); ++head) {
+            Index cv = cvOrder[head];
+            for (int j = cvOffsets[cv]; j < cvOffsets[cv+1]; ++j) {
+                int stencil = cvStencils[j];
+                if (stencilVisited[stencil]) continue;
+                stencilVisited[stencil] = true;
+
+                size_t first = cvOrder.size();
+                for (int k = offsets[stencil]; k < offsets[stencil+1]; ++k) {
+                    if (not cvVisited[indices[k]]) {
+                        cvVisited[indices[k]] = true;
+                        cvOrder.push_back(indices[k]);
+                    }
+                }
+                std::sort(cvOrder.begin() + first, cvOrder.end(), byDegree);
+            }
+        }
+    }
+    std::reverse(cvOrder.begin(), cvOrder.end());
+
+    if (not controlVertexOrder) {
+        for (int i = 0; i < ncvs; ++i) {
+            cvOrder[i] = i;
+        }
+    }
+
+    std::vector<Index> cvRemap(ncvs);
+    for (int i = 0; i < ncvs; ++i) {
+        cvRemap[cvOrder[i]] = i;
+    }
+
+    // the stencils are sorted by their first reordered control vertex (with
+    // a stable counting sort, stencils without weights last)
+    std::vector<Index> order(nstencils);
+    if (stencilOrder) {
+        std::vector<int> keys(nstencils, ncvs),
+                         keyOffsets(ncvs + 2, 0);
+        for (int i = 0; i < nstencils; ++i) {
+            for (int j = offsets[i]; j < offsets[i+1]; ++j) {
+                keys[i] = std::min(keys[i], (int)cvRemap[indices[j]]);
+            }
+            ++keyOffsets[keys[i] + 1];
+        }
+        for (int i = 0; i <= ncvs; ++i) {
+            keyOffsets[i+1] += keyOffsets[i];
+        }
+        for (int i = 0; i < nstencils; ++i) {
+            order[keyOffsets[keys[i]]++] = i;
+        }
+    } else {
+        for (int i = 0; i < nstencils; ++i) {
+            order[i] = i;
+        }
+    }
+
+    typedef typename StencilTableTypes<REAL>::LimitTable LimitTable;
+
+    LimitStencilTableReal<REAL> const * limitTable =
+        dynamic_cast<LimitStencilTableReal<REAL> const *>(&stencilTable);
+
+    StencilTableReal<REAL> const * result = 0;
+    if (limitTable) {
+        // the derivative weights are reordered along with the point weights
+        std::vector<int> orderedOffsets(nstencils),
+                         orderedSizes(nstencils);
+        for (int i = 0; i < nstencils; ++i) {
+            orderedOffsets[i] = offsets[order[i]];
+            orderedSizes[i] = sizes[order[i]];
+        }
+        std::vector<Index> remappedIndices(nelems);
+        for (int i = 0; i < nelems; ++i) {
+            remappedIndices[i] = cvRemap[indices[i]];
+        }
+
+        LimitTable * limitResult = new LimitTable(ncvs,
+            orderedOffsets, orderedSizes, remappedIndices,
+            limitTable->_weights,
+            limitTable->_duWeights, limitTable->_dvWeights,
+            limitTable->_duuWeights, limitTable->_duvWeights,
+            limitTable->_dvvWeights,
+            /*ctrlVerts*/false, /*firstOffset*/0);
+        limitResult->adviseHugePages();
+        result = limitResult;
+    } else {
+        Table * table = new Table;
+        table->resize(nstencils, nelems);
+        table->_numControlVertices = ncvs;
+
+        int * dstSizes = nstencils ? &table->_sizes[0] : 0;
+        Index * dstIndices = nelems ? &table->_indices[0] : 0;
+        REAL * dstWeights = nelems ? &table->_weights[0] : 0;
+        for (int i = 0; i < nstencils; ++i) {
+            int stencil = order[i];
+            dstSizes[i] = sizes[stencil];
+            for (int j = offsets[stencil]; j < offsets[stencil+1]; ++j) {
+                *dstIndices++ = cvRemap[indices[j]];
+                *dstWeights++ = stencilTable._weights[j];
+            }
+        }
+        table->generateOffsets();
+        table->adviseHugePages();
+        result = table;
+    }
+
+    if (controlVertexOrder) {
+        controlVertexOrder->swap(cvOrder);
+    }
+    if (stencilOrder) {
+        stencilOrder->swap(order);
+    }
     return result;
 }
 
+//------------------------------------------------------------------------------
+
+StencilTable const *
+StencilTableFactory::Create(TopologyRefiner const & refiner,
+    Options options) {
+
+    return static_cast<StencilTable const *>(
+        BaseFactory::Create(refiner, options));
+}
+
+StencilTable const *
+StencilTableFactory::Create(int numTables, StencilTable const ** tables) {
+
+    return static_cast<StencilTable const *>(
+        BaseFactory::Create(numTables,
+            reinterpret_cast<StencilTableReal<float> const **>(tables)));
+}
+
+StencilTable const *
+StencilTableFactory::AppendLocalPointStencilTable(
+    TopologyRefiner const &refiner,
+    StencilTable const * baseStencilTable,
+    StencilTable const * localPointStencilTable,
+    bool factorize) {
+
+    return static_cast<StencilTable const *>(
+        BaseFactory::AppendLocalPointStencilTable(refiner,
+            baseStencilTable, localPointStencilTable, factorize));
+}
+
+StencilTable const *
+StencilTableFactory::ReorderStencilTable(
+    StencilTable const &stencilTable,
+    std::vector<Index> *controlVertexOrder,
+    std::vector<Index> *stencilOrder) {
+
+    return static_cast<StencilTable const *>(
+        BaseFactory::ReorderStencilTable(stencilTable,
+            controlVertexOrder, stencilOrder));
+}
+
+LimitStencilTable const *
+LimitStencilTableFactory::Create(TopologyRefiner const & refiner,
+    LocationArrayVec const & locationArrays,
+        StencilTable const * cvStencils,
+            PatchTable const * patchTable,
+                Options options) {
+
+    return static_cast<LimitStencilTable const *>(
+        BaseFactory::Create(refiner, locationArrays, cvStencils, patchTable,
+                            options));
+}
+
+//
+//  Explicit instantiation for single and double precision tables:
+//
+template class StencilTableFactoryReal<float>;
+template class StencilTableFactoryReal<double>;
+
+template class LimitStencilTableFactoryReal<float>;
+template class LimitStencilTableFactoryReal<double>;
+
 } // end namespace Far
 
 } // end namespace OPENSUBDIV_VERSION
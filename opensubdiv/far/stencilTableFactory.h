@@ -37,6 +37,15 @@ namespace OPENSUBDIV_VERSION {
 namespace Far {
 
 class TopologyRefiner;
+class PrimvarRefiner;
+
+namespace internal {
+template <typename REAL> class StencilBuilder;
+}
+
+template <typename REAL> class StencilReal;
+template <typename REAL> class StencilTableReal;
+template <typename REAL> class LimitStencilTableReal;
 
 class Stencil;
 class StencilTable;
@@ -45,7 +54,12 @@ class LimitStencilTable;
 
 /// \brief A specialized factory for StencilTable
 ///
-class StencilTableFactory {
+/// The precision of the stencil weights is given by the REAL template
+/// parameter : StencilTableFactory creates single precision tables and
+/// StencilTableFactoryReal<double> the double precision ones.
+///
+template <typename REAL>
+class StencilTableFactoryReal {
 
 public:
 
@@ -84,8 +98,8 @@ public:
     ///
     /// @param options  Options controlling the creation of the table
     ///
-    static StencilTable const * Create(TopologyRefiner const & refiner,
-        Options options = Options());
+    static StencilTableReal<REAL> const * Create(
+        TopologyRefiner const & refiner, Options options = Options());
 
 
     /// \brief Instantiates StencilTable by concatenating an array of existing
@@ -100,7 +114,8 @@ public:
     ///
     /// @param tables    Array of input StencilTables
     ///
-    static StencilTable const * Create(int numTables, StencilTable const ** tables);
+    static StencilTableReal<REAL> const * Create(
+        int numTables, StencilTableReal<REAL> const ** tables);
 
 
     /// \brief Utility function for stencil splicing for local point stencils.
@@ -110,23 +125,97 @@ public:
     /// @param baseStencilTable     Input StencilTable for refined vertices
     ///
     /// @param localPointStencilTable
-    ///                             StencilTable for the change of basis patch points.
+    ///                             StencilTable for the change of basis patch
+    ///                             points (as generated by the PatchTable in
+    ///                             single precision)
     ///
     /// @param factorize            If factorize sets to true, endcap stencils will be
     ///                             factorized with supporting vertices from baseStencil
     ///                             table so that the endcap points can be computed
     ///                             directly from control vertices.
     ///
+    static StencilTableReal<REAL> const * AppendLocalPointStencilTable(
+        TopologyRefiner const &refiner,
+        StencilTableReal<REAL> const *baseStencilTable,
+        StencilTableReal<float> const *localPointStencilTable,
+        bool factorize = true);
+
+    /// \brief Reorders the control vertices and the stencils of a table for
+    ///        the locality of the evaluation.
+    ///
+    /// The control vertices are numbered in reverse Cuthill-McKee order of
+    /// the graph connecting the control vertices of each stencil, and the
+    /// stencils are sorted by their lowest renumbered control vertex (stencils
+    /// without control vertices last), so that the stencils evaluated in
+    /// sequence gather neighboring control vertices. The weights of each
+    /// stencil are kept in order, so that evaluations of the reordered table
+    /// match those of the original one exactly.
+    ///
+    /// A LimitStencilTableReal is reordered into a LimitStencilTableReal,
+    /// with its derivative weights reordered along with the point weights.
+    ///
+    /// The clients reorder their primvar buffers once with the returned
+    /// permutations : element i of a reordered buffer is element
+    /// permutation[i] of the original buffer. Any other data indexing the
+    /// refined vertices (e.g. a PatchTable) must be remapped accordingly.
+    ///
+    /// \note Returns NULL if the table refers to vertices other than its
+    ///       control vertices (e.g. local point stencils that were not
+    ///       factorized).
+    ///
+    /// @param stencilTable        The table to reorder
+    ///
+    /// @param controlVertexOrder  Returns the original index of each
+    ///                            reordered control vertex. If NULL, the
+    ///                            control vertices keep their order.
+    ///
+    /// @param stencilOrder        Returns the original index of each
+    ///                            reordered stencil. If NULL, the stencils
+    ///                            keep their order.
+    ///
+    static StencilTableReal<REAL> const * ReorderStencilTable(
+        StencilTableReal<REAL> const &stencilTable,
+        std::vector<Index> *controlVertexOrder,
+        std::vector<Index> *stencilOrder);
+
+protected:
+
+    // Generate stencils for the coarse control-vertices (single weight = 1.0f)
+    static void generateControlVertStencils(int numControlVerts,
+        StencilReal<REAL> & dst);
+
+    // Interpolate the stencils of the vertices of a level, in parallel when
+    // OpenMP is available (the stencils are identical to the serial ones)
+    static void interpolateLevel(TopologyRefiner const & refiner,
+        PrimvarRefiner const & primvarRefiner, int level,
+        internal::StencilBuilder<REAL> & builder,
+        int srcOffset, int dstOffset);
+};
+
+/// \brief A specialized factory for StencilTable (single precision)
+///
+class StencilTableFactory : public StencilTableFactoryReal<float> {
+protected:
+    typedef StencilTableFactoryReal<float> BaseFactory;
+
+public:
+
+    static StencilTable const * Create(TopologyRefiner const & refiner,
+        Options options = Options());
+
+    static StencilTable const * Create(int numTables,
+        StencilTable const ** tables);
+
     static StencilTable const * AppendLocalPointStencilTable(
         TopologyRefiner const &refiner,
         StencilTable const *baseStencilTable,
         StencilTable const *localPointStencilTable,
         bool factorize = true);
 
-private:
-
-    // Generate stencils for the coarse control-vertices (single weight = 1.0f)
-    static void generateControlVertStencils(int numControlVerts, Stencil & dst);
+    static StencilTable const * ReorderStencilTable(
+        StencilTable const &stencilTable,
+        std::vector<Index> *controlVertexOrder,
+        std::vector<Index> *stencilOrder);
 };
 
 /// \brief A specialized factory for LimitStencilTable
@@ -140,7 +229,8 @@ private:
 /// normalized (s,t) patch coordinates. The factory exposes the LocationArray
 /// struct as a container for these location descriptors.
 ///
-class LimitStencilTableFactory {
+template <typename REAL>
+class LimitStencilTableFactoryReal {
 
 public:
 
@@ -152,12 +242,21 @@ public:
         int ptexIdx,        ///< ptex face index
             numLocations;   ///< number of (u,v) coordinates in the array
 
-        float const * s,    ///< array of u coordinates
-                    * t;    ///< array of v coordinates
+        REAL const * s,     ///< array of u coordinates
+                   * t;     ///< array of v coordinates
     };
 
     typedef std::vector<LocationArray> LocationArrayVec;
 
+    struct Options {
+
+        Options() : generate1stDerivatives(true),
+                    generate2ndDerivatives(false) { }
+
+        unsigned int generate1stDerivatives : 1, ///< Generate weights for 1st derivatives
+                     generate2ndDerivatives : 1; ///< Generate weights for 2nd derivatives
+    };
+
     /// \brief Instantiates LimitStencilTable from a TopologyRefiner that has
     ///        been refined either uniformly or adaptively.
     ///
@@ -174,10 +273,30 @@ public:
     ///                         TopologyRefiner (optional: prevents redundant
     ///                         instanciation of the table if available)
     ///
+    /// @param options          Options controlling the derivative weights
+    ///                         of the table
+    ///
+    static LimitStencilTableReal<REAL> const * Create(
+        TopologyRefiner const & refiner,
+        LocationArrayVec const & locationArrays,
+            StencilTableReal<REAL> const * cvStencils=0,
+                PatchTable const * patchTable=0,
+                    Options options=Options());
+};
+
+/// \brief A specialized factory for LimitStencilTable (single precision)
+///
+class LimitStencilTableFactory : public LimitStencilTableFactoryReal<float> {
+protected:
+    typedef LimitStencilTableFactoryReal<float> BaseFactory;
+
+public:
+
     static LimitStencilTable const * Create(TopologyRefiner const & refiner,
         LocationArrayVec const & locationArrays,
             StencilTable const * cvStencils=0,
-                PatchTable const * patchTable=0);
+                PatchTable const * patchTable=0,
+                    Options options=Options());
 };
 
 
@@ -0,0 +1,261 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../far/stencilTableView.h"
+#include "../far/binaryFile.h"
+#include "../far/error.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+namespace {
+
+    // Sections of the stencil table files
+    enum {
+        SECTION_COUNTS,     // number of control vertices
+        SECTION_SIZES,
+        SECTION_OFFSETS,
+        SECTION_INDICES,
+        SECTION_WEIGHTS,
+        SECTION_DU_WEIGHTS,
+        SECTION_DV_WEIGHTS,
+        SECTION_DUU_WEIGHTS,
+        SECTION_DUV_WEIGHTS,
+        SECTION_DVV_WEIGHTS
+    };
+
+    // Adds the sections shared by the stencil and limit stencil tables : the
+    // weight arrays of the tables may have excess elements, only the weights
+    // of the stencils are written.
+    template <typename REAL>
+    void
+    addStencilSections(internal::BinaryFileWriter & writer,
+        StencilTableReal<REAL> const & table,
+        std::vector<int> & counts, std::vector<Index> & offsets) {
+
+        counts.push_back(table.GetNumControlVertices());
+
+        std::vector<int> const & sizes = table.GetSizes();
+        if (table.GetOffsets().size() != sizes.size()) {
+            offsets.resize(sizes.size());
+            Index offset = 0;
+            for (int i = 0; i < (int)sizes.size(); ++i) {
+                offsets[i] = offset;
+                offset += sizes[i];
+            }
+        }
+
+        size_t numWeights = table.GetControlIndices().size();
+
+        writer.AddSection(SECTION_COUNTS, counts);
+        writer.AddSection(SECTION_SIZES, sizes);
+        writer.AddSection(SECTION_OFFSETS,
+            offsets.empty() ? table.GetOffsets() : offsets);
+        writer.AddSection(SECTION_INDICES, table.GetControlIndices());
+        writer.AddSection(SECTION_WEIGHTS, table.GetWeights(), numWeights);
+    }
+
+    template <typename REAL>
+    void
+    addWeightSection(internal::BinaryFileWriter & writer, int tag,
+        std::vector<REAL> const & weights, size_t numWeights) {
+
+        // derivative weights are optional
+        if (not weights.empty()) {
+            writer.AddSection(tag, weights, numWeights);
+        }
+    }
+}
+
+//
+//  StencilTableViewReal
+//
+template <typename REAL>
+StencilTableViewReal<REAL>::StencilTableViewReal(
+    internal::MappedBinaryFile * file) :
+        _file(file),
+        _numControlVertices(0),
+        _numStencils(0),
+        _numWeights(0),
+        _sizes(0),
+        _offsets(0),
+        _indices(0),
+        _weights(0) {
+}
+
+template <typename REAL>
+StencilTableViewReal<REAL>::~StencilTableViewReal() {
+    delete _file;
+}
+
+template <typename REAL>
+size_t
+StencilTableViewReal<REAL>::GetMappedSize() const {
+    return _file->GetSize();
+}
+
+template <typename REAL>
+bool
+StencilTableViewReal<REAL>::mapStencils(char const * path) {
+
+    int numCounts = 0,
+        numOffsets = 0,
+        numIndices = 0;
+
+    int const * counts = _file->GetSection<int>(SECTION_COUNTS, &numCounts);
+
+    _sizes = _file->GetSection<int>(SECTION_SIZES, &_numStencils);
+    _offsets = _file->GetSection<Index>(SECTION_OFFSETS, &numOffsets);
+    _indices = _file->GetSection<Index>(SECTION_INDICES, &numIndices);
+    _weights = _file->GetSection<REAL>(SECTION_WEIGHTS, &_numWeights);
+
+    bool valid = numCounts == 1 and numOffsets == _numStencils and
+                 numIndices == _numWeights;
+
+    // the stencils must lie within the weights : the control vertex indices
+    // are not checked, so that opening a table doesn't read its weights
+    for (int i = 0; valid and i < _numStencils; ++i) {
+        valid = _sizes[i] >= 0 and _offsets[i] >= 0 and
+                _offsets[i] <= _numWeights - _sizes[i];
+    }
+
+    if (not valid) {
+        Error(FAR_RUNTIME_ERROR, "Failure in StencilTableView::Open() -- "
+            "\"%s\": corrupted stencil table", path);
+        return false;
+    }
+
+    _numControlVertices = counts[0];
+    return true;
+}
+
+template <typename REAL>
+bool
+StencilTableViewReal<REAL>::Write(char const * path,
+    StencilTableReal<REAL> const & table) {
+
+    std::vector<int> counts;
+    std::vector<Index> offsets;
+
+    internal::BinaryFileWriter writer(
+        internal::BINARY_FILE_STENCIL_TABLE, (int)sizeof(REAL));
+    addStencilSections(writer, table, counts, offsets);
+    return writer.Write(path);
+}
+
+template <typename REAL>
+StencilTableViewReal<REAL> *
+StencilTableViewReal<REAL>::Open(char const * path) {
+
+    internal::MappedBinaryFile * file = internal::MappedBinaryFile::Open(
+        path, internal::BINARY_FILE_STENCIL_TABLE, (int)sizeof(REAL));
+    if (not file) {
+        return 0;
+    }
+
+    StencilTableViewReal * view = new StencilTableViewReal(file);
+    if (not view->mapStencils(path)) {
+        delete view;
+        return 0;
+    }
+    return view;
+}
+
+//
+//  LimitStencilTableViewReal
+//
+template <typename REAL>
+bool
+LimitStencilTableViewReal<REAL>::Write(char const * path,
+    LimitStencilTableReal<REAL> const & table) {
+
+    std::vector<int> counts;
+    std::vector<Index> offsets;
+
+    internal::BinaryFileWriter writer(
+        internal::BINARY_FILE_LIMIT_STENCIL_TABLE, (int)sizeof(REAL));
+    addStencilSections(writer, table, counts, offsets);
+
+    size_t numWeights = table.GetControlIndices().size();
+    addWeightSection(writer, SECTION_DU_WEIGHTS,
+                     table.GetDuWeights(), numWeights);
+    addWeightSection(writer, SECTION_DV_WEIGHTS,
+                     table.GetDvWeights(), numWeights);
+    addWeightSection(writer, SECTION_DUU_WEIGHTS,
+                     table.GetDuuWeights(), numWeights);
+    addWeightSection(writer, SECTION_DUV_WEIGHTS,
+                     table.GetDuvWeights(), numWeights);
+    addWeightSection(writer, SECTION_DVV_WEIGHTS,
+                     table.GetDvvWeights(), numWeights);
+    return writer.Write(path);
+}
+
+template <typename REAL>
+LimitStencilTableViewReal<REAL> *
+LimitStencilTableViewReal<REAL>::Open(char const * path) {
+
+    internal::MappedBinaryFile * file = internal::MappedBinaryFile::Open(
+        path, internal::BINARY_FILE_LIMIT_STENCIL_TABLE, (int)sizeof(REAL));
+    if (not file) {
+        return 0;
+    }
+
+    LimitStencilTableViewReal * view = new LimitStencilTableViewReal(file);
+    if (not view->mapStencils(path)) {
+        delete view;
+        return 0;
+    }
+
+    REAL const ** derivWeights[5] = { &view->_duWeights, &view->_dvWeights,
+        &view->_duuWeights, &view->_duvWeights, &view->_dvvWeights };
+
+    for (int i = 0; i < 5; ++i) {
+        int numWeights = 0;
+        *derivWeights[i] = file->GetSection<REAL>(
+            SECTION_DU_WEIGHTS + i, &numWeights);
+        if (numWeights != 0 and numWeights != view->_numWeights) {
+            Error(FAR_RUNTIME_ERROR, "Failure in LimitStencilTableView::Open() "
+                "-- \"%s\": corrupted limit stencil table", path);
+            delete view;
+            return 0;
+        }
+    }
+    return view;
+}
+
+//
+//  Explicit instantiation for single and double precision views:
+//
+template class StencilTableViewReal<float>;
+template class StencilTableViewReal<double>;
+
+template class LimitStencilTableViewReal<float>;
+template class LimitStencilTableViewReal<double>;
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
@@ -0,0 +1,340 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OPENSUBDIV3_FAR_STENCILTABLE_VIEW_H
+#define OPENSUBDIV3_FAR_STENCILTABLE_VIEW_H
+
+#include "../version.h"
+
+#include "../far/stencilTable.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+namespace internal { class MappedBinaryFile; }
+
+/// \brief Read-only stencil table mapped from a file
+///
+/// Stencil tables written to a file with Write() are opened with Open(),
+/// which maps the file in memory : the arrays of the view point directly
+/// into the mapped file, so that opening a table doesn't copy it, and the
+/// processes that open the same file share its pages.
+///
+/// Views have the accessors of StencilTableReal used by the Osd CPU
+/// evaluators (GetNumStencils(), GetSizes(), GetOffsets(),
+/// GetControlIndices() and GetWeights(), which return pointers rather than
+/// vectors), so that they can be passed to their EvalStencils() functions
+/// in place of the tables.
+///
+/// Files record the byte order of the host that wrote them and the
+/// precision of the weights : they can only be opened on hosts of the same
+/// byte order, with a view of the same precision.
+///
+template <typename REAL>
+class StencilTableViewReal {
+public:
+
+    /// \brief Writes a stencil table to a file (the offsets of the stencils
+    ///        are written even when the table was created without them)
+    ///
+    /// Returns false (and reports a FAR_RUNTIME_ERROR) on failure.
+    ///
+    static bool Write(char const * path, StencilTableReal<REAL> const & table);
+
+    /// \brief Maps a stencil table file written with Write()
+    ///
+    /// Returns NULL (and reports a FAR_RUNTIME_ERROR) if the file can't be
+    /// mapped or isn't a stencil table of this precision.
+    ///
+    /// \note Open() checks that each stencil lies within the weights, which
+    ///       reads the sizes and offsets of the table : its cost is linear in
+    ///       the number of stencils. The control vertex indices and weights
+    ///       are neither read nor checked.
+    ///
+    static StencilTableViewReal * Open(char const * path);
+
+    virtual ~StencilTableViewReal();
+
+    /// \brief Returns the number of stencils in the table
+    int GetNumStencils() const {
+        return _numStencils;
+    }
+
+    /// \brief Returns the number of control vertices indexed in the table
+    int GetNumControlVertices() const {
+        return _numControlVertices;
+    }
+
+    /// \brief Returns the number of control vertex weights in the table
+    int GetNumWeights() const {
+        return _numWeights;
+    }
+
+    /// \brief Returns a Stencil at index i in the table
+    StencilReal<REAL> GetStencil(Index i) const {
+        assert(i >= 0 and i < _numStencils);
+        Index ofs = _offsets[i];
+        return StencilReal<REAL>(const_cast<int *>(_sizes + i),
+                                 const_cast<Index *>(_indices + ofs),
+                                 const_cast<REAL *>(_weights + ofs));
+    }
+
+    /// \brief Returns the stencil at index i in the table
+    StencilReal<REAL> operator[] (Index index) const {
+        return GetStencil(index);
+    }
+
+    /// \brief Returns the number of control vertices of each stencil
+    int const * GetSizes() const {
+        return _sizes;
+    }
+
+    /// \brief Returns the offset to each stencil
+    Index const * GetOffsets() const {
+        return _offsets;
+    }
+
+    /// \brief Returns the indices of the control vertices
+    Index const * GetControlIndices() const {
+        return _indices;
+    }
+
+    /// \brief Returns the stencil interpolation weights
+    REAL const * GetWeights() const {
+        return _weights;
+    }
+
+    /// \brief Returns the size of the mapped file in bytes
+    size_t GetMappedSize() const;
+
+    /// \brief Updates point values based on the control values
+    ///
+    /// \note The destination buffers are assumed to have allocated at least
+    ///       \c GetNumStencils() elements.
+    ///
+    /// @param controlValues  Buffer with primvar data for the control vertices
+    ///
+    /// @param values         Destination buffer for the interpolated primvar
+    ///                       data
+    ///
+    /// @param start          (skip to )index of first value to update
+    ///
+    /// @param end            Index of last value to update
+    ///
+    template <class T>
+    void UpdateValues(T const *controlValues, T *values, Index start=-1, Index end=-1) const {
+        update(controlValues, values, _weights, start, end);
+    }
+
+protected:
+    explicit StencilTableViewReal(internal::MappedBinaryFile * file);
+
+    // Maps the arrays of the stencils : returns false if the file is invalid
+    bool mapStencils(char const * path);
+
+    // Update values by applying the stencil weights to the control values
+    template <class T> void update(T const *controlValues, T *values,
+        REAL const * valueWeights, Index start, Index end) const;
+
+    internal::MappedBinaryFile * _file;
+
+    int _numControlVertices,
+        _numStencils,
+        _numWeights;
+
+    int const *   _sizes;
+    Index const * _offsets,
+                * _indices;
+    REAL const *  _weights;
+};
+
+/// \brief Read-only limit stencil table mapped from a file
+///
+/// The derivative weights of the view are NULL unless the table was created
+/// with them (see LimitStencilTableFactory::Options).
+///
+template <typename REAL>
+class LimitStencilTableViewReal : public StencilTableViewReal<REAL> {
+public:
+
+    /// \brief Writes a limit stencil table to a file
+    ///
+    /// Returns false (and reports a FAR_RUNTIME_ERROR) on failure.
+    ///
+    static bool Write(char const * path,
+                      LimitStencilTableReal<REAL> const & table);
+
+    /// \brief Maps a limit stencil table file written with Write()
+    ///
+    /// Returns NULL (and reports a FAR_RUNTIME_ERROR) if the file can't be
+    /// mapped or isn't a limit stencil table of this precision.
+    ///
+    static LimitStencilTableViewReal * Open(char const * path);
+
+    /// \brief Returns a LimitStencil at index i in the table
+    LimitStencilReal<REAL> GetLimitStencil(Index i) const {
+        assert(i >= 0 and i < this->_numStencils);
+        Index ofs = this->_offsets[i];
+        return LimitStencilReal<REAL>(
+            const_cast<int *>(this->_sizes + i),
+            const_cast<Index *>(this->_indices + ofs),
+            const_cast<REAL *>(this->_weights + ofs),
+            offsetWeights(_duWeights, ofs), offsetWeights(_dvWeights, ofs),
+            offsetWeights(_duuWeights, ofs), offsetWeights(_duvWeights, ofs),
+            offsetWeights(_dvvWeights, ofs));
+    }
+
+    /// \brief Returns the limit stencil at index i in the table
+    LimitStencilReal<REAL> operator[] (Index index) const {
+        return GetLimitStencil(index);
+    }
+
+    /// \brief Returns the 'u' derivative stencil interpolation weights
+    REAL const * GetDuWeights() const {
+        return _duWeights;
+    }
+
+    /// \brief Returns the 'v' derivative stencil interpolation weights
+    REAL const * GetDvWeights() const {
+        return _dvWeights;
+    }
+
+    /// \brief Returns the 'uu' derivative stencil interpolation weights
+    REAL const * GetDuuWeights() const {
+        return _duuWeights;
+    }
+
+    /// \brief Returns the 'uv' derivative stencil interpolation weights
+    REAL const * GetDuvWeights() const {
+        return _duvWeights;
+    }
+
+    /// \brief Returns the 'vv' derivative stencil interpolation weights
+    REAL const * GetDvvWeights() const {
+        return _dvvWeights;
+    }
+
+    /// \brief Updates derivative values based on the control values
+    ///
+    /// \note The destination buffers ('uderivs' & 'vderivs') are assumed to
+    ///       have allocated at least \c GetNumStencils() elements.
+    ///
+    template <class T>
+    void UpdateDerivs(T const *controlValues, T *uderivs, T *vderivs,
+        int start=-1, int end=-1) const {
+
+        this->update(controlValues, uderivs, _duWeights, start, end);
+        this->update(controlValues, vderivs, _dvWeights, start, end);
+    }
+
+    /// \brief Updates 2nd derivative values based on the control values
+    ///
+    /// \note The destination buffers ('uuderivs', 'uvderivs', & 'vvderivs')
+    ///       are assumed to have allocated at least \c GetNumStencils()
+    ///       elements, and the table must have second derivatives.
+    ///
+    template <class T>
+    void Update2ndDerivs(T const *controlValues,
+        T *uuderivs, T *uvderivs, T *vvderivs,
+        int start=-1, int end=-1) const {
+
+        this->update(controlValues, uuderivs, _duuWeights, start, end);
+        this->update(controlValues, uvderivs, _duvWeights, start, end);
+        this->update(controlValues, vvderivs, _dvvWeights, start, end);
+    }
+
+private:
+    explicit LimitStencilTableViewReal(internal::MappedBinaryFile * file)
+        : StencilTableViewReal<REAL>(file),
+          _duWeights(0), _dvWeights(0),
+          _duuWeights(0), _duvWeights(0), _dvvWeights(0) { }
+
+    static REAL * offsetWeights(REAL const * weights, Index ofs) {
+        return weights ? const_cast<REAL *>(weights + ofs) : 0;
+    }
+
+    REAL const * _duWeights,  // u derivative limit stencil weights
+               * _dvWeights,  // v derivative limit stencil weights
+               * _duuWeights, // uu derivative limit stencil weights
+               * _duvWeights, // uv derivative limit stencil weights
+               * _dvvWeights; // vv derivative limit stencil weights
+};
+
+/// \brief Single precision stencil table view
+typedef StencilTableViewReal<float> StencilTableView;
+
+/// \brief Single precision limit stencil table view
+typedef LimitStencilTableViewReal<float> LimitStencilTableView;
+
+
+// Update values by appling the stencil weights to the control values
+template <typename REAL>
+template <class T> void
+StencilTableViewReal<REAL>::update(T const *controlValues, T *values,
+    REAL const * valueWeights, Index start, Index end) const {
+
+    assert(valueWeights or _numStencils == 0);
+
+    int const * sizes = _sizes;
+    Index const * indices = _indices;
+    REAL const * weights = valueWeights;
+
+    if (start>0) {
+        assert(start<_numStencils);
+        sizes += start;
+        indices += _offsets[start];
+        weights += _offsets[start];
+        values += start;
+    }
+
+    if (end<start or end<0) {
+        end = GetNumStencils();
+    }
+
+    int nstencils = end - std::max(0, start);
+    for (int i=0; i<nstencils; ++i, ++sizes) {
+
+        // Zero out the result accumulators
+        values[i].Clear();
+
+        // For each element in the array, add the coefs contribution
+        for (int j=0; j<*sizes; ++j, ++indices, ++weights) {
+            values[i].AddWithWeight( controlValues[*indices], *weights );
+        }
+    }
+}
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // OPENSUBDIV3_FAR_STENCILTABLE_VIEW_H
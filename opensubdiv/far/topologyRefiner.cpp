@@ -22,6 +22,7 @@
 //   language governing permissions and limitations under the Apache License.
 //
 #include "../far/topologyRefiner.h"
+#include "../far/allocator.h"
 #include "../far/error.h"
 #include "../vtr/fvarLevel.h"
 #include "../vtr/sparseSelector.h"
@@ -168,6 +169,13 @@ TopologyRefiner::assembleFarLevels() {
         _farLevels[nRefinements]._level       = _levels[nRefinements];
         _farLevels[nRefinements]._refToChild  = 0;
     }
+
+    if (GetHugePagesMode() != HUGE_PAGES_NONE) {
+        void (*advise)(void const *, size_t) = AdviseHugePages;
+        for (int i = 0; i < (int)_levels.size(); ++i) {
+            _levels[i]->applyToArrays(advise);
+        }
+    }
 }
 
 
@@ -23,8 +23,12 @@
 //
 #include "../far/topologyRefinerFactory.h"
 #include "../far/topologyRefiner.h"
+#include "../far/binaryFile.h"
 #include "../sdc/types.h"
 #include "../vtr/level.h"
+#include "../vtr/quadRefinement.h"
+#include "../vtr/triRefinement.h"
+#include "../vtr/serialization.h"
 
 #include <cstdio>
 #ifdef _MSC_VER
@@ -303,6 +307,191 @@ TopologyRefinerFactoryBase::prepareFaceVaryingChannels(TopologyRefiner& refiner)
     return true;
 }
 
+//
+//  Snapshots of refiners:
+//      The values of the refiner are followed by those of its base level and by
+//  the child level and refinement of each refinement step.  The Vtr classes
+//  serialize their own members (see vtr/serialization.h).
+//
+//  The options of the refiner are written field by field, as the unused bits
+//  of their bitfields are undefined.  The file is stamped with the layout of
+//  the Vtr serialization, and the indices read are checked against the levels
+//  before the refiner is assembled.
+//
+namespace {
+    enum RefinerValue {
+        SCHEME_TYPE,
+        VTX_BOUNDARY_INTERPOLATION,
+        FVAR_LINEAR_INTERPOLATION,
+        CREASING_METHOD,
+        TRIANGLE_SUBDIVISION,
+        IS_UNIFORM,
+        HAS_HOLES,
+        MAX_LEVEL,
+        NUM_LEVELS,
+        UNIFORM_REFINEMENT_LEVEL,
+        UNIFORM_ORDER_VERTICES_FROM_FACES_FIRST,
+        UNIFORM_FULL_TOPOLOGY_IN_LAST_LEVEL,
+        ADAPTIVE_ISOLATION_LEVEL,
+        ADAPTIVE_USE_SINGLE_CREASE_PATCH,
+        ADAPTIVE_ORDER_VERTICES_FROM_FACES_FIRST,
+
+        NUM_REFINER_VALUES
+    };
+}
+
+bool
+TopologyRefinerFactoryBase::Write(char const * path, TopologyRefiner const & refiner) {
+
+    internal::BinaryFileWriter writer(internal::BINARY_FILE_TOPOLOGY_REFINER, 0,
+        Vtr::internal::getSerializationLayout());
+    internal::BinaryFileOutputArchive archive(writer);
+
+    int numLevels = (int)refiner._levels.size();
+
+    int values[NUM_REFINER_VALUES];
+    values[SCHEME_TYPE]                = refiner._subdivType;
+    values[VTX_BOUNDARY_INTERPOLATION] = refiner._subdivOptions.GetVtxBoundaryInterpolation();
+    values[FVAR_LINEAR_INTERPOLATION]  = refiner._subdivOptions.GetFVarLinearInterpolation();
+    values[CREASING_METHOD]            = refiner._subdivOptions.GetCreasingMethod();
+    values[TRIANGLE_SUBDIVISION]       = refiner._subdivOptions.GetTriangleSubdivision();
+    values[IS_UNIFORM]                 = refiner._isUniform;
+    values[HAS_HOLES]                  = refiner._hasHoles;
+    values[MAX_LEVEL]                  = refiner._maxLevel;
+    values[NUM_LEVELS]                 = numLevels;
+
+    values[UNIFORM_REFINEMENT_LEVEL]                 = refiner._uniformOptions.refinementLevel;
+    values[UNIFORM_ORDER_VERTICES_FROM_FACES_FIRST]  = refiner._uniformOptions.orderVerticesFromFacesFirst;
+    values[UNIFORM_FULL_TOPOLOGY_IN_LAST_LEVEL]      = refiner._uniformOptions.fullTopologyInLastLevel;
+    values[ADAPTIVE_ISOLATION_LEVEL]                 = refiner._adaptiveOptions.isolationLevel;
+    values[ADAPTIVE_USE_SINGLE_CREASE_PATCH]         = refiner._adaptiveOptions.useSingleCreasePatch;
+    values[ADAPTIVE_ORDER_VERTICES_FROM_FACES_FIRST] = refiner._adaptiveOptions.orderVerticesFromFacesFirst;
+
+    for (int i = 0; i < NUM_REFINER_VALUES; ++i) {
+        archive.value(values[i]);
+    }
+
+    Vtr::internal::Level const & baseLevel = *refiner._levels[0];
+    baseLevel.serialize(archive);
+    for (int i = 1; i < numLevels; ++i) {
+        Vtr::internal::Level const & level = *refiner._levels[i];
+        Vtr::internal::Refinement const & refinement = *refiner._refinements[i-1];
+        level.serialize(archive);
+        refinement.serialize(archive);
+    }
+    archive.Finish();
+
+    return writer.Write(path);
+}
+
+TopologyRefiner *
+TopologyRefinerFactoryBase::Read(char const * path) {
+
+    internal::MappedBinaryFile * file = internal::MappedBinaryFile::Open(
+        path, internal::BINARY_FILE_TOPOLOGY_REFINER, 0,
+        Vtr::internal::getSerializationLayout());
+    if (not file) {
+        return 0;
+    }
+
+    internal::BinaryFileInputArchive archive(*file);
+
+    int values[NUM_REFINER_VALUES];
+    for (int i = 0; i < NUM_REFINER_VALUES; ++i) {
+        values[i] = 0;
+        archive.value(values[i]);
+    }
+
+    Sdc::SchemeType schemeType = (Sdc::SchemeType)values[SCHEME_TYPE];
+
+    Sdc::Options schemeOptions;
+    schemeOptions.SetVtxBoundaryInterpolation(
+        (Sdc::Options::VtxBoundaryInterpolation)values[VTX_BOUNDARY_INTERPOLATION]);
+    schemeOptions.SetFVarLinearInterpolation(
+        (Sdc::Options::FVarLinearInterpolation)values[FVAR_LINEAR_INTERPOLATION]);
+    schemeOptions.SetCreasingMethod(
+        (Sdc::Options::CreasingMethod)values[CREASING_METHOD]);
+    schemeOptions.SetTriangleSubdivision(
+        (Sdc::Options::TriangleSubdivision)values[TRIANGLE_SUBDIVISION]);
+
+    int numLevels = values[NUM_LEVELS],
+        maxLevel  = values[MAX_LEVEL];
+
+    //  The levels are limited by the bits of the refinement level options:
+    bool valid = archive.IsValid() and
+                 (schemeType == Sdc::SCHEME_BILINEAR or
+                  schemeType == Sdc::SCHEME_CATMARK or
+                  schemeType == Sdc::SCHEME_LOOP) and
+                 numLevels >= 1 and numLevels <= 16 and
+                 maxLevel >= 0 and maxLevel < numLevels;
+
+    TopologyRefiner * refiner = 0;
+    if (valid) {
+        refiner = new TopologyRefiner(schemeType, schemeOptions);
+
+        refiner->_levels[0]->serialize(archive);
+        if (not archive.IsValid() or not refiner->_levels[0]->hasValidIndices()) {
+            valid = false;
+        } else {
+            refiner->initializeInventory();
+        }
+
+        Sdc::Split splitType = Sdc::SchemeTypeTraits::GetTopologicalSplitType(schemeType);
+
+        for (int i = 1; valid and i < numLevels; ++i) {
+            Vtr::internal::Level & parentLevel = refiner->getLevel(i-1);
+            Vtr::internal::Level & childLevel  = *(new Vtr::internal::Level);
+
+            //  The refinement is constructed first as it assigns the depth of
+            //  the child level, which is then read over:
+            Vtr::internal::Refinement * refinement = 0;
+            if (splitType == Sdc::SPLIT_TO_QUADS) {
+                refinement = new Vtr::internal::QuadRefinement(parentLevel, childLevel, schemeOptions);
+            } else {
+                refinement = new Vtr::internal::TriRefinement(parentLevel, childLevel, schemeOptions);
+            }
+            childLevel.serialize(archive);
+
+            refiner->appendLevel(childLevel);
+            refiner->appendRefinement(*refinement);
+
+            valid = archive.IsValid() and childLevel.hasValidIndices() and
+                    childLevel.getNumFVarChannels() == parentLevel.getNumFVarChannels();
+            if (valid) {
+                refinement->serialize(archive);
+                valid = archive.IsValid() and refinement->hasValidIndices();
+            }
+        }
+        valid = valid and archive.IsComplete() and
+                (int)refiner->_levels.size() == numLevels and
+                (int)refiner->_refinements.size() == numLevels - 1;
+    }
+
+    delete file;
+
+    if (not valid) {
+        Error(FAR_RUNTIME_ERROR, "Failure in TopologyRefinerFactoryBase::Read() -- "
+            "\"%s\": corrupted topology refiner", path);
+        delete refiner;
+        return 0;
+    }
+
+    refiner->_isUniform = values[IS_UNIFORM] ? 1 : 0;
+    refiner->_hasHoles  = values[HAS_HOLES] ? 1 : 0;
+    refiner->_maxLevel  = maxLevel;
+
+    refiner->_uniformOptions.refinementLevel             = values[UNIFORM_REFINEMENT_LEVEL];
+    refiner->_uniformOptions.orderVerticesFromFacesFirst = values[UNIFORM_ORDER_VERTICES_FROM_FACES_FIRST];
+    refiner->_uniformOptions.fullTopologyInLastLevel     = values[UNIFORM_FULL_TOPOLOGY_IN_LAST_LEVEL];
+
+    refiner->_adaptiveOptions.isolationLevel              = values[ADAPTIVE_ISOLATION_LEVEL];
+    refiner->_adaptiveOptions.useSingleCreasePatch        = values[ADAPTIVE_USE_SINGLE_CREASE_PATCH];
+    refiner->_adaptiveOptions.orderVerticesFromFacesFirst = values[ADAPTIVE_ORDER_VERTICES_FROM_FACES_FIRST];
+
+    refiner->assembleFarLevels();
+    return refiner;
+}
+
 } // end namespace Far
 
 } // end namespace OPENSUBDIV_VERSION
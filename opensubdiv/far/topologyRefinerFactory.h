@@ -45,6 +45,44 @@ namespace Far {
 /// independent of the subclass' mesh type.
 //
 class TopologyRefinerFactoryBase {
+public:
+
+    /// \brief Writes a snapshot of a refiner and all of its levels to a file
+    ///
+    /// The file holds the topology, tags and sharpness of every level, the
+    /// face-varying channels and the parent/child relations between levels,
+    /// so that a refiner can be restored without repeating the validation
+    /// of the base mesh and the refinement.  It is stamped with the layout
+    /// of the serialized topology, and is only meant to be read back by a
+    /// library of the same layout on the same architecture.
+    ///
+    /// @param path                 Path of the file
+    ///
+    /// @param refiner              Refiner to write (refined or not)
+    ///
+    /// @return                     False (and reports a FAR_RUNTIME_ERROR)
+    ///                             on failure
+    ///
+    static bool Write(char const * path, TopologyRefiner const & refiner);
+
+    /// \brief Reads a refiner file written with Write()
+    ///
+    /// The file is mapped in memory and the topology of its levels is copied.
+    /// The refiner returned is refined as the one written, and can be used
+    /// as such with PrimvarRefiner and the table factories.
+    ///
+    /// Files of another layout are rejected, and the indices read are
+    /// checked to refer to components of their levels, but the consistency
+    /// of the topology itself is not validated.
+    ///
+    /// @param path                 Path of the file
+    ///
+    /// @return                     A new instance of TopologyRefiner, or NULL
+    ///                             (and reports a FAR_RUNTIME_ERROR) if the
+    ///                             file can't be read
+    ///
+    static TopologyRefiner * Read(char const * path);
+
 protected:
 
     //
@@ -0,0 +1,123 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../far/transposedStencilTable.h"
+#include "../far/allocator.h"
+#include "../far/stencilTable.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+TransposedStencilTable::TransposedStencilTable(
+    StencilTable const & stencilTable) {
+
+    int numStencils = stencilTable.GetNumStencils();
+
+    std::vector<int> const & sizes = stencilTable.GetSizes();
+    std::vector<Index> const & indices = stencilTable.GetControlIndices();
+
+    // some tables refer to vertices past their control vertices (e.g. local
+    // point stencils that were not factorized)
+    int numVertices = stencilTable.GetNumControlVertices();
+    for (int i = 0; i < (int)indices.size(); ++i) {
+        numVertices = std::max(numVertices, indices[i] + 1);
+    }
+
+    _numStencils = numStencils;
+
+    _offsets.assign(numVertices + 1, 0);
+    for (int i = 0; i < (int)indices.size(); ++i) {
+        ++_offsets[indices[i] + 1];
+    }
+    for (int i = 0; i < numVertices; ++i) {
+        _offsets[i+1] += _offsets[i];
+    }
+
+    std::vector<float> const & weights = stencilTable.GetWeights();
+
+    // stencils are visited in order, so that the stencils of each vertex
+    // are sorted
+    _stencils.resize(indices.size());
+    _weights.resize(indices.size());
+    std::vector<int> fill(_offsets.begin(), _offsets.end() - 1);
+    for (int i = 0, entry = 0; i < numStencils; ++i) {
+        for (int j = 0; j < sizes[i]; ++j, ++entry) {
+            int & last = fill[indices[entry]];
+            // a vertex may appear more than once in a stencil
+            if (last == _offsets[indices[entry]] or _stencils[last-1] != i) {
+                _stencils[last] = i;
+                _weights[last] = weights[entry];
+                ++last;
+            } else {
+                _weights[last-1] += weights[entry];
+            }
+        }
+    }
+
+    // compact the duplicates out of the lists
+    int count = 0;
+    for (int i = 0; i < numVertices; ++i) {
+        int begin = _offsets[i],
+            end = fill[i];
+        _offsets[i] = count;
+        for (int j = begin; j < end; ++j, ++count) {
+            _stencils[count] = _stencils[j];
+            _weights[count] = _weights[j];
+        }
+    }
+    _offsets[numVertices] = count;
+    _stencils.resize(count);
+    _weights.resize(count);
+
+    AdviseHugePages(_offsets);
+    AdviseHugePages(_stencils);
+    AdviseHugePages(_weights);
+}
+
+void
+TransposedStencilTable::GetStencils(int numControlVertices,
+    Index const * controlVertices, std::vector<Index> & stencils) const {
+
+    stencils.clear();
+    for (int i = 0; i < numControlVertices; ++i) {
+        Index cv = controlVertices[i];
+        assert(cv >= 0 and cv < GetNumControlVertices());
+        stencils.insert(stencils.end(),
+            _stencils.begin() + _offsets[cv],
+            _stencils.begin() + _offsets[cv+1]);
+    }
+    std::sort(stencils.begin(), stencils.end());
+    stencils.erase(std::unique(stencils.begin(), stencils.end()),
+                   stencils.end());
+}
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
@@ -0,0 +1,128 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OPENSUBDIV3_FAR_TRANSPOSED_STENCILTABLE_H
+#define OPENSUBDIV3_FAR_TRANSPOSED_STENCILTABLE_H
+
+#include "../version.h"
+
+#include "../far/types.h"
+
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+class StencilTable;
+
+/// \brief Source-major view of a StencilTable
+///
+/// The TransposedStencilTable lists, for each control vertex of a
+/// StencilTable, the stencils that it supports, in increasing order, along
+/// with its weight in each of them. It answers which refined vertices must
+/// be updated when a few control vertices are edited, and applies the
+/// stencils to sparse sets of control values (e.g. blend shape offsets).
+///
+class TransposedStencilTable {
+
+public:
+
+    /// \brief Constructor
+    ///
+    /// @param stencilTable  The table to transpose
+    ///
+    TransposedStencilTable(StencilTable const & stencilTable);
+
+    /// \brief Returns the number of control vertices of the table
+    int GetNumControlVertices() const {
+        return (int)_offsets.size() - 1;
+    }
+
+    /// \brief Returns the number of stencils of the table
+    int GetNumStencils() const {
+        return _numStencils;
+    }
+
+    /// \brief Returns the indices of the stencils supported by a control
+    ///        vertex
+    ConstIndexArray GetStencils(Index controlVertex) const {
+        return ConstIndexArray(_stencils.empty() ? 0 :
+            &_stencils[0] + _offsets[controlVertex],
+            _offsets[controlVertex+1] - _offsets[controlVertex]);
+    }
+
+    /// \brief Returns the weights of a control vertex in the stencils that
+    ///        it supports (see GetStencils())
+    float const * GetWeights(Index controlVertex) const {
+        return _weights.empty() ? 0 :
+            &_weights[0] + _offsets[controlVertex];
+    }
+
+    /// \brief Returns the offset to the stencils of each control vertex
+    std::vector<int> const & GetOffsets() const {
+        return _offsets;
+    }
+
+    /// \brief Returns the stencils supported by the control vertices
+    std::vector<Index> const & GetStencilIndices() const {
+        return _stencils;
+    }
+
+    /// \brief Returns the weights of the control vertices in their stencils
+    std::vector<float> const & GetWeights() const {
+        return _weights;
+    }
+
+    /// \brief Gathers the stencils supported by a set of control vertices
+    ///
+    /// @param numControlVertices  The number of control vertices
+    ///
+    /// @param controlVertices     The indices of the control vertices
+    ///
+    /// @param stencils            Returns the indices of the stencils, in
+    ///                            increasing order and without duplicates
+    ///
+    void GetStencils(int numControlVertices, Index const * controlVertices,
+                     std::vector<Index> & stencils) const;
+
+private:
+
+    int _numStencils;
+
+    std::vector<int>   _offsets;   // offsets to the stencils of each vertex
+    std::vector<Index> _stencils;  // stencils supported by each vertex
+    std::vector<float> _weights;   // weights of the vertices in the stencils
+};
+
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // OPENSUBDIV3_FAR_TRANSPOSED_STENCILTABLE_H
@@ -0,0 +1,279 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#include "../osd/asyncEvaluation.h"
+
+#include <cassert>
+#include <cstddef>
+
+#if defined(OPENSUBDIV_HAS_THREADPOOL)
+    #include "../osd/threadPool.h"
+
+    #include <atomic>
+    #include <condition_variable>
+    #include <deque>
+    #include <mutex>
+    #include <thread>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+#if defined(OPENSUBDIV_HAS_THREADPOOL)
+
+struct AsyncEvaluation::State {
+    explicit State(Task * t) :
+        task(t), refCount(1), complete(false), result(false) { }
+
+    ~State() {
+        delete task;
+    }
+
+    void Release() {
+        if (--refCount == 0) {
+            delete this;
+        }
+    }
+
+    Task * task;
+    std::atomic<int> refCount;
+
+    std::mutex mutex;                  // guards the fields below
+    std::condition_variable finished;
+    bool complete,
+         result;
+};
+
+//
+// Runs the launched tasks in order on a single background thread, which is
+// started with the first task.
+//
+// The tasks of the ThreadPoolEvaluator run on the ThreadPool : the
+// dispatcher creates the pool before itself, so that the pool is destroyed
+// after the dispatcher has run the pending tasks and joined its thread at
+// exit.
+//
+class AsyncEvaluation::Dispatcher {
+public:
+    static Dispatcher & GetInstance() {
+        static Dispatcher dispatcher;
+        return dispatcher;
+    }
+
+    void Push(State * state) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (not _thread.joinable()) {
+            _thread = std::thread(&Dispatcher::run, this);
+        }
+        _states.push_back(state);
+        ++_numPending;
+        _wake.notify_one();
+    }
+
+    void WaitAll() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_numPending > 0) {
+            _idle.wait(lock);
+        }
+    }
+
+private:
+    Dispatcher() : _numPending(0), _stop(false) {
+        ThreadPool::GetInstance();
+    }
+
+    ~Dispatcher() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_one();
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;) {
+            while (_states.empty() and not _stop) {
+                _wake.wait(lock);
+            }
+            // the pending tasks are run before stopping
+            if (_states.empty()) return;
+
+            State * state = _states.front();
+            _states.pop_front();
+
+            lock.unlock();
+            bool result = state->task->Run();
+            {
+                std::lock_guard<std::mutex> stateLock(state->mutex);
+                state->complete = true;
+                state->result = result;
+            }
+            state->finished.notify_all();
+            state->Release();
+            lock.lock();
+
+            if (--_numPending == 0) {
+                _idle.notify_all();
+            }
+        }
+    }
+
+    std::mutex _mutex;                 // guards the fields below
+    std::condition_variable _wake,     // signals a new task or stop
+                            _idle;     // signals _numPending reaching 0
+    std::deque<State *> _states;
+    int _numPending;                   // queued or running tasks
+    bool _stop;
+
+    std::thread _thread;
+};
+
+AsyncEvaluation
+AsyncEvaluation::Launch(Task * task) {
+
+    assert(task);
+
+    // the dispatcher holds a reference until the task is complete
+    State * state = new State(task);
+    ++state->refCount;
+    Dispatcher::GetInstance().Push(state);
+
+    return AsyncEvaluation(state);
+}
+
+void
+AsyncEvaluation::WaitAll() {
+    Dispatcher::GetInstance().WaitAll();
+}
+
+AsyncEvaluation::AsyncEvaluation(AsyncEvaluation const & other) :
+    _state(other._state) {
+
+    if (_state) ++_state->refCount;
+}
+
+AsyncEvaluation::~AsyncEvaluation() {
+    if (_state) _state->Release();
+}
+
+AsyncEvaluation &
+AsyncEvaluation::operator = (AsyncEvaluation const & other) {
+    if (other._state) ++other._state->refCount;
+    if (_state) _state->Release();
+    _state = other._state;
+    return *this;
+}
+
+bool
+AsyncEvaluation::IsComplete() const {
+    if (not _state) return true;
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    return _state->complete;
+}
+
+bool
+AsyncEvaluation::Wait() const {
+    if (not _state) return true;
+    std::unique_lock<std::mutex> lock(_state->mutex);
+    while (not _state->complete) {
+        _state->finished.wait(lock);
+    }
+    return _state->result;
+}
+
+#else
+
+//
+// Without thread support, the tasks run synchronously : the handles only
+// record the result.
+//
+struct AsyncEvaluation::State {
+    explicit State(bool r) : refCount(1), result(r) { }
+
+    int refCount;
+    bool result;
+};
+
+AsyncEvaluation
+AsyncEvaluation::Launch(Task * task) {
+
+    assert(task);
+
+    bool result = task->Run();
+    delete task;
+
+    return AsyncEvaluation(new State(result));
+}
+
+void
+AsyncEvaluation::WaitAll() {
+}
+
+AsyncEvaluation::AsyncEvaluation(AsyncEvaluation const & other) :
+    _state(other._state) {
+
+    if (_state) ++_state->refCount;
+}
+
+AsyncEvaluation::~AsyncEvaluation() {
+    if (_state and --_state->refCount == 0) delete _state;
+}
+
+AsyncEvaluation &
+AsyncEvaluation::operator = (AsyncEvaluation const & other) {
+    if (other._state) ++other._state->refCount;
+    if (_state and --_state->refCount == 0) delete _state;
+    _state = other._state;
+    return *this;
+}
+
+bool
+AsyncEvaluation::IsComplete() const {
+    return true;
+}
+
+bool
+AsyncEvaluation::Wait() const {
+    return _state ? _state->result : true;
+}
+
+#endif
+
+AsyncEvaluation::AsyncEvaluation() : _state(NULL) {
+}
+
+AsyncEvaluation::AsyncEvaluation(State * state) : _state(state) {
+}
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
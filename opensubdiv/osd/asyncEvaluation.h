@@ -0,0 +1,147 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#ifndef OPENSUBDIV3_OSD_ASYNC_EVALUATION_H
+#define OPENSUBDIV3_OSD_ASYNC_EVALUATION_H
+
+#include "../version.h"
+
+#include "../osd/bufferDescriptor.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+/// \brief Completion handle of an evaluation running in the background
+///
+/// The EvalStencilsAsync() functions of the CPU evaluators launch their
+/// evaluation and return at once with an AsyncEvaluation, which tells when
+/// the results are available.
+///
+/// Asynchronous evaluations run one at a time on a background thread, in the
+/// order they were launched : an evaluation may consume the results of any
+/// evaluation launched before it. The buffers of an evaluation must remain
+/// valid, and its source data unchanged, until it completes.
+///
+/// Handles are reference counted and can be copied freely. Releasing them
+/// does not wait for the evaluation : use Wait() or the evaluators'
+/// Synchronize().
+///
+/// \note When the library is built without C++11 thread support
+///       (NO_THREADPOOL), the evaluations run synchronously and the handles
+///       are returned complete.
+///
+class AsyncEvaluation {
+public:
+
+    /// \brief Work of an asynchronous evaluation
+    class Task {
+    public:
+        virtual ~Task() { }
+
+        /// Runs the evaluation and returns its result
+        virtual bool Run() = 0;
+    };
+
+    /// \brief Launches a task on the background thread
+    ///
+    /// @param task  The task to run, which is deleted once complete
+    ///
+    static AsyncEvaluation Launch(Task * task);
+
+    /// \brief Waits for all the launched evaluations to complete
+    static void WaitAll();
+
+    /// Constructor (the handle is complete, with a successful result)
+    AsyncEvaluation();
+
+    /// Copy constructor
+    AsyncEvaluation(AsyncEvaluation const & other);
+
+    /// Destructor
+    ~AsyncEvaluation();
+
+    /// Assignment
+    AsyncEvaluation & operator = (AsyncEvaluation const & other);
+
+    /// \brief Returns true once the evaluation is complete
+    bool IsComplete() const;
+
+    /// \brief Waits for the evaluation to complete and returns its result
+    bool Wait() const;
+
+private:
+    struct State;
+    class Dispatcher;
+
+    explicit AsyncEvaluation(State * state);
+
+    State * _state;
+};
+
+/// \brief Task evaluating a range of stencils with the raw pointer
+///        EvalStencils() function of EVALUATOR
+template <class EVALUATOR>
+class AsyncEvalStencilsTask : public AsyncEvaluation::Task {
+public:
+    AsyncEvalStencilsTask(const float *src,  BufferDescriptor const &srcDesc,
+                          float *dst,        BufferDescriptor const &dstDesc,
+                          const int * sizes,
+                          const int * offsets,
+                          const int * indices,
+                          const float * weights,
+                          int start, int end) :
+        _src(src), _dst(dst), _srcDesc(srcDesc), _dstDesc(dstDesc),
+        _sizes(sizes), _offsets(offsets), _indices(indices),
+        _weights(weights), _start(start), _end(end) { }
+
+    virtual bool Run() {
+        return EVALUATOR::EvalStencils(_src, _srcDesc, _dst, _dstDesc,
+                                       _sizes, _offsets, _indices, _weights,
+                                       _start, _end);
+    }
+
+private:
+    const float * _src;
+    float * _dst;
+    BufferDescriptor _srcDesc,
+                     _dstDesc;
+    const int * _sizes,
+              * _offsets,
+              * _indices;
+    const float * _weights;
+    int _start,
+        _end;
+};
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OPENSUBDIV3_OSD_ASYNC_EVALUATION_H
@@ -41,7 +41,11 @@ namespace Osd {
 ///        batching offset if the data buffer is combined across multiple
 ///        objects together.
 ///
-///        * Note that each element has the same data type (float)
+///        * Note that each element has the same data type : float by
+///          default. The CPU evaluators also accept half precision (fp16)
+///          elements, in which case the float pointers passed along with the
+///          descriptor address 16-bit elements, and offset and stride count
+///          16-bit elements as well.
 ///
 
 //  example:
@@ -60,11 +64,25 @@ namespace Osd {
 //
 struct BufferDescriptor {
 
+    /// Element data types
+    enum ElementType {
+        FLOAT32 = 0,    ///< 32-bit IEEE float (default)
+        FLOAT16         ///< 16-bit IEEE half float (CPU evaluators only, the
+                        ///< GPU evaluators reject it)
+    };
+
     /// Default Constructor
-    BufferDescriptor() : offset(0), length(0), stride(0) { }
+    BufferDescriptor() : offset(0), length(0), stride(0),
+                         elementType(FLOAT32) { }
 
     /// Constructor
-    BufferDescriptor(int o, int l, int s) : offset(o), length(l), stride(s) { }
+    BufferDescriptor(int o, int l, int s, ElementType t = FLOAT32) :
+        offset(o), length(l), stride(s), elementType(t) { }
+
+    /// Returns the size of an element in bytes
+    int GetElementSize() const {
+        return elementType == FLOAT16 ? 2 : 4;
+    }
 
     /// Returns the relative offset within a stride
     int GetLocalOffset() const {
@@ -80,13 +98,15 @@ struct BufferDescriptor {
     /// Resets the descriptor to default
     void Reset() {
         offset = length = stride = 0;
+        elementType = FLOAT32;
     }
 
     /// True if the descriptors are identical
     bool operator == (BufferDescriptor const &other) const {
         return (offset == other.offset and
                 length == other.length and
-                stride == other.stride);
+                stride == other.stride and
+                elementType == other.elementType);
     }
 
     /// True if the descriptors are not identical
@@ -100,6 +120,61 @@ struct BufferDescriptor {
     int length;
     /// stride to the next element
     int stride;
+    /// data type of the elements
+    ElementType elementType;
+};
+
+/// \brief SoABufferDescriptor describes primvar data stored as a structure
+///        of arrays : each element of the primvar in its own plane of
+///        contiguous values, one per vertex. (CPU evaluators only)
+///
+
+//  example:
+//       n              n + planeStride        n + 2 * planeStride
+//  -----+--------------+---------------------+------------------+----------
+//       | X0 X1 X2 ... | Y0 Y1 Y2 ...        | Z0 Z1 Z2 ...     |
+//  -----+--------------+---------------------+------------------+----------
+//       <--- planeStride ------------------->
+//
+//     - XYZ      (offset = n, length = 3, planeStride)
+//
+struct SoABufferDescriptor {
+
+    /// Default Constructor
+    SoABufferDescriptor() : offset(0), length(0), planeStride(0) { }
+
+    /// Constructor
+    SoABufferDescriptor(int o, int l, int p) :
+        offset(o), length(l), planeStride(p) { }
+
+    /// True if the descriptor values are internally consistent
+    bool IsValid() const {
+        return length > 0 and planeStride > 0;
+    }
+
+    /// Resets the descriptor to default
+    void Reset() {
+        offset = length = planeStride = 0;
+    }
+
+    /// True if the descriptors are identical
+    bool operator == (SoABufferDescriptor const &other) const {
+        return (offset == other.offset and
+                length == other.length and
+                planeStride == other.planeStride);
+    }
+
+    /// True if the descriptors are not identical
+    bool operator != (SoABufferDescriptor const &other) const {
+        return !(this->operator==(other));
+    }
+
+    /// offset to the first value of the first plane
+    int offset;
+    /// number of elements (planes) of the primvar
+    int length;
+    /// distance between the planes of consecutive elements
+    int planeStride;
 };
 
 } // end namespace Osd
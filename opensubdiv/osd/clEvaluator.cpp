@@ -135,6 +135,14 @@ CLEvaluator::Compile(BufferDescriptor const &srcDesc,
         return false;
     }
 
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32) {
+        Far::Error(Far::FAR_RUNTIME_ERROR,
+                   "half precision primvars are only supported by the "
+                   "CPU evaluators.\n");
+        return false;
+    }
+
     cl_int errNum;
 
     std::ostringstream defines;
@@ -208,6 +216,12 @@ CLEvaluator::EvalStencils(cl_mem src, BufferDescriptor const &srcDesc,
                           unsigned int numStartEvents,
                           const cl_event* startEvents,
                           cl_event* endEvent) const {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
+
     if (end <= start) return true;
 
     size_t globalWorkSize = (size_t)(end - start);
@@ -255,6 +269,14 @@ CLEvaluator::EvalStencils(cl_mem src, BufferDescriptor const &srcDesc,
                           unsigned int numStartEvents,
                           const cl_event* startEvents,
                           cl_event* endEvent) const {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32 ||
+        duDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dvDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
+
     if (end <= start) return true;
 
     size_t globalWorkSize = (size_t)(end - start);
@@ -308,6 +330,13 @@ CLEvaluator::EvalPatches(cl_mem src, BufferDescriptor const &srcDesc,
                          unsigned int numStartEvents,
                          const cl_event* startEvents,
                          cl_event* endEvent) const {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32 ||
+        duDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dvDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
 
     size_t globalWorkSize = (size_t)(numPatchCoords);
 
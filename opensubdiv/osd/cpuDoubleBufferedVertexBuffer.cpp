@@ -0,0 +1,109 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#include "../osd/cpuDoubleBufferedVertexBuffer.h"
+#include "../far/allocator.h"
+
+#include <string.h>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+CpuDoubleBufferedVertexBuffer::CpuDoubleBufferedVertexBuffer(
+    int numElements, int numVertices)
+    : _numElements(numElements),
+      _numVertices(numVertices),
+      _front(0) {
+
+    size_t size = (size_t)numElements * numVertices * sizeof(float);
+    _cpuBuffers[0] = static_cast<float *>(Far::Allocate(size));
+    _cpuBuffers[1] = static_cast<float *>(Far::Allocate(size));
+}
+
+CpuDoubleBufferedVertexBuffer::~CpuDoubleBufferedVertexBuffer() {
+
+    Far::Free(_cpuBuffers[0]);
+    Far::Free(_cpuBuffers[1]);
+}
+
+CpuDoubleBufferedVertexBuffer *
+CpuDoubleBufferedVertexBuffer::Create(int numElements, int numVertices,
+                                      void * /*deviceContext*/) {
+
+    CpuDoubleBufferedVertexBuffer * instance =
+        new CpuDoubleBufferedVertexBuffer(numElements, numVertices);
+    if ((instance->_cpuBuffers[0] and instance->_cpuBuffers[1]) or
+        numElements * numVertices == 0) {
+        return instance;
+    }
+    delete instance;
+    return NULL;
+}
+
+void
+CpuDoubleBufferedVertexBuffer::UpdateData(const float *src,
+                                          int startVertex, int numVertices,
+                                          void * /*deviceContext*/) {
+
+    memcpy(BindBackCpuBuffer() + startVertex * _numElements,
+           src, GetNumElements() * numVertices * sizeof(float));
+}
+
+int
+CpuDoubleBufferedVertexBuffer::GetNumElements() const {
+
+    return _numElements;
+}
+
+int
+CpuDoubleBufferedVertexBuffer::GetNumVertices() const {
+
+    return _numVertices;
+}
+
+float*
+CpuDoubleBufferedVertexBuffer::BindCpuBuffer() {
+
+    return _cpuBuffers[_front];
+}
+
+float*
+CpuDoubleBufferedVertexBuffer::BindBackCpuBuffer() {
+
+    return _cpuBuffers[1 - _front];
+}
+
+void
+CpuDoubleBufferedVertexBuffer::Swap() {
+
+    _front = 1 - _front;
+}
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
@@ -0,0 +1,101 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#ifndef OPENSUBDIV3_OSD_CPU_DOUBLE_BUFFERED_VERTEX_BUFFER_H
+#define OPENSUBDIV3_OSD_CPU_DOUBLE_BUFFERED_VERTEX_BUFFER_H
+
+#include "../version.h"
+
+#include <cstddef>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+/// \brief Double-buffered vertex buffer class for cpu subdivision.
+///
+/// CpuDoubleBufferedVertexBuffer holds two copies of the vertex data : the
+/// front buffer is bound for the evaluations, while UpdateData() writes to
+/// the back buffer, so that the control vertices of the next frame can be
+/// uploaded while an asynchronous evaluation of the current frame is running
+/// (see AsyncEvaluation). Swap() exchanges the buffers once the evaluation is
+/// complete.
+///
+/// An instance of this buffer class can be passed to the CPU evaluators.
+///
+class CpuDoubleBufferedVertexBuffer {
+public:
+    /// Creator. Returns NULL if error.
+    static CpuDoubleBufferedVertexBuffer * Create(int numElements,
+                                                  int numVertices,
+                                                  void *deviceContext = NULL);
+
+    /// Destructor.
+    ~CpuDoubleBufferedVertexBuffer();
+
+    /// This method is meant to be used in client code in order to provide
+    /// coarse vertices data to Osd : the data is written to the back buffer.
+    void UpdateData(const float *src, int startVertex, int numVertices,
+                    void *deviceContext = NULL);
+
+    /// Returns how many elements defined in this vertex buffer.
+    int GetNumElements() const;
+
+    /// Returns how many vertices allocated in this vertex buffer.
+    int GetNumVertices() const;
+
+    /// Returns the address of the front CPU buffer
+    float * BindCpuBuffer();
+
+    /// Returns the address of the back CPU buffer
+    float * BindBackCpuBuffer();
+
+    /// \brief Exchanges the front and back buffers
+    ///
+    /// The evaluations using either buffer must be complete.
+    ///
+    void Swap();
+
+protected:
+    /// Constructor.
+    CpuDoubleBufferedVertexBuffer(int numElements, int numVertices);
+
+private:
+    int _numElements;
+    int _numVertices;
+    float *_cpuBuffers[2];
+    int _front;
+};
+
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OPENSUBDIV3_OSD_CPU_DOUBLE_BUFFERED_VERTEX_BUFFER_H
@@ -24,7 +24,7 @@
 
 #include "../osd/cpuEvaluator.h"
 #include "../osd/cpuKernel.h"
-#include "../far/patchBasis.h"
+#include "../far/stats.h"
 
 #include <cstdlib>
 
@@ -33,6 +33,12 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Osd {
 
+// half precision storage is only supported by the single precision kernels
+static inline bool
+isFloat32(BufferDescriptor const &desc) {
+    return desc.elementType == BufferDescriptor::FLOAT32;
+}
+
 /* static */
 bool
 CpuEvaluator::EvalStencils(const float *src, BufferDescriptor const &srcDesc,
@@ -46,6 +52,10 @@ CpuEvaluator::EvalStencils(const float *src, BufferDescriptor const &srcDesc,
     if (end <= start) return true;
     if (srcDesc.length != dstDesc.length) return false;
 
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end, srcDesc, dstDesc,
+                       CpuGetNumOutputs(dst), sizeof(float));
+
     // XXX: we can probably expand cpuKernel.cpp to here.
     CpuEvalStencils(src, srcDesc, dst, dstDesc,
                     sizes, offsets, indices, weights, start, end);
@@ -53,6 +63,30 @@ CpuEvaluator::EvalStencils(const float *src, BufferDescriptor const &srcDesc,
     return true;
 }
 
+/* static */
+bool
+CpuEvaluator::EvalStencils(const double *src, BufferDescriptor const &srcDesc,
+                           double *dst,       BufferDescriptor const &dstDesc,
+                           const int * sizes,
+                           const int * offsets,
+                           const int * indices,
+                           const double * weights,
+                           int start, int end) {
+
+    if (end <= start) return true;
+    if (srcDesc.length != dstDesc.length) return false;
+    if (not isFloat32(srcDesc) or not isFloat32(dstDesc)) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end, srcDesc, dstDesc,
+                       CpuGetNumOutputs(dst), sizeof(double));
+
+    CpuEvalStencils(src, srcDesc, dst, dstDesc,
+                    sizes, offsets, indices, weights, start, end);
+
+    return true;
+}
+
 /* static */
 bool
 CpuEvaluator::EvalStencils(const float *src, BufferDescriptor const &srcDesc,
@@ -70,6 +104,13 @@ CpuEvaluator::EvalStencils(const float *src, BufferDescriptor const &srcDesc,
     if (srcDesc.length != dstDesc.length) return false;
     if (srcDesc.length != duDesc.length) return false;
     if (srcDesc.length != dvDesc.length) return false;
+    if ((du and not duWeights) or (dv and not dvWeights)) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end, srcDesc,
+                       CpuGetOutputDesc(dst, dstDesc,
+                                        CpuGetOutputDesc(du, duDesc, dvDesc)),
+                       CpuGetNumOutputs(dst, du, dv), sizeof(float));
 
     CpuEvalStencils(src, srcDesc,
                     dst, dstDesc,
@@ -82,34 +123,317 @@ CpuEvaluator::EvalStencils(const float *src, BufferDescriptor const &srcDesc,
     return true;
 }
 
-template <typename T>
-struct BufferAdapter {
-    BufferAdapter(T *p, int length, int stride) :
-        _p(p), _length(length), _stride(stride) { }
-    void Clear() {
-        for (int i = 0; i < _length; ++i) _p[i] = 0;
-    }
-    void AddWithWeight(T const *src, float w) {
-        if (_p) {
-            for (int i = 0; i < _length; ++i) {
-                _p[i] += src[i] * w;
-            }
-        }
-    }
-    const T *operator[] (int index) const {
-        return _p + _stride * index;
+/* static */
+bool
+CpuEvaluator::EvalStencils(const double *src, BufferDescriptor const &srcDesc,
+                           double *dst,       BufferDescriptor const &dstDesc,
+                           double *du,        BufferDescriptor const &duDesc,
+                           double *dv,        BufferDescriptor const &dvDesc,
+                           const int * sizes,
+                           const int * offsets,
+                           const int * indices,
+                           const double * weights,
+                           const double * duWeights,
+                           const double * dvWeights,
+                           int start, int end) {
+    if (end <= start) return true;
+    if (srcDesc.length != dstDesc.length) return false;
+    if (srcDesc.length != duDesc.length) return false;
+    if (srcDesc.length != dvDesc.length) return false;
+    if ((du and not duWeights) or (dv and not dvWeights)) return false;
+    if (not isFloat32(srcDesc) or not isFloat32(dstDesc) or
+        not isFloat32(duDesc) or not isFloat32(dvDesc)) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end, srcDesc,
+                       CpuGetOutputDesc(dst, dstDesc,
+                                        CpuGetOutputDesc(du, duDesc, dvDesc)),
+                       CpuGetNumOutputs(dst, du, dv), sizeof(double));
+
+    CpuEvalStencils(src, srcDesc,
+                    dst, dstDesc,
+                    du,  duDesc,
+                    dv,  dvDesc,
+                    sizes, offsets, indices,
+                    weights, duWeights, dvWeights,
+                    start, end);
+
+    return true;
+}
+
+/* static */
+bool
+CpuEvaluator::EvalStencils(const float *src, BufferDescriptor const &srcDesc,
+                           float *dst,       BufferDescriptor const &dstDesc,
+                           float *du,        BufferDescriptor const &duDesc,
+                           float *dv,        BufferDescriptor const &dvDesc,
+                           float *duu,       BufferDescriptor const &duuDesc,
+                           float *duv,       BufferDescriptor const &duvDesc,
+                           float *dvv,       BufferDescriptor const &dvvDesc,
+                           const int * sizes,
+                           const int * offsets,
+                           const int * indices,
+                           const float * weights,
+                           const float * duWeights,
+                           const float * dvWeights,
+                           const float * duuWeights,
+                           const float * duvWeights,
+                           const float * dvvWeights,
+                           int start, int end) {
+    if (end <= start) return true;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (du  and srcDesc.length != duDesc.length)  return false;
+    if (dv  and srcDesc.length != dvDesc.length)  return false;
+    if (duu and srcDesc.length != duuDesc.length) return false;
+    if (duv and srcDesc.length != duvDesc.length) return false;
+    if (dvv and srcDesc.length != dvvDesc.length) return false;
+    if ((du  and not duWeights)  or (dv  and not dvWeights) or
+        (duu and not duuWeights) or (duv and not duvWeights) or
+        (dvv and not dvvWeights)) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end, srcDesc,
+                       CpuGetOutputDesc(dst, dstDesc, duDesc),
+                       CpuGetNumOutputs(dst, du, dv, duu, duv, dvv),
+                       sizeof(float));
+
+    CpuEvalStencils(src, srcDesc,
+                    dst, dstDesc,
+                    du,  duDesc,
+                    dv,  dvDesc,
+                    duu, duuDesc,
+                    duv, duvDesc,
+                    dvv, dvvDesc,
+                    sizes, offsets, indices,
+                    weights, duWeights, dvWeights,
+                    duuWeights, duvWeights, dvvWeights,
+                    start, end);
+
+    return true;
+}
+
+/* static */
+bool
+CpuEvaluator::EvalStencils(const double *src, BufferDescriptor const &srcDesc,
+                           double *dst,       BufferDescriptor const &dstDesc,
+                           double *du,        BufferDescriptor const &duDesc,
+                           double *dv,        BufferDescriptor const &dvDesc,
+                           double *duu,       BufferDescriptor const &duuDesc,
+                           double *duv,       BufferDescriptor const &duvDesc,
+                           double *dvv,       BufferDescriptor const &dvvDesc,
+                           const int * sizes,
+                           const int * offsets,
+                           const int * indices,
+                           const double * weights,
+                           const double * duWeights,
+                           const double * dvWeights,
+                           const double * duuWeights,
+                           const double * duvWeights,
+                           const double * dvvWeights,
+                           int start, int end) {
+    if (end <= start) return true;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (du  and srcDesc.length != duDesc.length)  return false;
+    if (dv  and srcDesc.length != dvDesc.length)  return false;
+    if (duu and srcDesc.length != duuDesc.length) return false;
+    if (duv and srcDesc.length != duvDesc.length) return false;
+    if (dvv and srcDesc.length != dvvDesc.length) return false;
+    if ((du  and not duWeights)  or (dv  and not dvWeights) or
+        (duu and not duuWeights) or (duv and not duvWeights) or
+        (dvv and not dvvWeights)) return false;
+    if (not isFloat32(srcDesc) or not isFloat32(dstDesc) or
+        not isFloat32(duDesc) or not isFloat32(dvDesc) or
+        not isFloat32(duuDesc) or not isFloat32(duvDesc) or
+        not isFloat32(dvvDesc)) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end, srcDesc,
+                       CpuGetOutputDesc(dst, dstDesc, duDesc),
+                       CpuGetNumOutputs(dst, du, dv, duu, duv, dvv),
+                       sizeof(double));
+
+    CpuEvalStencils(src, srcDesc,
+                    dst, dstDesc,
+                    du,  duDesc,
+                    dv,  dvDesc,
+                    duu, duuDesc,
+                    duv, duvDesc,
+                    dvv, dvvDesc,
+                    sizes, offsets, indices,
+                    weights, duWeights, dvWeights,
+                    duuWeights, duvWeights, dvvWeights,
+                    start, end);
+
+    return true;
+}
+
+/* static */
+bool
+CpuEvaluator::EvalStencils(
+    int numBuffers,
+    const float * const *srcs, BufferDescriptor const *srcDescs,
+    float * const *dsts,       BufferDescriptor const *dstDescs,
+    const int * sizes,
+    const int * offsets,
+    const int * indices,
+    const float * weights,
+    int start, int end) {
+
+    if (end <= start) return true;
+    for (int i = 0; i < numBuffers; ++i) {
+        if (srcDescs[i].length != dstDescs[i].length) return false;
     }
-    BufferAdapter<T> & operator ++() {
-        if (_p) {
-            _p += _stride;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end,
+                       numBuffers, srcDescs, dstDescs, sizeof(float));
+
+    CpuEvalStencils(numBuffers, srcs, srcDescs, dsts, dstDescs,
+                    sizes, offsets, indices, weights, start, end);
+
+    return true;
+}
+
+/* static */
+bool
+CpuEvaluator::EvalStencils(const float *src, SoABufferDescriptor const &srcDesc,
+                           float *dst,       SoABufferDescriptor const &dstDesc,
+                           const int * sizes,
+                           const int * offsets,
+                           const int * indices,
+                           const float * weights,
+                           int start, int end) {
+
+    if (end <= start) return true;
+    if (srcDesc.length != dstDesc.length) return false;
+    if (not srcDesc.IsValid() or not dstDesc.IsValid()) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end,
+                       BufferDescriptor(0, srcDesc.length, srcDesc.length),
+                       BufferDescriptor(0, dstDesc.length, dstDesc.length),
+                       1, sizeof(float));
+
+    CpuEvalStencils(src, srcDesc, dst, dstDesc,
+                    sizes, offsets, indices, weights, start, end);
+    return true;
+}
+
+/* static */
+bool
+CpuEvaluator::EvalInstanceStencils(
+    int numInstances,
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    const int * sizes,
+    const int * offsets,
+    const int * indices,
+    const float * weights,
+    int start, int end) {
+
+    if (end <= start) return true;
+    if (srcDesc.length != dstDesc.length) return false;
+
+    // the instances of a vertex are evaluated as a single wide primvar
+    BufferDescriptor instancesSrcDesc(srcDesc.offset,
+                                      srcDesc.length * numInstances,
+                                      srcDesc.stride, srcDesc.elementType),
+                     instancesDstDesc(dstDesc.offset,
+                                      dstDesc.length * numInstances,
+                                      dstDesc.stride, dstDesc.elementType);
+
+    if (instancesSrcDesc.length > srcDesc.stride or
+        instancesDstDesc.length > dstDesc.stride) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalInstanceStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end,
+                       instancesSrcDesc, instancesDstDesc, 1, sizeof(float));
+
+    CpuEvalStencils(src, instancesSrcDesc, dst, instancesDstDesc,
+                    sizes, offsets, indices, weights, start, end);
+
+    return true;
+}
+
+/* static */
+bool
+CpuEvaluator::EvalStencilList(const float *src,
+                              BufferDescriptor const &srcDesc,
+                              float *dst, BufferDescriptor const &dstDesc,
+                              const int * sizes,
+                              const int * offsets,
+                              const int * indices,
+                              const float * weights,
+                              const int * stencils, int numStencils) {
+
+    if (srcDesc.length != dstDesc.length) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencilList");
+    CpuSetStencilListStats(stats, sizes, stencils, numStencils,
+                           srcDesc, dstDesc, 1, sizeof(float));
+
+    // runs of consecutive stencils go through the range kernels
+    for (int i = 0; i < numStencils; ) {
+        int start = stencils[i],
+            end = start + 1;
+        for (++i; i < numStencils and stencils[i] == end; ++i) {
+            ++end;
         }
-        return *this;
+        CpuEvalStencils(src, srcDesc, dst, dstDesc,
+                        sizes, offsets, indices, weights, start, end);
     }
+    return true;
+}
+
+/* static */
+bool
+CpuEvaluator::EvalStencilDeltas(const float *deltas,
+                                BufferDescriptor const &deltaDesc,
+                                const int * deltaVertices, int numDeltas,
+                                float *dst, BufferDescriptor const &dstDesc,
+                                const int * offsets,
+                                const int * stencils,
+                                const float * weights) {
+
+    if (deltaDesc.length != dstDesc.length) return false;
+    if (not isFloat32(deltaDesc) or not isFloat32(dstDesc)) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencilDeltas");
+    CpuSetStencilStats(stats, offsets, deltaVertices, numDeltas,
+                       deltaDesc, dstDesc, sizeof(float));
+
+    CpuEvalStencilDeltas(deltas, deltaDesc, deltaVertices, numDeltas,
+                         dst, dstDesc, offsets, stencils, weights);
 
-    T *_p;
-    int _length;
-    int _stride;
-};
+    return true;
+}
+
+/* static */
+bool
+CpuEvaluator::EvalStencils(const float *src, BufferDescriptor const &srcDesc,
+                           float *dst,       BufferDescriptor const &dstDesc,
+                           const unsigned char * sizes,
+                           const float * scales,
+                           const int * blockIndexOffsets,
+                           const int * blockWeightOffsets,
+                           const unsigned char * indices,
+                           const short * weights,
+                           int start, int end) {
+
+    if (end <= start) return true;
+    if (srcDesc.length != dstDesc.length) return false;
+    // the compressed kernel reads and writes floats only
+    if (not isFloat32(srcDesc) or not isFloat32(dstDesc)) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencils");
+    CpuSetCompressedStencilStats(stats, sizes, start, end, srcDesc, dstDesc);
+
+    CpuEvalStencils(src, srcDesc, dst, dstDesc,
+                    sizes, scales, blockIndexOffsets, blockWeightOffsets,
+                    indices, weights, start, end);
+
+    return true;
+}
 
 /* static */
 bool
@@ -120,61 +444,44 @@ CpuEvaluator::EvalPatches(const float *src, BufferDescriptor const &srcDesc,
                           const PatchArray *patchArrays,
                           const int *patchIndexBuffer,
                           const PatchParam *patchParamBuffer) {
-    if (src) {
-        src += srcDesc.offset;
-    } else {
-        return false;
-    }
-    if (dst) {
-        dst += dstDesc.offset;
-        if (srcDesc.length != dstDesc.length) return false;
-    } else {
-        return false;
-    }
+    if (not src or not dst) return false;
+    if (srcDesc.length != dstDesc.length) return false;
 
-    BufferAdapter<const float> srcT(src, srcDesc.length, srcDesc.stride);
-    BufferAdapter<float>       dstT(dst, dstDesc.length, dstDesc.stride);
-
-    float wP[20], wDs[20], wDt[20];
-
-    for (int i = 0; i < numPatchCoords; ++i) {
-        PatchCoord const &coord = patchCoords[i];
-        PatchArray const &array = patchArrays[coord.handle.arrayIndex];
-
-        int patchType = array.GetPatchType();
-        // XXX: patchIndex is absolute. not sure it's consistent.
-        //      (should be offsetted by array.primitiveIdBase?)
-        //    patchParamBuffer[array.primitiveIdBase + coord.handle.patchIndex]
-        Far::PatchParam const & param =
-            patchParamBuffer[coord.handle.patchIndex];
-
-        int numControlVertices = 0;
-        if (patchType == Far::PatchDescriptor::REGULAR) {
-            Far::internal::GetBSplineWeights(param,
-                                             coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 16;
-        } else if (patchType == Far::PatchDescriptor::GREGORY_BASIS) {
-            Far::internal::GetGregoryWeights(param,
-                                             coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 20;
-        } else if (patchType == Far::PatchDescriptor::QUADS) {
-            Far::internal::GetBilinearWeights(param,
-                                              coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 4;
-        } else {
-            assert(0);
-            return false;
-        }
-        const int *cvs =
-            &patchIndexBuffer[array.indexBase + coord.handle.vertIndex];
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalPatches");
+    CpuSetPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                     srcDesc, dstDesc, CpuGetNumOutputs(dst), sizeof(float));
 
-        dstT.Clear();
-        for (int j = 0; j < numControlVertices; ++j) {
-            dstT.AddWithWeight(srcT[cvs[j]], wP[j]);
-        }
-        ++dstT;
-    }
-    return true;
+    return CpuEvalPatches(src, srcDesc,
+                          dst, dstDesc,
+                          NULL, BufferDescriptor(),
+                          NULL, BufferDescriptor(),
+                          numPatchCoords, patchCoords,
+                          patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+/* static */
+bool
+CpuEvaluator::EvalPatches(const double *src, BufferDescriptor const &srcDesc,
+                          double *dst,       BufferDescriptor const &dstDesc,
+                          int numPatchCoords,
+                          const PatchCoordReal<double> *patchCoords,
+                          const PatchArray *patchArrays,
+                          const int *patchIndexBuffer,
+                          const PatchParam *patchParamBuffer) {
+    if (not src or not dst) return false;
+    if (srcDesc.length != dstDesc.length) return false;
+    if (not isFloat32(srcDesc) or not isFloat32(dstDesc)) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalPatches");
+    CpuSetPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                     srcDesc, dstDesc, CpuGetNumOutputs(dst), sizeof(double));
+
+    return CpuEvalPatches(src, srcDesc,
+                          dst, dstDesc,
+                          NULL, BufferDescriptor(),
+                          NULL, BufferDescriptor(),
+                          numPatchCoords, patchCoords,
+                          patchArrays, patchIndexBuffer, patchParamBuffer);
 }
 
 /* static */
@@ -188,71 +495,186 @@ CpuEvaluator::EvalPatches(const float *src, BufferDescriptor const &srcDesc,
                           const PatchArray *patchArrays,
                           const int *patchIndexBuffer,
                           const PatchParam *patchParamBuffer) {
-    if (src) {
-        src += srcDesc.offset;
-    } else {
-        return false;
-    }
-    if (dst) {
-        if (srcDesc.length != dstDesc.length) return false;
-        dst += dstDesc.offset;
-    }
-    if (du) {
-        du  += duDesc.offset;
-        if (srcDesc.length != duDesc.length) return false;
-    }
-    if (dv) {
-        dv  += dvDesc.offset;
-        if (srcDesc.length != dvDesc.length) return false;
-    }
+    if (not src) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (du  and srcDesc.length != duDesc.length)  return false;
+    if (dv  and srcDesc.length != dvDesc.length)  return false;
 
-    BufferAdapter<const float> srcT(src, srcDesc.length, srcDesc.stride);
-    BufferAdapter<float>       dstT(dst, dstDesc.length, dstDesc.stride);
-    BufferAdapter<float>        duT(du,  duDesc.length,  duDesc.stride);
-    BufferAdapter<float>        dvT(dv,  dvDesc.length,  dvDesc.stride);
-
-    float wP[20], wDs[20], wDt[20];
-
-    for (int i = 0; i < numPatchCoords; ++i) {
-        PatchCoord const &coord = patchCoords[i];
-        PatchArray const &array = patchArrays[coord.handle.arrayIndex];
-
-        int patchType = array.GetPatchType();
-        Far::PatchParam const & param =
-            patchParamBuffer[coord.handle.patchIndex];
-
-        int numControlVertices = 0;
-        if (patchType == Far::PatchDescriptor::REGULAR) {
-            Far::internal::GetBSplineWeights(param,
-                                             coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 16;
-        } else if (patchType == Far::PatchDescriptor::GREGORY_BASIS) {
-            Far::internal::GetGregoryWeights(param,
-                                             coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 20;
-        } else if (patchType == Far::PatchDescriptor::QUADS) {
-            Far::internal::GetBilinearWeights(param,
-                                              coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 4;
-        } else {
-            assert(0);
-        }
-        const int *cvs =
-            &patchIndexBuffer[array.indexBase + coord.handle.vertIndex];
-
-        dstT.Clear();
-        duT.Clear();
-        dvT.Clear();
-        for (int j = 0; j < numControlVertices; ++j) {
-            dstT.AddWithWeight(srcT[cvs[j]], wP[j]);
-            duT.AddWithWeight (srcT[cvs[j]], wDs[j]);
-            dvT.AddWithWeight (srcT[cvs[j]], wDt[j]);
-        }
-        ++dstT;
-        ++duT;
-        ++dvT;
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalPatches");
+    CpuSetPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                     srcDesc, CpuGetOutputDesc(dst, dstDesc,
+                                       CpuGetOutputDesc(du, duDesc, dvDesc)),
+                     CpuGetNumOutputs(dst, du, dv), sizeof(float));
+
+    return CpuEvalPatches(src, srcDesc,
+                          dst, dstDesc,
+                          du,  duDesc,
+                          dv,  dvDesc,
+                          numPatchCoords, patchCoords,
+                          patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+/* static */
+bool
+CpuEvaluator::EvalPatchNormals(const float *src, BufferDescriptor const &srcDesc,
+                               float *dst,       BufferDescriptor const &dstDesc,
+                               float *normal,    BufferDescriptor const &normalDesc,
+                               int numPatchCoords,
+                               const PatchCoord *patchCoords,
+                               const PatchArray *patchArrays,
+                               const int *patchIndexBuffer,
+                               const PatchParam *patchParamBuffer) {
+    if (not src or not normal) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (srcDesc.length < 3 or normalDesc.length != 3) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalPatchNormals");
+    CpuSetPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                     srcDesc, CpuGetOutputDesc(dst, dstDesc, normalDesc),
+                     CpuGetNumOutputs(dst, normal), sizeof(float));
+
+    return CpuEvalPatchNormals(src, srcDesc,
+                               dst, dstDesc,
+                               normal, normalDesc,
+                               numPatchCoords, patchCoords,
+                               patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+/* static */
+bool
+CpuEvaluator::EvalPatches(const double *src, BufferDescriptor const &srcDesc,
+                          double *dst,       BufferDescriptor const &dstDesc,
+                          double *du,        BufferDescriptor const &duDesc,
+                          double *dv,        BufferDescriptor const &dvDesc,
+                          int numPatchCoords,
+                          const PatchCoordReal<double> *patchCoords,
+                          const PatchArray *patchArrays,
+                          const int *patchIndexBuffer,
+                          const PatchParam *patchParamBuffer) {
+    if (not src) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (du  and srcDesc.length != duDesc.length)  return false;
+    if (dv  and srcDesc.length != dvDesc.length)  return false;
+    if (not isFloat32(srcDesc) or not isFloat32(dstDesc) or
+        not isFloat32(duDesc) or not isFloat32(dvDesc)) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalPatches");
+    CpuSetPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                     srcDesc, CpuGetOutputDesc(dst, dstDesc,
+                                       CpuGetOutputDesc(du, duDesc, dvDesc)),
+                     CpuGetNumOutputs(dst, du, dv), sizeof(double));
+
+    return CpuEvalPatches(src, srcDesc,
+                          dst, dstDesc,
+                          du,  duDesc,
+                          dv,  dvDesc,
+                          numPatchCoords, patchCoords,
+                          patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+/* static */
+bool
+CpuEvaluator::EvalPatches(const float *src, BufferDescriptor const &srcDesc,
+                          float *dst,       BufferDescriptor const &dstDesc,
+                          float *du,        BufferDescriptor const &duDesc,
+                          float *dv,        BufferDescriptor const &dvDesc,
+                          float *duu,       BufferDescriptor const &duuDesc,
+                          float *duv,       BufferDescriptor const &duvDesc,
+                          float *dvv,       BufferDescriptor const &dvvDesc,
+                          int numPatchCoords,
+                          const PatchCoord *patchCoords,
+                          const PatchArray *patchArrays,
+                          const int *patchIndexBuffer,
+                          const PatchParam *patchParamBuffer) {
+    if (not src) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (du  and srcDesc.length != duDesc.length)  return false;
+    if (dv  and srcDesc.length != dvDesc.length)  return false;
+    if (duu and srcDesc.length != duuDesc.length) return false;
+    if (duv and srcDesc.length != duvDesc.length) return false;
+    if (dvv and srcDesc.length != dvvDesc.length) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalPatches");
+    CpuSetPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                     srcDesc, CpuGetOutputDesc(dst, dstDesc, duDesc),
+                     CpuGetNumOutputs(dst, du, dv, duu, duv, dvv),
+                     sizeof(float));
+
+    return CpuEvalPatches(src, srcDesc,
+                          dst, dstDesc,
+                          du,  duDesc,
+                          dv,  dvDesc,
+                          duu, duuDesc,
+                          duv, duvDesc,
+                          dvv, dvvDesc,
+                          numPatchCoords, patchCoords,
+                          patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+/* static */
+bool
+CpuEvaluator::EvalPatches(const double *src, BufferDescriptor const &srcDesc,
+                          double *dst,       BufferDescriptor const &dstDesc,
+                          double *du,        BufferDescriptor const &duDesc,
+                          double *dv,        BufferDescriptor const &dvDesc,
+                          double *duu,       BufferDescriptor const &duuDesc,
+                          double *duv,       BufferDescriptor const &duvDesc,
+                          double *dvv,       BufferDescriptor const &dvvDesc,
+                          int numPatchCoords,
+                          const PatchCoordReal<double> *patchCoords,
+                          const PatchArray *patchArrays,
+                          const int *patchIndexBuffer,
+                          const PatchParam *patchParamBuffer) {
+    if (not src) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (du  and srcDesc.length != duDesc.length)  return false;
+    if (dv  and srcDesc.length != dvDesc.length)  return false;
+    if (duu and srcDesc.length != duuDesc.length) return false;
+    if (duv and srcDesc.length != duvDesc.length) return false;
+    if (dvv and srcDesc.length != dvvDesc.length) return false;
+    if (not isFloat32(srcDesc) or not isFloat32(dstDesc) or
+        not isFloat32(duDesc) or not isFloat32(dvDesc) or
+        not isFloat32(duuDesc) or not isFloat32(duvDesc) or
+        not isFloat32(dvvDesc)) return false;
+
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalPatches");
+    CpuSetPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                     srcDesc, CpuGetOutputDesc(dst, dstDesc, duDesc),
+                     CpuGetNumOutputs(dst, du, dv, duu, duv, dvv),
+                     sizeof(double));
+
+    return CpuEvalPatches(src, srcDesc,
+                          dst, dstDesc,
+                          du,  duDesc,
+                          dv,  dvDesc,
+                          duu, duuDesc,
+                          duv, duvDesc,
+                          dvv, dvvDesc,
+                          numPatchCoords, patchCoords,
+                          patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+/* static */
+AsyncEvaluation
+CpuEvaluator::EvalStencilsAsync(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    const int * sizes,
+    const int * offsets,
+    const int * indices,
+    const float * weights,
+    int start, int end) {
+
+    // measures the launch only : the evaluation itself is measured by
+    // EvalStencils(), on the thread of the dispatcher
+    Far::internal::StatsScope stats("Osd::CpuEvaluator::EvalStencilsAsync");
+    if (stats.IsEnabled() and end > start) {
+        stats.SetCounts(end - start, 0, 0, 0);
     }
-    return true;
+
+    return AsyncEvaluation::Launch(new AsyncEvalStencilsTask<CpuEvaluator>(
+        src, srcDesc, dst, dstDesc,
+        sizes, offsets, indices, weights, start, end));
 }
 
 
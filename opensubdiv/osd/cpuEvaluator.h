@@ -29,8 +29,11 @@
 
 #include <cstddef>
 #include <vector>
+#include "../osd/asyncEvaluation.h"
 #include "../osd/bufferDescriptor.h"
 #include "../osd/types.h"
+#include "../far/compressedStencilTable.h"
+#include "../far/transposedStencilTable.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -129,6 +132,18 @@ public:
         const float * weights,
         int start, int end);
 
+    /// \brief Double precision variant of the function above, for primvar
+    ///        buffers of doubles and Far::StencilTableReal<double> weights.
+    ///
+    static bool EvalStencils(
+        const double *src, BufferDescriptor const &srcDesc,
+        double *dst,       BufferDescriptor const &dstDesc,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const double * weights,
+        int start, int end);
+
     /// \brief Generic static eval stencils function with derivatives.
     ///        This function has a same signature as other device kernels
     ///        have so that it can be called in the same way from OsdMesh
@@ -187,14 +202,15 @@ public:
                             &stencilTable->GetOffsets()[0],
                             &stencilTable->GetControlIndices()[0],
                             &stencilTable->GetWeights()[0],
-                            &stencilTable->GetDuWeights()[0],
-                            &stencilTable->GetDvWeights()[0],
+                            GetStencilWeights(stencilTable->GetDuWeights()),
+                            GetStencilWeights(stencilTable->GetDvWeights()),
                             /*start = */ 0,
                             /*end   = */ stencilTable->GetNumStencils());
     }
 
     /// \brief Static eval stencils function with derivatives, which takes
-    ///        raw CPU pointers for input and output.
+    ///        raw CPU pointers for input and output. Returns false if a
+    ///        derivative output is given without its weights.
     ///
     /// @param src            Input primvar pointer. An offset of srcDesc
     ///                       will be applied internally (i.e. the pointer
@@ -246,6 +262,714 @@ public:
         const float * dvWeights,
         int start, int end);
 
+    /// \brief Double precision variant of the function above, for primvar
+    ///        buffers of doubles and Far::LimitStencilTableReal<double>
+    ///        weights.
+    ///
+    static bool EvalStencils(
+        const double *src, BufferDescriptor const &srcDesc,
+        double *dst,       BufferDescriptor const &dstDesc,
+        double *du,        BufferDescriptor const &duDesc,
+        double *dv,        BufferDescriptor const &dvDesc,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const double * weights,
+        const double * duWeights,
+        const double * dvWeights,
+        int start, int end);
+
+    /// \brief Generic static eval stencils function with first and second
+    ///        derivatives, for limit stencil tables generated with
+    ///        second derivative weights.
+    ///
+    /// @param srcBuffer      Input primvar buffer.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       const float pointer for read
+    ///
+    /// @param srcDesc        vertex buffer descriptor for the input buffer
+    ///
+    /// @param dstBuffer      Output primvar buffer
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       float pointer for write
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param duBuffer       Output U-derivative buffer
+    ///
+    /// @param duDesc         vertex buffer descriptor for the output buffer
+    ///
+    /// @param dvBuffer       Output V-derivative buffer
+    ///
+    /// @param dvDesc         vertex buffer descriptor for the output buffer
+    ///
+    /// @param duuBuffer      Output UU-derivative buffer
+    ///
+    /// @param duuDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param duvBuffer      Output UV-derivative buffer
+    ///
+    /// @param duvDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param dvvBuffer      Output VV-derivative buffer
+    ///
+    /// @param dvvDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param stencilTable   Far::LimitStencilTable or equivalent
+    ///
+    /// @param instance       not used in the cpu kernel
+    ///                       (declared as a typed pointer to prevent
+    ///                        undesirable template resolution)
+    ///
+    /// @param deviceContext  not used in the cpu kernel
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER, typename STENCIL_TABLE>
+    static bool EvalStencils(
+        SRC_BUFFER *srcBuffer, BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer, BufferDescriptor const &dstDesc,
+        DST_BUFFER *duBuffer,  BufferDescriptor const &duDesc,
+        DST_BUFFER *dvBuffer,  BufferDescriptor const &dvDesc,
+        DST_BUFFER *duuBuffer, BufferDescriptor const &duuDesc,
+        DST_BUFFER *duvBuffer, BufferDescriptor const &duvDesc,
+        DST_BUFFER *dvvBuffer, BufferDescriptor const &dvvDesc,
+        STENCIL_TABLE const *stencilTable,
+        const CpuEvaluator *instance = NULL,
+        void * deviceContext = NULL) {
+
+        (void)instance;       // unused
+        (void)deviceContext;  // unused
+
+        return EvalStencils(srcBuffer->BindCpuBuffer(), srcDesc,
+                            dstBuffer->BindCpuBuffer(), dstDesc,
+                            duBuffer->BindCpuBuffer(),  duDesc,
+                            dvBuffer->BindCpuBuffer(),  dvDesc,
+                            duuBuffer->BindCpuBuffer(), duuDesc,
+                            duvBuffer->BindCpuBuffer(), duvDesc,
+                            dvvBuffer->BindCpuBuffer(), dvvDesc,
+                            &stencilTable->GetSizes()[0],
+                            &stencilTable->GetOffsets()[0],
+                            &stencilTable->GetControlIndices()[0],
+                            &stencilTable->GetWeights()[0],
+                            GetStencilWeights(stencilTable->GetDuWeights()),
+                            GetStencilWeights(stencilTable->GetDvWeights()),
+                            GetStencilWeights(stencilTable->GetDuuWeights()),
+                            GetStencilWeights(stencilTable->GetDuvWeights()),
+                            GetStencilWeights(stencilTable->GetDvvWeights()),
+                            /*start = */ 0,
+                            /*end   = */ stencilTable->GetNumStencils());
+    }
+
+    /// \brief Static eval stencils function with first and second
+    ///        derivatives, which takes raw CPU pointers for input and output.
+    ///        Any of the outputs can be NULL, in which case the matching
+    ///        weights are not read. Returns false if an output is given
+    ///        without its weights (e.g. derivatives that the table was not
+    ///        generated with).
+    ///
+    /// @param src            Input primvar pointer. An offset of srcDesc
+    ///                       will be applied internally (i.e. the pointer
+    ///                       should not include the offset)
+    ///
+    /// @param srcDesc        vertex buffer descriptor for the input buffer
+    ///
+    /// @param dst            Output primvar pointer. An offset of dstDesc
+    ///                       will be applied internally.
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param du             Output U-derivatives pointer
+    ///
+    /// @param duDesc         vertex buffer descriptor for the output buffer
+    ///
+    /// @param dv             Output V-derivatives pointer
+    ///
+    /// @param dvDesc         vertex buffer descriptor for the output buffer
+    ///
+    /// @param duu            Output UU-derivatives pointer
+    ///
+    /// @param duuDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param duv            Output UV-derivatives pointer
+    ///
+    /// @param duvDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param dvv            Output VV-derivatives pointer
+    ///
+    /// @param dvvDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param sizes          pointer to the sizes buffer of the stencil table
+    ///
+    /// @param offsets        pointer to the offsets buffer of the stencil table
+    ///
+    /// @param indices        pointer to the indices buffer of the stencil table
+    ///
+    /// @param weights        pointer to the weights buffer of the stencil table
+    ///
+    /// @param duWeights      pointer to the du-weights buffer of the stencil table
+    ///
+    /// @param dvWeights      pointer to the dv-weights buffer of the stencil table
+    ///
+    /// @param duuWeights     pointer to the duu-weights buffer of the stencil table
+    ///
+    /// @param duvWeights     pointer to the duv-weights buffer of the stencil table
+    ///
+    /// @param dvvWeights     pointer to the dvv-weights buffer of the stencil table
+    ///
+    /// @param start          start index of stencil table
+    ///
+    /// @param end            end index of stencil table
+    ///
+    static bool EvalStencils(
+        const float *src, BufferDescriptor const &srcDesc,
+        float *dst,       BufferDescriptor const &dstDesc,
+        float *du,        BufferDescriptor const &duDesc,
+        float *dv,        BufferDescriptor const &dvDesc,
+        float *duu,       BufferDescriptor const &duuDesc,
+        float *duv,       BufferDescriptor const &duvDesc,
+        float *dvv,       BufferDescriptor const &dvvDesc,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const float * weights,
+        const float * duWeights,
+        const float * dvWeights,
+        const float * duuWeights,
+        const float * duvWeights,
+        const float * dvvWeights,
+        int start, int end);
+
+    /// \brief Double precision variant of the function above
+    ///
+    static bool EvalStencils(
+        const double *src, BufferDescriptor const &srcDesc,
+        double *dst,       BufferDescriptor const &dstDesc,
+        double *du,        BufferDescriptor const &duDesc,
+        double *dv,        BufferDescriptor const &dvDesc,
+        double *duu,       BufferDescriptor const &duuDesc,
+        double *duv,       BufferDescriptor const &duvDesc,
+        double *dvv,       BufferDescriptor const &dvvDesc,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const double * weights,
+        const double * duWeights,
+        const double * dvWeights,
+        const double * duuWeights,
+        const double * duvWeights,
+        const double * dvvWeights,
+        int start, int end);
+
+    /// \brief Generic static eval stencils function applying a single pass
+    ///        over the stencil table to several primvar buffers, so that the
+    ///        stencil indices and weights are read once for all of them.
+    ///
+    /// @param numBuffers     number of source / destination buffer pairs
+    ///
+    /// @param srcs           Input primvar pointers, one per buffer pair.
+    ///                       The offsets of srcDescs will be applied
+    ///                       internally (i.e. the pointers should not
+    ///                       include the offsets)
+    ///
+    /// @param srcDescs       vertex buffer descriptors for the input buffers
+    ///
+    /// @param dsts           Output primvar pointers, one per buffer pair.
+    ///                       The offsets of dstDescs will be applied
+    ///                       internally.
+    ///
+    /// @param dstDescs       vertex buffer descriptors for the output buffers
+    ///
+    /// @param stencilTable   Far::StencilTable or equivalent
+    ///
+    template <typename STENCIL_TABLE>
+    static bool EvalStencils(
+        int numBuffers,
+        const float * const *srcs, BufferDescriptor const *srcDescs,
+        float * const *dsts,       BufferDescriptor const *dstDescs,
+        STENCIL_TABLE const *stencilTable) {
+
+        if (stencilTable->GetNumStencils() == 0)
+            return false;
+
+        return EvalStencils(numBuffers,
+                            srcs, srcDescs,
+                            dsts, dstDescs,
+                            &stencilTable->GetSizes()[0],
+                            &stencilTable->GetOffsets()[0],
+                            &stencilTable->GetControlIndices()[0],
+                            &stencilTable->GetWeights()[0],
+                            /*start = */ 0,
+                            /*end   = */ stencilTable->GetNumStencils());
+    }
+
+    /// \brief Static eval stencils function applying a single pass over the
+    ///        stencil table to several primvar buffers, which takes raw CPU
+    ///        pointers for input and output.
+    ///
+    /// @param numBuffers     number of source / destination buffer pairs
+    ///
+    /// @param srcs           Input primvar pointers, one per buffer pair.
+    ///                       The offsets of srcDescs will be applied
+    ///                       internally (i.e. the pointers should not
+    ///                       include the offsets)
+    ///
+    /// @param srcDescs       vertex buffer descriptors for the input buffers
+    ///
+    /// @param dsts           Output primvar pointers, one per buffer pair.
+    ///                       The offsets of dstDescs will be applied
+    ///                       internally.
+    ///
+    /// @param dstDescs       vertex buffer descriptors for the output buffers
+    ///
+    /// @param sizes          pointer to the sizes buffer of the stencil table
+    ///
+    /// @param offsets        pointer to the offsets buffer of the stencil table
+    ///
+    /// @param indices        pointer to the indices buffer of the stencil table
+    ///
+    /// @param weights        pointer to the weights buffer of the stencil table
+    ///
+    /// @param start          start index of stencil table
+    ///
+    /// @param end            end index of stencil table
+    ///
+    static bool EvalStencils(
+        int numBuffers,
+        const float * const *srcs, BufferDescriptor const *srcDescs,
+        float * const *dsts,       BufferDescriptor const *dstDescs,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const float * weights,
+        int start, int end);
+
+    /// \brief Generic static eval stencils function for a batch of instances
+    ///        (e.g. the poses of a crowd) sharing the stencil table, which is
+    ///        read once for all of them.
+    ///
+    /// The buffers are instance-interleaved : each vertex holds the primvars
+    /// of all the instances back to back, i.e. element e of instance k of
+    /// vertex v is at offset + v * stride + k * length + e, so that the
+    /// kernels vectorize across the instances.
+    ///
+    /// @param numInstances   number of instances
+    ///
+    /// @param srcBuffer      Input primvar buffer.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       const float pointer for read
+    ///
+    /// @param srcDesc        vertex buffer descriptor of the first instance
+    ///                       in the input buffer (the stride spans all the
+    ///                       instances)
+    ///
+    /// @param dstBuffer      Output primvar buffer
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       float pointer for write
+    ///
+    /// @param dstDesc        vertex buffer descriptor of the first instance
+    ///                       in the output buffer
+    ///
+    /// @param stencilTable   Far::StencilTable or equivalent
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER, typename STENCIL_TABLE>
+    static bool EvalInstanceStencils(
+        int numInstances,
+        SRC_BUFFER *srcBuffer, BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer, BufferDescriptor const &dstDesc,
+        STENCIL_TABLE const *stencilTable) {
+
+        if (stencilTable->GetNumStencils() == 0)
+            return false;
+
+        return EvalInstanceStencils(numInstances,
+                                    srcBuffer->BindCpuBuffer(), srcDesc,
+                                    dstBuffer->BindCpuBuffer(), dstDesc,
+                                    &stencilTable->GetSizes()[0],
+                                    &stencilTable->GetOffsets()[0],
+                                    &stencilTable->GetControlIndices()[0],
+                                    &stencilTable->GetWeights()[0],
+                                    /*start = */ 0,
+                                    /*end   = */ stencilTable->GetNumStencils());
+    }
+
+    /// \brief Static eval stencils function for a batch of instances sharing
+    ///        the stencil table, which takes raw CPU pointers for input and
+    ///        output (see above for the layout of the buffers).
+    ///
+    /// @param numInstances   number of instances
+    ///
+    /// @param src            Input primvar pointer. An offset of srcDesc
+    ///                       will be applied internally (i.e. the pointer
+    ///                       should not include the offset)
+    ///
+    /// @param srcDesc        vertex buffer descriptor of the first instance
+    ///                       in the input buffer
+    ///
+    /// @param dst            Output primvar pointer. An offset of dstDesc
+    ///                       will be applied internally.
+    ///
+    /// @param dstDesc        vertex buffer descriptor of the first instance
+    ///                       in the output buffer
+    ///
+    /// @param sizes          pointer to the sizes buffer of the stencil table
+    ///
+    /// @param offsets        pointer to the offsets buffer of the stencil table
+    ///
+    /// @param indices        pointer to the indices buffer of the stencil table
+    ///
+    /// @param weights        pointer to the weights buffer of the stencil table
+    ///
+    /// @param start          start index of stencil table
+    ///
+    /// @param end            end index of stencil table
+    ///
+    static bool EvalInstanceStencils(
+        int numInstances,
+        const float *src,  BufferDescriptor const &srcDesc,
+        float *dst,        BufferDescriptor const &dstDesc,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const float * weights,
+        int start, int end);
+
+    /// \brief Generic static eval stencils function for primvars stored as
+    ///        structure of arrays (see SoABufferDescriptor).
+    ///
+    /// @param srcBuffer      Input primvar buffer.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       const float pointer for read
+    ///
+    /// @param srcDesc        planes descriptor for the input buffer
+    ///
+    /// @param dstBuffer      Output primvar buffer
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       float pointer for write
+    ///
+    /// @param dstDesc        planes descriptor for the output buffer
+    ///
+    /// @param stencilTable   Far::StencilTable or equivalent
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER, typename STENCIL_TABLE>
+    static bool EvalStencils(
+        SRC_BUFFER *srcBuffer, SoABufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer, SoABufferDescriptor const &dstDesc,
+        STENCIL_TABLE const *stencilTable) {
+
+        if (stencilTable->GetNumStencils() == 0)
+            return false;
+
+        return EvalStencils(srcBuffer->BindCpuBuffer(), srcDesc,
+                            dstBuffer->BindCpuBuffer(), dstDesc,
+                            &stencilTable->GetSizes()[0],
+                            &stencilTable->GetOffsets()[0],
+                            &stencilTable->GetControlIndices()[0],
+                            &stencilTable->GetWeights()[0],
+                            /*start = */ 0,
+                            /*end   = */ stencilTable->GetNumStencils());
+    }
+
+    /// \brief Static eval stencils function for primvars stored as structure
+    ///        of arrays, which takes raw CPU pointers for input and output.
+    ///
+    /// @param src            Input primvar pointer. An offset of srcDesc
+    ///                       will be applied internally (i.e. the pointer
+    ///                       should not include the offset)
+    ///
+    /// @param srcDesc        planes descriptor for the input buffer
+    ///
+    /// @param dst            Output primvar pointer. An offset of dstDesc
+    ///                       will be applied internally.
+    ///
+    /// @param dstDesc        planes descriptor for the output buffer
+    ///
+    /// @param sizes          pointer to the sizes buffer of the stencil table
+    ///
+    /// @param offsets        pointer to the offsets buffer of the stencil table
+    ///
+    /// @param indices        pointer to the indices buffer of the stencil table
+    ///
+    /// @param weights        pointer to the weights buffer of the stencil table
+    ///
+    /// @param start          start index of stencil table
+    ///
+    /// @param end            end index of stencil table
+    ///
+    static bool EvalStencils(
+        const float *src,  SoABufferDescriptor const &srcDesc,
+        float *dst,        SoABufferDescriptor const &dstDesc,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const float * weights,
+        int start, int end);
+
+    /// \brief Generic static eval stencils function which only updates the
+    ///        stencils supported by a set of edited control vertices.
+    ///
+    /// @param srcBuffer      Input primvar buffer.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       const float pointer for read
+    ///
+    /// @param srcDesc        vertex buffer descriptor for the input buffer
+    ///
+    /// @param dstBuffer      Output primvar buffer, holding the results of
+    ///                       a previous evaluation of the stencil table.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       float pointer for write
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param stencilTable   Far::StencilTable or equivalent, with offsets
+    ///
+    /// @param transposedTable  Far::TransposedStencilTable of stencilTable
+    ///
+    /// @param numDirtyVertices  number of edited control vertices
+    ///
+    /// @param dirtyVertices  indices of the edited control vertices
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER, typename STENCIL_TABLE>
+    static bool EvalDirtyStencils(
+        SRC_BUFFER *srcBuffer, BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer, BufferDescriptor const &dstDesc,
+        STENCIL_TABLE const *stencilTable,
+        Far::TransposedStencilTable const *transposedTable,
+        int numDirtyVertices, Far::Index const *dirtyVertices) {
+
+        std::vector<Far::Index> stencils;
+        transposedTable->GetStencils(numDirtyVertices, dirtyVertices,
+                                     stencils);
+        if (stencils.empty())
+            return true;
+
+        return EvalStencilList(srcBuffer->BindCpuBuffer(), srcDesc,
+                               dstBuffer->BindCpuBuffer(), dstDesc,
+                               &stencilTable->GetSizes()[0],
+                               &stencilTable->GetOffsets()[0],
+                               &stencilTable->GetControlIndices()[0],
+                               &stencilTable->GetWeights()[0],
+                               &stencils[0], (int)stencils.size());
+    }
+
+    /// \brief Static eval stencils function evaluating a list of stencils,
+    ///        which takes raw CPU pointers for input and output.
+    ///
+    /// @param src            Input primvar pointer. An offset of srcDesc
+    ///                       will be applied internally (i.e. the pointer
+    ///                       should not include the offset)
+    ///
+    /// @param srcDesc        vertex buffer descriptor for the input buffer
+    ///
+    /// @param dst            Output primvar pointer. An offset of dstDesc
+    ///                       will be applied internally.
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param sizes          pointer to the sizes buffer of the stencil table
+    ///
+    /// @param offsets        pointer to the offsets buffer of the stencil table
+    ///
+    /// @param indices        pointer to the indices buffer of the stencil table
+    ///
+    /// @param weights        pointer to the weights buffer of the stencil table
+    ///
+    /// @param stencils       indices of the stencils to evaluate, in
+    ///                       increasing order
+    ///
+    /// @param numStencils    number of stencils to evaluate
+    ///
+    static bool EvalStencilList(
+        const float *src,  BufferDescriptor const &srcDesc,
+        float *dst,        BufferDescriptor const &dstDesc,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const float * weights,
+        const int * stencils, int numStencils);
+
+    /// \brief Generic static function applying the stencils to a sparse set
+    ///        of control values (e.g. the offsets of a blend shape) and
+    ///        accumulating the results into the destination buffer.
+    ///
+    /// @param deltaBuffer    Input buffer of control values, one element per
+    ///                       delta vertex.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       const float pointer for read
+    ///
+    /// @param deltaDesc      vertex buffer descriptor for the input buffer
+    ///
+    /// @param deltaVertices  control vertex index of each element of the
+    ///                       input buffer
+    ///
+    /// @param numDeltas      number of elements of the input buffer
+    ///
+    /// @param dstBuffer      Output primvar buffer, to which the stencils of
+    ///                       the deltas are added.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       float pointer for write
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param transposedTable  Far::TransposedStencilTable of the stencils
+    ///
+    template <typename DELTA_BUFFER, typename DST_BUFFER>
+    static bool EvalStencilDeltas(
+        DELTA_BUFFER *deltaBuffer, BufferDescriptor const &deltaDesc,
+        Far::Index const *deltaVertices, int numDeltas,
+        DST_BUFFER *dstBuffer, BufferDescriptor const &dstDesc,
+        Far::TransposedStencilTable const *transposedTable) {
+
+        if (transposedTable->GetStencilIndices().empty())
+            return true;
+
+        return EvalStencilDeltas(deltaBuffer->BindCpuBuffer(), deltaDesc,
+                                 deltaVertices, numDeltas,
+                                 dstBuffer->BindCpuBuffer(), dstDesc,
+                                 &transposedTable->GetOffsets()[0],
+                                 &transposedTable->GetStencilIndices()[0],
+                                 &transposedTable->GetWeights()[0]);
+    }
+
+    /// \brief Static function applying the stencils to a sparse set of
+    ///        control values, which takes raw CPU pointers for input and
+    ///        output.
+    ///
+    /// @param deltas         Input pointer to the control values. An offset
+    ///                       of deltaDesc will be applied internally (i.e.
+    ///                       the pointer should not include the offset)
+    ///
+    /// @param deltaDesc      vertex buffer descriptor for the input buffer
+    ///
+    /// @param deltaVertices  control vertex index of each input element
+    ///
+    /// @param numDeltas      number of input elements
+    ///
+    /// @param dst            Output primvar pointer. An offset of dstDesc
+    ///                       will be applied internally.
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param offsets        pointer to the offsets buffer of the transposed
+    ///                       stencil table
+    ///
+    /// @param stencils       pointer to the stencil indices buffer of the
+    ///                       transposed stencil table
+    ///
+    /// @param weights        pointer to the weights buffer of the transposed
+    ///                       stencil table
+    ///
+    static bool EvalStencilDeltas(
+        const float *deltas, BufferDescriptor const &deltaDesc,
+        const int * deltaVertices, int numDeltas,
+        float *dst,          BufferDescriptor const &dstDesc,
+        const int * offsets,
+        const int * stencils,
+        const float * weights);
+
+    /// ----------------------------------------------------------------------
+    ///
+    ///   Stencil evaluations with CompressedStencilTable
+    ///
+    /// ----------------------------------------------------------------------
+
+    /// \brief Generic static eval stencils function for compressed stencil
+    ///        tables, which are decoded on the fly.
+    ///
+    /// @param srcBuffer      Input primvar buffer.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       const float pointer for read
+    ///
+    /// @param srcDesc        vertex buffer descriptor for the input buffer
+    ///
+    /// @param dstBuffer      Output primvar buffer
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       float pointer for write
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param stencilTable   Far::CompressedStencilTable
+    ///
+    /// @param instance       not used in the cpu kernel
+    ///
+    /// @param deviceContext  not used in the cpu kernel
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER>
+    static bool EvalStencils(
+        SRC_BUFFER *srcBuffer, BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer, BufferDescriptor const &dstDesc,
+        Far::CompressedStencilTable const *stencilTable,
+        const CpuEvaluator *instance = NULL,
+        void * deviceContext = NULL) {
+
+        (void)instance;       // unused
+        (void)deviceContext;  // unused
+
+        // nothing to evaluate
+        if (stencilTable->GetNumStencils() == 0)
+            return true;
+
+        // the indices and weights are empty when all the stencils are
+        std::vector<unsigned char> const & indices =
+            stencilTable->GetControlIndices();
+        std::vector<short> const & weights = stencilTable->GetWeights();
+
+        return EvalStencils(srcBuffer->BindCpuBuffer(), srcDesc,
+                            dstBuffer->BindCpuBuffer(), dstDesc,
+                            &stencilTable->GetSizes()[0],
+                            &stencilTable->GetScales()[0],
+                            &stencilTable->GetBlockIndexOffsets()[0],
+                            &stencilTable->GetBlockWeightOffsets()[0],
+                            indices.empty() ? NULL : &indices[0],
+                            weights.empty() ? NULL : &weights[0],
+                            /*start = */ 0,
+                            /*end   = */ stencilTable->GetNumStencils());
+    }
+
+    /// \brief Static eval stencils function for compressed stencil tables,
+    ///        which takes raw CPU pointers for input and output.
+    ///
+    /// @param src            Input primvar pointer. An offset of srcDesc
+    ///                       will be applied internally (i.e. the pointer
+    ///                       should not include the offset)
+    ///
+    /// @param srcDesc        vertex buffer descriptor for the input buffer
+    ///
+    /// @param dst            Output primvar pointer. An offset of dstDesc
+    ///                       will be applied internally.
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param sizes          pointer to the sizes buffer of the stencil table
+    ///
+    /// @param scales         pointer to the weight scales buffer of the
+    ///                       stencil table
+    ///
+    /// @param blockIndexOffsets   pointer to the block index offsets buffer
+    ///                            of the stencil table
+    ///
+    /// @param blockWeightOffsets  pointer to the block weight offsets buffer
+    ///                            of the stencil table
+    ///
+    /// @param indices        pointer to the encoded indices buffer of the
+    ///                       stencil table
+    ///
+    /// @param weights        pointer to the quantized weights buffer of the
+    ///                       stencil table
+    ///
+    /// @param start          start index of stencil table
+    ///
+    /// @param end            end index of stencil table
+    ///
+    static bool EvalStencils(
+        const float *src,  BufferDescriptor const &srcDesc,
+        float *dst,        BufferDescriptor const &dstDesc,
+        const unsigned char * sizes,
+        const float * scales,
+        const int * blockIndexOffsets,
+        const int * blockWeightOffsets,
+        const unsigned char * indices,
+        const short * weights,
+        int start, int end);
+
     /// ----------------------------------------------------------------------
     ///
     ///   Limit evaluations with PatchTable
@@ -410,6 +1134,18 @@ public:
         const int *patchIndexBuffer,
         const PatchParam *patchParamBuffer);
 
+    /// \brief Double precision variant of the function above : the patch
+    ///        coordinates and the basis weights are double precision as well.
+    ///
+    static bool EvalPatches(
+        const double *src, BufferDescriptor const &srcDesc,
+        double *dst,       BufferDescriptor const &dstDesc,
+        int numPatchCoords,
+        const PatchCoordReal<double> *patchCoords,
+        const PatchArray *patchArrays,
+        const int *patchIndexBuffer,
+        const PatchParam *patchParamBuffer);
+
     /// \brief Static limit eval function. It takes an array of PatchCoord
     ///        and evaluate limit values on given PatchTable.
     ///
@@ -458,6 +1194,343 @@ public:
         const int *patchIndexBuffer,
         PatchParam const *patchParamBuffer);
 
+    /// \brief Double precision variant of the function above : the patch
+    ///        coordinates and the basis weights are double precision as well.
+    ///
+    static bool EvalPatches(
+        const double *src, BufferDescriptor const &srcDesc,
+        double *dst,       BufferDescriptor const &dstDesc,
+        double *du,        BufferDescriptor const &duDesc,
+        double *dv,        BufferDescriptor const &dvDesc,
+        int numPatchCoords,
+        PatchCoordReal<double> const *patchCoords,
+        PatchArray const *patchArrays,
+        const int *patchIndexBuffer,
+        PatchParam const *patchParamBuffer);
+
+    /// \brief Generic limit eval function with first and second derivatives.
+    ///        This function has a same signature as other device kernels
+    ///        have so that it can be called in the same way.
+    ///
+    /// @param srcBuffer        Input primvar buffer.
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         const float pointer for read
+    ///
+    /// @param srcDesc          vertex buffer descriptor for the input buffer
+    ///
+    /// @param dstBuffer        Output primvar buffer
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         float pointer for write
+    ///
+    /// @param dstDesc          vertex buffer descriptor for the output buffer
+    ///
+    /// @param duBuffer         Output U-derivatives buffer
+    ///
+    /// @param duDesc           vertex buffer descriptor for the duBuffer
+    ///
+    /// @param dvBuffer         Output V-derivatives buffer
+    ///
+    /// @param dvDesc           vertex buffer descriptor for the dvBuffer
+    ///
+    /// @param duuBuffer        Output UU-derivatives buffer
+    ///
+    /// @param duuDesc          vertex buffer descriptor for the duuBuffer
+    ///
+    /// @param duvBuffer        Output UV-derivatives buffer
+    ///
+    /// @param duvDesc          vertex buffer descriptor for the duvBuffer
+    ///
+    /// @param dvvBuffer        Output VV-derivatives buffer
+    ///
+    /// @param dvvDesc          vertex buffer descriptor for the dvvBuffer
+    ///
+    /// @param numPatchCoords   number of patchCoords.
+    ///
+    /// @param patchCoords      array of locations to be evaluated.
+    ///
+    /// @param patchTable       CpuPatchTable or equivalent
+    ///                         XXX: currently Far::PatchTable can't be used
+    ///                              due to interface mismatch
+    ///
+    /// @param instance         not used in the cpu evaluator
+    ///
+    /// @param deviceContext    not used in the cpu evaluator
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER,
+              typename PATCHCOORD_BUFFER, typename PATCH_TABLE>
+    static bool EvalPatches(
+        SRC_BUFFER *srcBuffer, BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer, BufferDescriptor const &dstDesc,
+        DST_BUFFER *duBuffer,  BufferDescriptor const &duDesc,
+        DST_BUFFER *dvBuffer,  BufferDescriptor const &dvDesc,
+        DST_BUFFER *duuBuffer, BufferDescriptor const &duuDesc,
+        DST_BUFFER *duvBuffer, BufferDescriptor const &duvDesc,
+        DST_BUFFER *dvvBuffer, BufferDescriptor const &dvvDesc,
+        int numPatchCoords,
+        PATCHCOORD_BUFFER *patchCoords,
+        PATCH_TABLE *patchTable,
+        CpuEvaluator const *instance = NULL,
+        void * deviceContext = NULL) {
+        (void)instance;       // unused
+        (void)deviceContext;  // unused
+
+        return EvalPatches(srcBuffer->BindCpuBuffer(), srcDesc,
+                           dstBuffer->BindCpuBuffer(), dstDesc,
+                           duBuffer->BindCpuBuffer(),  duDesc,
+                           dvBuffer->BindCpuBuffer(),  dvDesc,
+                           duuBuffer->BindCpuBuffer(), duuDesc,
+                           duvBuffer->BindCpuBuffer(), duvDesc,
+                           dvvBuffer->BindCpuBuffer(), dvvDesc,
+                           numPatchCoords,
+                           (const PatchCoord*)patchCoords->BindCpuBuffer(),
+                           patchTable->GetPatchArrayBuffer(),
+                           patchTable->GetPatchIndexBuffer(),
+                           patchTable->GetPatchParamBuffer());
+    }
+
+    /// \brief Static limit eval function with first and second derivatives.
+    ///        Any of the outputs can be NULL.
+    ///
+    /// @param src              Input primvar pointer. An offset of srcDesc
+    ///                         will be applied internally (i.e. the pointer
+    ///                         should not include the offset)
+    ///
+    /// @param srcDesc          vertex buffer descriptor for the input buffer
+    ///
+    /// @param dst              Output primvar pointer. An offset of dstDesc
+    ///                         will be applied internally.
+    ///
+    /// @param dstDesc          vertex buffer descriptor for the output buffer
+    ///
+    /// @param du               Output U-derivatives pointer
+    ///
+    /// @param duDesc           vertex buffer descriptor for the du buffer
+    ///
+    /// @param dv               Output V-derivatives pointer
+    ///
+    /// @param dvDesc           vertex buffer descriptor for the dv buffer
+    ///
+    /// @param duu              Output UU-derivatives pointer
+    ///
+    /// @param duuDesc          vertex buffer descriptor for the duu buffer
+    ///
+    /// @param duv              Output UV-derivatives pointer
+    ///
+    /// @param duvDesc          vertex buffer descriptor for the duv buffer
+    ///
+    /// @param dvv              Output VV-derivatives pointer
+    ///
+    /// @param dvvDesc          vertex buffer descriptor for the dvv buffer
+    ///
+    /// @param numPatchCoords   number of patchCoords.
+    ///
+    /// @param patchCoords      array of locations to be evaluated.
+    ///
+    /// @param patchArrays      an array of Osd::PatchArray struct
+    ///                         indexed by PatchCoord::arrayIndex
+    ///
+    /// @param patchIndexBuffer an array of patch indices
+    ///                         indexed by PatchCoord::vertIndex
+    ///
+    /// @param patchParamBuffer an array of Osd::PatchParam struct
+    ///                         indexed by PatchCoord::patchIndex
+    ///
+    static bool EvalPatches(
+        const float *src, BufferDescriptor const &srcDesc,
+        float *dst,       BufferDescriptor const &dstDesc,
+        float *du,        BufferDescriptor const &duDesc,
+        float *dv,        BufferDescriptor const &dvDesc,
+        float *duu,       BufferDescriptor const &duuDesc,
+        float *duv,       BufferDescriptor const &duvDesc,
+        float *dvv,       BufferDescriptor const &dvvDesc,
+        int numPatchCoords,
+        PatchCoord const *patchCoords,
+        PatchArray const *patchArrays,
+        const int *patchIndexBuffer,
+        PatchParam const *patchParamBuffer);
+
+    /// \brief Double precision variant of the function above : the patch
+    ///        coordinates and the basis weights are double precision as well.
+    ///
+    static bool EvalPatches(
+        const double *src, BufferDescriptor const &srcDesc,
+        double *dst,       BufferDescriptor const &dstDesc,
+        double *du,        BufferDescriptor const &duDesc,
+        double *dv,        BufferDescriptor const &dvDesc,
+        double *duu,       BufferDescriptor const &duuDesc,
+        double *duv,       BufferDescriptor const &duvDesc,
+        double *dvv,       BufferDescriptor const &dvvDesc,
+        int numPatchCoords,
+        PatchCoordReal<double> const *patchCoords,
+        PatchArray const *patchArrays,
+        const int *patchIndexBuffer,
+        PatchParam const *patchParamBuffer);
+
+    /// \brief Generic limit eval function writing unit normals : the
+    ///        normalized cross products of the first three elements of the
+    ///        U and V derivatives, which are not written.
+    ///
+    /// @param srcBuffer        Input primvar buffer.
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         const float pointer for read
+    ///
+    /// @param srcDesc          vertex buffer descriptor for the input buffer
+    ///                         (at least 3 elements)
+    ///
+    /// @param dstBuffer        Output primvar buffer (can be NULL)
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         float pointer for write
+    ///
+    /// @param dstDesc          vertex buffer descriptor for the output buffer
+    ///
+    /// @param normalBuffer     Output normal buffer
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         float pointer for write
+    ///
+    /// @param normalDesc       vertex buffer descriptor for the normalBuffer
+    ///                         (3 elements)
+    ///
+    /// @param numPatchCoords   number of patchCoords.
+    ///
+    /// @param patchCoords      array of locations to be evaluated.
+    ///
+    /// @param patchTable       CpuPatchTable or equivalent
+    ///                         XXX: currently Far::PatchTable can't be used
+    ///                              due to interface mismatch
+    ///
+    /// @param instance         not used in the cpu evaluator
+    ///
+    /// @param deviceContext    not used in the cpu evaluator
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER,
+              typename PATCHCOORD_BUFFER, typename PATCH_TABLE>
+    static bool EvalPatchNormals(
+        SRC_BUFFER *srcBuffer,    BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer,    BufferDescriptor const &dstDesc,
+        DST_BUFFER *normalBuffer, BufferDescriptor const &normalDesc,
+        int numPatchCoords,
+        PATCHCOORD_BUFFER *patchCoords,
+        PATCH_TABLE *patchTable,
+        CpuEvaluator const *instance = NULL,
+        void * deviceContext = NULL) {
+
+        (void)instance;       // unused
+        (void)deviceContext;  // unused
+
+        return EvalPatchNormals(srcBuffer->BindCpuBuffer(), srcDesc,
+                                dstBuffer ? dstBuffer->BindCpuBuffer() : NULL,
+                                dstDesc,
+                                normalBuffer->BindCpuBuffer(), normalDesc,
+                                numPatchCoords,
+                                (const PatchCoord*)patchCoords->BindCpuBuffer(),
+                                patchTable->GetPatchArrayBuffer(),
+                                patchTable->GetPatchIndexBuffer(),
+                                patchTable->GetPatchParamBuffer());
+    }
+
+    /// \brief Static limit eval function writing unit normals (see above),
+    ///        which takes raw CPU pointers for input and output.
+    ///
+    /// @param src              Input primvar pointer. An offset of srcDesc
+    ///                         will be applied internally (i.e. the pointer
+    ///                         should not include the offset)
+    ///
+    /// @param srcDesc          vertex buffer descriptor for the input buffer
+    ///                         (at least 3 elements)
+    ///
+    /// @param dst              Output primvar pointer (can be NULL). An
+    ///                         offset of dstDesc will be applied internally.
+    ///
+    /// @param dstDesc          vertex buffer descriptor for the output buffer
+    ///
+    /// @param normal           Output normal pointer. An offset of
+    ///                         normalDesc will be applied internally.
+    ///
+    /// @param normalDesc       vertex buffer descriptor for the normal buffer
+    ///                         (3 elements)
+    ///
+    /// @param numPatchCoords   number of patchCoords.
+    ///
+    /// @param patchCoords      array of locations to be evaluated.
+    ///
+    /// @param patchArrays      an array of Osd::PatchArray struct
+    ///                         indexed by PatchCoord::arrayIndex
+    ///
+    /// @param patchIndexBuffer an array of patch indices
+    ///                         indexed by PatchCoord::vertIndex
+    ///
+    /// @param patchParamBuffer an array of Osd::PatchParam struct
+    ///                         indexed by PatchCoord::patchIndex
+    ///
+    static bool EvalPatchNormals(
+        const float *src, BufferDescriptor const &srcDesc,
+        float *dst,       BufferDescriptor const &dstDesc,
+        float *normal,    BufferDescriptor const &normalDesc,
+        int numPatchCoords,
+        PatchCoord const *patchCoords,
+        PatchArray const *patchArrays,
+        const int *patchIndexBuffer,
+        PatchParam const *patchParamBuffer);
+
+    /// ----------------------------------------------------------------------
+    ///
+    ///   Asynchronous stencil evaluation
+    ///
+    /// ----------------------------------------------------------------------
+
+    /// \brief Generic eval stencils function which returns at once : the
+    ///        evaluation runs in the background (see AsyncEvaluation).
+    ///
+    /// The buffers are bound when the evaluation is launched, and must not be
+    /// modified (sources) or read (destinations) until it is complete.
+    ///
+    /// @param srcBuffer      Input primvar buffer.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       const float pointer for read
+    ///
+    /// @param srcDesc        vertex buffer descriptor for the input buffer
+    ///
+    /// @param dstBuffer      Output primvar buffer
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       float pointer for write
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param stencilTable   Far::StencilTable or equivalent, which must
+    ///                       remain valid until the evaluation is complete
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER, typename STENCIL_TABLE>
+    static AsyncEvaluation EvalStencilsAsync(
+        SRC_BUFFER *srcBuffer, BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer, BufferDescriptor const &dstDesc,
+        STENCIL_TABLE const *stencilTable) {
+
+        // nothing to launch : the handle is complete
+        if (stencilTable->GetNumStencils() == 0)
+            return AsyncEvaluation();
+
+        return EvalStencilsAsync(srcBuffer->BindCpuBuffer(), srcDesc,
+                                 dstBuffer->BindCpuBuffer(), dstDesc,
+                                 &stencilTable->GetSizes()[0],
+                                 &stencilTable->GetOffsets()[0],
+                                 &stencilTable->GetControlIndices()[0],
+                                 &stencilTable->GetWeights()[0],
+                                 /*start = */ 0,
+                                 /*end   = */ stencilTable->GetNumStencils());
+    }
+
+    /// \brief Static eval stencils function which returns at once, and takes
+    ///        raw CPU pointers for input and output (see EvalStencils()).
+    ///
+    static AsyncEvaluation EvalStencilsAsync(
+        const float *src,  BufferDescriptor const &srcDesc,
+        float *dst,        BufferDescriptor const &dstDesc,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const float * weights,
+        int start, int end);
+
     /// ----------------------------------------------------------------------
     ///
     ///   Other methods
@@ -466,7 +1539,7 @@ public:
 
     /// \brief synchronize all asynchronous computation invoked on this device.
     static void Synchronize(void * /*deviceContext = NULL*/) {
-        // nothing.
+        AsyncEvaluation::WaitAll();
     }
 };
 
@@ -23,13 +23,28 @@
 //
 
 #include "../osd/cpuKernel.h"
+#include "../osd/cpuSimdKernel.h"
 #include "../osd/bufferDescriptor.h"
+#include "../osd/types.h"
+#include "../far/compressedStencilTable.h"
+#include "../far/patchBasis.h"
+#include "../far/stats.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <vector>
 
+#if defined(OPENSUBDIV_HAS_CPU_SIMD)
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #elif defined(__GNUC__)
+    #include <cpuid.h>
+  #endif
+#endif
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -41,15 +56,17 @@ elementAtIndex(T * src, int index, BufferDescriptor const &desc) {
     return src + index * desc.stride;
 }
 
+template <typename REAL>
 static inline void
-clear(float *dst, BufferDescriptor const &desc) {
+clear(REAL *dst, BufferDescriptor const &desc) {
 
     assert(dst);
-    memset(dst, 0, desc.length*sizeof(float));
+    memset(dst, 0, desc.length*sizeof(REAL));
 }
 
+template <typename REAL>
 static inline void
-addWithWeight(float *dst, const float *src, int srcIndex, float weight,
+addWithWeight(REAL *dst, const REAL *src, int srcIndex, REAL weight,
               BufferDescriptor const &desc) {
 
     assert(src and dst);
@@ -59,13 +76,485 @@ addWithWeight(float *dst, const float *src, int srcIndex, float weight,
     }
 }
 
+template <typename REAL>
 static inline void
-copy(float *dst, int dstIndex, const float *src, BufferDescriptor const &desc) {
+copy(REAL *dst, int dstIndex, const REAL *src, BufferDescriptor const &desc) {
 
     assert(src and dst);
 
     dst = elementAtIndex(dst, dstIndex, desc);
-    memcpy(dst, src, desc.length*sizeof(float));
+    memcpy(dst, src, desc.length*sizeof(REAL));
+}
+
+//
+// Half precision floats : portable conversions for the primvar buffers with
+// a FLOAT16 element type. Values are always accumulated in single precision.
+//
+static inline float
+halfToFloat(unsigned short h) {
+
+    unsigned int sign = (unsigned int)(h & 0x8000) << 16,
+                 exponent = (h >> 10) & 0x1f,
+                 mantissa = h & 0x3ff,
+                 bits;
+
+    if (exponent == 0x1f) {
+        // inf / nan
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else if (exponent) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // renormalize subnormals
+        exponent = 113;
+        while ((mantissa & 0x400) == 0) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline unsigned short
+floatToHalf(float f) {
+
+    unsigned int bits;
+    memcpy(&bits, &f, sizeof(bits));
+
+    unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+    unsigned int absBits = bits & 0x7fffffff;
+
+    if (absBits >= 0x7f800000) {
+        // inf / nan (quiet)
+        return sign | 0x7c00 | (absBits > 0x7f800000 ? 0x200 : 0);
+    }
+    if (absBits >= 0x477ff000) {
+        // overflows to inf after rounding
+        return sign | 0x7c00;
+    }
+    if (absBits < 0x33000000) {
+        // underflows to zero after rounding
+        return sign;
+    }
+
+    // round to nearest even
+    if (absBits < 0x38800000) {
+        // subnormal
+        int shift = 126 - (int)(absBits >> 23);
+        unsigned int mantissa = (absBits & 0x7fffff) | 0x800000,
+                     half = mantissa >> shift,
+                     rem = mantissa & ((1u << shift) - 1),
+                     mid = 1u << (shift - 1);
+        if (rem > mid or (rem == mid and (half & 1))) {
+            ++half;
+        }
+        return sign | (unsigned short)half;
+    }
+
+    unsigned int half = (absBits - 0x38000000) >> 13,
+                 rem = absBits & 0x1fff;
+    if (rem > 0x1000 or (rem == 0x1000 and (half & 1))) {
+        ++half;
+    }
+    return sign | (unsigned short)half;
+}
+
+// Hardware conversions (F16C) are used with the AVX2 kernels
+static bool
+hasF16C() {
+
+#if defined(OPENSUBDIV_HAS_CPU_SIMD)
+  #if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    static bool f16c = (info[2] & (1 << 29)) != 0;
+    return f16c;
+  #elif defined(__GNUC__)
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    static bool f16c = __get_cpuid(1, &eax, &ebx, &ecx, &edx) and
+                       (ecx & (1u << 29)) != 0;
+    return f16c;
+  #endif
+#endif
+    return false;
+}
+
+static inline bool
+isHalf(BufferDescriptor const &desc) {
+    return desc.elementType == BufferDescriptor::FLOAT16;
+}
+
+// Offsets and strides count elements of the descriptor's type
+template <class T> static inline T *
+elementAtOffset(T * p, int count, BufferDescriptor const &desc) {
+    int elementSize = isHalf(desc) ? desc.GetElementSize() : (int)sizeof(T);
+    return reinterpret_cast<T *>(const_cast<char *>(
+        reinterpret_cast<char const *>(p) + count * elementSize));
+}
+
+template <typename REAL>
+static inline void
+loadElements(REAL * dst, REAL const * src, int length, bool half) {
+    if (half) {
+        unsigned short const * h =
+            reinterpret_cast<unsigned short const *>(src);
+        for (int k = 0; k < length; ++k) {
+            dst[k] = halfToFloat(h[k]);
+        }
+    } else {
+        memcpy(dst, src, length * sizeof(REAL));
+    }
+}
+
+template <typename REAL>
+static inline void
+storeElements(REAL * dst, REAL const * src, int length, bool half) {
+    if (half) {
+        unsigned short * h = reinterpret_cast<unsigned short *>(dst);
+        for (int k = 0; k < length; ++k) {
+            h[k] = floatToHalf((float)src[k]);
+        }
+    } else {
+        memcpy(dst, src, length * sizeof(REAL));
+    }
+}
+
+// Stencils on primvar buffers where either one holds half precision floats
+static void
+evalStencilsConvert(float const * src, BufferDescriptor const &srcDesc,
+                    float * dst,       BufferDescriptor const &dstDesc,
+                    int const * sizes,
+                    int const * indices,
+                    float const * weights,
+                    int start, int nstencils) {
+
+    bool srcHalf = isHalf(srcDesc),
+         dstHalf = isHalf(dstDesc);
+
+    src = elementAtOffset(src, srcDesc.offset, srcDesc);
+    dst = elementAtOffset(dst, dstDesc.offset + start * dstDesc.stride,
+                          dstDesc);
+
+    // only the elements held by both the source and the destination primvars
+    // are evaluated
+    int length = std::min(srcDesc.length, dstDesc.length);
+
+#if defined(OPENSUBDIV_HAS_CPU_SIMD)
+    if (CpuGetSimdLevel() >= CPU_SIMD_AVX2 and hasF16C()) {
+        CpuEvalStencilsF16C(src, srcHalf, srcDesc.stride,
+                            dst, dstHalf, dstDesc.stride, length,
+                            sizes, indices, weights, nstencils);
+        return;
+    }
+#endif
+
+    float * result = (float*)alloca(length * sizeof(float)),
+          * values = (float*)alloca(length * sizeof(float));
+
+    for (int i=0; i<nstencils; ++i, ++sizes) {
+
+        memset(result, 0, length * sizeof(float));
+
+        for (int j=0; j<*sizes; ++j) {
+            loadElements(values,
+                elementAtOffset(src, *indices++ * srcDesc.stride, srcDesc),
+                length, srcHalf);
+            float w = *weights++;
+            for (int k = 0; k < length; ++k) {
+                result[k] += values[k] * w;
+            }
+        }
+
+        storeElements(elementAtOffset(dst, i * dstDesc.stride, dstDesc),
+                      result, length, dstHalf);
+    }
+}
+
+static CpuSimdLevel
+detectSimdLevel() {
+
+#if defined(OPENSUBDIV_HAS_CPU_SIMD)
+  #if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse2    = (info[3] & (1 << 26)) != 0,
+         fma     = (info[2] & (1 << 12)) != 0,
+         osxsave = (info[2] & (1 << 27)) != 0;
+
+    // the OS must save the ymm / zmm registers on context switches
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    bool ymmState = (xcr0 & 0x06) == 0x06,
+         zmmState = (xcr0 & 0xe6) == 0xe6;
+
+    bool avx2 = false, avx512f = false;
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2    = (info[1] & (1 <<  5)) != 0;
+        avx512f = (info[1] & (1 << 16)) != 0;
+    }
+
+    if (avx512f and zmmState) return CPU_SIMD_AVX512;
+    if (avx2 and fma and ymmState) return CPU_SIMD_AVX2;
+    if (sse2) return CPU_SIMD_SSE;
+  #else
+    // note : these builtins also check that the OS supports the extended
+    //        register states
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return CPU_SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2") and
+        __builtin_cpu_supports("fma")) return CPU_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return CPU_SIMD_SSE;
+  #endif
+#endif
+    return CPU_SIMD_NONE;
+}
+
+static CpuSimdLevel &
+simdLevel() {
+    static CpuSimdLevel level = detectSimdLevel();
+    return level;
+}
+
+CpuSimdLevel
+CpuGetSimdLevel() {
+    return simdLevel();
+}
+
+void
+CpuSetSimdLevel(CpuSimdLevel level) {
+    CpuSimdLevel maxLevel = detectSimdLevel();
+    simdLevel() = level < maxLevel ? level : maxLevel;
+}
+
+// Number of weights (i.e. multiply-adds per primvar element) targeted by
+// each partition of a parallel stencil evaluation
+static const int weightsPerPartition = 2048;
+
+static inline int
+getNumWeights(int const * sizes, int const * offsets, int start, int end) {
+    return offsets[end-1] + sizes[end-1] - offsets[start];
+}
+
+int
+CpuGetNumStencilPartitions(int const * sizes, int const * offsets,
+                           int start, int end, int minPartitions) {
+
+    if (end <= start) return 0;
+
+    int numWeights = getNumWeights(sizes, offsets, start, end);
+
+    int numPartitions = std::max(minPartitions,
+        (numWeights + weightsPerPartition - 1) / weightsPerPartition);
+
+    return std::max(1, std::min(numPartitions, end - start));
+}
+
+int
+CpuGetStencilPartitionStart(int const * sizes, int const * offsets,
+                            int start, int end,
+                            int partition, int numPartitions) {
+
+    if (partition <= 0) return start;
+    if (partition >= numPartitions) return end;
+
+    long long numWeights = getNumWeights(sizes, offsets, start, end);
+
+    int target = offsets[start] +
+        (int)(numWeights * partition / numPartitions);
+
+    return (int)(std::lower_bound(offsets + start, offsets + end, target) -
+                 offsets);
+}
+
+// Size of the primvar elements of a descriptor : the values of half
+// precision primvars are stored in 16 bits, others in the evaluation type
+static inline size_t
+statsElementSize(BufferDescriptor const &desc, int realSize) {
+    return isHalf(desc) ? (size_t)desc.GetElementSize() : (size_t)realSize;
+}
+
+// Each stencil reads stencilBytes of sizes and offsets, and each of its
+// weights the index of a source vertex, its elements, and one weight per
+// output
+static void
+setStencilCounts(Far::internal::StatsScope & stats,
+                 size_t numStencils, size_t numWeights,
+                 size_t stencilBytes, size_t indexBytes, size_t weightBytes,
+                 BufferDescriptor const &srcDesc,
+                 BufferDescriptor const &dstDesc,
+                 int numOutputs, int realSize) {
+
+    stats.SetCounts(numStencils, numWeights * numOutputs,
+        numStencils * stencilBytes +
+        numWeights * (indexBytes + numOutputs * weightBytes +
+                      srcDesc.length * statsElementSize(srcDesc, realSize)),
+        numStencils * numOutputs * dstDesc.length *
+            statsElementSize(dstDesc, realSize));
+}
+
+void
+CpuSetStencilStats(Far::internal::StatsScope & stats,
+                   int const * sizes, int const * offsets,
+                   int start, int end,
+                   BufferDescriptor const &srcDesc,
+                   BufferDescriptor const &dstDesc,
+                   int numOutputs, int realSize) {
+
+    if (not stats.IsEnabled() or end <= start) return;
+
+    setStencilCounts(stats, end - start,
+                     getNumWeights(sizes, offsets, start, end),
+                     2 * sizeof(int), sizeof(int), realSize,
+                     srcDesc, dstDesc, numOutputs, realSize);
+}
+
+void
+CpuSetStencilStats(Far::internal::StatsScope & stats,
+                   int const * sizes, int const * offsets,
+                   int start, int end,
+                   int numBuffers,
+                   BufferDescriptor const *srcDescs,
+                   BufferDescriptor const *dstDescs,
+                   int realSize) {
+
+    if (not stats.IsEnabled() or end <= start) return;
+
+    BufferDescriptor srcDesc, dstDesc;
+    for (int i = 0; i < numBuffers; ++i) {
+        srcDesc.length += srcDescs[i].length;
+        dstDesc.length += dstDescs[i].length;
+    }
+    CpuSetStencilStats(stats, sizes, offsets, start, end,
+                       srcDesc, dstDesc, 1, realSize);
+}
+
+void
+CpuSetStencilStats(Far::internal::StatsScope & stats,
+                   int const * offsets,
+                   int const * deltaVertices, int numDeltas,
+                   BufferDescriptor const &deltaDesc,
+                   BufferDescriptor const &dstDesc,
+                   int realSize) {
+
+    if (not stats.IsEnabled() or numDeltas <= 0) return;
+
+    size_t numWeights = 0;
+    for (int i = 0; i < numDeltas; ++i) {
+        int vertex = deltaVertices[i];
+        numWeights += offsets[vertex+1] - offsets[vertex];
+    }
+
+    // each delta reads its vertex, its offsets and its elements, and each
+    // weight a stencil index and the destination elements it accumulates to
+    size_t dstBytes = dstDesc.length * statsElementSize(dstDesc, realSize);
+    stats.SetCounts(numDeltas, numWeights,
+        numDeltas * (3 * sizeof(int) +
+                     deltaDesc.length * statsElementSize(deltaDesc, realSize)) +
+        numWeights * (sizeof(int) + realSize + dstBytes),
+        numWeights * dstBytes);
+}
+
+void
+CpuSetStencilListStats(Far::internal::StatsScope & stats,
+                       int const * sizes,
+                       int const * stencils, int numStencils,
+                       BufferDescriptor const &srcDesc,
+                       BufferDescriptor const &dstDesc,
+                       int numOutputs, int realSize) {
+
+    if (not stats.IsEnabled() or numStencils <= 0) return;
+
+    size_t numWeights = 0;
+    for (int i = 0; i < numStencils; ++i) {
+        numWeights += sizes[stencils[i]];
+    }
+
+    // the stencil list is read as well
+    setStencilCounts(stats, numStencils, numWeights,
+                     3 * sizeof(int), sizeof(int), realSize,
+                     srcDesc, dstDesc, numOutputs, realSize);
+}
+
+void
+CpuSetCompressedStencilStats(Far::internal::StatsScope & stats,
+                             unsigned char const * sizes,
+                             int start, int end,
+                             BufferDescriptor const &srcDesc,
+                             BufferDescriptor const &dstDesc) {
+
+    if (not stats.IsEnabled() or end <= start) return;
+
+    // the sizes from 255 on are completed by a varint, which is not
+    // decoded here : the count is a lower bound for those stencils
+    size_t numWeights = 0;
+    for (int i = start; i < end; ++i) {
+        numWeights += sizes[i];
+    }
+
+    // each stencil reads its 8-bit size and its scale, and each weight a
+    // 16-bit weight and a delta-coded index (one byte at least)
+    setStencilCounts(stats, end - start, numWeights,
+                     1 + sizeof(float), 1, sizeof(short),
+                     srcDesc, dstDesc, 1, sizeof(float));
+}
+
+template <typename REAL>
+static void
+setPatchStats(Far::internal::StatsScope & stats,
+              int numPatchCoords,
+              PatchCoordReal<REAL> const *patchCoords,
+              PatchArray const *patchArrays,
+              BufferDescriptor const &srcDesc,
+              BufferDescriptor const &dstDesc,
+              int numOutputs, int realSize) {
+
+    if (not stats.IsEnabled()) return;
+
+    size_t numCVs = 0;
+    for (int i = 0; i < numPatchCoords; ++i) {
+        numCVs += patchArrays[patchCoords[i].handle.arrayIndex].
+            GetDescriptor().GetNumControlVertices();
+    }
+
+    // each location reads its coord, the indices and elements of its
+    // control vertices, and applies one weight per control vertex and output
+    stats.SetCounts(numPatchCoords, numCVs * numOutputs,
+        numPatchCoords * sizeof(PatchCoordReal<REAL>) +
+        numCVs * (sizeof(int) +
+                  srcDesc.length * statsElementSize(srcDesc, realSize)),
+        (size_t)numPatchCoords * numOutputs * dstDesc.length *
+            statsElementSize(dstDesc, realSize));
+}
+
+void
+CpuSetPatchStats(Far::internal::StatsScope & stats,
+                 int numPatchCoords,
+                 PatchCoord const *patchCoords,
+                 PatchArray const *patchArrays,
+                 BufferDescriptor const &srcDesc,
+                 BufferDescriptor const &dstDesc,
+                 int numOutputs, int realSize) {
+    setPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                  srcDesc, dstDesc, numOutputs, realSize);
+}
+
+void
+CpuSetPatchStats(Far::internal::StatsScope & stats,
+                 int numPatchCoords,
+                 PatchCoordReal<double> const *patchCoords,
+                 PatchArray const *patchArrays,
+                 BufferDescriptor const &srcDesc,
+                 BufferDescriptor const &dstDesc,
+                 int numOutputs, int realSize) {
+    setPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                  srcDesc, dstDesc, numOutputs, realSize);
 }
 
 void
@@ -85,29 +574,69 @@ CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
         weights += offsets[start];
     }
 
+    if (isHalf(srcDesc) or isHalf(dstDesc)) {
+        evalStencilsConvert(src, srcDesc, dst, dstDesc,
+                            sizes, indices, weights, start, end-start);
+        return;
+    }
+
+    // note : stencil i is written to element i of the destination buffer,
+    //        as with the other backends.
     src += srcDesc.offset;
-    dst += dstDesc.offset;
+    dst += dstDesc.offset + start * dstDesc.stride;
+
+    int nstencils = end-start;
+
+    // only the elements held by both the source and the destination primvars
+    // are evaluated
+    int length = std::min(srcDesc.length, dstDesc.length);
+
+#if defined(OPENSUBDIV_HAS_CPU_SIMD)
+
+    switch (CpuGetSimdLevel()) {
+        case CPU_SIMD_AVX512:
+            // narrow primvars do not benefit from the wider registers
+            if (length > 8) {
+                CpuEvalStencilsAVX512(src, srcDesc.stride,
+                                      dst, dstDesc.stride, length,
+                                      sizes, indices, weights, nstencils);
+                return;
+            }
+            // fall through
+        case CPU_SIMD_AVX2:
+            CpuEvalStencilsAVX2(src, srcDesc.stride,
+                                dst, dstDesc.stride, length,
+                                sizes, indices, weights, nstencils);
+            return;
+        case CPU_SIMD_SSE:
+            CpuEvalStencilsSSE(src, srcDesc.stride,
+                               dst, dstDesc.stride, length,
+                               sizes, indices, weights, nstencils);
+            return;
+        default:
+            break;
+    }
+#endif
 
     if (srcDesc.length == 4 and dstDesc.length == 4 and
         srcDesc.stride == 4 and dstDesc.stride == 4) {
 
         // SIMD fast path for aligned primvar data (4 floats)
         ComputeStencilKernel<4>(src, dst,
-            sizes, indices, weights, start,  end);
+            sizes, indices, weights, 0, nstencils);
 
     } else if (srcDesc.length == 8 and dstDesc.length == 8 and
                srcDesc.stride == 8 and dstDesc.stride == 8) {
 
         // SIMD fast path for aligned primvar data (8 floats)
         ComputeStencilKernel<8>(src, dst,
-            sizes, indices, weights, start,  end);
+            sizes, indices, weights, 0, nstencils);
     } else {
 
         // Slow path for non-aligned data
 
         float * result = (float*)alloca(srcDesc.length * sizeof(float));
 
-        int nstencils = end-start;
         for (int i=0; i<nstencils; ++i, ++sizes) {
 
             clear(result, srcDesc);
@@ -116,7 +645,8 @@ CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
                 addWithWeight(result, src, *indices++, *weights++, srcDesc);
             }
 
-            copy(dst, i, result, dstDesc);
+            memcpy(elementAtIndex(dst, i, dstDesc), result,
+                   length * sizeof(float));
         }
     }
 }
@@ -133,6 +663,28 @@ CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
                 float const * duWeights,
                 float const * dvWeights,
                 int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    // derivative outputs are optional : fall back to separate passes if
+    // any of them is missing, or if any buffer holds half precision floats
+    if (not dst or not dstDu or not dstDv or isHalf(srcDesc) or
+        isHalf(dstDesc) or isHalf(dstDuDesc) or isHalf(dstDvDesc)) {
+        if (dst) {
+            CpuEvalStencils(src, srcDesc, dst, dstDesc,
+                            sizes, offsets, indices, weights, start, end);
+        }
+        if (dstDu) {
+            CpuEvalStencils(src, srcDesc, dstDu, dstDuDesc,
+                            sizes, offsets, indices, duWeights, start, end);
+        }
+        if (dstDv) {
+            CpuEvalStencils(src, srcDesc, dstDv, dstDvDesc,
+                            sizes, offsets, indices, dvWeights, start, end);
+        }
+        return;
+    }
+
     if (start > 0) {
         sizes += start;
         indices += offsets[start];
@@ -142,26 +694,479 @@ CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
     }
 
     src += srcDesc.offset;
+    dst += dstDesc.offset + start * dstDesc.stride;
+    dstDu += dstDuDesc.offset + start * dstDuDesc.stride;
+    dstDv += dstDvDesc.offset + start * dstDvDesc.stride;
+
+    int nStencils = end - start;
+
+    int length = std::min(std::min(srcDesc.length, dstDesc.length),
+                          std::min(dstDuDesc.length, dstDvDesc.length));
+
+#if defined(OPENSUBDIV_HAS_CPU_SIMD)
+    switch (CpuGetSimdLevel()) {
+        case CPU_SIMD_AVX512:
+            if (length > 8) {
+                CpuEvalStencilsAVX512(src, srcDesc.stride,
+                                      dst, dstDesc.stride,
+                                      dstDu, dstDuDesc.stride,
+                                      dstDv, dstDvDesc.stride,
+                                      length, sizes, indices,
+                                      weights, duWeights, dvWeights,
+                                      nStencils);
+                return;
+            }
+            // fall through
+        case CPU_SIMD_AVX2:
+            CpuEvalStencilsAVX2(src, srcDesc.stride,
+                                dst, dstDesc.stride,
+                                dstDu, dstDuDesc.stride,
+                                dstDv, dstDvDesc.stride,
+                                length, sizes, indices,
+                                weights, duWeights, dvWeights,
+                                nStencils);
+            return;
+        case CPU_SIMD_SSE:
+            CpuEvalStencilsSSE(src, srcDesc.stride,
+                               dst, dstDesc.stride,
+                               dstDu, dstDuDesc.stride,
+                               dstDv, dstDvDesc.stride,
+                               length, sizes, indices,
+                               weights, duWeights, dvWeights,
+                               nStencils);
+            return;
+        default:
+            break;
+    }
+#endif
+
+    float * result   = (float*)alloca(3 * length * sizeof(float));
+    float * resultDu = result + length;
+    float * resultDv = resultDu + length;
+
+    for (int i = 0; i < nStencils; ++i, ++sizes) {
+
+        // clear
+        memset(result, 0, 3 * length * sizeof(float));
+
+        // read each source element once for the 3 results
+        for (int j=0; j<*sizes; ++j) {
+            float const * s = elementAtIndex(src, *indices++, srcDesc);
+            float w = *weights++, wDu = *duWeights++, wDv = *dvWeights++;
+            for (int k = 0; k < length; ++k) {
+                result[k]   += s[k] * w;
+                resultDu[k] += s[k] * wDu;
+                resultDv[k] += s[k] * wDv;
+            }
+        }
+        memcpy(elementAtIndex(dst, i, dstDesc), result,
+               length * sizeof(float));
+        memcpy(elementAtIndex(dstDu, i, dstDuDesc), resultDu,
+               length * sizeof(float));
+        memcpy(elementAtIndex(dstDv, i, dstDvDesc), resultDv,
+               length * sizeof(float));
+    }
+}
+
+// The second derivatives are evaluated with a second pass of the kernel above,
+// which applies three weight arrays to the same source elements
+void
+CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
+                float * dst,       BufferDescriptor const &dstDesc,
+                float * dstDu,     BufferDescriptor const &dstDuDesc,
+                float * dstDv,     BufferDescriptor const &dstDvDesc,
+                float * dstDuu,    BufferDescriptor const &dstDuuDesc,
+                float * dstDuv,    BufferDescriptor const &dstDuvDesc,
+                float * dstDvv,    BufferDescriptor const &dstDvvDesc,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                float const * duWeights,
+                float const * dvWeights,
+                float const * duuWeights,
+                float const * duvWeights,
+                float const * dvvWeights,
+                int start, int end) {
+
+    if (dst or dstDu or dstDv) {
+        CpuEvalStencils(src, srcDesc, dst, dstDesc,
+                        dstDu, dstDuDesc, dstDv, dstDvDesc,
+                        sizes, offsets, indices,
+                        weights, duWeights, dvWeights, start, end);
+    }
+    if (dstDuu or dstDuv or dstDvv) {
+        CpuEvalStencils(src, srcDesc, dstDuu, dstDuuDesc,
+                        dstDuv, dstDuvDesc, dstDvv, dstDvvDesc,
+                        sizes, offsets, indices,
+                        duuWeights, duvWeights, dvvWeights, start, end);
+    }
+}
+
+// Number of stencils evaluated for every buffer pair before moving to the
+// next block : the indices and weights of a block stay in the L1 cache
+// while they are applied to each buffer.
+static const int multiBufferBlockSize = 64;
+
+void
+CpuEvalStencils(int numBuffers,
+                float const * const * srcs, BufferDescriptor const * srcDescs,
+                float * const * dsts,       BufferDescriptor const * dstDescs,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    for (int first = start; first < end; first += multiBufferBlockSize) {
+
+        int last = std::min(first + multiBufferBlockSize, end);
+
+        for (int i = 0; i < numBuffers; ++i) {
+            CpuEvalStencils(srcs[i], srcDescs[i], dsts[i], dstDescs[i],
+                            sizes, offsets, indices, weights, first, last);
+        }
+    }
+}
+
+//
+// Structure of arrays stencils : groups of up to NP planes are accumulated
+// per stencil. There is no SIMD path : gathering the scattered source values
+// of consecutive stencils was not faster than the AoS kernels.
+//
+template <int NP>
+static void
+evalStencilsSoA(float const * src, int srcPlaneStride,
+                float * dst, int dstPlaneStride,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                int start, int end) {
+
+    for (int i = start; i < end; ++i) {
+
+        float result[NP];
+        for (int p = 0; p < NP; ++p) {
+            result[p] = 0.0f;
+        }
+
+        int const * index = indices + offsets[i];
+        float const * weight = weights + offsets[i];
+        for (int j = 0; j < sizes[i]; ++j) {
+            float const * s = src + index[j];
+            for (int p = 0; p < NP; ++p) {
+                result[p] += s[p * srcPlaneStride] * weight[j];
+            }
+        }
+
+        for (int p = 0; p < NP; ++p) {
+            dst[p * dstPlaneStride + i] = result[p];
+        }
+    }
+}
+
+void
+CpuEvalStencils(float const * src, SoABufferDescriptor const &srcDesc,
+                float * dst,       SoABufferDescriptor const &dstDesc,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    src += srcDesc.offset;
+    dst += dstDesc.offset;
+
+    int length = srcDesc.length;
+
+    for (int p = 0; p < length; p += 4) {
+        float const * s = src + p * srcDesc.planeStride;
+        float * d = dst + p * dstDesc.planeStride;
+        switch (std::min(length - p, 4)) {
+            case 1:
+                evalStencilsSoA<1>(s, srcDesc.planeStride,
+                    d, dstDesc.planeStride,
+                    sizes, offsets, indices, weights, start, end);
+                break;
+            case 2:
+                evalStencilsSoA<2>(s, srcDesc.planeStride,
+                    d, dstDesc.planeStride,
+                    sizes, offsets, indices, weights, start, end);
+                break;
+            case 3:
+                evalStencilsSoA<3>(s, srcDesc.planeStride,
+                    d, dstDesc.planeStride,
+                    sizes, offsets, indices, weights, start, end);
+                break;
+            default:
+                evalStencilsSoA<4>(s, srcDesc.planeStride,
+                    d, dstDesc.planeStride,
+                    sizes, offsets, indices, weights, start, end);
+                break;
+        }
+    }
+}
+
+//
+// Compressed stencils : the weights are quantized integers of a per-stencil
+// scale, so the primvar elements are accumulated with the integer weights
+// and scaled once per stencil.
+//
+template <int LENGTH>
+static void
+evalCompressedStencils(float const * src, int srcStride,
+                       float * dst, int dstStride, int length,
+                       unsigned char const * sizes,
+                       float const * scales,
+                       int const * blockIndexOffsets,
+                       int const * blockWeightOffsets,
+                       unsigned char const * indices,
+                       short const * weights,
+                       int start, int end) {
+
+    typedef Far::CompressedStencilTable Table;
+
+    // the accumulators of the unrolled paths stay in registers
+    float fixedResult[LENGTH ? LENGTH : 1],
+        * result = fixedResult;
+    if (LENGTH) {
+        length = LENGTH;
+    } else {
+        result = (float*)alloca(length * sizeof(float));
+    }
+
+    // decode from the start of the block holding the first stencil
+    int i = start - start % Table::BLOCK_SIZE;
+
+    indices += blockIndexOffsets[i / Table::BLOCK_SIZE];
+    weights += blockWeightOffsets[i / Table::BLOCK_SIZE];
+
+    int firstIndex = 0;
+    for (; i < end; ++i) {
+
+        if (i % Table::BLOCK_SIZE == 0) {
+            firstIndex = 0;
+        }
+
+        int size = sizes[i];
+        if (size == 255) {
+            size += Table::DecodeVarint(indices);
+        }
+
+        // empty stencils are encoded without any index
+        if (size > 0) {
+            firstIndex += Table::DecodeZigZag(Table::DecodeVarint(indices));
+        }
+
+        if (i < start) {
+            // skip the remaining indices of the stencil
+            for (int j = 1; j < size; ++j) {
+                Table::DecodeVarint(indices);
+            }
+            weights += size;
+            continue;
+        }
+
+        for (int k = 0; k < length; ++k) {
+            result[k] = 0.0f;
+        }
+
+        int index = firstIndex;
+        for (int j = 0; j < size; ++j) {
+            if (j > 0) {
+                index += Table::DecodeVarint(indices);
+            }
+            float const * s = src + index * srcStride;
+            float w = weights[j];
+            for (int k = 0; k < length; ++k) {
+                result[k] += s[k] * w;
+            }
+        }
+        weights += size;
+
+        float scale = scales[i],
+            * d = dst + i * dstStride;
+        for (int k = 0; k < length; ++k) {
+            d[k] = result[k] * scale;
+        }
+    }
+}
+
+void
+CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
+                float * dst,       BufferDescriptor const &dstDesc,
+                unsigned char const * sizes,
+                float const * scales,
+                int const * blockIndexOffsets,
+                int const * blockWeightOffsets,
+                unsigned char const * indices,
+                short const * weights,
+                int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    src += srcDesc.offset;
+    dst += dstDesc.offset;
+
+    // unrolled paths for the common primvar lengths
+    switch (srcDesc.length) {
+        case 3:
+            evalCompressedStencils<3>(src, srcDesc.stride,
+                dst, dstDesc.stride, srcDesc.length, sizes, scales,
+                blockIndexOffsets, blockWeightOffsets, indices, weights,
+                start, end);
+            break;
+        case 4:
+            evalCompressedStencils<4>(src, srcDesc.stride,
+                dst, dstDesc.stride, srcDesc.length, sizes, scales,
+                blockIndexOffsets, blockWeightOffsets, indices, weights,
+                start, end);
+            break;
+        default:
+            evalCompressedStencils<0>(src, srcDesc.stride,
+                dst, dstDesc.stride, srcDesc.length, sizes, scales,
+                blockIndexOffsets, blockWeightOffsets, indices, weights,
+                start, end);
+            break;
+    }
+}
+
+void
+CpuEvalStencilDeltas(float const * deltas, BufferDescriptor const &deltaDesc,
+                     int const * deltaVertices, int numDeltas,
+                     float * dst, BufferDescriptor const &dstDesc,
+                     int const * offsets,
+                     int const * stencils,
+                     float const * weights) {
+
+    deltas += deltaDesc.offset;
     dst += dstDesc.offset;
-    dstDu += dstDuDesc.offset;
-    dstDv += dstDvDesc.offset;
 
-    int nOutLength = dstDesc.length + dstDuDesc.length + dstDvDesc.length;
-    float * result   = (float*)alloca(nOutLength * sizeof(float));
-    float * resultDu = result + dstDesc.length;
-    float * resultDv = resultDu + dstDuDesc.length;
+    int length = deltaDesc.length;
+
+    for (int i = 0; i < numDeltas; ++i) {
+
+        float const * delta = deltas + i * deltaDesc.stride;
+
+        int vertex = deltaVertices[i];
+        for (int j = offsets[vertex]; j < offsets[vertex+1]; ++j) {
+            float * d = dst + stencils[j] * dstDesc.stride,
+                    w = weights[j];
+            for (int k = 0; k < length; ++k) {
+                d[k] += delta[k] * w;
+            }
+        }
+    }
+}
+
+//
+// Double precision stencil kernels : these are portable (the SIMD kernels
+// only exist for floats) and otherwise follow the single precision ones.
+//
+void
+CpuEvalStencils(double const * src, BufferDescriptor const &srcDesc,
+                double * dst,       BufferDescriptor const &dstDesc,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                double const * weights,
+                int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    if (start>0) {
+        sizes += start;
+        indices += offsets[start];
+        weights += offsets[start];
+    }
+
+    src += srcDesc.offset;
+    dst += dstDesc.offset + start * dstDesc.stride;
+
+    int nstencils = end-start;
+
+    double * result = (double*)alloca(srcDesc.length * sizeof(double));
+
+    for (int i=0; i<nstencils; ++i, ++sizes) {
+
+        clear(result, srcDesc);
+
+        for (int j=0; j<*sizes; ++j) {
+            addWithWeight(result, src, *indices++, *weights++, srcDesc);
+        }
+
+        copy(dst, i, result, dstDesc);
+    }
+}
+
+void
+CpuEvalStencils(double const * src, BufferDescriptor const &srcDesc,
+                double * dst,       BufferDescriptor const &dstDesc,
+                double * dstDu,     BufferDescriptor const &dstDuDesc,
+                double * dstDv,     BufferDescriptor const &dstDvDesc,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                double const * weights,
+                double const * duWeights,
+                double const * dvWeights,
+                int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    if (not dst or not dstDu or not dstDv) {
+        if (dst) {
+            CpuEvalStencils(src, srcDesc, dst, dstDesc,
+                            sizes, offsets, indices, weights, start, end);
+        }
+        if (dstDu) {
+            CpuEvalStencils(src, srcDesc, dstDu, dstDuDesc,
+                            sizes, offsets, indices, duWeights, start, end);
+        }
+        if (dstDv) {
+            CpuEvalStencils(src, srcDesc, dstDv, dstDvDesc,
+                            sizes, offsets, indices, dvWeights, start, end);
+        }
+        return;
+    }
+
+    if (start > 0) {
+        sizes += start;
+        indices += offsets[start];
+        weights += offsets[start];
+        duWeights += offsets[start];
+        dvWeights += offsets[start];
+    }
+
+    src += srcDesc.offset;
+    dst += dstDesc.offset + start * dstDesc.stride;
+    dstDu += dstDuDesc.offset + start * dstDuDesc.stride;
+    dstDv += dstDvDesc.offset + start * dstDvDesc.stride;
 
     int nStencils = end - start;
+
+    int length = srcDesc.length;
+    double * result   = (double*)alloca(3 * length * sizeof(double));
+    double * resultDu = result + length;
+    double * resultDv = resultDu + length;
+
     for (int i = 0; i < nStencils; ++i, ++sizes) {
 
-        // clear
-        memset(result, 0, nOutLength * sizeof(float));
+        memset(result, 0, 3 * length * sizeof(double));
 
         for (int j=0; j<*sizes; ++j) {
-            addWithWeight(result,   src, *indices, *weights++,   srcDesc);
-            addWithWeight(resultDu, src, *indices, *duWeights++, srcDesc);
-            addWithWeight(resultDv, src, *indices, *dvWeights++, srcDesc);
-            ++indices;
+            double const * s = elementAtIndex(src, *indices++, srcDesc);
+            double w = *weights++, wDu = *duWeights++, wDv = *dvWeights++;
+            for (int k = 0; k < length; ++k) {
+                result[k]   += s[k] * w;
+                resultDu[k] += s[k] * wDu;
+                resultDv[k] += s[k] * wDv;
+            }
         }
         copy(dst,   i, result, dstDesc);
         copy(dstDu, i, resultDu, dstDuDesc);
@@ -169,6 +1174,523 @@ CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
     }
 }
 
+void
+CpuEvalStencils(double const * src, BufferDescriptor const &srcDesc,
+                double * dst,       BufferDescriptor const &dstDesc,
+                double * dstDu,     BufferDescriptor const &dstDuDesc,
+                double * dstDv,     BufferDescriptor const &dstDvDesc,
+                double * dstDuu,    BufferDescriptor const &dstDuuDesc,
+                double * dstDuv,    BufferDescriptor const &dstDuvDesc,
+                double * dstDvv,    BufferDescriptor const &dstDvvDesc,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                double const * weights,
+                double const * duWeights,
+                double const * dvWeights,
+                double const * duuWeights,
+                double const * duvWeights,
+                double const * dvvWeights,
+                int start, int end) {
+
+    if (dst or dstDu or dstDv) {
+        CpuEvalStencils(src, srcDesc, dst, dstDesc,
+                        dstDu, dstDuDesc, dstDv, dstDvDesc,
+                        sizes, offsets, indices,
+                        weights, duWeights, dvWeights, start, end);
+    }
+    if (dstDuu or dstDuv or dstDvv) {
+        CpuEvalStencils(src, srcDesc, dstDuu, dstDuuDesc,
+                        dstDuv, dstDuvDesc, dstDvv, dstDvvDesc,
+                        sizes, offsets, indices,
+                        duuWeights, duvWeights, dvvWeights, start, end);
+    }
+}
+
+// Number of coordinates on a patch sharing the SoA weight buffers
+static const int patchBlockSize = 32;
+
+static inline bool
+isSamePatch(Far::PatchTable::PatchHandle const & a,
+            Far::PatchTable::PatchHandle const & b) {
+    return a.patchIndex == b.patchIndex and
+           a.arrayIndex == b.arrayIndex and
+           a.vertIndex == b.vertIndex;
+}
+
+//
+// Orders the coordinates so that those sharing a patch are contiguous. The
+// client order is kept when it is already grouped (e.g. coordinates generated
+// patch by patch) or when there are too few coordinates per patch to pay for
+// the counting sort.
+//
+template <typename REAL>
+static void
+binPatchCoords(int numPatchCoords, PatchCoordReal<REAL> const * patchCoords,
+               int * order) {
+
+    if (numPatchCoords <= 0) return;
+
+    int numRuns = 1,
+        minPatchIndex = patchCoords[0].handle.patchIndex,
+        maxPatchIndex = minPatchIndex;
+    for (int i = 1; i < numPatchCoords; ++i) {
+        int patchIndex = patchCoords[i].handle.patchIndex;
+        if (patchIndex != patchCoords[i-1].handle.patchIndex) {
+            ++numRuns;
+        }
+        minPatchIndex = std::min(minPatchIndex, patchIndex);
+        maxPatchIndex = std::max(maxPatchIndex, patchIndex);
+    }
+
+    int numBins = maxPatchIndex - minPatchIndex + 1;
+    if (numRuns*2 <= numPatchCoords or numPatchCoords < numBins*2) {
+        for (int i = 0; i < numPatchCoords; ++i) {
+            order[i] = i;
+        }
+        return;
+    }
+
+    // stable counting sort on the patch index
+    std::vector<int> binOffsets(numBins + 1, 0);
+    for (int i = 0; i < numPatchCoords; ++i) {
+        ++binOffsets[patchCoords[i].handle.patchIndex - minPatchIndex + 1];
+    }
+    for (int i = 0; i < numBins; ++i) {
+        binOffsets[i+1] += binOffsets[i];
+    }
+    for (int i = 0; i < numPatchCoords; ++i) {
+        order[binOffsets[patchCoords[i].handle.patchIndex - minPatchIndex]++] = i;
+    }
+}
+
+void
+CpuBinPatchCoords(int numPatchCoords, PatchCoord const * patchCoords,
+                  int * order) {
+    binPatchCoords(numPatchCoords, patchCoords, order);
+}
+
+//
+// Combines the gathered control vertices of a patch with the SoA weights of a
+// block of coordinates : the inner loop runs over the coordinates so that each
+// control vertex element is loaded once for the whole block.
+//
+template <typename REAL>
+static void
+evalPatchBlock(REAL const * cvs, int numControlVertices, int length,
+               REAL const * weights, int numCoords,
+               REAL * dst, int dstStride, bool dstHalf,
+               int const * dstIndices) {
+
+    REAL result[patchBlockSize];
+
+    for (int e = 0; e < length; ++e) {
+        for (int k = 0; k < numCoords; ++k) {
+            result[k] = 0;
+        }
+        for (int j = 0; j < numControlVertices; ++j) {
+            REAL cv = cvs[j*length + e];
+            REAL const * w = weights + j*patchBlockSize;
+            for (int k = 0; k < numCoords; ++k) {
+                result[k] += w[k] * cv;
+            }
+        }
+        if (dstHalf) {
+            unsigned short * h = reinterpret_cast<unsigned short *>(dst);
+            for (int k = 0; k < numCoords; ++k) {
+                h[dstIndices[k]*dstStride + e] = floatToHalf((float)result[k]);
+            }
+        } else {
+            for (int k = 0; k < numCoords; ++k) {
+                dst[dstIndices[k]*dstStride + e] = result[k];
+            }
+        }
+    }
+}
+
+//
+// Combines the gathered control vertices of a patch with the derivative
+// weights of a block of coordinates, and writes the unit normals : the
+// normalized cross products of the first three elements of the U and V
+// derivatives (or zero where the derivatives are parallel).
+//
+template <typename REAL>
+static void
+evalPatchNormalBlock(REAL const * cvs, int numControlVertices, int length,
+                     REAL const * wDs, REAL const * wDt, int numCoords,
+                     REAL * dst, int dstStride, bool dstHalf,
+                     int const * dstIndices) {
+
+    REAL du[3][patchBlockSize],
+         dv[3][patchBlockSize];
+
+    for (int e = 0; e < 3; ++e) {
+        for (int k = 0; k < numCoords; ++k) {
+            du[e][k] = 0;
+            dv[e][k] = 0;
+        }
+        for (int j = 0; j < numControlVertices; ++j) {
+            REAL cv = cvs[j*length + e];
+            REAL const * ws = wDs + j*patchBlockSize,
+                       * wt = wDt + j*patchBlockSize;
+            for (int k = 0; k < numCoords; ++k) {
+                du[e][k] += ws[k] * cv;
+                dv[e][k] += wt[k] * cv;
+            }
+        }
+    }
+
+    for (int k = 0; k < numCoords; ++k) {
+        REAL n[3] = { du[1][k]*dv[2][k] - du[2][k]*dv[1][k],
+                      du[2][k]*dv[0][k] - du[0][k]*dv[2][k],
+                      du[0][k]*dv[1][k] - du[1][k]*dv[0][k] };
+        REAL len = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]),
+             scale = (len > 0) ? REAL(1) / len : REAL(0);
+
+        if (dstHalf) {
+            unsigned short * h = reinterpret_cast<unsigned short *>(dst) +
+                                 dstIndices[k]*dstStride;
+            for (int e = 0; e < 3; ++e) {
+                h[e] = floatToHalf((float)(n[e] * scale));
+            }
+        } else {
+            REAL * d = dst + dstIndices[k]*dstStride;
+            for (int e = 0; e < 3; ++e) {
+                d[e] = n[e] * scale;
+            }
+        }
+    }
+}
+
+template <typename REAL>
+static bool
+evalPatches(REAL const * src, BufferDescriptor const &srcDesc,
+            REAL * dst,       BufferDescriptor const &dstDesc,
+            REAL * dstDu,     BufferDescriptor const &dstDuDesc,
+            REAL * dstDv,     BufferDescriptor const &dstDvDesc,
+            REAL * dstNormal, BufferDescriptor const &dstNormalDesc,
+            REAL * dstDuu,    BufferDescriptor const &dstDuuDesc,
+            REAL * dstDuv,    BufferDescriptor const &dstDuvDesc,
+            REAL * dstDvv,    BufferDescriptor const &dstDvvDesc,
+            int numPatchCoords,
+            int const * order,
+            PatchCoordReal<REAL> const * patchCoords,
+            PatchArray const * patchArrays,
+            int const * patchIndexBuffer,
+            PatchParam const * patchParamBuffer) {
+
+    int length = srcDesc.length;
+    if (numPatchCoords <= 0 or length <= 0) return true;
+    if (dstNormal and length < 3) return false;
+
+    src = elementAtOffset(src, srcDesc.offset, srcDesc);
+    if (dst)   dst   = elementAtOffset(dst, dstDesc.offset, dstDesc);
+    if (dstDu) dstDu = elementAtOffset(dstDu, dstDuDesc.offset, dstDuDesc);
+    if (dstDv) dstDv = elementAtOffset(dstDv, dstDvDesc.offset, dstDvDesc);
+    if (dstNormal) {
+        dstNormal = elementAtOffset(dstNormal, dstNormalDesc.offset,
+                                    dstNormalDesc);
+    }
+    if (dstDuu) dstDuu = elementAtOffset(dstDuu, dstDuuDesc.offset, dstDuuDesc);
+    if (dstDuv) dstDuv = elementAtOffset(dstDuv, dstDuvDesc.offset, dstDuvDesc);
+    if (dstDvv) dstDvv = elementAtOffset(dstDvv, dstDvvDesc.offset, dstDvvDesc);
+
+    bool computeDerivs  = (dstDu or dstDv or dstNormal),
+         computeDerivs2 = (dstDuu or dstDuv or dstDvv);
+
+    std::vector<REAL> cvs(20 * length);
+
+    REAL s[patchBlockSize],
+         t[patchBlockSize];
+    int dstIndices[patchBlockSize];
+
+    REAL wP[20 * patchBlockSize],
+         wDs[20 * patchBlockSize],
+         wDt[20 * patchBlockSize],
+         wDss[20 * patchBlockSize],
+         wDst[20 * patchBlockSize],
+         wDtt[20 * patchBlockSize];
+
+    for (int runBegin = 0; runBegin < numPatchCoords; ) {
+
+        Far::PatchTable::PatchHandle const & handle =
+            patchCoords[order[runBegin]].handle;
+
+        int runEnd = runBegin + 1;
+        while (runEnd < numPatchCoords and
+               isSamePatch(patchCoords[order[runEnd]].handle, handle)) {
+            ++runEnd;
+        }
+
+        PatchArray const & array = patchArrays[handle.arrayIndex];
+        // XXX: patchIndex is absolute. not sure it's consistent.
+        //      (should be offsetted by array.primitiveIdBase?)
+        //    patchParamBuffer[array.primitiveIdBase + handle.patchIndex]
+        Far::PatchParam const & param = patchParamBuffer[handle.patchIndex];
+
+        int patchType = array.GetPatchType(),
+            numControlVertices = 0;
+        if (patchType == Far::PatchDescriptor::REGULAR) {
+            numControlVertices = 16;
+        } else if (patchType == Far::PatchDescriptor::GREGORY_BASIS) {
+            numControlVertices = 20;
+        } else if (patchType == Far::PatchDescriptor::QUADS) {
+            numControlVertices = 4;
+        } else {
+            assert(0);
+            return false;
+        }
+
+        // gather the control vertices once for all the coordinates on the patch
+        int const * cvIndices =
+            &patchIndexBuffer[array.indexBase + handle.vertIndex];
+        for (int j = 0; j < numControlVertices; ++j) {
+            loadElements(&cvs[j*length],
+                elementAtOffset(src, cvIndices[j]*srcDesc.stride, srcDesc),
+                length, isHalf(srcDesc));
+        }
+
+        for (int blockBegin = runBegin; blockBegin < runEnd;
+             blockBegin += patchBlockSize) {
+
+            int numCoords = std::min(runEnd - blockBegin, patchBlockSize);
+
+            for (int k = 0; k < numCoords; ++k) {
+                int index = order[blockBegin + k];
+                s[k] = patchCoords[index].s;
+                t[k] = patchCoords[index].t;
+                dstIndices[k] = index;
+            }
+
+            REAL * wDsPtr  = computeDerivs ? wDs : 0,
+                 * wDtPtr  = computeDerivs ? wDt : 0,
+                 * wDssPtr = computeDerivs2 ? wDss : 0,
+                 * wDstPtr = computeDerivs2 ? wDst : 0,
+                 * wDttPtr = computeDerivs2 ? wDtt : 0;
+            if (patchType == Far::PatchDescriptor::REGULAR) {
+                Far::internal::GetBSplineWeights(param, numCoords, s, t,
+                    wP, wDsPtr, wDtPtr, wDssPtr, wDstPtr, wDttPtr,
+                    patchBlockSize);
+            } else if (patchType == Far::PatchDescriptor::GREGORY_BASIS) {
+                Far::internal::GetGregoryWeights(param, numCoords, s, t,
+                    wP, wDsPtr, wDtPtr, wDssPtr, wDstPtr, wDttPtr,
+                    patchBlockSize);
+            } else {
+                Far::internal::GetBilinearWeights(param, numCoords, s, t,
+                    wP, wDsPtr, wDtPtr, wDssPtr, wDstPtr, wDttPtr,
+                    patchBlockSize);
+            }
+
+            if (dst) {
+                evalPatchBlock(&cvs[0], numControlVertices, length,
+                               wP, numCoords,
+                               dst, dstDesc.stride, isHalf(dstDesc),
+                               dstIndices);
+            }
+            if (dstDu) {
+                evalPatchBlock(&cvs[0], numControlVertices, length,
+                               wDs, numCoords,
+                               dstDu, dstDuDesc.stride, isHalf(dstDuDesc),
+                               dstIndices);
+            }
+            if (dstDv) {
+                evalPatchBlock(&cvs[0], numControlVertices, length,
+                               wDt, numCoords,
+                               dstDv, dstDvDesc.stride, isHalf(dstDvDesc),
+                               dstIndices);
+            }
+            if (dstNormal) {
+                evalPatchNormalBlock(&cvs[0], numControlVertices, length,
+                                     wDs, wDt, numCoords,
+                                     dstNormal, dstNormalDesc.stride,
+                                     isHalf(dstNormalDesc), dstIndices);
+            }
+            if (dstDuu) {
+                evalPatchBlock(&cvs[0], numControlVertices, length,
+                               wDss, numCoords,
+                               dstDuu, dstDuuDesc.stride, isHalf(dstDuuDesc),
+                               dstIndices);
+            }
+            if (dstDuv) {
+                evalPatchBlock(&cvs[0], numControlVertices, length,
+                               wDst, numCoords,
+                               dstDuv, dstDuvDesc.stride, isHalf(dstDuvDesc),
+                               dstIndices);
+            }
+            if (dstDvv) {
+                evalPatchBlock(&cvs[0], numControlVertices, length,
+                               wDtt, numCoords,
+                               dstDvv, dstDvvDesc.stride, isHalf(dstDvvDesc),
+                               dstIndices);
+            }
+        }
+        runBegin = runEnd;
+    }
+    return true;
+}
+
+template <typename REAL>
+static bool
+binAndEvalPatches(REAL const * src, BufferDescriptor const &srcDesc,
+                  REAL * dst,       BufferDescriptor const &dstDesc,
+                  REAL * dstDu,     BufferDescriptor const &dstDuDesc,
+                  REAL * dstDv,     BufferDescriptor const &dstDvDesc,
+                  REAL * dstNormal, BufferDescriptor const &dstNormalDesc,
+                  REAL * dstDuu,    BufferDescriptor const &dstDuuDesc,
+                  REAL * dstDuv,    BufferDescriptor const &dstDuvDesc,
+                  REAL * dstDvv,    BufferDescriptor const &dstDvvDesc,
+                  int numPatchCoords,
+                  PatchCoordReal<REAL> const * patchCoords,
+                  PatchArray const * patchArrays,
+                  int const * patchIndexBuffer,
+                  PatchParam const * patchParamBuffer) {
+
+    if (numPatchCoords <= 0) return true;
+
+    std::vector<int> order(numPatchCoords);
+    binPatchCoords(numPatchCoords, patchCoords, &order[0]);
+
+    return evalPatches(src, srcDesc, dst, dstDesc,
+                       dstDu, dstDuDesc, dstDv, dstDvDesc,
+                       dstNormal, dstNormalDesc,
+                       dstDuu, dstDuuDesc, dstDuv, dstDuvDesc,
+                       dstDvv, dstDvvDesc,
+                       numPatchCoords, &order[0], patchCoords,
+                       patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+bool
+CpuEvalPatches(float const * src, BufferDescriptor const &srcDesc,
+               float * dst,       BufferDescriptor const &dstDesc,
+               float * dstDu,     BufferDescriptor const &dstDuDesc,
+               float * dstDv,     BufferDescriptor const &dstDvDesc,
+               int numPatchCoords,
+               PatchCoord const * patchCoords,
+               PatchArray const * patchArrays,
+               int const * patchIndexBuffer,
+               PatchParam const * patchParamBuffer) {
+
+    return binAndEvalPatches(src, srcDesc, dst, dstDesc,
+                             dstDu, dstDuDesc, dstDv, dstDvDesc,
+                             (float *)NULL, BufferDescriptor(),
+                             (float *)NULL, BufferDescriptor(),
+                             (float *)NULL, BufferDescriptor(),
+                             (float *)NULL, BufferDescriptor(),
+                             numPatchCoords, patchCoords,
+                             patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+bool
+CpuEvalPatchNormals(float const * src, BufferDescriptor const &srcDesc,
+                    float * dst,       BufferDescriptor const &dstDesc,
+                    float * dstNormal, BufferDescriptor const &dstNormalDesc,
+                    int numPatchCoords,
+                    PatchCoord const * patchCoords,
+                    PatchArray const * patchArrays,
+                    int const * patchIndexBuffer,
+                    PatchParam const * patchParamBuffer) {
+
+    return binAndEvalPatches(src, srcDesc, dst, dstDesc,
+                             (float *)NULL, BufferDescriptor(),
+                             (float *)NULL, BufferDescriptor(),
+                             dstNormal, dstNormalDesc,
+                             (float *)NULL, BufferDescriptor(),
+                             (float *)NULL, BufferDescriptor(),
+                             (float *)NULL, BufferDescriptor(),
+                             numPatchCoords, patchCoords,
+                             patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+bool
+CpuEvalPatches(float const * src, BufferDescriptor const &srcDesc,
+               float * dst,       BufferDescriptor const &dstDesc,
+               float * dstDu,     BufferDescriptor const &dstDuDesc,
+               float * dstDv,     BufferDescriptor const &dstDvDesc,
+               float * dstNormal, BufferDescriptor const &dstNormalDesc,
+               int numCoords,
+               int const * coordIndices,
+               PatchCoord const * patchCoords,
+               PatchArray const * patchArrays,
+               int const * patchIndexBuffer,
+               PatchParam const * patchParamBuffer) {
+
+    return evalPatches(src, srcDesc, dst, dstDesc,
+                       dstDu, dstDuDesc, dstDv, dstDvDesc,
+                       dstNormal, dstNormalDesc,
+                       (float *)NULL, BufferDescriptor(),
+                       (float *)NULL, BufferDescriptor(),
+                       (float *)NULL, BufferDescriptor(),
+                       numCoords, coordIndices, patchCoords,
+                       patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+bool
+CpuEvalPatches(float const * src, BufferDescriptor const &srcDesc,
+               float * dst,       BufferDescriptor const &dstDesc,
+               float * dstDu,     BufferDescriptor const &dstDuDesc,
+               float * dstDv,     BufferDescriptor const &dstDvDesc,
+               float * dstDuu,    BufferDescriptor const &dstDuuDesc,
+               float * dstDuv,    BufferDescriptor const &dstDuvDesc,
+               float * dstDvv,    BufferDescriptor const &dstDvvDesc,
+               int numPatchCoords,
+               PatchCoord const * patchCoords,
+               PatchArray const * patchArrays,
+               int const * patchIndexBuffer,
+               PatchParam const * patchParamBuffer) {
+
+    return binAndEvalPatches(src, srcDesc, dst, dstDesc,
+                             dstDu, dstDuDesc, dstDv, dstDvDesc,
+                             (float *)NULL, BufferDescriptor(),
+                             dstDuu, dstDuuDesc, dstDuv, dstDuvDesc,
+                             dstDvv, dstDvvDesc,
+                             numPatchCoords, patchCoords,
+                             patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+bool
+CpuEvalPatches(double const * src, BufferDescriptor const &srcDesc,
+               double * dst,       BufferDescriptor const &dstDesc,
+               double * dstDu,     BufferDescriptor const &dstDuDesc,
+               double * dstDv,     BufferDescriptor const &dstDvDesc,
+               int numPatchCoords,
+               PatchCoordReal<double> const * patchCoords,
+               PatchArray const * patchArrays,
+               int const * patchIndexBuffer,
+               PatchParam const * patchParamBuffer) {
+
+    return binAndEvalPatches(src, srcDesc, dst, dstDesc,
+                             dstDu, dstDuDesc, dstDv, dstDvDesc,
+                             (double *)NULL, BufferDescriptor(),
+                             (double *)NULL, BufferDescriptor(),
+                             (double *)NULL, BufferDescriptor(),
+                             (double *)NULL, BufferDescriptor(),
+                             numPatchCoords, patchCoords,
+                             patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+bool
+CpuEvalPatches(double const * src, BufferDescriptor const &srcDesc,
+               double * dst,       BufferDescriptor const &dstDesc,
+               double * dstDu,     BufferDescriptor const &dstDuDesc,
+               double * dstDv,     BufferDescriptor const &dstDvDesc,
+               double * dstDuu,    BufferDescriptor const &dstDuuDesc,
+               double * dstDuv,    BufferDescriptor const &dstDuvDesc,
+               double * dstDvv,    BufferDescriptor const &dstDvvDesc,
+               int numPatchCoords,
+               PatchCoordReal<double> const * patchCoords,
+               PatchArray const * patchArrays,
+               int const * patchIndexBuffer,
+               PatchParam const * patchParamBuffer) {
+
+    return binAndEvalPatches(src, srcDesc, dst, dstDesc,
+                             dstDu, dstDuDesc, dstDv, dstDvDesc,
+                             (double *)NULL, BufferDescriptor(),
+                             dstDuu, dstDuuDesc, dstDuv, dstDuvDesc,
+                             dstDvv, dstDvvDesc,
+                             numPatchCoords, patchCoords,
+                             patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
 }  // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
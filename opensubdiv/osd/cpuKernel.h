@@ -31,9 +31,141 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
+namespace Far {
+namespace internal {
+class StatsScope;
+}
+}
+
 namespace Osd {
 
 struct BufferDescriptor;
+struct SoABufferDescriptor;
+template <typename REAL> struct PatchCoordReal;
+typedef PatchCoordReal<float> PatchCoord;
+struct PatchArray;
+struct PatchParam;
+
+//
+// Runtime instruction set dispatch
+//
+// The stencil kernels are compiled for several x86 instruction sets and the
+// best one supported by the host is selected the first time a kernel runs.
+// CpuSetSimdLevel() can be used to force a lower level (e.g. for debugging or
+// benchmarking) : requests above the detected level are clamped.
+//
+enum CpuSimdLevel {
+    CPU_SIMD_NONE = 0,   ///< portable C++ kernels
+    CPU_SIMD_SSE,        ///< SSE2
+    CPU_SIMD_AVX2,       ///< AVX2 + FMA
+    CPU_SIMD_AVX512      ///< AVX-512F
+};
+
+CpuSimdLevel CpuGetSimdLevel();
+
+void CpuSetSimdLevel(CpuSimdLevel level);
+
+//
+// Cost-balanced partitioning of stencil ranges
+//
+// The parallel kernels split [start, end) into partitions holding about the
+// same number of weights rather than the same number of stencils, so that
+// ranges of large (e.g. extraordinary vertex) stencils are not handed to a
+// single task. Partition boundaries are found by binary search in the offsets
+// table, which holds the prefix sums of the stencil sizes.
+//
+int CpuGetNumStencilPartitions(int const * sizes, int const * offsets,
+                               int start, int end, int minPartitions = 1);
+
+// Returns the first stencil of the given partition (or end)
+int CpuGetStencilPartitionStart(int const * sizes, int const * offsets,
+                                int start, int end,
+                                int partition, int numPartitions);
+
+//
+// Counters of the evaluators (see Far::SetStatsCallback())
+//
+// These fill the counts of a measured call from its inputs : numOutputs is
+// the number of destination buffers written (e.g. 3 for the point and its
+// two derivatives) and realSize the size of the weights and of the primvar
+// values (but for half precision primvars, counted as such). They return
+// immediately when the scope is disabled.
+//
+// Number of outputs written by an evaluation : its non-NULL buffers
+template <typename REAL>
+inline int
+CpuGetNumOutputs(REAL const *p0, REAL const *p1 = 0, REAL const *p2 = 0,
+                 REAL const *p3 = 0, REAL const *p4 = 0, REAL const *p5 = 0) {
+    return (p0 != 0) + (p1 != 0) + (p2 != 0) +
+           (p3 != 0) + (p4 != 0) + (p5 != 0);
+}
+
+// Descriptor of the outputs counted by the stats : the destination, or
+// another output if there is no destination
+inline BufferDescriptor const &
+CpuGetOutputDesc(void const *dst, BufferDescriptor const &dstDesc,
+                 BufferDescriptor const &otherDesc) {
+    if (dst) return dstDesc;
+    return otherDesc;
+}
+
+void CpuSetStencilStats(Far::internal::StatsScope & stats,
+                        int const * sizes, int const * offsets,
+                        int start, int end,
+                        BufferDescriptor const &srcDesc,
+                        BufferDescriptor const &dstDesc,
+                        int numOutputs, int realSize);
+
+// Variant for several primvar buffers evaluated in one pass : the stencils
+// are read once, and the buffers counted as a single wide primvar
+void CpuSetStencilStats(Far::internal::StatsScope & stats,
+                        int const * sizes, int const * offsets,
+                        int start, int end,
+                        int numBuffers,
+                        BufferDescriptor const *srcDescs,
+                        BufferDescriptor const *dstDescs,
+                        int realSize);
+
+// Variant for the deltas scattered through the source-major arrays of a
+// Far::TransposedStencilTable (see CpuEvaluator::EvalStencilDeltas()) : each
+// weight reads and writes an element of the destination
+void CpuSetStencilStats(Far::internal::StatsScope & stats,
+                        int const * offsets,
+                        int const * deltaVertices, int numDeltas,
+                        BufferDescriptor const &deltaDesc,
+                        BufferDescriptor const &dstDesc,
+                        int realSize);
+
+// Variant for a list of stencils (see CpuEvaluator::EvalStencilList())
+void CpuSetStencilListStats(Far::internal::StatsScope & stats,
+                            int const * sizes,
+                            int const * stencils, int numStencils,
+                            BufferDescriptor const &srcDesc,
+                            BufferDescriptor const &dstDesc,
+                            int numOutputs, int realSize);
+
+// Variant for a range of compressed stencils (see Far::CompressedStencilTable)
+void CpuSetCompressedStencilStats(Far::internal::StatsScope & stats,
+                                  unsigned char const * sizes,
+                                  int start, int end,
+                                  BufferDescriptor const &srcDesc,
+                                  BufferDescriptor const &dstDesc);
+
+void CpuSetPatchStats(Far::internal::StatsScope & stats,
+                      int numPatchCoords,
+                      PatchCoord const *patchCoords,
+                      PatchArray const *patchArrays,
+                      BufferDescriptor const &srcDesc,
+                      BufferDescriptor const &dstDesc,
+                      int numOutputs, int realSize);
+
+void CpuSetPatchStats(Far::internal::StatsScope & stats,
+                      int numPatchCoords,
+                      PatchCoordReal<double> const *patchCoords,
+                      PatchArray const *patchArrays,
+                      BufferDescriptor const &srcDesc,
+                      BufferDescriptor const &dstDesc,
+                      int numOutputs, int realSize);
 
 void
 CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
@@ -57,6 +189,216 @@ CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
                 float const * dvWeights,
                 int start, int end);
 
+// Evaluates the limit values and the first and second derivatives of limit
+// stencils : any of the outputs can be NULL
+void
+CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
+                float * dst,       BufferDescriptor const &dstDesc,
+                float * dstDu,     BufferDescriptor const &dstDuDesc,
+                float * dstDv,     BufferDescriptor const &dstDvDesc,
+                float * dstDuu,    BufferDescriptor const &dstDuuDesc,
+                float * dstDuv,    BufferDescriptor const &dstDuvDesc,
+                float * dstDvv,    BufferDescriptor const &dstDvvDesc,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                float const * duWeights,
+                float const * dvWeights,
+                float const * duuWeights,
+                float const * duvWeights,
+                float const * dvvWeights,
+                int start, int end);
+
+// Evaluates several source / destination buffer pairs with a single pass
+// over the stencil table
+void
+CpuEvalStencils(int numBuffers,
+                float const * const * srcs, BufferDescriptor const * srcDescs,
+                float * const * dsts,       BufferDescriptor const * dstDescs,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                int start, int end);
+
+// Evaluates stencils on primvars stored as structure of arrays : stencil i
+// is written to value i of each destination plane
+void
+CpuEvalStencils(float const * src, SoABufferDescriptor const &srcDesc,
+                float * dst,       SoABufferDescriptor const &dstDesc,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                int start, int end);
+
+// Evaluates the stencils of a Far::CompressedStencilTable, decoding the
+// indices and weights on the fly
+void
+CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
+                float * dst,       BufferDescriptor const &dstDesc,
+                unsigned char const * sizes,
+                float const * scales,
+                int const * blockIndexOffsets,
+                int const * blockWeightOffsets,
+                unsigned char const * indices,
+                short const * weights,
+                int start, int end);
+
+// Accumulates the stencils applied to a sparse set of control values into
+// the destination, with the source-major arrays of a
+// Far::TransposedStencilTable
+void
+CpuEvalStencilDeltas(float const * deltas, BufferDescriptor const &deltaDesc,
+                     int const * deltaVertices, int numDeltas,
+                     float * dst, BufferDescriptor const &dstDesc,
+                     int const * offsets,
+                     int const * stencils,
+                     float const * weights);
+
+//
+// Batched limit evaluation
+//
+// Coordinates are binned by patch so that the control vertices of a patch
+// are gathered once and the basis weights of all the coordinates on it are
+// evaluated together in SoA form.  Results are written in the order of
+// patchCoords. Any of dst, dstDu and dstDv can be NULL.
+//
+bool
+CpuEvalPatches(float const * src, BufferDescriptor const &srcDesc,
+               float * dst,       BufferDescriptor const &dstDesc,
+               float * dstDu,     BufferDescriptor const &dstDuDesc,
+               float * dstDv,     BufferDescriptor const &dstDvDesc,
+               int numPatchCoords,
+               PatchCoord const * patchCoords,
+               PatchArray const * patchArrays,
+               int const * patchIndexBuffer,
+               PatchParam const * patchParamBuffer);
+
+// Same as above, with the second derivatives (any output can be NULL)
+bool
+CpuEvalPatches(float const * src, BufferDescriptor const &srcDesc,
+               float * dst,       BufferDescriptor const &dstDesc,
+               float * dstDu,     BufferDescriptor const &dstDuDesc,
+               float * dstDv,     BufferDescriptor const &dstDvDesc,
+               float * dstDuu,    BufferDescriptor const &dstDuuDesc,
+               float * dstDuv,    BufferDescriptor const &dstDuvDesc,
+               float * dstDvv,    BufferDescriptor const &dstDvvDesc,
+               int numPatchCoords,
+               PatchCoord const * patchCoords,
+               PatchArray const * patchArrays,
+               int const * patchIndexBuffer,
+               PatchParam const * patchParamBuffer);
+
+// Orders the coordinates so that those sharing a patch are contiguous : order
+// receives numPatchCoords indices. The client order is kept when it is already
+// grouped or when there are too few coordinates per patch.
+void
+CpuBinPatchCoords(int numPatchCoords, PatchCoord const * patchCoords,
+                  int * order);
+
+// Evaluates the coordinates of patchCoords listed by coordIndices (e.g. a
+// range of the order returned by CpuBinPatchCoords()) : the results of
+// coordinate i are written to element i of the outputs, which can be NULL.
+// Unit normals are written in place of the derivatives if dstNormal is not
+// NULL (see CpuEvalPatchNormals()).
+bool
+CpuEvalPatches(float const * src, BufferDescriptor const &srcDesc,
+               float * dst,       BufferDescriptor const &dstDesc,
+               float * dstDu,     BufferDescriptor const &dstDuDesc,
+               float * dstDv,     BufferDescriptor const &dstDvDesc,
+               float * dstNormal, BufferDescriptor const &dstNormalDesc,
+               int numCoords,
+               int const * coordIndices,
+               PatchCoord const * patchCoords,
+               PatchArray const * patchArrays,
+               int const * patchIndexBuffer,
+               PatchParam const * patchParamBuffer);
+
+// Evaluates the limit values (dst can be NULL) and the unit normals, i.e. the
+// normalized cross products of the first three elements of the U and V
+// derivatives, without writing the derivatives
+bool
+CpuEvalPatchNormals(float const * src, BufferDescriptor const &srcDesc,
+                    float * dst,       BufferDescriptor const &dstDesc,
+                    float * dstNormal, BufferDescriptor const &dstNormalDesc,
+                    int numPatchCoords,
+                    PatchCoord const * patchCoords,
+                    PatchArray const * patchArrays,
+                    int const * patchIndexBuffer,
+                    PatchParam const * patchParamBuffer);
+
+//
+// Double precision variants of the kernels above, for primvar buffers and
+// stencil tables (Far::StencilTableReal<double>) holding doubles.
+//
+void
+CpuEvalStencils(double const * src, BufferDescriptor const &srcDesc,
+                double * dst,       BufferDescriptor const &dstDesc,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                double const * weights,
+                int start, int end);
+
+void
+CpuEvalStencils(double const * src, BufferDescriptor const &srcDesc,
+                double * dst,       BufferDescriptor const &dstDesc,
+                double * dstDu,     BufferDescriptor const &dstDuDesc,
+                double * dstDv,     BufferDescriptor const &dstDvDesc,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                double const * weights,
+                double const * duWeights,
+                double const * dvWeights,
+                int start, int end);
+
+void
+CpuEvalStencils(double const * src, BufferDescriptor const &srcDesc,
+                double * dst,       BufferDescriptor const &dstDesc,
+                double * dstDu,     BufferDescriptor const &dstDuDesc,
+                double * dstDv,     BufferDescriptor const &dstDvDesc,
+                double * dstDuu,    BufferDescriptor const &dstDuuDesc,
+                double * dstDuv,    BufferDescriptor const &dstDuvDesc,
+                double * dstDvv,    BufferDescriptor const &dstDvvDesc,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                double const * weights,
+                double const * duWeights,
+                double const * dvWeights,
+                double const * duuWeights,
+                double const * duvWeights,
+                double const * dvvWeights,
+                int start, int end);
+
+bool
+CpuEvalPatches(double const * src, BufferDescriptor const &srcDesc,
+               double * dst,       BufferDescriptor const &dstDesc,
+               double * dstDu,     BufferDescriptor const &dstDuDesc,
+               double * dstDv,     BufferDescriptor const &dstDvDesc,
+               int numPatchCoords,
+               PatchCoordReal<double> const * patchCoords,
+               PatchArray const * patchArrays,
+               int const * patchIndexBuffer,
+               PatchParam const * patchParamBuffer);
+
+bool
+CpuEvalPatches(double const * src, BufferDescriptor const &srcDesc,
+               double * dst,       BufferDescriptor const &dstDesc,
+               double * dstDu,     BufferDescriptor const &dstDuDesc,
+               double * dstDv,     BufferDescriptor const &dstDvDesc,
+               double * dstDuu,    BufferDescriptor const &dstDuuDesc,
+               double * dstDuv,    BufferDescriptor const &dstDuvDesc,
+               double * dstDvv,    BufferDescriptor const &dstDvvDesc,
+               int numPatchCoords,
+               PatchCoordReal<double> const * patchCoords,
+               PatchArray const * patchArrays,
+               int const * patchIndexBuffer,
+               PatchParam const * patchParamBuffer);
+
 //
 // SIMD ICC optimization of the stencil kernel
 //
@@ -67,7 +409,8 @@ CpuEvalStencils(float const * src, BufferDescriptor const &srcDesc,
     #define __ALIGN_DATA
 #endif
 
-// Note : this function is re-used in the TBB Compute kernel
+// Note : this function is the portable fallback used by CpuEvalStencils()
+//        when no runtime-dispatched SIMD kernel is available
 template <int numElems> void
 ComputeStencilKernel(float const * vertexSrc,
                      float * vertexDst,
@@ -0,0 +1,356 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OPENSUBDIV3_OSD_CPU_SIMD_KERNEL_H
+#define OPENSUBDIV3_OSD_CPU_SIMD_KERNEL_H
+
+#include "../version.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+//
+// Instruction set specific stencil kernels
+//
+// Each of these functions lives in its own translation unit which is compiled
+// with the matching instruction set flags (see osd/CMakeLists.txt), so they
+// must only be called after CpuGetSimdLevel() has confirmed that the host
+// supports the instruction set.
+//
+// Unlike CpuEvalStencils(), the buffer offsets and the 'start' stencil have
+// already been applied to all the pointers : the kernels evaluate stencils
+// [0, numStencils) and write stencil i to dst + i * dstStride.
+//
+
+void
+CpuEvalStencilsSSE(float const * src, int srcStride,
+                   float * dst, int dstStride, int length,
+                   int const * sizes,
+                   int const * indices,
+                   float const * weights,
+                   int numStencils);
+
+void
+CpuEvalStencilsAVX2(float const * src, int srcStride,
+                    float * dst, int dstStride, int length,
+                    int const * sizes,
+                    int const * indices,
+                    float const * weights,
+                    int numStencils);
+
+void
+CpuEvalStencilsAVX512(float const * src, int srcStride,
+                      float * dst, int dstStride, int length,
+                      int const * sizes,
+                      int const * indices,
+                      float const * weights,
+                      int numStencils);
+
+// Fused evaluation of stencils with derivatives : each source element is
+// loaded once and accumulated into the point, u and v derivative results.
+void
+CpuEvalStencilsSSE(float const * src, int srcStride,
+                   float * dst, int dstStride,
+                   float * dstDu, int dstDuStride,
+                   float * dstDv, int dstDvStride,
+                   int length,
+                   int const * sizes,
+                   int const * indices,
+                   float const * weights,
+                   float const * duWeights,
+                   float const * dvWeights,
+                   int numStencils);
+
+void
+CpuEvalStencilsAVX2(float const * src, int srcStride,
+                    float * dst, int dstStride,
+                    float * dstDu, int dstDuStride,
+                    float * dstDv, int dstDvStride,
+                    int length,
+                    int const * sizes,
+                    int const * indices,
+                    float const * weights,
+                    float const * duWeights,
+                    float const * dvWeights,
+                    int numStencils);
+
+void
+CpuEvalStencilsAVX512(float const * src, int srcStride,
+                      float * dst, int dstStride,
+                      float * dstDu, int dstDuStride,
+                      float * dstDv, int dstDvStride,
+                      int length,
+                      int const * sizes,
+                      int const * indices,
+                      float const * weights,
+                      float const * duWeights,
+                      float const * dvWeights,
+                      int numStencils);
+
+// Stencils on primvars stored as half precision floats : the elements of
+// either buffer are converted with F16C on load and store and accumulated in
+// single precision. Requires AVX2 and F16C support.
+void
+CpuEvalStencilsF16C(void const * src, bool srcHalf, int srcStride,
+                    void * dst, bool dstHalf, int dstStride, int length,
+                    int const * sizes,
+                    int const * indices,
+                    float const * weights,
+                    int numStencils);
+
+//
+// Generic SIMD stencil kernel
+//
+// The OPS template parameter wraps the intrinsics of a given instruction set :
+//
+//   Vec                     register type holding OPS::Width floats
+//   Mask                    selects the first 'count' lanes of a register
+//   Zero(), Broadcast(w)
+//   Load(p), Store(p, v)    full width unaligned memory access
+//   MakeMask(count)         'count' is clamped to [0, Width]
+//   MaskLoad(p, m)          masked-off lanes are zero and are never read
+//   MaskStore(p, m, v)      masked-off lanes are never written
+//   MulAdd(a, b, c)         a * b + c
+//
+// Primvars are processed in blocks of NV registers : the accumulators for a
+// block stay in registers while the weights of the stencil are applied, so
+// each source element is read only once for primvars up to NV*Width floats
+// wide. Wider primvars are processed in several blocks. The tail of the
+// primvar uses masked loads and stores, which allows arbitrary lengths and
+// strides without reading or writing past the end of an element.
+//
+// Note : OPS must have internal linkage in the translation unit that
+// instantiates these templates, so that instantiations compiled with
+// different instruction set flags can never be merged by the linker.
+//
+
+template <class OPS, int NV> void
+SimdComputeStencils(float const * src, int srcStride,
+                    float * dst, int dstStride, int length,
+                    int const * sizes,
+                    int const * indices,
+                    float const * weights,
+                    int numStencils) {
+
+    typedef typename OPS::Vec  Vec;
+    typedef typename OPS::Mask Mask;
+
+    int const blockSize = NV * OPS::Width,
+              numFullBlocks = length / blockSize,
+              tailStart = numFullBlocks * blockSize;
+
+    // masks for the last (partial) block are the same for all the stencils
+    Mask tailMask[NV];
+    for (int v = 0; v < NV; ++v) {
+        tailMask[v] = OPS::MakeMask(length - tailStart - v * OPS::Width);
+    }
+
+    Vec acc[NV];
+
+    for (int i = 0; i < numStencils; ++i, dst += dstStride) {
+
+        int size = sizes[i];
+
+        for (int k = 0; k < tailStart; k += blockSize) {
+
+            for (int v = 0; v < NV; ++v) {
+                acc[v] = OPS::Zero();
+            }
+
+            for (int j = 0; j < size; ++j) {
+                float const * s = src + indices[j] * srcStride + k;
+                Vec w = OPS::Broadcast(weights[j]);
+                for (int v = 0; v < NV; ++v) {
+                    acc[v] = OPS::MulAdd(
+                        OPS::Load(s + v * OPS::Width), w, acc[v]);
+                }
+            }
+
+            for (int v = 0; v < NV; ++v) {
+                OPS::Store(dst + k + v * OPS::Width, acc[v]);
+            }
+        }
+
+        if (tailStart < length) {
+
+            for (int v = 0; v < NV; ++v) {
+                acc[v] = OPS::Zero();
+            }
+
+            for (int j = 0; j < size; ++j) {
+                float const * s = src + indices[j] * srcStride + tailStart;
+                Vec w = OPS::Broadcast(weights[j]);
+                for (int v = 0; v < NV; ++v) {
+                    acc[v] = OPS::MulAdd(
+                        OPS::MaskLoad(s + v * OPS::Width, tailMask[v]),
+                        w, acc[v]);
+                }
+            }
+
+            for (int v = 0; v < NV; ++v) {
+                OPS::MaskStore(dst + tailStart + v * OPS::Width,
+                               tailMask[v], acc[v]);
+            }
+        }
+
+        indices += size;
+        weights += size;
+    }
+}
+
+// Selects the number of accumulator registers from the primvar length
+template <class OPS> void
+SimdEvalStencils(float const * src, int srcStride,
+                 float * dst, int dstStride, int length,
+                 int const * sizes,
+                 int const * indices,
+                 float const * weights,
+                 int numStencils) {
+
+    switch ((length + OPS::Width - 1) / OPS::Width) {
+        case 1 : SimdComputeStencils<OPS, 1>(src, srcStride, dst, dstStride,
+                     length, sizes, indices, weights, numStencils); break;
+        case 2 : SimdComputeStencils<OPS, 2>(src, srcStride, dst, dstStride,
+                     length, sizes, indices, weights, numStencils); break;
+        case 3 : SimdComputeStencils<OPS, 3>(src, srcStride, dst, dstStride,
+                     length, sizes, indices, weights, numStencils); break;
+        default: SimdComputeStencils<OPS, 4>(src, srcStride, dst, dstStride,
+                     length, sizes, indices, weights, numStencils); break;
+    }
+}
+
+// Same as SimdComputeStencils(), with 3 sets of accumulators for the point
+// and the u and v derivatives.
+template <class OPS, int NV> void
+SimdComputeStencilsWithDerivatives(float const * src, int srcStride,
+                                   float * dst, int dstStride,
+                                   float * dstDu, int dstDuStride,
+                                   float * dstDv, int dstDvStride,
+                                   int length,
+                                   int const * sizes,
+                                   int const * indices,
+                                   float const * weights,
+                                   float const * duWeights,
+                                   float const * dvWeights,
+                                   int numStencils) {
+
+    typedef typename OPS::Vec  Vec;
+    typedef typename OPS::Mask Mask;
+
+    int const blockSize = NV * OPS::Width,
+              numFullBlocks = length / blockSize,
+              tailStart = numFullBlocks * blockSize;
+
+    Mask tailMask[NV];
+    for (int v = 0; v < NV; ++v) {
+        tailMask[v] = OPS::MakeMask(length - tailStart - v * OPS::Width);
+    }
+
+    Vec acc[NV], accDu[NV], accDv[NV];
+
+    for (int i = 0; i < numStencils; ++i,
+             dst += dstStride, dstDu += dstDuStride, dstDv += dstDvStride) {
+
+        int size = sizes[i];
+
+        for (int k = 0; k < length; k += blockSize) {
+
+            bool tail = (k == tailStart);
+
+            for (int v = 0; v < NV; ++v) {
+                acc[v] = accDu[v] = accDv[v] = OPS::Zero();
+            }
+
+            for (int j = 0; j < size; ++j) {
+                float const * s = src + indices[j] * srcStride + k;
+                Vec w   = OPS::Broadcast(weights[j]),
+                    wDu = OPS::Broadcast(duWeights[j]),
+                    wDv = OPS::Broadcast(dvWeights[j]);
+                for (int v = 0; v < NV; ++v) {
+                    Vec x = tail ?
+                        OPS::MaskLoad(s + v * OPS::Width, tailMask[v]) :
+                        OPS::Load(s + v * OPS::Width);
+                    acc[v]   = OPS::MulAdd(x, w,   acc[v]);
+                    accDu[v] = OPS::MulAdd(x, wDu, accDu[v]);
+                    accDv[v] = OPS::MulAdd(x, wDv, accDv[v]);
+                }
+            }
+
+            for (int v = 0; v < NV; ++v) {
+                int ofs = k + v * OPS::Width;
+                if (tail) {
+                    OPS::MaskStore(dst + ofs, tailMask[v], acc[v]);
+                    OPS::MaskStore(dstDu + ofs, tailMask[v], accDu[v]);
+                    OPS::MaskStore(dstDv + ofs, tailMask[v], accDv[v]);
+                } else {
+                    OPS::Store(dst + ofs, acc[v]);
+                    OPS::Store(dstDu + ofs, accDu[v]);
+                    OPS::Store(dstDv + ofs, accDv[v]);
+                }
+            }
+        }
+
+        indices += size;
+        weights += size;
+        duWeights += size;
+        dvWeights += size;
+    }
+}
+
+// The derivative kernel needs 3 times as many accumulators : the blocks are
+// kept to at most 2 registers to avoid spilling.
+template <class OPS> void
+SimdEvalStencils(float const * src, int srcStride,
+                 float * dst, int dstStride,
+                 float * dstDu, int dstDuStride,
+                 float * dstDv, int dstDvStride,
+                 int length,
+                 int const * sizes,
+                 int const * indices,
+                 float const * weights,
+                 float const * duWeights,
+                 float const * dvWeights,
+                 int numStencils) {
+
+    if (length <= OPS::Width) {
+        SimdComputeStencilsWithDerivatives<OPS, 1>(src, srcStride,
+            dst, dstStride, dstDu, dstDuStride, dstDv, dstDvStride, length,
+            sizes, indices, weights, duWeights, dvWeights, numStencils);
+    } else {
+        SimdComputeStencilsWithDerivatives<OPS, 2>(src, srcStride,
+            dst, dstStride, dstDu, dstDuStride, dstDv, dstDvStride, length,
+            sizes, indices, weights, duWeights, dvWeights, numStencils);
+    }
+}
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OPENSUBDIV3_OSD_CPU_SIMD_KERNEL_H
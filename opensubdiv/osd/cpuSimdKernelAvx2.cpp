@@ -0,0 +1,245 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../osd/cpuSimdKernel.h"
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+namespace {
+
+// Sliding window of lane masks : loading 8 ints at (8 - count) selects the
+// first 'count' lanes.
+const int maskTable[16] = { -1, -1, -1, -1, -1, -1, -1, -1,
+                                    0,  0,  0,  0,  0,  0,  0,  0 };
+
+struct Avx2Ops {
+
+    typedef __m256  Vec;
+    typedef __m256i Mask;
+
+    enum { Width = 8 };
+
+    static inline Vec Zero() { return _mm256_setzero_ps(); }
+
+    static inline Vec Broadcast(float w) { return _mm256_set1_ps(w); }
+
+    static inline Vec Load(float const * p) { return _mm256_loadu_ps(p); }
+
+    static inline void Store(float * p, Vec v) { _mm256_storeu_ps(p, v); }
+
+    static inline Mask MakeMask(int count) {
+        count = count < 0 ? 0 : (count > Width ? Width : count);
+        return _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(maskTable + Width - count));
+    }
+
+    static inline Vec MaskLoad(float const * p, Mask m) {
+        return _mm256_maskload_ps(p, m);
+    }
+
+    static inline void MaskStore(float * p, Mask m, Vec v) {
+        _mm256_maskstore_ps(p, m, v);
+    }
+
+    static inline Vec MulAdd(Vec a, Vec b, Vec c) {
+        return _mm256_fmadd_ps(a, b, c);
+    }
+};
+
+//
+// Loads and stores of up to 8 primvar elements held as floats or as half
+// precision floats (converted with F16C)
+//
+template <bool HALF> struct Avx2Elements;
+
+template <> struct Avx2Elements<false> {
+
+    typedef float Type;
+
+    static inline __m256 Load(float const * p, int count) {
+        return count == 8 ? _mm256_loadu_ps(p) :
+            _mm256_maskload_ps(p, Avx2Ops::MakeMask(count));
+    }
+
+    static inline void Store(float * p, int count, __m256 v) {
+        if (count == 8) {
+            _mm256_storeu_ps(p, v);
+        } else {
+            _mm256_maskstore_ps(p, Avx2Ops::MakeMask(count), v);
+        }
+    }
+};
+
+template <> struct Avx2Elements<true> {
+
+    typedef unsigned short Type;
+
+    static inline __m256 Load(unsigned short const * p, int count) {
+        if (count == 8) {
+            return _mm256_cvtph_ps(
+                _mm_loadu_si128(reinterpret_cast<__m128i const *>(p)));
+        }
+        // there are no masked 16-bit loads in AVX2
+        unsigned short h[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        memcpy(h, p, count * sizeof(unsigned short));
+        return _mm256_cvtph_ps(
+            _mm_loadu_si128(reinterpret_cast<__m128i const *>(h)));
+    }
+
+    static inline void Store(unsigned short * p, int count, __m256 v) {
+        __m128i h = _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+        if (count == 8) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(p), h);
+        } else {
+            unsigned short tmp[8];
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(tmp), h);
+            memcpy(p, tmp, count * sizeof(unsigned short));
+        }
+    }
+};
+
+// Primvars are processed in blocks of up to 4 registers, as in
+// SimdComputeStencils()
+template <class SRC, class DST> void
+evalStencilsF16C(typename SRC::Type const * src, int srcStride,
+                 typename DST::Type * dst, int dstStride, int length,
+                 int const * sizes,
+                 int const * indices,
+                 float const * weights,
+                 int numStencils) {
+
+    int const blockSize = 4 * Avx2Ops::Width;
+
+    __m256 acc[4];
+
+    for (int i = 0; i < numStencils; ++i, dst += dstStride) {
+
+        int size = sizes[i];
+
+        for (int k = 0; k < length; k += blockSize) {
+
+            int n = length - k < blockSize ? length - k : blockSize,
+                nv = (n + Avx2Ops::Width - 1) / Avx2Ops::Width;
+
+            for (int v = 0; v < nv; ++v) {
+                acc[v] = _mm256_setzero_ps();
+            }
+
+            for (int j = 0; j < size; ++j) {
+                typename SRC::Type const * s =
+                    src + indices[j] * srcStride + k;
+                __m256 w = _mm256_set1_ps(weights[j]);
+                for (int v = 0, count = n; v < nv; ++v, count -= 8) {
+                    acc[v] = _mm256_fmadd_ps(
+                        SRC::Load(s + v * 8, count < 8 ? count : 8),
+                        w, acc[v]);
+                }
+            }
+
+            for (int v = 0, count = n; v < nv; ++v, count -= 8) {
+                DST::Store(dst + k + v * 8, count < 8 ? count : 8, acc[v]);
+            }
+        }
+
+        indices += size;
+        weights += size;
+    }
+}
+
+}  // end anonymous namespace
+
+void
+CpuEvalStencilsAVX2(float const * src, int srcStride,
+                    float * dst, int dstStride, int length,
+                    int const * sizes,
+                    int const * indices,
+                    float const * weights,
+                    int numStencils) {
+
+    SimdEvalStencils<Avx2Ops>(src, srcStride, dst, dstStride, length,
+                              sizes, indices, weights, numStencils);
+}
+
+void
+CpuEvalStencilsAVX2(float const * src, int srcStride,
+                    float * dst, int dstStride,
+                    float * dstDu, int dstDuStride,
+                    float * dstDv, int dstDvStride,
+                    int length,
+                    int const * sizes,
+                    int const * indices,
+                    float const * weights,
+                    float const * duWeights,
+                    float const * dvWeights,
+                    int numStencils) {
+
+    SimdEvalStencils<Avx2Ops>(src, srcStride, dst, dstStride,
+                              dstDu, dstDuStride, dstDv, dstDvStride, length,
+                              sizes, indices, weights, duWeights, dvWeights,
+                              numStencils);
+}
+
+void
+CpuEvalStencilsF16C(void const * src, bool srcHalf, int srcStride,
+                    void * dst, bool dstHalf, int dstStride, int length,
+                    int const * sizes,
+                    int const * indices,
+                    float const * weights,
+                    int numStencils) {
+
+    typedef unsigned short half;
+
+    if (srcHalf and dstHalf) {
+        evalStencilsF16C<Avx2Elements<true>, Avx2Elements<true> >(
+            static_cast<half const *>(src), srcStride,
+            static_cast<half *>(dst), dstStride, length,
+            sizes, indices, weights, numStencils);
+    } else if (srcHalf) {
+        evalStencilsF16C<Avx2Elements<true>, Avx2Elements<false> >(
+            static_cast<half const *>(src), srcStride,
+            static_cast<float *>(dst), dstStride, length,
+            sizes, indices, weights, numStencils);
+    } else if (dstHalf) {
+        evalStencilsF16C<Avx2Elements<false>, Avx2Elements<true> >(
+            static_cast<float const *>(src), srcStride,
+            static_cast<half *>(dst), dstStride, length,
+            sizes, indices, weights, numStencils);
+    } else {
+        CpuEvalStencilsAVX2(static_cast<float const *>(src), srcStride,
+                            static_cast<float *>(dst), dstStride, length,
+                            sizes, indices, weights, numStencils);
+    }
+}
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
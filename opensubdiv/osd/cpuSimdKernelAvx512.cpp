@@ -0,0 +1,105 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../osd/cpuSimdKernel.h"
+
+#include <immintrin.h>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+namespace {
+
+struct Avx512Ops {
+
+    typedef __m512    Vec;
+    typedef __mmask16 Mask;
+
+    enum { Width = 16 };
+
+    static inline Vec Zero() { return _mm512_setzero_ps(); }
+
+    static inline Vec Broadcast(float w) { return _mm512_set1_ps(w); }
+
+    static inline Vec Load(float const * p) { return _mm512_loadu_ps(p); }
+
+    static inline void Store(float * p, Vec v) { _mm512_storeu_ps(p, v); }
+
+    static inline Mask MakeMask(int count) {
+        count = count < 0 ? 0 : (count > Width ? Width : count);
+        return (Mask)((1u << count) - 1u);
+    }
+
+    static inline Vec MaskLoad(float const * p, Mask m) {
+        return _mm512_maskz_loadu_ps(m, p);
+    }
+
+    static inline void MaskStore(float * p, Mask m, Vec v) {
+        _mm512_mask_storeu_ps(p, m, v);
+    }
+
+    static inline Vec MulAdd(Vec a, Vec b, Vec c) {
+        return _mm512_fmadd_ps(a, b, c);
+    }
+};
+
+}  // end anonymous namespace
+
+void
+CpuEvalStencilsAVX512(float const * src, int srcStride,
+                      float * dst, int dstStride, int length,
+                      int const * sizes,
+                      int const * indices,
+                      float const * weights,
+                      int numStencils) {
+
+    SimdEvalStencils<Avx512Ops>(src, srcStride, dst, dstStride, length,
+                                sizes, indices, weights, numStencils);
+}
+
+void
+CpuEvalStencilsAVX512(float const * src, int srcStride,
+                      float * dst, int dstStride,
+                      float * dstDu, int dstDuStride,
+                      float * dstDv, int dstDvStride,
+                      int length,
+                      int const * sizes,
+                      int const * indices,
+                      float const * weights,
+                      float const * duWeights,
+                      float const * dvWeights,
+                      int numStencils) {
+
+    SimdEvalStencils<Avx512Ops>(src, srcStride, dst, dstStride,
+                                dstDu, dstDuStride, dstDv, dstDvStride, length,
+                                sizes, indices, weights, duWeights, dvWeights,
+                                numStencils);
+}
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
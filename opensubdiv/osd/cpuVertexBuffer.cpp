@@ -23,6 +23,7 @@
 //
 
 #include "../osd/cpuVertexBuffer.h"
+#include "../far/allocator.h"
 
 #include <string.h>
 
@@ -36,19 +37,27 @@ CpuVertexBuffer::CpuVertexBuffer(int numElements, int numVertices)
       _numVertices(numVertices),
       _cpuBuffer(NULL) {
 
-    _cpuBuffer = new float[numElements * numVertices];
+    // aligned for the SIMD kernels, and possibly backed by huge pages
+    _cpuBuffer = static_cast<float *>(
+        Far::Allocate((size_t)numElements * numVertices * sizeof(float)));
 }
 
 CpuVertexBuffer::~CpuVertexBuffer() {
 
-    delete[] _cpuBuffer;
+    Far::Free(_cpuBuffer);
 }
 
 CpuVertexBuffer *
 CpuVertexBuffer::Create(int numElements, int numVertices,
                         void * /*deviceContext*/) {
 
-    return new CpuVertexBuffer(numElements, numVertices);
+    CpuVertexBuffer * instance =
+        new CpuVertexBuffer(numElements, numVertices);
+    if (instance->_cpuBuffer or numElements * numVertices == 0) {
+        return instance;
+    }
+    delete instance;
+    return NULL;
 }
 
 void
@@ -139,6 +139,12 @@ CudaEvaluator::EvalStencils(const float *src, BufferDescriptor const &srcDesc,
                             const float * weights,
                             int start,
                             int end) {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
+
     if (dst == NULL) return false;
 
     CudaEvalStencils(src + srcDesc.offset,
@@ -165,6 +171,14 @@ CudaEvaluator::EvalStencils(const float *src, BufferDescriptor const &srcDesc,
                             const float * dvWeights,
                             int start,
                             int end) {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32 ||
+        duDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dvDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
+
     // PERFORMANCE: need to combine 3 launches together
     if (dst) {
         CudaEvalStencils(src + srcDesc.offset,
@@ -207,6 +221,12 @@ CudaEvaluator::EvalPatches(const float *src,
                            const PatchArray *patchArrays,
                            const int *patchIndices,
                            const PatchParam *patchParams) {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
+
     if (src) src += srcDesc.offset;
     if (dst) dst += dstDesc.offset;
 
@@ -229,6 +249,13 @@ CudaEvaluator::EvalPatches(
     const PatchArray *patchArrays,
     const int *patchIndices,
     const PatchParam *patchParams) {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32 ||
+        duDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dvDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
 
     if (src) src += srcDesc.offset;
     if (dst) dst += dstDesc.offset;
@@ -204,6 +204,14 @@ D3D11ComputeEvaluator::Compile(BufferDescriptor const &srcDesc,
         return false;
     }
 
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32) {
+        Far::Error(Far::FAR_RUNTIME_ERROR,
+                   "half precision primvars are only supported by the "
+                   "CPU evaluators.\n");
+        return false;
+    }
+
     DWORD dwShaderFlags = D3DCOMPILE_ENABLE_STRICTNESS;
 #if defined(D3D10_SHADER_RESOURCES_MAY_ALIAS)
      dwShaderFlags |= D3D10_SHADER_RESOURCES_MAY_ALIAS;
@@ -321,6 +329,12 @@ D3D11ComputeEvaluator::EvalStencils(ID3D11UnorderedAccessView *srcUAV,
                                     int start,
                                     int end,
                                     ID3D11DeviceContext *deviceContext) const {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
+
     assert(deviceContext);
 
     int count = end - start;
@@ -169,6 +169,16 @@ GLComputeEvaluator::Compile(BufferDescriptor const &srcDesc,
                             BufferDescriptor const &duDesc,
                             BufferDescriptor const &dvDesc) {
 
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32 ||
+        duDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dvDesc.elementType != BufferDescriptor::FLOAT32) {
+        Far::Error(Far::FAR_RUNTIME_ERROR,
+                   "half precision primvars are only supported by the "
+                   "CPU evaluators.\n");
+        return false;
+    }
+
     // create a stencil kernel
     if (!_stencilKernel.Compile(srcDesc, dstDesc, duDesc, dvDesc,
                                 _workGroupSize)) {
@@ -205,6 +215,13 @@ GLComputeEvaluator::EvalStencils(
     GLuint duWeightsBuffer,
     GLuint dvWeightsBuffer,
     int start, int end) const {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32 ||
+        duDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dvDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
 
     if (!_stencilKernel.program) return false;
     int count = end - start;
@@ -263,6 +280,13 @@ GLComputeEvaluator::EvalPatches(
     const PatchArrayVector &patchArrays,
     GLuint patchIndexBuffer,
     GLuint patchParamsBuffer) const {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32 ||
+        duDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dvDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
 
     if (!_patchKernel.program) return false;
 
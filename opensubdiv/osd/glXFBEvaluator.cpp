@@ -268,6 +268,16 @@ GLXFBEvaluator::Compile(BufferDescriptor const &srcDesc,
                         BufferDescriptor const &duDesc,
                         BufferDescriptor const &dvDesc) {
 
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32 ||
+        duDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dvDesc.elementType != BufferDescriptor::FLOAT32) {
+        Far::Error(Far::FAR_RUNTIME_ERROR,
+                   "half precision primvars are only supported by the "
+                   "CPU evaluators.\n");
+        return false;
+    }
+
     // create a stencil kernel
     _stencilKernel.Compile(srcDesc, dstDesc, duDesc, dvDesc);
 
@@ -313,6 +323,13 @@ GLXFBEvaluator::EvalStencils(
     GLuint duWeightsTexture,
     GLuint dvWeightsTexture,
     int start, int end) const {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32 ||
+        duDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dvDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
 
     if (!_stencilKernel.program) return false;
     int count = end - start;
@@ -439,6 +456,13 @@ GLXFBEvaluator::EvalPatches(
     const PatchArrayVector &patchArrays,
     GLuint patchIndexTexture,
     GLuint patchParamTexture) const {
+    // half precision primvars are only supported by the CPU evaluators
+    if (srcDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dstDesc.elementType != BufferDescriptor::FLOAT32 ||
+        duDesc.elementType != BufferDescriptor::FLOAT32 ||
+        dvDesc.elementType != BufferDescriptor::FLOAT32) {
+        return false;
+    }
 
     bool derivatives = (duDesc.length > 0 || dvDesc.length > 0);
 
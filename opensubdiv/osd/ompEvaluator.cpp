@@ -24,9 +24,22 @@
 
 #include "../osd/ompEvaluator.h"
 #include "../osd/ompKernel.h"
-#include "../far/patchBasis.h"
+#include "../osd/cpuKernel.h"
+#include "../far/allocator.h"
+#include "../far/stats.h"
+#include "../far/stencilTable.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
 #include <omp.h>
 
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -72,6 +85,7 @@ OmpEvaluator::EvalStencils(
     if (srcDesc.length != dstDesc.length) return false;
     if (srcDesc.length != duDesc.length) return false;
     if (srcDesc.length != dvDesc.length) return false;
+    if ((du and not duWeights) or (dv and not dvWeights)) return false;
 
     OmpEvalStencils(src, srcDesc,
                     dst, dstDesc,
@@ -84,36 +98,460 @@ OmpEvaluator::EvalStencils(
     return true;
 }
 
-template <typename T>
-struct BufferAdapter {
-    BufferAdapter(T *p, int length, int stride) :
-        _p(p), _length(length), _stride(stride) { }
-    void Clear() {
-        for (int i = 0; i < _length; ++i) _p[i] = 0;
+/* static */
+bool
+OmpEvaluator::EvalStencils(
+    int numBuffers,
+    const float * const *srcs, BufferDescriptor const *srcDescs,
+    float * const *dsts,       BufferDescriptor const *dstDescs,
+    const int * sizes,
+    const int * offsets,
+    const int * indices,
+    const float * weights,
+    int start, int end) {
+
+    if (end <= start) return true;
+    for (int i = 0; i < numBuffers; ++i) {
+        if (srcDescs[i].length != dstDescs[i].length) return false;
     }
-    void AddWithWeight(T const *src, float w) {
-        if (_p) {
-            // TODO: derivatives.
-            for (int i = 0; i < _length; ++i) {
-                _p[i] += src[i] * w;
+
+    OmpEvalStencils(numBuffers, srcs, srcDescs, dsts, dstDescs,
+                    sizes, offsets, indices, weights, start, end);
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+//
+//   NUMA partitioned stencil table
+//
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Parses a list of CPUs or nodes from sysfs (e.g. "0-3,8-11")
+bool
+readIdList(char const * path, std::vector<int> & ids) {
+
+    ids.clear();
+#if defined(__linux__)
+    FILE * file = fopen(path, "r");
+    if (not file) return false;
+
+    int first = 0, last = 0;
+    char separator = ',';
+    while (separator == ',' and fscanf(file, "%d", &first) == 1) {
+        last = first;
+        if (fscanf(file, "%c", &separator) == 1 and separator == '-') {
+            if (fscanf(file, "%d", &last) != 1 or
+                fscanf(file, "%c", &separator) != 1) {
+                separator = '\n';
             }
         }
+        for (int id = first; id <= last; ++id) {
+            ids.push_back(id);
+        }
     }
-    const T *operator[] (int index) const {
-        return _p + _stride * index;
+    fclose(file);
+#else
+    (void)path;
+#endif
+    return not ids.empty();
+}
+
+// Gathers the NUMA nodes holding CPUs that the process may run on, and the
+// CPUs of each node
+void
+getNumaNodes(std::vector<int> & nodes,
+             std::vector<int> & cpuOffsets, std::vector<int> & cpus) {
+
+    nodes.clear();
+    cpuOffsets.assign(1, 0);
+    cpus.clear();
+
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+
+    std::vector<int> onlineNodes, nodeCpus;
+    if (not readIdList("/sys/devices/system/node/online", onlineNodes)) {
+        return;
+    }
+    for (int i = 0; i < (int)onlineNodes.size(); ++i) {
+        char path[64];
+        snprintf(path, sizeof(path),
+            "/sys/devices/system/node/node%d/cpulist", onlineNodes[i]);
+        readIdList(path, nodeCpus);
+
+        int numCpus = (int)cpus.size();
+        for (int j = 0; j < (int)nodeCpus.size(); ++j) {
+            if (nodeCpus[j] < CPU_SETSIZE and CPU_ISSET(nodeCpus[j], &allowed)) {
+                cpus.push_back(nodeCpus[j]);
+            }
+        }
+        if ((int)cpus.size() > numCpus) {
+            nodes.push_back(onlineNodes[i]);
+            cpuOffsets.push_back((int)cpus.size());
+        }
     }
-    BufferAdapter<T> & operator ++() {
-        if (_p) {
-            _p += _stride;
+#endif
+}
+
+// Pins the calling thread to a set of CPUs (if any) for its lifetime, and
+// restores the affinity the thread had before (the master thread belongs to
+// the application, and the pool threads may be shared by other regions)
+class ThreadBinding {
+public:
+    ThreadBinding(int const * cpus, int numCpus) : _bound(false) {
+#if defined(__linux__)
+        if (numCpus <= 0 or
+            sched_getaffinity(0, sizeof(_saved), &_saved) != 0) return;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int i = 0; i < numCpus; ++i) {
+            CPU_SET(cpus[i], &set);
         }
-        return *this;
+        _bound = (sched_setaffinity(0, sizeof(set), &set) == 0);
+#else
+        (void)cpus;
+        (void)numCpus;
+#endif
     }
 
-    T *_p;
-    int _length;
-    int _stride;
+    ~ThreadBinding() {
+#if defined(__linux__)
+        if (_bound) {
+            sched_setaffinity(0, sizeof(_saved), &_saved);
+        }
+#endif
+    }
+
+private:
+    ThreadBinding(ThreadBinding const &);
+    ThreadBinding & operator=(ThreadBinding const &);
+
+#if defined(__linux__)
+    cpu_set_t _saved;
+#endif
+    bool _bound;
+};
+
+} // end namespace
+
+template <class FUNCTION> void
+OmpNumaStencilTable::forEachThread(FUNCTION const & f) const {
+
+    int numThreads = (int)_threadStarts.size() - 1;
+
+    // one iteration per thread : each thread is handed the range it (or a
+    // thread of the same node) touched first
+#pragma omp parallel for schedule(static, 1) num_threads(numThreads)
+    for (int thread = 0; thread < numThreads; ++thread) {
+
+        int p = 0;
+        while (thread >= _partitions[p].firstThread +
+                         _partitions[p].numThreads) {
+            ++p;
+        }
+        Partition const & partition = _partitions[p];
+
+        ThreadBinding binding(
+            _partitions.size() > 1 ? &_cpus[_cpuOffsets[p]] : 0,
+            _partitions.size() > 1 ? _cpuOffsets[p+1] - _cpuOffsets[p] : 0);
+
+        int first = _threadStarts[thread] - partition.start,
+            last = _threadStarts[thread+1] - partition.start;
+        if (first < last) {
+            f(partition, first, last);
+        }
+    }
+}
+
+// Copies the stencils of a thread into the arrays of its partition
+struct OmpNumaStencilTable::CopyFunction {
+    CopyFunction(Far::StencilTable const & table) : _table(table) { }
+
+    void operator()(Partition const & p, int first, int last) const {
+        int const * sizes = &_table.GetSizes()[p.start];
+        int const * offsets = &_table.GetOffsets()[p.start];
+
+        for (int i = first; i < last; ++i) {
+            p.sizes[i] = sizes[i];
+            p.offsets[i] = offsets[i] - offsets[0];
+        }
+
+        int begin = offsets[first],
+            end = offsets[last-1] + sizes[last-1];
+        std::memcpy(p.indices + (begin - offsets[0]),
+                    &_table.GetControlIndices()[begin],
+                    (end - begin) * sizeof(int));
+        std::memcpy(p.weights + (begin - offsets[0]),
+                    &_table.GetWeights()[begin],
+                    (end - begin) * sizeof(float));
+    }
+
+    Far::StencilTable const & _table;
 };
 
+// Clears the destination elements of the stencils of a thread
+struct OmpNumaStencilTable::TouchFunction {
+    TouchFunction(float * dst, BufferDescriptor const & dstDesc) :
+        _dst(dst), _dstDesc(dstDesc) { }
+
+    void operator()(Partition const & p, int first, int last) const {
+        // only the elements of the descriptor are cleared : the rest of the
+        // stride may hold other interleaved primvars
+        float * dst = _dst + _dstDesc.offset +
+                      (p.start + first) * _dstDesc.stride;
+        for (int i = first; i < last; ++i, dst += _dstDesc.stride) {
+            std::memset(dst, 0, _dstDesc.length * sizeof(float));
+        }
+    }
+
+    float * _dst;
+    BufferDescriptor _dstDesc;
+};
+
+// Evaluates the stencils of a thread, and records its busy time when the
+// call is measured
+struct OmpNumaStencilTable::EvalFunction {
+    EvalFunction(float const * src, BufferDescriptor const & srcDesc,
+                 float * dst,       BufferDescriptor const & dstDesc,
+                 double * busyTimes) :
+        _src(src), _srcDesc(srcDesc), _dst(dst), _dstDesc(dstDesc),
+        _busyTimes(busyTimes) { }
+
+    void operator()(Partition const & p, int first, int last) const {
+        Far::internal::StatsTimer timer(
+            _busyTimes ? &_busyTimes[omp_get_thread_num()] : 0);
+
+        // the stencils of the partition are numbered from its start
+        BufferDescriptor dstDesc = _dstDesc;
+        dstDesc.offset += p.start * _dstDesc.stride;
+
+        CpuEvalStencils(_src, _srcDesc, _dst, dstDesc,
+                        p.sizes, p.offsets, p.indices, p.weights,
+                        first, last);
+    }
+
+    float const * _src;
+    BufferDescriptor _srcDesc;
+    float * _dst;
+    BufferDescriptor _dstDesc;
+    double * _busyTimes;
+};
+
+OmpNumaStencilTable::OmpNumaStencilTable(
+    Far::StencilTable const *stencilTable) : _numStencils(0) {
+
+    _numStencils = stencilTable->GetNumStencils();
+
+    int numThreads = omp_get_max_threads();
+
+    std::vector<int> nodes;
+    getNumaNodes(nodes, _cpuOffsets, _cpus);
+
+    int numNodes = std::min((int)nodes.size(), numThreads);
+    if (numNodes <= 1) {
+        numNodes = 1;
+        nodes.assign(1, nodes.empty() ? 0 : nodes[0]);
+        _cpuOffsets.assign(2, 0);
+        _cpus.clear();
+    } else {
+        _cpuOffsets.resize(numNodes + 1);
+        _cpus.resize(_cpuOffsets[numNodes]);
+    }
+
+    // the threads are shared between the nodes in proportion of their
+    // CPUs, and the stencils between the threads in proportion of their
+    // weights
+    int const * sizes = _numStencils ? &stencilTable->GetSizes()[0] : 0;
+    int const * offsets = _numStencils ? &stencilTable->GetOffsets()[0] : 0;
+
+    _threadStarts.resize(numThreads + 1);
+    for (int i = 0; i <= numThreads; ++i) {
+        _threadStarts[i] = _numStencils == 0 ? 0 :
+            CpuGetStencilPartitionStart(sizes, offsets, 0, _numStencils,
+                                        i, numThreads);
+    }
+
+    std::vector<int> firstThreads(numNodes + 1, 0);
+    firstThreads[numNodes] = numThreads;
+    for (int i = 1; i < numNodes; ++i) {
+        int first = (int)((long long)numThreads * _cpuOffsets[i] /
+                          _cpuOffsets[numNodes]);
+        firstThreads[i] = std::min(std::max(first, firstThreads[i-1] + 1),
+                                   numThreads - numNodes + i);
+    }
+
+    _partitions.resize(numNodes);
+    for (int i = 0; i < numNodes; ++i) {
+        Partition & p = _partitions[i];
+
+        p.firstThread = firstThreads[i];
+        p.numThreads = firstThreads[i+1] - firstThreads[i];
+
+        p.node = nodes[i];
+        p.start = _threadStarts[p.firstThread];
+        p.numStencils = _threadStarts[firstThreads[i+1]] - p.start;
+
+        int numWeights = p.numStencils == 0 ? 0 :
+            offsets[p.start + p.numStencils - 1] +
+            sizes[p.start + p.numStencils - 1] - offsets[p.start];
+
+        // the pages are not written until the partition is copied below
+        size_t numInts = 2 * (size_t)p.numStencils + numWeights;
+        p.data = Far::Allocate(std::max(numInts * sizeof(int) +
+                                        numWeights * sizeof(float),
+                                        (size_t)1));
+        if (not p.data) {
+            for (int j = 0; j < i; ++j) {
+                Far::Free(_partitions[j].data);
+            }
+            throw std::bad_alloc();
+        }
+        p.sizes = static_cast<int *>(p.data);
+        p.offsets = p.sizes + p.numStencils;
+        p.indices = p.offsets + p.numStencils;
+        p.weights = reinterpret_cast<float *>(p.indices + numWeights);
+    }
+
+    if (_numStencils > 0) {
+        forEachThread(CopyFunction(*stencilTable));
+    }
+}
+
+OmpNumaStencilTable::~OmpNumaStencilTable() {
+
+    for (int i = 0; i < (int)_partitions.size(); ++i) {
+        Far::Free(_partitions[i].data);
+    }
+}
+
+void
+OmpNumaStencilTable::TouchDestination(
+    float *dst, BufferDescriptor const &dstDesc) const {
+
+    if (dst and _numStencils > 0) {
+        forEachThread(TouchFunction(dst, dstDesc));
+    }
+}
+
+bool
+OmpNumaStencilTable::EvalStencils(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc) const {
+
+    if (srcDesc.length != dstDesc.length) return false;
+
+    if (_numStencils <= 0) return true;
+
+    Far::internal::StatsScope stats("Osd::OmpEvaluator::EvalStencils");
+
+    // the partitions are counted one after the other (their offsets are
+    // relative to their first stencil) and their counts summed
+    if (stats.IsEnabled()) {
+        Far::Stats counts = Far::Stats();
+        for (int i = 0; i < (int)_partitions.size(); ++i) {
+            Partition const & p = _partitions[i];
+            if (p.numStencils == 0) continue;
+
+            CpuSetStencilStats(stats, p.sizes, p.offsets, 0, p.numStencils,
+                               srcDesc, dstDesc, 1, sizeof(float));
+            counts.numItems += stats.GetStats().numItems;
+            counts.numWeights += stats.GetStats().numWeights;
+            counts.bytesRead += stats.GetStats().bytesRead;
+            counts.bytesWritten += stats.GetStats().bytesWritten;
+        }
+        stats.SetCounts(counts.numItems, counts.numWeights,
+                        counts.bytesRead, counts.bytesWritten);
+    }
+
+    // busy time of each thread, when measured
+    int numThreads = (int)_threadStarts.size() - 1;
+    std::vector<double> busyTimes(stats.IsEnabled() ? numThreads : 0, 0.0);
+
+    forEachThread(EvalFunction(src, srcDesc, dst, dstDesc,
+                               busyTimes.empty() ? 0 : &busyTimes[0]));
+
+    stats.SetThreads(numThreads, busyTimes);
+    return true;
+}
+
+// Minimum number of coordinates handed to a thread by EvalPatches()
+static const int patchGrainSize = 256;
+
+//
+// The coordinates are binned by patch once, and the binned order is split into
+// chunks evaluated by the batched CPU kernel. The chunks are scheduled
+// dynamically : the cost of a coordinate depends on the type of its patch
+// (e.g. 16 B-spline vs 20 Gregory basis control vertices), so that chunks of
+// the same size may not take the same time.
+//
+static bool
+evalPatches(float const * src, BufferDescriptor const &srcDesc,
+            float * dst,       BufferDescriptor const &dstDesc,
+            float * du,        BufferDescriptor const &duDesc,
+            float * dv,        BufferDescriptor const &dvDesc,
+            float * normal,    BufferDescriptor const &normalDesc,
+            int numPatchCoords,
+            PatchCoord const * patchCoords,
+            PatchArray const * patchArrays,
+            int const * patchIndexBuffer,
+            PatchParam const * patchParamBuffer) {
+
+    if (numPatchCoords <= 0) return true;
+
+    Far::internal::StatsScope stats("Osd::OmpEvaluator::EvalPatches");
+    CpuSetPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                     srcDesc,
+                     CpuGetOutputDesc(dst, dstDesc,
+                         CpuGetOutputDesc(du, duDesc,
+                             CpuGetOutputDesc(dv, dvDesc, normalDesc))),
+                     CpuGetNumOutputs(dst, du, dv, normal), sizeof(float));
+
+    std::vector<int> order(numPatchCoords);
+    CpuBinPatchCoords(numPatchCoords, patchCoords, &order[0]);
+
+    // a few chunks per thread so that the dynamic schedule can even out the
+    // load
+    int numThreads = omp_get_max_threads();
+    int grainSize = std::max(patchGrainSize,
+                             numPatchCoords / (8 * numThreads));
+    int numChunks = (numPatchCoords + grainSize - 1) / grainSize;
+
+    // busy time of each chunk, when measured
+    std::vector<double> busyTimes(stats.IsEnabled() ? numChunks : 0, 0.0);
+
+    bool failed = false;
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int chunk = 0; chunk < numChunks; ++chunk) {
+
+        Far::internal::StatsTimer timer(
+            busyTimes.empty() ? 0 : &busyTimes[chunk]);
+
+        int begin = chunk * grainSize,
+            end = std::min(begin + grainSize, numPatchCoords);
+
+        if (not CpuEvalPatches(src, srcDesc,
+                               dst, dstDesc,
+                               du,  duDesc,
+                               dv,  dvDesc,
+                               normal, normalDesc,
+                               end - begin, &order[begin], patchCoords,
+                               patchArrays, patchIndexBuffer,
+                               patchParamBuffer)) {
+#pragma omp critical
+            failed = true;
+        }
+    }
+    stats.SetThreads(std::min(numThreads, numChunks), busyTimes);
+    return not failed;
+}
+
 /* static */
 bool
 OmpEvaluator::EvalPatches(
@@ -125,51 +563,16 @@ OmpEvaluator::EvalPatches(
     const int *patchIndexBuffer,
     const PatchParam *patchParamBuffer){
 
-    src += srcDesc.offset;
-    if (dst) dst += dstDesc.offset;
-    else return false;
-    BufferAdapter<const float> srcT(src, srcDesc.length, srcDesc.stride);
-
-#pragma omp parallel for
-    for (int i = 0; i < numPatchCoords; ++i) {
-        BufferAdapter<float> dstT(dst + dstDesc.stride*i, dstDesc.length, dstDesc.stride);
-
-        float wP[20], wDs[20], wDt[20];
-        PatchCoord const &coord = patchCoords[i];
-        PatchArray const &array = patchArrays[coord.handle.arrayIndex];
-
-        int patchType = array.GetPatchType();
-        // XXX: patchIndex is absolute. not sure it's consistent.
-        //      (should be offsetted by array.primitiveIdBase?)
-        //    patchParamBuffer[array.primitiveIdBase + coord.handle.patchIndex]
-        Far::PatchParam const & param =
-            patchParamBuffer[coord.handle.patchIndex];
-
-        int numControlVertices = 0;
-        if (patchType == Far::PatchDescriptor::REGULAR) {
-            Far::internal::GetBSplineWeights(param,
-                                             coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 16;
-        } else if (patchType == Far::PatchDescriptor::GREGORY_BASIS) {
-            Far::internal::GetGregoryWeights(param,
-                                             coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 20;
-        } else if (patchType == Far::PatchDescriptor::QUADS) {
-            Far::internal::GetBilinearWeights(param,
-                                              coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 4;
-        } else {
-            continue;
-        }
-        const int *cvs =
-            &patchIndexBuffer[array.indexBase + coord.handle.vertIndex];
+    if (not src or not dst) return false;
+    if (srcDesc.length != dstDesc.length) return false;
 
-        dstT.Clear();
-        for (int j = 0; j < numControlVertices; ++j) {
-            dstT.AddWithWeight(srcT[cvs[j]], wP[j]);
-        }
-    }
-    return true;
+    return evalPatches(src, srcDesc,
+                       dst, dstDesc,
+                       NULL, BufferDescriptor(),
+                       NULL, BufferDescriptor(),
+                       NULL, BufferDescriptor(),
+                       numPatchCoords, patchCoords,
+                       patchArrays, patchIndexBuffer, patchParamBuffer);
 }
 
 /* static */
@@ -185,59 +588,43 @@ OmpEvaluator::EvalPatches(
     const int *patchIndexBuffer,
     PatchParam const *patchParamBuffer) {
 
-    src += srcDesc.offset;
-    if (dst) dst += dstDesc.offset;
-    if (du)  du += duDesc.offset;
-    if (dv)  dv += dvDesc.offset;
-
-    BufferAdapter<const float> srcT(src, srcDesc.length, srcDesc.stride);
-
-#pragma omp parallel for
-    for (int i = 0; i < numPatchCoords; ++i) {
-        float wP[20], wDs[20], wDt[20];
-        BufferAdapter<float> dstT(dst + dstDesc.stride*i, dstDesc.length, dstDesc.stride);
-        BufferAdapter<float> duT(du   + duDesc.stride*i, duDesc.length, duDesc.stride);
-        BufferAdapter<float> dvT(dv   + dvDesc.stride*i, dvDesc.length, dvDesc.stride);
-
-        PatchCoord const &coord = patchCoords[i];
-        PatchArray const &array = patchArrays[coord.handle.arrayIndex];
-
-        int patchType = array.GetPatchType();
-        Far::PatchParam const & param =
-            patchParamBuffer[coord.handle.patchIndex];
-
-        int numControlVertices = 0;
-        if (patchType == Far::PatchDescriptor::REGULAR) {
-            Far::internal::GetBSplineWeights(param,
-                                             coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 16;
-        } else if (patchType == Far::PatchDescriptor::GREGORY_BASIS) {
-            Far::internal::GetGregoryWeights(param,
-                                             coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 20;
-        } else if (patchType == Far::PatchDescriptor::QUADS) {
-            Far::internal::GetBilinearWeights(param,
-                                              coord.s, coord.t, wP, wDs, wDt);
-            numControlVertices = 4;
-        } else {
-            continue;
-        }
-        const int *cvs =
-            &patchIndexBuffer[array.indexBase + coord.handle.vertIndex];
-
-        dstT.Clear();
-        duT.Clear();
-        dvT.Clear();
-        for (int j = 0; j < numControlVertices; ++j) {
-            dstT.AddWithWeight(srcT[cvs[j]], wP[j]);
-            duT.AddWithWeight(srcT[cvs[j]], wDs[j]);
-            dvT.AddWithWeight(srcT[cvs[j]], wDt[j]);
-        }
-        ++dstT;
-        ++duT;
-        ++dvT;
-    }
-    return true;
+    if (not src) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (du  and srcDesc.length != duDesc.length)  return false;
+    if (dv  and srcDesc.length != dvDesc.length)  return false;
+
+    return evalPatches(src, srcDesc,
+                       dst, dstDesc,
+                       du,  duDesc,
+                       dv,  dvDesc,
+                       NULL, BufferDescriptor(),
+                       numPatchCoords, patchCoords,
+                       patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+/* static */
+bool
+OmpEvaluator::EvalPatchNormals(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    float *normal,    BufferDescriptor const &normalDesc,
+    int numPatchCoords,
+    PatchCoord const *patchCoords,
+    PatchArray const *patchArrays,
+    const int *patchIndexBuffer,
+    PatchParam const *patchParamBuffer) {
+
+    if (not src or not normal) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (srcDesc.length < 3 or normalDesc.length != 3) return false;
+
+    return evalPatches(src, srcDesc,
+                       dst, dstDesc,
+                       NULL, BufferDescriptor(),
+                       NULL, BufferDescriptor(),
+                       normal, normalDesc,
+                       numPatchCoords, patchCoords,
+                       patchArrays, patchIndexBuffer, patchParamBuffer);
 }
 
 /* static */
@@ -28,14 +28,125 @@
 #include "../version.h"
 
 #include <cstddef>
+#include <vector>
 #include "../osd/types.h"
 #include "../osd/bufferDescriptor.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
+namespace Far {
+    class StencilTable;
+}
+
 namespace Osd {
 
+/// \brief NUMA partitioned stencil table
+///
+/// The stencils are split by destination range into one partition per NUMA
+/// node of the host, holding about the same number of weights per thread.
+/// The sizes, offsets, indices and weights of each partition are copied by
+/// the threads of the node which evaluates them, so that the first-touch
+/// policy of the operating system places their pages in the memory of that
+/// node, and OmpEvaluator pins its threads to the CPUs of their node when
+/// evaluating the table.
+///
+/// On hosts with a single node (or on platforms other than Linux) the table
+/// holds a single partition and no thread is pinned.
+///
+/// \note The threads are only pinned for the duration of a call : each one
+///       is restored to its previous affinity afterwards.
+///
+class OmpNumaStencilTable {
+public:
+    static OmpNumaStencilTable *Create(Far::StencilTable const *stencilTable,
+                                       void *deviceContext = NULL) {
+        (void)deviceContext;  // unused
+        return new OmpNumaStencilTable(stencilTable);
+    }
+
+    explicit OmpNumaStencilTable(Far::StencilTable const *stencilTable);
+    ~OmpNumaStencilTable();
+
+    /// \brief Returns the number of stencils in the table
+    int GetNumStencils() const { return _numStencils; }
+
+    /// \brief Returns the number of NUMA partitions of the table
+    int GetNumPartitions() const { return (int)_partitions.size(); }
+
+    /// \brief Returns the NUMA node of a partition
+    int GetPartitionNode(int partition) const {
+        return _partitions[partition].node;
+    }
+
+    /// \brief Returns the first stencil of a partition
+    int GetPartitionStart(int partition) const {
+        return _partitions[partition].start;
+    }
+
+    /// \brief Returns the number of stencils of a partition
+    int GetPartitionNumStencils(int partition) const {
+        return _partitions[partition].numStencils;
+    }
+
+    /// \brief Places the pages of the destination range of each partition
+    ///        in the memory of its node, by clearing the elements described
+    ///        by dstDesc from the threads of that node. The other elements
+    ///        of each stride (e.g. interleaved primvars) are left untouched.
+    ///
+    /// The operating system places a page on first write : this must be
+    /// called on a newly allocated buffer (e.g. right after
+    /// CpuVertexBuffer::Create()), before any other write.
+    ///
+    /// @param dst      Output primvar pointer. An offset of dstDesc will be
+    ///                 applied internally.
+    ///
+    /// @param dstDesc  vertex buffer descriptor for the output buffer
+    ///
+    void TouchDestination(float *dst, BufferDescriptor const &dstDesc) const;
+
+    /// \brief Evaluates the stencils of each partition with the threads of
+    ///        its node (see OmpEvaluator::EvalStencils()), from raw CPU
+    ///        pointers. The offsets of srcDesc and dstDesc are applied
+    ///        internally.
+    bool EvalStencils(const float *src, BufferDescriptor const &srcDesc,
+                      float *dst,       BufferDescriptor const &dstDesc) const;
+
+private:
+    // non-copyable
+    OmpNumaStencilTable(OmpNumaStencilTable const &);
+    OmpNumaStencilTable & operator=(OmpNumaStencilTable const &);
+
+    struct Partition {
+        int node,
+            start,          // first stencil of the partition
+            numStencils,
+            firstThread,    // first thread evaluating the partition
+            numThreads;
+
+        void * data;        // storage of the following arrays
+        int * sizes,
+            * offsets,      // offsets relative to the partition
+            * indices;
+        float * weights;
+    };
+
+    struct CopyFunction;
+    struct TouchFunction;
+    struct EvalFunction;
+
+    // Runs the function on each thread, pinned to the node of its partition
+    template <class FUNCTION> void forEachThread(FUNCTION const & f) const;
+
+    int _numStencils;
+
+    std::vector<Partition> _partitions;
+
+    std::vector<int> _threadStarts,  // first stencil of each thread
+                     _cpuOffsets,    // CPUs of the node of each partition
+                     _cpus;
+};
+
 class OmpEvaluator {
 public:
     /// ----------------------------------------------------------------------
@@ -128,6 +239,45 @@ public:
         const float * weights,
         int start, int end);
 
+    /// \brief Generic static eval stencils function for an
+    ///        OmpNumaStencilTable. Each partition of the table is evaluated
+    ///        by threads pinned to its NUMA node.
+    ///
+    /// @param srcBuffer      Input primvar buffer.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       const float pointer for read
+    ///
+    /// @param srcDesc        vertex buffer descriptor for the input buffer
+    ///
+    /// @param dstBuffer      Output primvar buffer
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       float pointer for write
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param stencilTable   OmpNumaStencilTable
+    ///
+    /// @param instance       not used in the omp kernel
+    ///                       (declared as a typed pointer to prevent
+    ///                        undesirable template resolution)
+    ///
+    /// @param deviceContext  not used in the omp kernel
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER>
+    static bool EvalStencils(
+        SRC_BUFFER *srcBuffer, BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer, BufferDescriptor const &dstDesc,
+        OmpNumaStencilTable const *stencilTable,
+        const OmpEvaluator *instance = NULL,
+        void * deviceContext = NULL) {
+
+        (void)instance;       // unused
+        (void)deviceContext;  // unused
+
+        return stencilTable->EvalStencils(srcBuffer->BindCpuBuffer(), srcDesc,
+                                          dstBuffer->BindCpuBuffer(), dstDesc);
+    }
+
     /// \brief Generic static eval stencils function with derivatives.
     ///        This function has a same signature as other device kernels
     ///        have so that it can be called in the same way from OsdMesh
@@ -186,8 +336,8 @@ public:
                             &stencilTable->GetOffsets()[0],
                             &stencilTable->GetControlIndices()[0],
                             &stencilTable->GetWeights()[0],
-                            &stencilTable->GetDuWeights()[0],
-                            &stencilTable->GetDvWeights()[0],
+                            GetStencilWeights(stencilTable->GetDuWeights()),
+                            GetStencilWeights(stencilTable->GetDvWeights()),
                             /*start = */ 0,
                             /*end   = */ stencilTable->GetNumStencils());
     }
@@ -245,6 +395,89 @@ public:
         const float * dvWeights,
         int start, int end);
 
+    /// \brief Generic static eval stencils function applying a single pass
+    ///        over the stencil table to several primvar buffers, so that the
+    ///        stencil indices and weights are read once for all of them.
+    ///
+    /// @param numBuffers     number of source / destination buffer pairs
+    ///
+    /// @param srcs           Input primvar pointers, one per buffer pair.
+    ///                       The offsets of srcDescs will be applied
+    ///                       internally (i.e. the pointers should not
+    ///                       include the offsets)
+    ///
+    /// @param srcDescs       vertex buffer descriptors for the input buffers
+    ///
+    /// @param dsts           Output primvar pointers, one per buffer pair.
+    ///                       The offsets of dstDescs will be applied
+    ///                       internally.
+    ///
+    /// @param dstDescs       vertex buffer descriptors for the output buffers
+    ///
+    /// @param stencilTable   Far::StencilTable or equivalent
+    ///
+    template <typename STENCIL_TABLE>
+    static bool EvalStencils(
+        int numBuffers,
+        const float * const *srcs, BufferDescriptor const *srcDescs,
+        float * const *dsts,       BufferDescriptor const *dstDescs,
+        STENCIL_TABLE const *stencilTable) {
+
+        if (stencilTable->GetNumStencils() == 0)
+            return false;
+
+        return EvalStencils(numBuffers,
+                            srcs, srcDescs,
+                            dsts, dstDescs,
+                            &stencilTable->GetSizes()[0],
+                            &stencilTable->GetOffsets()[0],
+                            &stencilTable->GetControlIndices()[0],
+                            &stencilTable->GetWeights()[0],
+                            /*start = */ 0,
+                            /*end   = */ stencilTable->GetNumStencils());
+    }
+
+    /// \brief Static eval stencils function applying a single pass over the
+    ///        stencil table to several primvar buffers, which takes raw CPU
+    ///        pointers for input and output.
+    ///
+    /// @param numBuffers     number of source / destination buffer pairs
+    ///
+    /// @param srcs           Input primvar pointers, one per buffer pair.
+    ///                       The offsets of srcDescs will be applied
+    ///                       internally (i.e. the pointers should not
+    ///                       include the offsets)
+    ///
+    /// @param srcDescs       vertex buffer descriptors for the input buffers
+    ///
+    /// @param dsts           Output primvar pointers, one per buffer pair.
+    ///                       The offsets of dstDescs will be applied
+    ///                       internally.
+    ///
+    /// @param dstDescs       vertex buffer descriptors for the output buffers
+    ///
+    /// @param sizes          pointer to the sizes buffer of the stencil table
+    ///
+    /// @param offsets        pointer to the offsets buffer of the stencil table
+    ///
+    /// @param indices        pointer to the indices buffer of the stencil table
+    ///
+    /// @param weights        pointer to the weights buffer of the stencil table
+    ///
+    /// @param start          start index of stencil table
+    ///
+    /// @param end            end index of stencil table
+    ///
+    static bool EvalStencils(
+        int numBuffers,
+        const float * const *srcs, BufferDescriptor const *srcDescs,
+        float * const *dsts,       BufferDescriptor const *dstDescs,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const float * weights,
+        int start, int end);
+
     /// ----------------------------------------------------------------------
     ///
     ///   Limit evaluations with PatchTable
@@ -457,6 +690,112 @@ public:
         const int *patchIndexBuffer,
         PatchParam const *patchParamBuffer);
 
+    /// \brief Generic limit eval function writing unit normals : the
+    ///        normalized cross products of the first three elements of the
+    ///        U and V derivatives, which are not written.
+    ///
+    /// @param srcBuffer        Input primvar buffer.
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         const float pointer for read
+    ///
+    /// @param srcDesc          vertex buffer descriptor for the input buffer
+    ///                         (at least 3 elements)
+    ///
+    /// @param dstBuffer        Output primvar buffer (can be NULL)
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         float pointer for write
+    ///
+    /// @param dstDesc          vertex buffer descriptor for the output buffer
+    ///
+    /// @param normalBuffer     Output normal buffer
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         float pointer for write
+    ///
+    /// @param normalDesc       vertex buffer descriptor for the normalBuffer
+    ///                         (3 elements)
+    ///
+    /// @param numPatchCoords   number of patchCoords.
+    ///
+    /// @param patchCoords      array of locations to be evaluated.
+    ///
+    /// @param patchTable       CpuPatchTable or equivalent
+    ///                         XXX: currently Far::PatchTable can't be used
+    ///                              due to interface mismatch
+    ///
+    /// @param instance         not used in the omp evaluator
+    ///
+    /// @param deviceContext    not used in the omp evaluator
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER,
+              typename PATCHCOORD_BUFFER, typename PATCH_TABLE>
+    static bool EvalPatchNormals(
+        SRC_BUFFER *srcBuffer,    BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer,    BufferDescriptor const &dstDesc,
+        DST_BUFFER *normalBuffer, BufferDescriptor const &normalDesc,
+        int numPatchCoords,
+        PATCHCOORD_BUFFER *patchCoords,
+        PATCH_TABLE *patchTable,
+        OmpEvaluator const *instance = NULL,
+        void * deviceContext = NULL) {
+
+        (void)instance;       // unused
+        (void)deviceContext;  // unused
+
+        return EvalPatchNormals(srcBuffer->BindCpuBuffer(), srcDesc,
+                                dstBuffer ? dstBuffer->BindCpuBuffer() : NULL,
+                                dstDesc,
+                                normalBuffer->BindCpuBuffer(), normalDesc,
+                                numPatchCoords,
+                                (const PatchCoord*)patchCoords->BindCpuBuffer(),
+                                patchTable->GetPatchArrayBuffer(),
+                                patchTable->GetPatchIndexBuffer(),
+                                patchTable->GetPatchParamBuffer());
+    }
+
+    /// \brief Static limit eval function writing unit normals (see above),
+    ///        which takes raw CPU pointers for input and output.
+    ///
+    /// @param src              Input primvar pointer. An offset of srcDesc
+    ///                         will be applied internally (i.e. the pointer
+    ///                         should not include the offset)
+    ///
+    /// @param srcDesc          vertex buffer descriptor for the input buffer
+    ///                         (at least 3 elements)
+    ///
+    /// @param dst              Output primvar pointer (can be NULL). An
+    ///                         offset of dstDesc will be applied internally.
+    ///
+    /// @param dstDesc          vertex buffer descriptor for the output buffer
+    ///
+    /// @param normal           Output normal pointer. An offset of
+    ///                         normalDesc will be applied internally.
+    ///
+    /// @param normalDesc       vertex buffer descriptor for the normal buffer
+    ///                         (3 elements)
+    ///
+    /// @param numPatchCoords   number of patchCoords.
+    ///
+    /// @param patchCoords      array of locations to be evaluated.
+    ///
+    /// @param patchArrays      an array of Osd::PatchArray struct
+    ///                         indexed by PatchCoord::arrayIndex
+    ///
+    /// @param patchIndexBuffer an array of patch indices
+    ///                         indexed by PatchCoord::vertIndex
+    ///
+    /// @param patchParamBuffer an array of Osd::PatchParam struct
+    ///                         indexed by PatchCoord::patchIndex
+    ///
+    static bool EvalPatchNormals(
+        const float *src, BufferDescriptor const &srcDesc,
+        float *dst,       BufferDescriptor const &dstDesc,
+        float *normal,    BufferDescriptor const &normalDesc,
+        int numPatchCoords,
+        PatchCoord const *patchCoords,
+        PatchArray const *patchArrays,
+        const int *patchIndexBuffer,
+        PatchParam const *patchParamBuffer);
+
     /// ----------------------------------------------------------------------
     ///
     ///   Other methods
@@ -23,10 +23,11 @@
 //
 
 #include "../osd/ompKernel.h"
+#include "../osd/cpuKernel.h"
 #include "../osd/bufferDescriptor.h"
+#include "../far/stats.h"
 
-#include <cassert>
-#include <cstdlib>
+#include <algorithm>
 #include <omp.h>
 #include <vector>
 
@@ -35,43 +36,6 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Osd {
 
-template <class T> T *
-elementAtIndex(T * src, int index, BufferDescriptor const &desc) {
-
-    return src + index * desc.stride;
-}
-
-static inline void
-clear(float *dst, BufferDescriptor const &desc) {
-
-    assert(dst);
-    memset(dst, 0, desc.length*sizeof(float));
-}
-
-static inline void
-addWithWeight(float *dst, const float *src, int srcIndex, float weight,
-              BufferDescriptor const &desc) {
-
-    assert(src and dst);
-    src = elementAtIndex(src, srcIndex, desc);
-    for (int k = 0; k < desc.length; ++k) {
-        dst[k] += src[k] * weight;
-    }
-}
-
-static inline void
-copy(float *dst, int dstIndex, const float *src,
-     BufferDescriptor const &desc) {
-
-    assert(src and dst);
-
-    dst = elementAtIndex(dst, dstIndex, desc);
-    memcpy(dst, src, desc.length*sizeof(float));
-}
-
-
-// XXXX manuelk this should be optimized further by using SIMD - considering
-//              OMP is somewhat obsolete - this is probably not worth it.
 void
 OmpEvalStencils(float const * src, BufferDescriptor const &srcDesc,
                 float * dst,       BufferDescriptor const &dstDesc,
@@ -81,37 +45,37 @@ OmpEvalStencils(float const * src, BufferDescriptor const &srcDesc,
                 float const * weights,
                 int start, int end) {
     start = (start > 0 ? start : 0);
-    
-    src += srcDesc.offset;
-    dst += dstDesc.offset;
-
-    int numThreads = omp_get_max_threads();
-    int n = end - start;
 
-    float * result = (float*)alloca(srcDesc.length * numThreads * sizeof(float));
-
-#pragma omp parallel for
-    for (int i = 0; i < n; ++i) {
+    // partitions hold the same number of weights : each one goes through
+    // the SIMD CPU kernel
+    int numThreads = omp_get_max_threads(),
+        numPartitions = CpuGetNumStencilPartitions(
+            sizes, offsets, start, end, numThreads);
 
-        int index = i + start; // Stencil index
+    Far::internal::StatsScope stats("Osd::OmpEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end,
+                       srcDesc, dstDesc, 1, sizeof(float));
 
-        // Get thread-local pointers
-        int const           * threadIndices = indices + offsets[index];
-        float const         * threadWeights = weights + offsets[index];
+    // busy time of each partition, when measured
+    std::vector<double> busyTimes(stats.IsEnabled() ? numPartitions : 0, 0.0);
 
-        int threadId = omp_get_thread_num();
+#pragma omp parallel for
+    for (int partition = 0; partition < numPartitions; ++partition) {
 
-        float * threadResult = result + threadId*srcDesc.length;
+        Far::internal::StatsTimer timer(
+            busyTimes.empty() ? 0 : &busyTimes[partition]);
 
-        clear(threadResult, dstDesc);
+        int first = CpuGetStencilPartitionStart(
+                sizes, offsets, start, end, partition, numPartitions),
+            last = CpuGetStencilPartitionStart(
+                sizes, offsets, start, end, partition+1, numPartitions);
 
-        for (int j=0; j<(int)sizes[index]; ++j) {
-            addWithWeight(threadResult, src,
-                threadIndices[j], threadWeights[j], srcDesc);
+        if (first < last) {
+            CpuEvalStencils(src, srcDesc, dst, dstDesc,
+                            sizes, offsets, indices, weights, first, last);
         }
-
-        copy(dst, i, threadResult, dstDesc);
     }
+    stats.SetThreads(std::min(numThreads, numPartitions), busyTimes);
 }
 
 void
@@ -128,53 +92,82 @@ OmpEvalStencils(float const * src, BufferDescriptor const &srcDesc,
                 int start, int end) {
     start = (start > 0 ? start : 0);
 
-    src += srcDesc.offset;
-    dst += dstDesc.offset;
-    dstDu += dstDuDesc.offset;
-    dstDv += dstDvDesc.offset;
+    int numThreads = omp_get_max_threads(),
+        numPartitions = CpuGetNumStencilPartitions(
+            sizes, offsets, start, end, numThreads);
 
-    int numThreads = omp_get_max_threads();
-    int n = end - start;
+    Far::internal::StatsScope stats("Osd::OmpEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end, srcDesc,
+                       CpuGetOutputDesc(dst, dstDesc,
+                           CpuGetOutputDesc(dstDu, dstDuDesc, dstDvDesc)),
+                       CpuGetNumOutputs(dst, dstDu, dstDv), sizeof(float));
 
-    float * result = (float*)alloca(srcDesc.length * numThreads * sizeof(float));
-    float * resultDu = (float*)alloca(srcDesc.length * numThreads * sizeof(float));
-    float * resultDv = (float*)alloca(srcDesc.length * numThreads * sizeof(float));
+    std::vector<double> busyTimes(stats.IsEnabled() ? numPartitions : 0, 0.0);
 
+    // the fused CPU kernel reads each source element once for the point
+    // and both derivatives
 #pragma omp parallel for
-    for (int i = 0; i < n; ++i) {
+    for (int partition = 0; partition < numPartitions; ++partition) {
+
+        Far::internal::StatsTimer timer(
+            busyTimes.empty() ? 0 : &busyTimes[partition]);
+
+        int first = CpuGetStencilPartitionStart(
+                sizes, offsets, start, end, partition, numPartitions),
+            last = CpuGetStencilPartitionStart(
+                sizes, offsets, start, end, partition+1, numPartitions);
+
+        if (first < last) {
+            CpuEvalStencils(src, srcDesc,
+                            dst, dstDesc,
+                            dstDu, dstDuDesc,
+                            dstDv, dstDvDesc,
+                            sizes, offsets, indices,
+                            weights, duWeights, dvWeights,
+                            first, last);
+        }
+    }
+    stats.SetThreads(std::min(numThreads, numPartitions), busyTimes);
+}
 
-        int index = i + start; // Stencil index
+void
+OmpEvalStencils(int numBuffers,
+                float const * const * srcs, BufferDescriptor const * srcDescs,
+                float * const * dsts,       BufferDescriptor const * dstDescs,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                int start, int end) {
+    start = (start > 0 ? start : 0);
+
+    int numThreads = omp_get_max_threads(),
+        numPartitions = CpuGetNumStencilPartitions(
+            sizes, offsets, start, end, numThreads);
 
-        // Get thread-local pointers
-        int const           * threadIndices = indices + offsets[index];
-        float const         * threadWeights = weights + offsets[index];
-        float const         * threadWeightsDu = duWeights + offsets[index];
-        float const         * threadWeightsDv = dvWeights + offsets[index];
+    Far::internal::StatsScope stats("Osd::OmpEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end,
+                       numBuffers, srcDescs, dstDescs, sizeof(float));
 
-        int threadId = omp_get_thread_num();
+    std::vector<double> busyTimes(stats.IsEnabled() ? numPartitions : 0, 0.0);
 
-        float * threadResult = result + threadId*srcDesc.length;
-        float * threadResultDu = resultDu + threadId*srcDesc.length;
-        float * threadResultDv = resultDv + threadId*srcDesc.length;
+#pragma omp parallel for
+    for (int partition = 0; partition < numPartitions; ++partition) {
 
-        clear(threadResult, dstDesc);
-        clear(threadResultDu, dstDuDesc);
-        clear(threadResultDv, dstDvDesc);
+        Far::internal::StatsTimer timer(
+            busyTimes.empty() ? 0 : &busyTimes[partition]);
 
-        for (int j=0; j<(int)sizes[index]; ++j) {
-            addWithWeight(threadResult, src,
-                threadIndices[j], threadWeights[j], srcDesc);
-            addWithWeight(threadResultDu, src,
-                threadIndices[j], threadWeightsDu[j], srcDesc);
-            addWithWeight(threadResultDv, src,
-                threadIndices[j], threadWeightsDv[j], srcDesc);
-        }
+        int first = CpuGetStencilPartitionStart(
+                sizes, offsets, start, end, partition, numPartitions),
+            last = CpuGetStencilPartitionStart(
+                sizes, offsets, start, end, partition+1, numPartitions);
 
-        copy(dst, i, threadResult, dstDesc);
-        copy(dstDu, i, threadResultDu, dstDuDesc);
-        copy(dstDv, i, threadResultDv, dstDvDesc);
+        if (first < last) {
+            CpuEvalStencils(numBuffers, srcs, srcDescs, dsts, dstDescs,
+                            sizes, offsets, indices, weights, first, last);
+        }
     }
-
+    stats.SetThreads(std::min(numThreads, numPartitions), busyTimes);
 }
 
 }  // end namespace Osd
@@ -56,6 +56,16 @@ OmpEvalStencils(float const * src, BufferDescriptor const &srcDesc,
                 float const * dvWeights,
                 int start, int end);
 
+void
+OmpEvalStencils(int numBuffers,
+                float const * const * srcs, BufferDescriptor const * srcDescs,
+                float * const * dsts,       BufferDescriptor const * dstDescs,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                int start, int end);
+
 } // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
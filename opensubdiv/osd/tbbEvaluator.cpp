@@ -70,6 +70,7 @@ TbbEvaluator::EvalStencils(
     if (srcDesc.length != dstDesc.length) return false;
     if (srcDesc.length != duDesc.length) return false;
     if (srcDesc.length != dvDesc.length) return false;
+    if ((du and not duWeights) or (dv and not dvWeights)) return false;
 
     TbbEvalStencils(src, srcDesc,
                     dst, dstDesc,
@@ -82,6 +83,29 @@ TbbEvaluator::EvalStencils(
     return true;
 }
 
+/* static */
+bool
+TbbEvaluator::EvalStencils(
+    int numBuffers,
+    const float * const *srcs, BufferDescriptor const *srcDescs,
+    float * const *dsts,       BufferDescriptor const *dstDescs,
+    const int * sizes,
+    const int * offsets,
+    const int * indices,
+    const float * weights,
+    int start, int end) {
+
+    if (end <= start) return true;
+    for (int i = 0; i < numBuffers; ++i) {
+        if (srcDescs[i].length != dstDescs[i].length) return false;
+    }
+
+    TbbEvalStencils(numBuffers, srcs, srcDescs, dsts, dstDescs,
+                    sizes, offsets, indices, weights, start, end);
+
+    return true;
+}
+
 /* static */
 bool
 TbbEvaluator::EvalPatches(
@@ -96,6 +120,7 @@ TbbEvaluator::EvalPatches(
     if (srcDesc.length != dstDesc.length) return false;
 
     TbbEvalPatches(src, srcDesc, dst, dstDesc,
+                   NULL, BufferDescriptor(),
                    NULL, BufferDescriptor(),
                    NULL, BufferDescriptor(),
                    numPatchCoords, patchCoords,
@@ -117,19 +142,66 @@ TbbEvaluator::EvalPatches(
     const int *patchIndexBuffer,
     const PatchParam *patchParamBuffer) {
 
-    if (srcDesc.length != dstDesc.length) return false;
+    if (not src) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (du  and srcDesc.length != duDesc.length)  return false;
+    if (dv  and srcDesc.length != dvDesc.length)  return false;
 
     TbbEvalPatches(src, srcDesc, dst, dstDesc,
                    du,  duDesc,  dv,  dvDesc,
+                   NULL, BufferDescriptor(),
                    numPatchCoords, patchCoords,
                    patchArrayBuffer, patchIndexBuffer, patchParamBuffer);
 
     return true;
 }
 
+/* static */
+bool
+TbbEvaluator::EvalPatchNormals(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    float *normal,    BufferDescriptor const &normalDesc,
+    int numPatchCoords,
+    const PatchCoord *patchCoords,
+    const PatchArray *patchArrayBuffer,
+    const int *patchIndexBuffer,
+    const PatchParam *patchParamBuffer) {
+
+    if (not src or not normal) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (srcDesc.length < 3 or normalDesc.length != 3) return false;
+
+    TbbEvalPatches(src, srcDesc, dst, dstDesc,
+                   NULL, BufferDescriptor(),
+                   NULL, BufferDescriptor(),
+                   normal, normalDesc,
+                   numPatchCoords, patchCoords,
+                   patchArrayBuffer, patchIndexBuffer, patchParamBuffer);
+
+    return true;
+}
+
+/* static */
+AsyncEvaluation
+TbbEvaluator::EvalStencilsAsync(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    const int * sizes,
+    const int * offsets,
+    const int * indices,
+    const float * weights,
+    int start, int end) {
+
+    return AsyncEvaluation::Launch(new AsyncEvalStencilsTask<TbbEvaluator>(
+        src, srcDesc, dst, dstDesc,
+        sizes, offsets, indices, weights, start, end));
+}
+
 /* static */
 void
 TbbEvaluator::Synchronize(void *) {
+    AsyncEvaluation::WaitAll();
 }
 
 /* static */
@@ -27,6 +27,7 @@
 
 #include "../version.h"
 #include "../osd/types.h"
+#include "../osd/asyncEvaluation.h"
 #include "../osd/bufferDescriptor.h"
 #include "../far/patchTable.h"
 
@@ -187,8 +188,8 @@ public:
                             &stencilTable->GetOffsets()[0],
                             &stencilTable->GetControlIndices()[0],
                             &stencilTable->GetWeights()[0],
-                            &stencilTable->GetDuWeights()[0],
-                            &stencilTable->GetDvWeights()[0],
+                            GetStencilWeights(stencilTable->GetDuWeights()),
+                            GetStencilWeights(stencilTable->GetDvWeights()),
                             /*start = */ 0,
                             /*end   = */ stencilTable->GetNumStencils());
     }
@@ -247,6 +248,89 @@ public:
         const float * dvWeights,
         int start, int end);
 
+    /// \brief Generic static eval stencils function applying a single pass
+    ///        over the stencil table to several primvar buffers, so that the
+    ///        stencil indices and weights are read once for all of them.
+    ///
+    /// @param numBuffers     number of source / destination buffer pairs
+    ///
+    /// @param srcs           Input primvar pointers, one per buffer pair.
+    ///                       The offsets of srcDescs will be applied
+    ///                       internally (i.e. the pointers should not
+    ///                       include the offsets)
+    ///
+    /// @param srcDescs       vertex buffer descriptors for the input buffers
+    ///
+    /// @param dsts           Output primvar pointers, one per buffer pair.
+    ///                       The offsets of dstDescs will be applied
+    ///                       internally.
+    ///
+    /// @param dstDescs       vertex buffer descriptors for the output buffers
+    ///
+    /// @param stencilTable   Far::StencilTable or equivalent
+    ///
+    template <typename STENCIL_TABLE>
+    static bool EvalStencils(
+        int numBuffers,
+        const float * const *srcs, BufferDescriptor const *srcDescs,
+        float * const *dsts,       BufferDescriptor const *dstDescs,
+        STENCIL_TABLE const *stencilTable) {
+
+        if (stencilTable->GetNumStencils() == 0)
+            return false;
+
+        return EvalStencils(numBuffers,
+                            srcs, srcDescs,
+                            dsts, dstDescs,
+                            &stencilTable->GetSizes()[0],
+                            &stencilTable->GetOffsets()[0],
+                            &stencilTable->GetControlIndices()[0],
+                            &stencilTable->GetWeights()[0],
+                            /*start = */ 0,
+                            /*end   = */ stencilTable->GetNumStencils());
+    }
+
+    /// \brief Static eval stencils function applying a single pass over the
+    ///        stencil table to several primvar buffers, which takes raw CPU
+    ///        pointers for input and output.
+    ///
+    /// @param numBuffers     number of source / destination buffer pairs
+    ///
+    /// @param srcs           Input primvar pointers, one per buffer pair.
+    ///                       The offsets of srcDescs will be applied
+    ///                       internally (i.e. the pointers should not
+    ///                       include the offsets)
+    ///
+    /// @param srcDescs       vertex buffer descriptors for the input buffers
+    ///
+    /// @param dsts           Output primvar pointers, one per buffer pair.
+    ///                       The offsets of dstDescs will be applied
+    ///                       internally.
+    ///
+    /// @param dstDescs       vertex buffer descriptors for the output buffers
+    ///
+    /// @param sizes          pointer to the sizes buffer of the stencil table
+    ///
+    /// @param offsets        pointer to the offsets buffer of the stencil table
+    ///
+    /// @param indices        pointer to the indices buffer of the stencil table
+    ///
+    /// @param weights        pointer to the weights buffer of the stencil table
+    ///
+    /// @param start          start index of stencil table
+    ///
+    /// @param end            end index of stencil table
+    ///
+    static bool EvalStencils(
+        int numBuffers,
+        const float * const *srcs, BufferDescriptor const *srcDescs,
+        float * const *dsts,       BufferDescriptor const *dstDescs,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const float * weights,
+        int start, int end);
+
     /// ----------------------------------------------------------------------
     ///
     ///   Limit evaluations with PatchTable
@@ -454,6 +538,167 @@ public:
         const int *patchIndexBuffer,
         const PatchParam *patchParamBuffer);
 
+    /// \brief Generic limit eval function writing unit normals : the
+    ///        normalized cross products of the first three elements of the
+    ///        U and V derivatives, which are not written.
+    ///
+    /// @param srcBuffer        Input primvar buffer.
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         const float pointer for read
+    ///
+    /// @param srcDesc          vertex buffer descriptor for the input buffer
+    ///                         (at least 3 elements)
+    ///
+    /// @param dstBuffer        Output primvar buffer (can be NULL)
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         float pointer for write
+    ///
+    /// @param dstDesc          vertex buffer descriptor for the output buffer
+    ///
+    /// @param normalBuffer     Output normal buffer
+    ///                         must have BindCpuBuffer() method returning a
+    ///                         float pointer for write
+    ///
+    /// @param normalDesc       vertex buffer descriptor for the normalBuffer
+    ///                         (3 elements)
+    ///
+    /// @param numPatchCoords   number of patchCoords.
+    ///
+    /// @param patchCoords      array of locations to be evaluated.
+    ///
+    /// @param patchTable       CpuPatchTable or equivalent
+    ///                         XXX: currently Far::PatchTable can't be used
+    ///                              due to interface mismatch
+    ///
+    /// @param instance         not used in the tbb evaluator
+    ///
+    /// @param deviceContext    not used in the tbb evaluator
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER,
+              typename PATCHCOORD_BUFFER, typename PATCH_TABLE>
+    static bool EvalPatchNormals(
+        SRC_BUFFER *srcBuffer,    BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer,    BufferDescriptor const &dstDesc,
+        DST_BUFFER *normalBuffer, BufferDescriptor const &normalDesc,
+        int numPatchCoords,
+        PATCHCOORD_BUFFER *patchCoords,
+        PATCH_TABLE *patchTable,
+        TbbEvaluator const *instance = NULL,
+        void * deviceContext = NULL) {
+
+        (void)instance;       // unused
+        (void)deviceContext;  // unused
+
+        return EvalPatchNormals(srcBuffer->BindCpuBuffer(), srcDesc,
+                                dstBuffer ? dstBuffer->BindCpuBuffer() : NULL,
+                                dstDesc,
+                                normalBuffer->BindCpuBuffer(), normalDesc,
+                                numPatchCoords,
+                                (const PatchCoord*)patchCoords->BindCpuBuffer(),
+                                patchTable->GetPatchArrayBuffer(),
+                                patchTable->GetPatchIndexBuffer(),
+                                patchTable->GetPatchParamBuffer());
+    }
+
+    /// \brief Static limit eval function writing unit normals (see above),
+    ///        which takes raw CPU pointers for input and output.
+    ///
+    /// @param src              Input primvar pointer. An offset of srcDesc
+    ///                         will be applied internally (i.e. the pointer
+    ///                         should not include the offset)
+    ///
+    /// @param srcDesc          vertex buffer descriptor for the input buffer
+    ///                         (at least 3 elements)
+    ///
+    /// @param dst              Output primvar pointer (can be NULL). An
+    ///                         offset of dstDesc will be applied internally.
+    ///
+    /// @param dstDesc          vertex buffer descriptor for the output buffer
+    ///
+    /// @param normal           Output normal pointer. An offset of
+    ///                         normalDesc will be applied internally.
+    ///
+    /// @param normalDesc       vertex buffer descriptor for the normal buffer
+    ///                         (3 elements)
+    ///
+    /// @param numPatchCoords   number of patchCoords.
+    ///
+    /// @param patchCoords      array of locations to be evaluated.
+    ///
+    /// @param patchArrays      an array of Osd::PatchArray struct
+    ///                         indexed by PatchCoord::arrayIndex
+    ///
+    /// @param patchIndexBuffer an array of patch indices
+    ///                         indexed by PatchCoord::vertIndex
+    ///
+    /// @param patchParamBuffer an array of Osd::PatchParam struct
+    ///                         indexed by PatchCoord::patchIndex
+    ///
+    static bool EvalPatchNormals(
+        const float *src, BufferDescriptor const &srcDesc,
+        float *dst,       BufferDescriptor const &dstDesc,
+        float *normal,    BufferDescriptor const &normalDesc,
+        int numPatchCoords,
+        PatchCoord const *patchCoords,
+        PatchArray const *patchArrays,
+        const int *patchIndexBuffer,
+        PatchParam const *patchParamBuffer);
+
+    /// ----------------------------------------------------------------------
+    ///
+    ///   Asynchronous stencil evaluation
+    ///
+    /// ----------------------------------------------------------------------
+
+    /// \brief Generic eval stencils function which returns at once : the
+    ///        evaluation runs in the background (see AsyncEvaluation).
+    ///
+    /// The buffers are bound when the evaluation is launched, and must not be
+    /// modified (sources) or read (destinations) until it is complete.
+    ///
+    /// @param srcBuffer      Input primvar buffer.
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       const float pointer for read
+    ///
+    /// @param srcDesc        vertex buffer descriptor for the input buffer
+    ///
+    /// @param dstBuffer      Output primvar buffer
+    ///                       must have BindCpuBuffer() method returning a
+    ///                       float pointer for write
+    ///
+    /// @param dstDesc        vertex buffer descriptor for the output buffer
+    ///
+    /// @param stencilTable   Far::StencilTable or equivalent, which must
+    ///                       remain valid until the evaluation is complete
+    ///
+    template <typename SRC_BUFFER, typename DST_BUFFER, typename STENCIL_TABLE>
+    static AsyncEvaluation EvalStencilsAsync(
+        SRC_BUFFER *srcBuffer, BufferDescriptor const &srcDesc,
+        DST_BUFFER *dstBuffer, BufferDescriptor const &dstDesc,
+        STENCIL_TABLE const *stencilTable) {
+
+        return EvalStencilsAsync(srcBuffer->BindCpuBuffer(), srcDesc,
+                                 dstBuffer->BindCpuBuffer(), dstDesc,
+                                 &stencilTable->GetSizes()[0],
+                                 &stencilTable->GetOffsets()[0],
+                                 &stencilTable->GetControlIndices()[0],
+                                 &stencilTable->GetWeights()[0],
+                                 /*start = */ 0,
+                                 /*end   = */ stencilTable->GetNumStencils());
+    }
+
+    /// \brief Static eval stencils function which returns at once, and takes
+    ///        raw CPU pointers for input and output (see EvalStencils()).
+    ///
+    static AsyncEvaluation EvalStencilsAsync(
+        const float *src,  BufferDescriptor const &srcDesc,
+        float *dst,        BufferDescriptor const &dstDesc,
+        const int * sizes,
+        const int * offsets,
+        const int * indices,
+        const float * weights,
+        int start, int end);
+
     /// ----------------------------------------------------------------------
     ///
     ///   Other methods
@@ -26,10 +26,13 @@
 #include "../osd/tbbKernel.h"
 #include "../osd/types.h"
 #include "../osd/bufferDescriptor.h"
-#include "../far/patchBasis.h"
+#include "../far/stats.h"
 
 #include <cassert>
 #include <cstdlib>
+#include <functional>
+#include <vector>
+#include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 
 namespace OpenSubdiv {
@@ -37,125 +40,168 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Osd {
 
-#define grain_size  200
+// Busy time of each thread taking part in a measured call (see
+// Far::SetStatsCallback())
+typedef tbb::enumerable_thread_specific<double> BusyTimes;
 
-template <class T> T *
-elementAtIndex(T * src, int index, BufferDescriptor const &desc) {
-
-    return src + index * desc.stride;
-}
-
-static inline void
-clear(float *dst, BufferDescriptor const &desc) {
-
-    assert(dst);
-    memset(dst, 0, desc.length*sizeof(float));
-}
-
-static inline void
-addWithWeight(float *dst, const float *src, int srcIndex, float weight,
-              BufferDescriptor const &desc) {
-
-    assert(src and dst);
-    src = elementAtIndex(src, srcIndex, desc);
-    for (int k = 0; k < desc.length; ++k) {
-        dst[k] += src[k] * weight;
+// Holds the busy times of a call only while it is measured (the thread
+// specific storage is not free to create), and reports them to its scope
+class ThreadBusyTimes {
+public:
+    explicit ThreadBusyTimes(Far::internal::StatsScope & stats) :
+        _stats(stats),
+        _busyTimes(stats.IsEnabled() ? new BusyTimes(0.0) : 0) { }
+
+    ~ThreadBusyTimes() {
+        if (_busyTimes) {
+            _stats.SetThreads((int)_busyTimes->size(),
+                              _busyTimes->combine(std::plus<double>()));
+            delete _busyTimes;
+        }
     }
-}
 
-static inline void
-copy(float *dst, int dstIndex, const float *src,
-     BufferDescriptor const &desc) {
+    // Returns the busy times to record, or NULL if the call is not measured
+    BusyTimes * Get() const { return _busyTimes; }
 
-    assert(src and dst);
-
-    dst = elementAtIndex(dst, dstIndex, desc);
-    memcpy(dst, src, desc.length*sizeof(float));
-}
+private:
+    ThreadBusyTimes(ThreadBusyTimes const &);
+    ThreadBusyTimes & operator=(ThreadBusyTimes const &);
 
+    Far::internal::StatsScope & _stats;
+    BusyTimes * _busyTimes;
+};
 
 class TBBStencilKernel {
 
     BufferDescriptor _srcDesc;
     BufferDescriptor _dstDesc;
+    BufferDescriptor _duDesc;
+    BufferDescriptor _dvDesc;
     float const * _vertexSrc;
     float * _vertexDst;
+    float * _vertexDu;
+    float * _vertexDv;
 
     int const * _sizes;
     int const * _offsets,
               * _indices;
     float const * _weights;
+    float const * _duWeights;
+    float const * _dvWeights;
 
+    // stencil range split into partitions of equal cost
+    int _start,
+        _end,
+        _numPartitions;
+
+    BusyTimes * _busyTimes;
 
 public:
     TBBStencilKernel(float const *src, BufferDescriptor srcDesc,
                      float *dst,       BufferDescriptor dstDesc,
                      int const * sizes, int const * offsets,
-                     int const * indices, float const * weights) :
+                     int const * indices, float const * weights,
+                     int start, int end, int numPartitions,
+                     BusyTimes * busyTimes) :
          _srcDesc(srcDesc),
          _dstDesc(dstDesc),
          _vertexSrc(src),
          _vertexDst(dst),
+         _vertexDu(NULL),
+         _vertexDv(NULL),
          _sizes(sizes),
          _offsets(offsets),
          _indices(indices),
-         _weights(weights) { }
+         _weights(weights),
+         _duWeights(NULL),
+         _dvWeights(NULL),
+         _start(start),
+         _end(end),
+         _numPartitions(numPartitions),
+         _busyTimes(busyTimes) { }
+
+    TBBStencilKernel(float const *src, BufferDescriptor srcDesc,
+                     float *dst,       BufferDescriptor dstDesc,
+                     float *du,        BufferDescriptor duDesc,
+                     float *dv,        BufferDescriptor dvDesc,
+                     int const * sizes, int const * offsets,
+                     int const * indices, float const * weights,
+                     float const * duWeights, float const * dvWeights,
+                     int start, int end, int numPartitions,
+                     BusyTimes * busyTimes) :
+         _srcDesc(srcDesc),
+         _dstDesc(dstDesc),
+         _duDesc(duDesc),
+         _dvDesc(dvDesc),
+         _vertexSrc(src),
+         _vertexDst(dst),
+         _vertexDu(du),
+         _vertexDv(dv),
+         _sizes(sizes),
+         _offsets(offsets),
+         _indices(indices),
+         _weights(weights),
+         _duWeights(duWeights),
+         _dvWeights(dvWeights),
+         _start(start),
+         _end(end),
+         _numPartitions(numPartitions),
+         _busyTimes(busyTimes) { }
 
     TBBStencilKernel(TBBStencilKernel const & other) {
         _srcDesc    = other._srcDesc;
         _dstDesc    = other._dstDesc;
+        _duDesc     = other._duDesc;
+        _dvDesc     = other._dvDesc;
         _sizes      = other._sizes;
         _offsets    = other._offsets;
         _indices    = other._indices;
         _weights    = other._weights;
+        _duWeights  = other._duWeights;
+        _dvWeights  = other._dvWeights;
         _vertexSrc  = other._vertexSrc;
         _vertexDst  = other._vertexDst;
+        _vertexDu   = other._vertexDu;
+        _vertexDv   = other._vertexDv;
+        _start      = other._start;
+        _end        = other._end;
+        _numPartitions = other._numPartitions;
+        _busyTimes  = other._busyTimes;
     }
 
     void operator() (tbb::blocked_range<int> const &r) const {
-#define USE_SIMD
-#ifdef USE_SIMD
-        if (_srcDesc.length==4 and _srcDesc.stride==4 and _dstDesc.stride==4) {
 
-            // SIMD fast path for aligned primvar data (4 floats)
-            int offset = _offsets[r.begin()];
-            ComputeStencilKernel<4>(_vertexSrc, _vertexDst,
-                _sizes, _indices+offset, _weights+offset, r.begin(), r.end());
+        Far::internal::StatsTimer timer(
+            _busyTimes ? &_busyTimes->local() : 0);
 
-        } else if (_srcDesc.length==8 and _srcDesc.stride==4 and _dstDesc.stride==4) {
+        for (int partition = r.begin(); partition < r.end(); ++partition) {
 
-            // SIMD fast path for aligned primvar data (8 floats)
-            int offset = _offsets[r.begin()];
-            ComputeStencilKernel<8>(_vertexSrc, _vertexDst,
-                _sizes, _indices+offset, _weights+offset, r.begin(), r.end());
+            int first = CpuGetStencilPartitionStart(_sizes, _offsets,
+                    _start, _end, partition, _numPartitions),
+                last = CpuGetStencilPartitionStart(_sizes, _offsets,
+                    _start, _end, partition+1, _numPartitions);
 
-        } else {
-#else
-        {
-#endif
-            int const * sizes = _sizes;
-            int const * indices = _indices;
-            float const * weights = _weights;
-
-            if (r.begin()>0) {
-                sizes += r.begin();
-                indices += _offsets[r.begin()];
-                weights += _offsets[r.begin()];
+            if (first < last) {
+                evalStencils(first, last);
             }
+        }
+    }
 
-            // Slow path for non-aligned data
-            float * result = (float*)alloca(_srcDesc.length * sizeof(float));
-
-            for (int i=r.begin(); i<r.end(); ++i, ++sizes) {
-
-                clear(result, _dstDesc);
-
-                for (int j=0; j<*sizes; ++j) {
-                    addWithWeight(result, _vertexSrc, *indices++, *weights++, _srcDesc);
-                }
+private:
+    void evalStencils(int first, int last) const {
 
-                copy(_vertexDst, i, result, _dstDesc);
-            }
+        // the CPU kernels apply the buffer offsets and select the best
+        // SIMD implementation for the primvar layout
+        if (_vertexDu == NULL and _vertexDv == NULL) {
+            CpuEvalStencils(_vertexSrc, _srcDesc, _vertexDst, _dstDesc,
+                            _sizes, _offsets, _indices, _weights,
+                            first, last);
+        } else {
+            CpuEvalStencils(_vertexSrc, _srcDesc, _vertexDst, _dstDesc,
+                            _vertexDu, _duDesc, _vertexDv, _dvDesc,
+                            _sizes, _offsets, _indices,
+                            _weights, _duWeights, _dvWeights,
+                            first, last);
         }
     }
 };
@@ -169,13 +215,21 @@ TbbEvalStencils(float const * src, BufferDescriptor const &srcDesc,
                 float const * weights,
                 int start, int end) {
 
-    src += srcDesc.offset;
-    dst += dstDesc.offset;
+    // partitions hold the same number of weights
+    int numPartitions =
+        CpuGetNumStencilPartitions(sizes, offsets, start, end);
+
+    Far::internal::StatsScope stats("Osd::TbbEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end,
+                       srcDesc, dstDesc, 1, sizeof(float));
+    ThreadBusyTimes busyTimes(stats);
 
     TBBStencilKernel kernel(src, srcDesc, dst, dstDesc,
-                            sizes, offsets, indices, weights);
+                            sizes, offsets, indices, weights,
+                            start, end, numPartitions,
+                            busyTimes.Get());
 
-    tbb::blocked_range<int> range(start, end, grain_size);
+    tbb::blocked_range<int> range(0, numPartitions, 1);
 
     tbb::parallel_for(range, kernel);
 }
@@ -193,219 +247,190 @@ TbbEvalStencils(float const * src, BufferDescriptor const &srcDesc,
                 float const * dvWeights,
                 int start, int end) {
 
-    if (src) src += srcDesc.offset;
-    if (dst) dst += dstDesc.offset;
-    if (du)  du  += duDesc.offset;
-    if (dv)  dv  += dvDesc.offset;
-
-    // PERFORMANCE: need to combine 3 launches together
-    if (dst) {
-        TBBStencilKernel kernel(src, srcDesc, dst, dstDesc,
-                                sizes, offsets, indices, weights);
-        tbb::blocked_range<int> range(start, end, grain_size);
-        tbb::parallel_for(range, kernel);
-    }
+    int numPartitions =
+        CpuGetNumStencilPartitions(sizes, offsets, start, end);
 
-    if (du) {
-        TBBStencilKernel kernel(src, srcDesc, du, duDesc,
-                                sizes, offsets, indices, duWeights);
-        tbb::blocked_range<int> range(start, end, grain_size);
-        tbb::parallel_for(range, kernel);
-    }
+    Far::internal::StatsScope stats("Osd::TbbEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end, srcDesc,
+                       CpuGetOutputDesc(dst, dstDesc,
+                                        CpuGetOutputDesc(du, duDesc, dvDesc)),
+                       CpuGetNumOutputs(dst, du, dv), sizeof(float));
+    ThreadBusyTimes busyTimes(stats);
 
-    if (dv) {
-        TBBStencilKernel kernel(src, srcDesc, dv, dvDesc,
-                                sizes, offsets, indices, dvWeights);
-        tbb::blocked_range<int> range(start, end, grain_size);
-        tbb::parallel_for(range, kernel);
-    }
+    // single launch : the source elements are read once for the point
+    // and the derivatives
+    TBBStencilKernel kernel(src, srcDesc, dst, dstDesc,
+                            du, duDesc, dv, dvDesc,
+                            sizes, offsets, indices,
+                            weights, duWeights, dvWeights,
+                            start, end, numPartitions,
+                            busyTimes.Get());
+
+    tbb::blocked_range<int> range(0, numPartitions, 1);
+
+    tbb::parallel_for(range, kernel);
 }
 
-// ---------------------------------------------------------------------------
+class TBBMultiStencilKernel {
 
-template <typename T>
-struct BufferAdapter {
-    BufferAdapter(T *p, int length, int stride) :
-        _p(p), _length(length), _stride(stride) { }
-    void Clear() {
-        for (int i = 0; i < _length; ++i) _p[i] = 0;
-    }
-    void AddWithWeight(T const *src, float w) {
-        if (_p) {
-            for (int i = 0; i < _length; ++i) {
-                _p[i] += src[i] * w;
+    int _numBuffers;
+    float const * const * _srcs;
+    BufferDescriptor const * _srcDescs;
+    float * const * _dsts;
+    BufferDescriptor const * _dstDescs;
+
+    int const * _sizes;
+    int const * _offsets,
+              * _indices;
+    float const * _weights;
+
+    int _start,
+        _end,
+        _numPartitions;
+
+    BusyTimes * _busyTimes;
+
+public:
+    TBBMultiStencilKernel(int numBuffers,
+                          float const * const * srcs,
+                          BufferDescriptor const * srcDescs,
+                          float * const * dsts,
+                          BufferDescriptor const * dstDescs,
+                          int const * sizes, int const * offsets,
+                          int const * indices, float const * weights,
+                          int start, int end, int numPartitions,
+                          BusyTimes * busyTimes) :
+         _numBuffers(numBuffers),
+         _srcs(srcs),
+         _srcDescs(srcDescs),
+         _dsts(dsts),
+         _dstDescs(dstDescs),
+         _sizes(sizes),
+         _offsets(offsets),
+         _indices(indices),
+         _weights(weights),
+         _start(start),
+         _end(end),
+         _numPartitions(numPartitions),
+         _busyTimes(busyTimes) { }
+
+    void operator() (tbb::blocked_range<int> const &r) const {
+
+        Far::internal::StatsTimer timer(
+            _busyTimes ? &_busyTimes->local() : 0);
+
+        for (int partition = r.begin(); partition < r.end(); ++partition) {
+
+            int first = CpuGetStencilPartitionStart(_sizes, _offsets,
+                    _start, _end, partition, _numPartitions),
+                last = CpuGetStencilPartitionStart(_sizes, _offsets,
+                    _start, _end, partition+1, _numPartitions);
+
+            if (first < last) {
+                CpuEvalStencils(_numBuffers, _srcs, _srcDescs,
+                                _dsts, _dstDescs,
+                                _sizes, _offsets, _indices, _weights,
+                                first, last);
             }
         }
     }
-    const T *operator[] (int index) const {
-        return _p + _stride * index;
-    }
-    BufferAdapter<T> & operator ++() {
-        if (_p) {
-            _p += _stride;
-        }
-        return *this;
-    }
-
-    T *_p;
-    int _length;
-    int _stride;
 };
 
+void
+TbbEvalStencils(int numBuffers,
+                float const * const * srcs, BufferDescriptor const * srcDescs,
+                float * const * dsts,       BufferDescriptor const * dstDescs,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                int start, int end) {
+
+    int numPartitions =
+        CpuGetNumStencilPartitions(sizes, offsets, start, end);
+
+    Far::internal::StatsScope stats("Osd::TbbEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end,
+                       numBuffers, srcDescs, dstDescs, sizeof(float));
+    ThreadBusyTimes busyTimes(stats);
+
+    TBBMultiStencilKernel kernel(numBuffers, srcs, srcDescs, dsts, dstDescs,
+                                 sizes, offsets, indices, weights,
+                                 start, end, numPartitions,
+                                 busyTimes.Get());
+
+    tbb::blocked_range<int> range(0, numPartitions, 1);
+
+    tbb::parallel_for(range, kernel);
+}
+
+// ---------------------------------------------------------------------------
+
+// Minimum number of coordinates evaluated by a task
+#define patch_grain_size  256
+
+//
+// The coordinates are binned by patch once, and each task evaluates a range of
+// the binned order with the batched CPU kernel. The cost of a coordinate
+// depends on the type of its patch (e.g. 16 B-spline vs 20 Gregory basis
+// control vertices) : the ranges are split further and stolen by idle threads
+// as needed by the default (auto) partitioner.
+//
 class TbbEvalPatchesKernel {
     BufferDescriptor _srcDesc;
     BufferDescriptor _dstDesc;
     BufferDescriptor _dstDuDesc;
     BufferDescriptor _dstDvDesc;
+    BufferDescriptor _dstNormalDesc;
     float const * _src;
     float * _dst;
     float * _dstDu;
     float * _dstDv;
-    int _numPatchCoords;
+    float * _dstNormal;
+    const int        *_order;
     const PatchCoord *_patchCoords;
     const PatchArray *_patchArrayBuffer;
     const int        *_patchIndexBuffer;
     const PatchParam *_patchParamBuffer;
+    BusyTimes        *_busyTimes;
 
 public:
     TbbEvalPatchesKernel(float const *src, BufferDescriptor srcDesc,
                          float *dst,       BufferDescriptor dstDesc,
                          float *dstDu,     BufferDescriptor dstDuDesc,
                          float *dstDv,     BufferDescriptor dstDvDesc,
-                         int numPatchCoords,
+                         float *dstNormal, BufferDescriptor dstNormalDesc,
+                         const int *order,
                          const PatchCoord *patchCoords,
                          const PatchArray *patchArrayBuffer,
                          const int *patchIndexBuffer,
-                         const PatchParam *patchParamBuffer) :
+                         const PatchParam *patchParamBuffer,
+                         BusyTimes *busyTimes) :
         _srcDesc(srcDesc), _dstDesc(dstDesc),
         _dstDuDesc(dstDuDesc), _dstDvDesc(dstDvDesc),
+        _dstNormalDesc(dstNormalDesc),
         _src(src), _dst(dst), _dstDu(dstDu), _dstDv(dstDv),
-        _numPatchCoords(numPatchCoords),
+        _dstNormal(dstNormal),
+        _order(order),
         _patchCoords(patchCoords),
         _patchArrayBuffer(patchArrayBuffer),
         _patchIndexBuffer(patchIndexBuffer),
-        _patchParamBuffer(patchParamBuffer) {
+        _patchParamBuffer(patchParamBuffer),
+        _busyTimes(busyTimes) {
     }
 
     void operator() (tbb::blocked_range<int> const &r) const {
-        if (_dstDu == NULL && _dstDv == NULL) {
-            compute(r);
-        } else {
-            computeWithDerivative(r);
-        }
-    }
-
-    void compute(tbb::blocked_range<int> const &r) const {
-        float wP[20], wDs[20], wDt[20];
-        BufferAdapter<const float> srcT(_src + _srcDesc.offset,
-                                        _srcDesc.length,
-                                        _srcDesc.stride);
-        BufferAdapter<float> dstT(_dst + _dstDesc.offset
-                                       + r.begin() * _dstDesc.stride,
-                                  _dstDesc.length,
-                                  _dstDesc.stride);
-
-        BufferAdapter<float> dstDuT(_dstDu,
-                                    _dstDuDesc.length,
-                                    _dstDuDesc.stride);
-        BufferAdapter<float> dstDvT(_dstDv,
-                                    _dstDvDesc.length,
-                                    _dstDvDesc.stride);
-
-        for (int i = r.begin(); i < r.end(); ++i) {
-            PatchCoord const &coord = _patchCoords[i];
-            PatchArray const &array = _patchArrayBuffer[coord.handle.arrayIndex];
-
-            int patchType = array.GetPatchType();
-            Far::PatchParam const & param =
-                _patchParamBuffer[coord.handle.patchIndex];
-
-            int numControlVertices = 0;
-            if (patchType == Far::PatchDescriptor::REGULAR) {
-                Far::internal::GetBSplineWeights(param,
-                                                 coord.s, coord.t, wP, wDs, wDt);
-                numControlVertices = 16;
-            } else if (patchType == Far::PatchDescriptor::GREGORY_BASIS) {
-                Far::internal::GetGregoryWeights(param,
-                                                 coord.s, coord.t, wP, wDs, wDt);
-                numControlVertices = 20;
-            } else if (patchType == Far::PatchDescriptor::QUADS) {
-                Far::internal::GetBilinearWeights(param,
-                                                  coord.s, coord.t, wP, wDs, wDt);
-                numControlVertices = 4;
-            } else {
-                assert(0);
-            }
-
-            const int *cvs =
-                &_patchIndexBuffer[array.indexBase + coord.handle.vertIndex];
-
-            dstT.Clear();
-            for (int j = 0; j < numControlVertices; ++j) {
-                dstT.AddWithWeight(srcT[cvs[j]], wP[j]);
-            }
-            ++dstT;
-        }
-    }
-
-    void computeWithDerivative(tbb::blocked_range<int> const &r) const {
-        float wP[20], wDs[20], wDt[20];
-        BufferAdapter<const float> srcT(_src + _srcDesc.offset,
-                                        _srcDesc.length,
-                                        _srcDesc.stride);
-        BufferAdapter<float> dstT(_dst + _dstDesc.offset
-                                       + r.begin() * _dstDesc.stride,
-                                  _dstDesc.length,
-                                  _dstDesc.stride);
-        BufferAdapter<float> dstDuT(_dstDu + _dstDuDesc.offset
-                                       + r.begin() * _dstDuDesc.stride,
-                                  _dstDuDesc.length,
-                                  _dstDuDesc.stride);
-        BufferAdapter<float> dstDvT(_dstDv + _dstDvDesc.offset
-                                       + r.begin() * _dstDvDesc.stride,
-                                  _dstDvDesc.length,
-                                  _dstDvDesc.stride);
-
-        for (int i = r.begin(); i < r.end(); ++i) {
-            PatchCoord const &coord = _patchCoords[i];
-            PatchArray const &array = _patchArrayBuffer[coord.handle.arrayIndex];
-
-            int patchType = array.GetPatchType();
-            Far::PatchParam const & param =
-                _patchParamBuffer[coord.handle.patchIndex];
-
-            int numControlVertices = 0;
-            if (patchType == Far::PatchDescriptor::REGULAR) {
-                Far::internal::GetBSplineWeights(param,
-                                                 coord.s, coord.t, wP, wDs, wDt);
-                numControlVertices = 16;
-            } else if (patchType == Far::PatchDescriptor::GREGORY_BASIS) {
-                Far::internal::GetGregoryWeights(param,
-                                                 coord.s, coord.t, wP, wDs, wDt);
-                numControlVertices = 20;
-            } else if (patchType == Far::PatchDescriptor::QUADS) {
-                Far::internal::GetBilinearWeights(param,
-                                                  coord.s, coord.t, wP, wDs, wDt);
-                numControlVertices = 4;
-            } else {
-                assert(0);
-            }
-
-            const int *cvs =
-                &_patchIndexBuffer[array.indexBase + coord.handle.vertIndex];
-
-            dstT.Clear();
-            dstDuT.Clear();
-            dstDvT.Clear();
-            for (int j = 0; j < numControlVertices; ++j) {
-                dstT.AddWithWeight(srcT[cvs[j]], wP[j]);
-                dstDuT.AddWithWeight(srcT[cvs[j]], wDs[j]);
-                dstDvT.AddWithWeight(srcT[cvs[j]], wDt[j]);
-            }
-            ++dstT;
-            ++dstDuT;
-            ++dstDvT;
-        }
+        Far::internal::StatsTimer timer(
+            _busyTimes ? &_busyTimes->local() : 0);
+
+        CpuEvalPatches(_src, _srcDesc,
+                       _dst, _dstDesc,
+                       _dstDu, _dstDuDesc,
+                       _dstDv, _dstDvDesc,
+                       _dstNormal, _dstNormalDesc,
+                       (int)r.size(), _order + r.begin(), _patchCoords,
+                       _patchArrayBuffer, _patchIndexBuffer,
+                       _patchParamBuffer);
     }
 };
 
@@ -415,22 +440,40 @@ TbbEvalPatches(float const *src, BufferDescriptor const &srcDesc,
                float *dst,       BufferDescriptor const &dstDesc,
                float *dstDu,     BufferDescriptor const &dstDuDesc,
                float *dstDv,     BufferDescriptor const &dstDvDesc,
+               float *dstNormal, BufferDescriptor const &dstNormalDesc,
                int numPatchCoords,
                const PatchCoord *patchCoords,
                const PatchArray *patchArrayBuffer,
                const int *patchIndexBuffer,
                const PatchParam *patchParamBuffer) {
 
+    if (numPatchCoords <= 0) return;
+
+    Far::internal::StatsScope stats("Osd::TbbEvaluator::EvalPatches");
+    CpuSetPatchStats(stats, numPatchCoords, patchCoords, patchArrayBuffer,
+                     srcDesc,
+                     CpuGetOutputDesc(dst, dstDesc,
+                         CpuGetOutputDesc(dstDu, dstDuDesc,
+                             CpuGetOutputDesc(dstDv, dstDvDesc,
+                                              dstNormalDesc))),
+                     CpuGetNumOutputs(dst, dstDu, dstDv, dstNormal),
+                     sizeof(float));
+    ThreadBusyTimes busyTimes(stats);
+
+    std::vector<int> order(numPatchCoords);
+    CpuBinPatchCoords(numPatchCoords, patchCoords, &order[0]);
+
     TbbEvalPatchesKernel kernel(src, srcDesc, dst, dstDesc,
                                 dstDu, dstDuDesc, dstDv, dstDvDesc,
-                                numPatchCoords, patchCoords,
+                                dstNormal, dstNormalDesc,
+                                &order[0], patchCoords,
                                 patchArrayBuffer,
                                 patchIndexBuffer,
-                                patchParamBuffer);
+                                patchParamBuffer,
+                                busyTimes.Get());
 
-    tbb::blocked_range<int> range(0, numPatchCoords, grain_size);
+    tbb::blocked_range<int> range(0, numPatchCoords, patch_grain_size);
     tbb::parallel_for(range, kernel);
-
 }
 
 }  // end namespace Osd
@@ -33,7 +33,8 @@ namespace OPENSUBDIV_VERSION {
 namespace Osd {
 
 struct PatchArray;
-struct PatchCoord;
+template <typename REAL> struct PatchCoordReal;
+typedef PatchCoordReal<float> PatchCoord;
 struct PatchParam;
 struct BufferDescriptor;
 
@@ -59,11 +60,24 @@ TbbEvalStencils(float const * src, BufferDescriptor const &srcDesc,
                 float const * dvWeights,
                 int start, int end);
 
+void
+TbbEvalStencils(int numBuffers,
+                float const * const * srcs, BufferDescriptor const * srcDescs,
+                float * const * dsts,       BufferDescriptor const * dstDescs,
+                int const * sizes,
+                int const * offsets,
+                int const * indices,
+                float const * weights,
+                int start, int end);
+
+// Evaluates the limit values and derivatives, or the unit normals instead of
+// the derivatives if dstNormal is not NULL (see CpuEvalPatchNormals())
 void
 TbbEvalPatches(float const *src, BufferDescriptor const &srcDesc,
                float *dst,       BufferDescriptor const &dstDesc,
                float *dstDu,     BufferDescriptor const &dstDuDesc,
                float *dstDv,     BufferDescriptor const &dstDvDesc,
+               float *dstNormal, BufferDescriptor const &dstNormalDesc,
                int numPatchCoords,
                const PatchCoord *patchCoords,
                const PatchArray *patchArrayBuffer,
@@ -0,0 +1,265 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../osd/threadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+namespace {
+
+// Set on threads executing chunks, so that nested ParallelFor() calls run
+// serially instead of waiting on the pool they are part of.
+thread_local bool insideTask = false;
+
+// Chunks [begin, end) owned by one thread : the owner pops from the front
+// while thieves take the back half.
+struct ChunkQueue {
+    std::mutex mutex;
+    int begin, end;
+};
+
+struct Job {
+    ThreadPool::Task const * task;
+    int begin, end, grainSize;
+    std::vector<ChunkQueue> queues;
+
+    explicit Job(int numQueues) : queues(numQueues) { }
+
+    void runChunk(int chunk) const {
+        int first = begin + chunk * grainSize,
+            last = std::min(first + grainSize, end);
+        task->Run(first, last);
+    }
+
+    bool pop(int queueIndex, int * chunk) {
+        ChunkQueue & q = queues[queueIndex];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.begin == q.end) return false;
+        *chunk = q.begin++;
+        return true;
+    }
+
+    bool steal(int queueIndex, int * chunk) {
+        int numQueues = (int)queues.size();
+        for (int i = 1; i < numQueues; ++i) {
+            ChunkQueue & victim = queues[(queueIndex + i) % numQueues];
+
+            int first, last;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                int size = victim.end - victim.begin;
+                if (size == 0) continue;
+                last = victim.end;
+                first = last - (size + 1) / 2;
+                victim.end = first;
+            }
+
+            // keep the first stolen chunk, queue the rest as our own
+            ChunkQueue & q = queues[queueIndex];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.begin = first + 1;
+            q.end = last;
+            *chunk = first;
+            return true;
+        }
+        return false;
+    }
+
+    void run(int queueIndex) {
+        insideTask = true;
+        int chunk;
+        while (pop(queueIndex, &chunk) or steal(queueIndex, &chunk)) {
+            runChunk(chunk);
+        }
+        insideTask = false;
+    }
+};
+
+}  // end anonymous namespace
+
+struct ThreadPool::Impl {
+    Impl() : numThreads(1), job(NULL), generation(0), numBusy(0),
+             stop(false) { }
+
+    void startWorkers(int count);
+    void stopWorkers();
+    void workerLoop(int queueIndex, unsigned int seen);
+
+    std::vector<std::thread> workers;
+    std::atomic<int> numThreads;      // workers + calling thread
+
+    std::mutex mutex;                 // guards the fields below
+    std::condition_variable wake,     // signals a new job or stop
+                            done;     // signals numBusy reaching 0
+    Job * job;
+    unsigned int generation;
+    int numBusy;
+    bool stop;
+
+    std::mutex jobMutex;              // serializes ParallelFor() calls
+};
+
+void
+ThreadPool::Impl::startWorkers(int count) {
+    if (count <= 0) {
+        count = (int)std::thread::hardware_concurrency();
+    }
+    // the calling thread is the first of the count
+    for (int i = 1; i < count; ++i) {
+        workers.push_back(
+            std::thread(&Impl::workerLoop, this, i, generation));
+    }
+    numThreads = (int)workers.size() + 1;
+}
+
+void
+ThreadPool::Impl::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+    workers.clear();
+    numThreads = 1;
+    stop = false;
+}
+
+void
+ThreadPool::Impl::workerLoop(int queueIndex, unsigned int seen) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        while (not stop and generation == seen) {
+            wake.wait(lock);
+        }
+        if (stop) return;
+
+        seen = generation;
+        Job * current = job;
+
+        lock.unlock();
+        current->run(queueIndex);
+        lock.lock();
+
+        if (--numBusy == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+ThreadPool::ThreadPool() : _impl(new Impl) {
+    _impl->startWorkers(0);
+}
+
+ThreadPool::~ThreadPool() {
+    _impl->stopWorkers();
+    delete _impl;
+}
+
+ThreadPool &
+ThreadPool::GetInstance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void
+ThreadPool::SetNumThreads(int numThreads) {
+    std::lock_guard<std::mutex> lock(_impl->jobMutex);
+    _impl->stopWorkers();
+    _impl->startWorkers(numThreads);
+}
+
+int
+ThreadPool::GetNumThreads() const {
+    return _impl->numThreads;
+}
+
+void
+ThreadPool::ParallelFor(int begin, int end, int grainSize, Task const & task) {
+
+    if (end <= begin) return;
+
+    grainSize = std::max(grainSize, 1);
+    int numChunks = (end - begin + grainSize - 1) / grainSize;
+
+    if (numChunks == 1 or insideTask) {
+        task.Run(begin, end);
+        return;
+    }
+
+    std::lock_guard<std::mutex> jobLock(_impl->jobMutex);
+
+    int numWorkers = (int)_impl->workers.size();
+    if (numWorkers == 0) {
+        task.Run(begin, end);
+        return;
+    }
+
+    // deal the chunks out in contiguous blocks, one per thread
+    int numQueues = numWorkers + 1;
+
+    Job job(numQueues);
+    job.task = &task;
+    job.begin = begin;
+    job.end = end;
+    job.grainSize = grainSize;
+    for (int i = 0; i < numQueues; ++i) {
+        job.queues[i].begin = (int)((long long)numChunks * i / numQueues);
+        job.queues[i].end = (int)((long long)numChunks * (i+1) / numQueues);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_impl->mutex);
+        _impl->job = &job;
+        _impl->numBusy = numWorkers;
+        ++_impl->generation;
+    }
+    _impl->wake.notify_all();
+
+    job.run(0);
+
+    // the job lives on this stack frame : wait for every worker to leave it
+    std::unique_lock<std::mutex> lock(_impl->mutex);
+    while (_impl->numBusy > 0) {
+        _impl->done.wait(lock);
+    }
+    _impl->job = NULL;
+}
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
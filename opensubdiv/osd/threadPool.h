@@ -0,0 +1,83 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OPENSUBDIV3_OSD_THREAD_POOL_H
+#define OPENSUBDIV3_OSD_THREAD_POOL_H
+
+#include "../version.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+//
+// Minimal work-stealing thread pool used by ThreadPoolEvaluator
+//
+// ParallelFor() splits a range into chunks of grainSize, hands a contiguous
+// block of chunks to each thread and lets idle threads steal half of the
+// remaining chunks of a busy one. The calling thread participates, and nested
+// calls (from inside a running task) are executed serially by the caller.
+//
+class ThreadPool {
+public:
+    class Task {
+    public:
+        virtual ~Task() { }
+
+        // Processes the sub-range [begin, end)
+        virtual void Run(int begin, int end) const = 0;
+    };
+
+    // Returns the pool shared by all the evaluations
+    static ThreadPool & GetInstance();
+
+    // Sets the number of threads, including the calling thread (<= 0 for the
+    // number of hardware threads)
+    void SetNumThreads(int numThreads);
+
+    int GetNumThreads() const;
+
+    void ParallelFor(int begin, int end, int grainSize, Task const & task);
+
+private:
+    ThreadPool();
+    ~ThreadPool();
+
+    // non-copyable
+    ThreadPool(ThreadPool const &);
+    ThreadPool & operator=(ThreadPool const &);
+
+    struct Impl;
+    Impl * _impl;
+};
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OPENSUBDIV3_OSD_THREAD_POOL_H
@@ -0,0 +1,562 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../osd/threadPoolEvaluator.h"
+#include "../osd/threadPool.h"
+#include "../osd/cpuKernel.h"
+#include "../far/stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+// Minimum number of patch coordinates evaluated by each task : the CPU patch
+// kernel bins the coordinates of a task by patch, so tasks should be large
+// enough to expose some reuse.
+static const int patchGrainSize = 256;
+
+namespace {
+
+// Adds the time spent in a task to a shared counter, in nanoseconds, when the
+// call is measured (see Far::SetStatsCallback())
+class BusyTimer {
+public:
+    explicit BusyTimer(std::atomic<long long> * busyTime) :
+        _busyTime(busyTime),
+        _start(busyTime ? Far::internal::GetStatsTime() : 0.0) { }
+
+    ~BusyTimer() {
+        if (_busyTime) {
+            *_busyTime += (long long)(
+                1e9 * (Far::internal::GetStatsTime() - _start));
+        }
+    }
+
+private:
+    std::atomic<long long> * _busyTime;
+    double _start;
+};
+
+class StencilTask : public ThreadPool::Task {
+public:
+    StencilTask(float const * src, BufferDescriptor const &srcDesc,
+                float * dst,       BufferDescriptor const &dstDesc,
+                float * du,        BufferDescriptor const &duDesc,
+                float * dv,        BufferDescriptor const &dvDesc,
+                int const * sizes, int const * offsets, int const * indices,
+                float const * weights,
+                float const * duWeights,
+                float const * dvWeights,
+                int start, int end, int numPartitions,
+                std::atomic<long long> * busyTime) :
+        _src(src), _srcDesc(srcDesc),
+        _dst(dst), _dstDesc(dstDesc),
+        _du(du), _duDesc(duDesc),
+        _dv(dv), _dvDesc(dvDesc),
+        _sizes(sizes), _offsets(offsets), _indices(indices),
+        _weights(weights), _duWeights(duWeights), _dvWeights(dvWeights),
+        _start(start), _end(end), _numPartitions(numPartitions),
+        _busyTime(busyTime) { }
+
+    // Evaluates the partitions [begin, end) of the stencil range
+    virtual void Run(int begin, int end) const {
+        BusyTimer timer(_busyTime);
+        for (int partition = begin; partition < end; ++partition) {
+
+            int first = CpuGetStencilPartitionStart(_sizes, _offsets,
+                    _start, _end, partition, _numPartitions),
+                last = CpuGetStencilPartitionStart(_sizes, _offsets,
+                    _start, _end, partition+1, _numPartitions);
+
+            if (first < last) {
+                evalStencils(first, last);
+            }
+        }
+    }
+
+private:
+    void evalStencils(int begin, int end) const {
+        if (_du or _dv) {
+            CpuEvalStencils(_src, _srcDesc,
+                            _dst, _dstDesc,
+                            _du,  _duDesc,
+                            _dv,  _dvDesc,
+                            _sizes, _offsets, _indices,
+                            _weights, _duWeights, _dvWeights,
+                            begin, end);
+        } else {
+            CpuEvalStencils(_src, _srcDesc,
+                            _dst, _dstDesc,
+                            _sizes, _offsets, _indices, _weights,
+                            begin, end);
+        }
+    }
+
+    float const * _src;
+    BufferDescriptor _srcDesc;
+    float * _dst;
+    BufferDescriptor _dstDesc;
+    float * _du;
+    BufferDescriptor _duDesc;
+    float * _dv;
+    BufferDescriptor _dvDesc;
+    int const * _sizes;
+    int const * _offsets;
+    int const * _indices;
+    float const * _weights;
+    float const * _duWeights;
+    float const * _dvWeights;
+    int _start;
+    int _end;
+    int _numPartitions;
+    std::atomic<long long> * _busyTime;
+};
+
+class MultiStencilTask : public ThreadPool::Task {
+public:
+    MultiStencilTask(int numBuffers,
+                     float const * const * srcs,
+                     BufferDescriptor const * srcDescs,
+                     float * const * dsts,
+                     BufferDescriptor const * dstDescs,
+                     int const * sizes, int const * offsets,
+                     int const * indices, float const * weights,
+                     int start, int end, int numPartitions,
+                     std::atomic<long long> * busyTime) :
+        _numBuffers(numBuffers),
+        _srcs(srcs), _srcDescs(srcDescs),
+        _dsts(dsts), _dstDescs(dstDescs),
+        _sizes(sizes), _offsets(offsets), _indices(indices),
+        _weights(weights),
+        _start(start), _end(end), _numPartitions(numPartitions),
+        _busyTime(busyTime) { }
+
+    // Evaluates the partitions [begin, end) of the stencil range
+    virtual void Run(int begin, int end) const {
+        BusyTimer timer(_busyTime);
+        for (int partition = begin; partition < end; ++partition) {
+
+            int first = CpuGetStencilPartitionStart(_sizes, _offsets,
+                    _start, _end, partition, _numPartitions),
+                last = CpuGetStencilPartitionStart(_sizes, _offsets,
+                    _start, _end, partition+1, _numPartitions);
+
+            if (first < last) {
+                CpuEvalStencils(_numBuffers, _srcs, _srcDescs,
+                                _dsts, _dstDescs,
+                                _sizes, _offsets, _indices, _weights,
+                                first, last);
+            }
+        }
+    }
+
+private:
+    int _numBuffers;
+    float const * const * _srcs;
+    BufferDescriptor const * _srcDescs;
+    float * const * _dsts;
+    BufferDescriptor const * _dstDescs;
+    int const * _sizes;
+    int const * _offsets;
+    int const * _indices;
+    float const * _weights;
+    int _start;
+    int _end;
+    int _numPartitions;
+    std::atomic<long long> * _busyTime;
+};
+
+class PatchTask : public ThreadPool::Task {
+public:
+    PatchTask(float const * src, BufferDescriptor const &srcDesc,
+              float * dst,       BufferDescriptor const &dstDesc,
+              float * du,        BufferDescriptor const &duDesc,
+              float * dv,        BufferDescriptor const &dvDesc,
+              float * normal,    BufferDescriptor const &normalDesc,
+              int const * order,
+              PatchCoord const * patchCoords,
+              PatchArray const * patchArrays,
+              int const * patchIndexBuffer,
+              PatchParam const * patchParamBuffer,
+              std::atomic<long long> * busyTime) :
+        _src(src), _srcDesc(srcDesc),
+        _dst(dst), _dstDesc(dstDesc),
+        _du(du), _duDesc(duDesc),
+        _dv(dv), _dvDesc(dvDesc),
+        _normal(normal), _normalDesc(normalDesc),
+        _order(order), _patchCoords(patchCoords), _patchArrays(patchArrays),
+        _patchIndexBuffer(patchIndexBuffer),
+        _patchParamBuffer(patchParamBuffer),
+        _busyTime(busyTime),
+        _failed(false) { }
+
+    virtual void Run(int begin, int end) const {
+        BusyTimer timer(_busyTime);
+        if (not CpuEvalPatches(_src, _srcDesc,
+                               _dst, _dstDesc,
+                               _du,  _duDesc,
+                               _dv,  _dvDesc,
+                               _normal, _normalDesc,
+                               end - begin, _order + begin, _patchCoords,
+                               _patchArrays, _patchIndexBuffer,
+                               _patchParamBuffer)) {
+            _failed = true;
+        }
+    }
+
+    bool Failed() const { return _failed; }
+
+private:
+    float const * _src;
+    BufferDescriptor _srcDesc;
+    float * _dst;
+    BufferDescriptor _dstDesc;
+    float * _du;
+    BufferDescriptor _duDesc;
+    float * _dv;
+    BufferDescriptor _dvDesc;
+    float * _normal;
+    BufferDescriptor _normalDesc;
+    int const * _order;
+    PatchCoord const * _patchCoords;
+    PatchArray const * _patchArrays;
+    int const * _patchIndexBuffer;
+    PatchParam const * _patchParamBuffer;
+    std::atomic<long long> * _busyTime;
+
+    mutable std::atomic<bool> _failed;
+};
+
+}  // end anonymous namespace
+
+static bool
+evalPatches(float const * src, BufferDescriptor const &srcDesc,
+            float * dst,       BufferDescriptor const &dstDesc,
+            float * du,        BufferDescriptor const &duDesc,
+            float * dv,        BufferDescriptor const &dvDesc,
+            float * normal,    BufferDescriptor const &normalDesc,
+            int numPatchCoords,
+            PatchCoord const * patchCoords,
+            PatchArray const * patchArrays,
+            int const * patchIndexBuffer,
+            PatchParam const * patchParamBuffer) {
+
+    if (numPatchCoords <= 0) return true;
+
+    Far::internal::StatsScope stats("Osd::ThreadPoolEvaluator::EvalPatches");
+    CpuSetPatchStats(stats, numPatchCoords, patchCoords, patchArrays,
+                     srcDesc,
+                     CpuGetOutputDesc(dst, dstDesc,
+                         CpuGetOutputDesc(du, duDesc,
+                             CpuGetOutputDesc(dv, dvDesc, normalDesc))),
+                     CpuGetNumOutputs(dst, du, dv, normal), sizeof(float));
+    std::atomic<long long> busyTime(0);
+
+    // the coordinates are binned by patch once, and the tasks evaluate
+    // ranges of the binned order
+    std::vector<int> order(numPatchCoords);
+    CpuBinPatchCoords(numPatchCoords, patchCoords, &order[0]);
+
+    ThreadPool & pool = ThreadPool::GetInstance();
+
+    // a few tasks per thread so that stealing can even out the load
+    int grainSize = std::max(patchGrainSize,
+                             numPatchCoords / (4 * pool.GetNumThreads()));
+
+    PatchTask task(src, srcDesc, dst, dstDesc, du, duDesc, dv, dvDesc,
+                   normal, normalDesc, &order[0], patchCoords, patchArrays,
+                   patchIndexBuffer, patchParamBuffer,
+                   stats.IsEnabled() ? &busyTime : NULL);
+
+    pool.ParallelFor(0, numPatchCoords, grainSize, task);
+
+    stats.SetThreads(std::min(pool.GetNumThreads(),
+                         (numPatchCoords + grainSize - 1) / grainSize),
+                     1e-9 * (double)busyTime);
+
+    return not task.Failed();
+}
+
+/* static */
+bool
+ThreadPoolEvaluator::EvalStencils(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    const int * sizes,
+    const int * offsets,
+    const int * indices,
+    const float * weights,
+    int start, int end) {
+
+    if (end <= start) return true;
+    if (srcDesc.length != dstDesc.length) return false;
+
+    start = std::max(start, 0);
+
+    // partitions hold the same number of weights
+    ThreadPool & pool = ThreadPool::GetInstance();
+    int numPartitions = CpuGetNumStencilPartitions(
+        sizes, offsets, start, end, pool.GetNumThreads());
+
+    Far::internal::StatsScope stats("Osd::ThreadPoolEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end,
+                       srcDesc, dstDesc, 1, sizeof(float));
+    std::atomic<long long> busyTime(0);
+
+    StencilTask task(src, srcDesc,
+                     dst, dstDesc,
+                     NULL, BufferDescriptor(),
+                     NULL, BufferDescriptor(),
+                     sizes, offsets, indices,
+                     weights, NULL, NULL,
+                     start, end, numPartitions,
+                     stats.IsEnabled() ? &busyTime : NULL);
+
+    pool.ParallelFor(0, numPartitions, 1, task);
+
+    stats.SetThreads(std::min(pool.GetNumThreads(), numPartitions),
+                     1e-9 * (double)busyTime);
+
+    return true;
+}
+
+/* static */
+bool
+ThreadPoolEvaluator::EvalStencils(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    float *du,        BufferDescriptor const &duDesc,
+    float *dv,        BufferDescriptor const &dvDesc,
+    const int * sizes,
+    const int * offsets,
+    const int * indices,
+    const float * weights,
+    const float * duWeights,
+    const float * dvWeights,
+    int start, int end) {
+
+    if (end <= start) return true;
+    if (srcDesc.length != dstDesc.length) return false;
+    if (srcDesc.length != duDesc.length) return false;
+    if (srcDesc.length != dvDesc.length) return false;
+    if ((du and not duWeights) or (dv and not dvWeights)) return false;
+
+    start = std::max(start, 0);
+
+    ThreadPool & pool = ThreadPool::GetInstance();
+    int numPartitions = CpuGetNumStencilPartitions(
+        sizes, offsets, start, end, pool.GetNumThreads());
+
+    Far::internal::StatsScope stats("Osd::ThreadPoolEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end, srcDesc,
+                       CpuGetOutputDesc(dst, dstDesc,
+                                        CpuGetOutputDesc(du, duDesc, dvDesc)),
+                       CpuGetNumOutputs(dst, du, dv), sizeof(float));
+    std::atomic<long long> busyTime(0);
+
+    StencilTask task(src, srcDesc,
+                     dst, dstDesc,
+                     du,  duDesc,
+                     dv,  dvDesc,
+                     sizes, offsets, indices,
+                     weights, duWeights, dvWeights,
+                     start, end, numPartitions,
+                     stats.IsEnabled() ? &busyTime : NULL);
+
+    pool.ParallelFor(0, numPartitions, 1, task);
+
+    stats.SetThreads(std::min(pool.GetNumThreads(), numPartitions),
+                     1e-9 * (double)busyTime);
+
+    return true;
+}
+
+/* static */
+bool
+ThreadPoolEvaluator::EvalStencils(
+    int numBuffers,
+    const float * const *srcs, BufferDescriptor const *srcDescs,
+    float * const *dsts,       BufferDescriptor const *dstDescs,
+    const int * sizes,
+    const int * offsets,
+    const int * indices,
+    const float * weights,
+    int start, int end) {
+
+    if (end <= start) return true;
+    for (int i = 0; i < numBuffers; ++i) {
+        if (srcDescs[i].length != dstDescs[i].length) return false;
+    }
+
+    start = std::max(start, 0);
+
+    ThreadPool & pool = ThreadPool::GetInstance();
+    int numPartitions = CpuGetNumStencilPartitions(
+        sizes, offsets, start, end, pool.GetNumThreads());
+
+    Far::internal::StatsScope stats("Osd::ThreadPoolEvaluator::EvalStencils");
+    CpuSetStencilStats(stats, sizes, offsets, start, end,
+                       numBuffers, srcDescs, dstDescs, sizeof(float));
+    std::atomic<long long> busyTime(0);
+
+    MultiStencilTask task(numBuffers, srcs, srcDescs, dsts, dstDescs,
+                          sizes, offsets, indices, weights,
+                          start, end, numPartitions,
+                          stats.IsEnabled() ? &busyTime : NULL);
+
+    pool.ParallelFor(0, numPartitions, 1, task);
+
+    stats.SetThreads(std::min(pool.GetNumThreads(), numPartitions),
+                     1e-9 * (double)busyTime);
+
+    return true;
+}
+
+/* static */
+bool
+ThreadPoolEvaluator::EvalPatches(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    int numPatchCoords,
+    const PatchCoord *patchCoords,
+    const PatchArray *patchArrays,
+    const int *patchIndexBuffer,
+    const PatchParam *patchParamBuffer) {
+
+    if (not src or not dst) return false;
+    if (srcDesc.length != dstDesc.length) return false;
+
+    return evalPatches(src, srcDesc,
+                       dst, dstDesc,
+                       NULL, BufferDescriptor(),
+                       NULL, BufferDescriptor(),
+                       NULL, BufferDescriptor(),
+                       numPatchCoords, patchCoords,
+                       patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+/* static */
+bool
+ThreadPoolEvaluator::EvalPatches(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    float *du,        BufferDescriptor const &duDesc,
+    float *dv,        BufferDescriptor const &dvDesc,
+    int numPatchCoords,
+    const PatchCoord *patchCoords,
+    const PatchArray *patchArrays,
+    const int *patchIndexBuffer,
+    const PatchParam *patchParamBuffer) {
+
+    if (not src) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (du  and srcDesc.length != duDesc.length)  return false;
+    if (dv  and srcDesc.length != dvDesc.length)  return false;
+
+    return evalPatches(src, srcDesc,
+                       dst, dstDesc,
+                       du,  duDesc,
+                       dv,  dvDesc,
+                       NULL, BufferDescriptor(),
+                       numPatchCoords, patchCoords,
+                       patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+/* static */
+bool
+ThreadPoolEvaluator::EvalPatchNormals(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    float *normal,    BufferDescriptor const &normalDesc,
+    int numPatchCoords,
+    const PatchCoord *patchCoords,
+    const PatchArray *patchArrays,
+    const int *patchIndexBuffer,
+    const PatchParam *patchParamBuffer) {
+
+    if (not src or not normal) return false;
+    if (dst and srcDesc.length != dstDesc.length) return false;
+    if (srcDesc.length < 3 or normalDesc.length != 3) return false;
+
+    return evalPatches(src, srcDesc,
+                       dst, dstDesc,
+                       NULL, BufferDescriptor(),
+                       NULL, BufferDescriptor(),
+                       normal, normalDesc,
+                       numPatchCoords, patchCoords,
+                       patchArrays, patchIndexBuffer, patchParamBuffer);
+}
+
+/* static */
+AsyncEvaluation
+ThreadPoolEvaluator::EvalStencilsAsync(
+    const float *src, BufferDescriptor const &srcDesc,
+    float *dst,       BufferDescriptor const &dstDesc,
+    const int * sizes,
+    const int * offsets,
+    const int * indices,
+    const float * weights,
+    int start, int end) {
+
+    // measures the launch only : the evaluation itself is measured by
+    // EvalStencils(), on the thread of the dispatcher
+    Far::internal::StatsScope stats(
+        "Osd::ThreadPoolEvaluator::EvalStencilsAsync");
+    if (stats.IsEnabled() and end > start) {
+        stats.SetCounts(end - start, 0, 0, 0);
+    }
+
+    return AsyncEvaluation::Launch(new AsyncEvalStencilsTask<ThreadPoolEvaluator>(
+        src, srcDesc, dst, dstDesc,
+        sizes, offsets, indices, weights, start, end));
+}
+
+/* static */
+void
+ThreadPoolEvaluator::Synchronize(void * /*deviceContext*/) {
+    // synchronous evaluations return once all the tasks are complete
+    AsyncEvaluation::WaitAll();
+}
+
+/* static */
+void
+ThreadPoolEvaluator::SetNumThreads(int numThreads) {
+    ThreadPool::GetInstance().SetNumThreads(numThreads);
+}
+
+/* static */
+int
+ThreadPoolEvaluator::GetNumThreads() {
+    return ThreadPool::GetInstance().GetNumThreads();
+}
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
@@ -37,8 +37,14 @@ namespace Osd {
 ///
 ///  XXX: this class may be moved into Far
 ///
-struct PatchCoord {
-    // 5-ints struct.
+/// The parametric location is held in the precision of the evaluation :
+/// PatchCoord (single precision) is the one used by all the evaluators, the
+/// double precision evaluation of the CpuEvaluator takes
+/// PatchCoordReal<double>.
+///
+template <typename REAL>
+struct PatchCoordReal {
+    // 5-ints struct (single precision).
 
     /// \brief Constructor
     ///
@@ -48,19 +54,22 @@ struct PatchCoord {
     ///
     /// @param tArg         parametric location on the patch
     ///
-    PatchCoord(Far::PatchTable::PatchHandle handleArg, float sArg, float tArg) :
+    PatchCoordReal(Far::PatchTable::PatchHandle handleArg,
+                   REAL sArg, REAL tArg) :
         handle(handleArg), s(sArg), t(tArg) { }
 
-    PatchCoord() : s(0), t(0) {
+    PatchCoordReal() : s(0), t(0) {
         handle.arrayIndex = 0;
         handle.patchIndex = 0;
         handle.vertIndex = 0;
     }
 
     Far::PatchTable::PatchHandle handle; ///< patch handle
-    float s, t;              ///< parametric location on patch
+    REAL s, t;               ///< parametric location on patch
 };
 
+typedef PatchCoordReal<float> PatchCoord;
+
 struct PatchArray {
     // 4-ints struct.
     PatchArray(Far::PatchDescriptor desc_in, int numPatches_in,
@@ -98,6 +107,21 @@ struct PatchParam : public Far::PatchParam {
 typedef std::vector<PatchArray> PatchArrayVector;
 typedef std::vector<PatchParam> PatchParamVector;
 
+/// \brief Returns the stencil weights of a table, or NULL if it has none
+///
+/// The stencil tables hold their weights in vectors, the stencil table views
+/// (see Far::StencilTableViewReal) as pointers, NULL when missing.
+///
+template <typename REAL>
+inline REAL const * GetStencilWeights(std::vector<REAL> const & weights) {
+    return weights.empty() ? NULL : &weights[0];
+}
+
+template <typename REAL>
+inline REAL const * GetStencilWeights(REAL const * weights) {
+    return weights;
+}
+
 }  // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
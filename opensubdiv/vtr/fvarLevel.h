@@ -234,7 +234,21 @@ public:
     void print() const;
     void buildFaceVertexSiblingsFromVertexFaceSiblings(std::vector<Sibling>& fvSiblings) const;
 
+    //  Reads or writes all members with an archive (see serialization.h) -- a
+    //  const FVarLevel is only written:
+    template <class ARCHIVE>
+    void serialize(ARCHIVE & archive);
+    template <class ARCHIVE>
+    void serialize(ARCHIVE & archive) const;
+
+    //  Returns true if the values and indices read by serialize() are within
+    //  those of the channel and of its Level (see serialization.h):
+    bool hasValidIndices() const;
+
 private:
+    template <class ARCHIVE, class FVAR_LEVEL>
+    static void serializeMembers(ARCHIVE & archive, FVAR_LEVEL & fvarLevel);
+
     //  Just as Refinements build Levels, FVarRefinements build FVarLevels...
     friend class FVarRefinement;
 
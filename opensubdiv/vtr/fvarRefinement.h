@@ -69,6 +69,17 @@ public:
                               Index cVert, LocalIndex cSibling) const;
 
 
+    //  Reads or writes all members with an archive (see serialization.h) -- a
+    //  const FVarRefinement is only written:
+    template <class ARCHIVE>
+    void serialize(ARCHIVE & archive);
+    template <class ARCHIVE>
+    void serialize(ARCHIVE & archive) const;
+
+    //  Returns true if the parent sources read by serialize() match the values
+    //  of the child channel (see serialization.h):
+    bool hasValidIndices() const;
+
     //  Modifiers supporting application of the refinement:
     void applyRefinement();
 
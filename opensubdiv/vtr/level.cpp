@@ -73,6 +73,41 @@ Level::~Level() {
     }
 }
 
+namespace {
+    template <typename T>
+    void
+    applyToVector(Level::ArrayFunction function, std::vector<T> const & v) {
+        if (!v.empty()) {
+            function(&v[0], v.size() * sizeof(T));
+        }
+    }
+}
+
+void
+Level::applyToArrays(ArrayFunction function) const {
+
+    applyToVector(function, _faceVertCountsAndOffsets);
+    applyToVector(function, _faceVertIndices);
+    applyToVector(function, _faceEdgeIndices);
+    applyToVector(function, _faceTags);
+
+    applyToVector(function, _edgeVertIndices);
+    applyToVector(function, _edgeFaceCountsAndOffsets);
+    applyToVector(function, _edgeFaceIndices);
+    applyToVector(function, _edgeFaceLocalIndices);
+    applyToVector(function, _edgeSharpness);
+    applyToVector(function, _edgeTags);
+
+    applyToVector(function, _vertFaceCountsAndOffsets);
+    applyToVector(function, _vertFaceIndices);
+    applyToVector(function, _vertFaceLocalIndices);
+    applyToVector(function, _vertEdgeCountsAndOffsets);
+    applyToVector(function, _vertEdgeIndices);
+    applyToVector(function, _vertEdgeLocalIndices);
+    applyToVector(function, _vertSharpness);
+    applyToVector(function, _vertTags);
+}
+
 
 char const *
 Level::getTopologyErrorString(TopologyError errCode) {
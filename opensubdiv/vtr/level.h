@@ -395,7 +395,28 @@ public:
 
     IndexArray shareFaceVertCountsAndOffsets() const;
 
+    //  Invokes a function on the storage of each of the topology vectors, e.g. to
+    //  advise the memory system of large arrays:
+    typedef void (*ArrayFunction)(void const * data, size_t size);
+
+    void applyToArrays(ArrayFunction function) const;
+
+    //  Reads or writes all members, including the face-varying channels, with an
+    //  archive of the client (see serialization.h) -- a const Level is only
+    //  written:
+    template <class ARCHIVE>
+    void serialize(ARCHIVE & archive);
+    template <class ARCHIVE>
+    void serialize(ARCHIVE & archive) const;
+
+    //  Returns true if the indices of the members read by serialize() refer to
+    //  components of the Level (see serialization.h):
+    bool hasValidIndices() const;
+
 private:
+    template <class ARCHIVE, class LEVEL>
+    static void serializeMembers(ARCHIVE & archive, LEVEL & level);
+
     //  Refinement classes (including all subclasses) build a Level:
     friend class Refinement;
     friend class TriRefinement;
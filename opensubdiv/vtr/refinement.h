@@ -122,6 +122,18 @@ public:
 
     bool hasFaceVerticesFirst() const { return _faceVertsFirst; }
 
+    //  Reads or writes all members, including the face-varying channels, with an
+    //  archive (see serialization.h) -- the parent and child Levels are expected
+    //  to have been read first, and a const Refinement is only written:
+    template <class ARCHIVE>
+    void serialize(ARCHIVE & archive);
+    template <class ARCHIVE>
+    void serialize(ARCHIVE & archive) const;
+
+    //  Returns true if the indices read by serialize() refer to components of
+    //  the parent and child Levels (see serialization.h):
+    bool hasValidIndices() const;
+
 public:
     //
     //  Access to members -- some testing classes (involving vertex interpolation)
@@ -320,6 +332,9 @@ public:
     void subdivideFVarChannels();
 
 protected:
+    template <class ARCHIVE, class REFINEMENT>
+    static void serializeMembers(ARCHIVE & archive, REFINEMENT & refinement);
+
     // A debug method of Level prints a Refinement (should really change this)
     friend void Level::print(const Refinement *) const;
 
@@ -0,0 +1,546 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OPENSUBDIV3_VTR_SERIALIZATION_H
+#define OPENSUBDIV3_VTR_SERIALIZATION_H
+
+#include "../version.h"
+
+#include "../vtr/level.h"
+#include "../vtr/fvarLevel.h"
+#include "../vtr/refinement.h"
+#include "../vtr/fvarRefinement.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Vtr {
+namespace internal {
+
+//
+//  Serialization of the refined topology:
+//      The serialize() methods of Level, Refinement and their face-varying
+//  counterparts visit all of their members with an archive, which either reads
+//  or writes them -- the same method supporting both directions keeps the two
+//  in sync.  The archive is a class of the client that provides:
+//
+//      bool isReading() const;
+//      template <class T> void value(T & value);
+//      template <class T> void array(std::vector<T> & values);
+//
+//  Archives that only write may take const references instead, so that const
+//  objects can be written through the const serialize() methods.
+//
+//  Values and arrays are visited in a fixed order, and the tags and other small
+//  types are copied as raw bytes, so a serialized hierarchy is only meant to be
+//  read back by a library of the same serialization layout (see
+//  getSerializationLayout()) on the same architecture.
+//
+//  Levels are expected to be read before the Refinements between them, and a
+//  Refinement to be constructed before its child Level is read (construction
+//  assigns the depth of the child).  The indices read are not trusted : they
+//  are checked with the hasValidIndices() methods before the topology is used.
+//
+
+//
+//  Returns a stamp of the serialized layout, to be recorded with the archive
+//  and matched when reading it back :  the version of the serialize() methods,
+//  incremented by any change to the members they visit, and the sizes of the
+//  types copied as raw bytes.
+//
+inline unsigned int
+getSerializationLayout() {
+
+    static const unsigned int version = 1;
+
+    return version |
+           ((unsigned int)sizeof(Index)                       <<  4) |
+           ((unsigned int)sizeof(LocalIndex)                  <<  8) |
+           ((unsigned int)sizeof(Level::VTag)                 << 12) |
+           ((unsigned int)sizeof(Level::ETag)                 << 16) |
+           ((unsigned int)sizeof(Level::FTag)                 << 20) |
+           ((unsigned int)sizeof(FVarLevel::ValueTag)         << 24) |
+           ((unsigned int)sizeof(FVarLevel::CreaseEndPair)    << 28);
+}
+
+//
+//  The objects being read are modified beyond their members (e.g. to create
+//  their face-varying channels) -- const objects are only written, so their
+//  read target is NULL and never used:
+//
+template <class T>
+inline T * readTarget(T & object) { return &object; }
+
+template <class T>
+inline T * readTarget(T const &) { return 0; }
+
+template <class ARCHIVE>
+void
+Level::serialize(ARCHIVE & archive) {
+    serializeMembers(archive, *this);
+}
+
+template <class ARCHIVE>
+void
+Level::serialize(ARCHIVE & archive) const {
+    serializeMembers(archive, *this);
+}
+
+template <class ARCHIVE, class LEVEL>
+void
+Level::serializeMembers(ARCHIVE & archive, LEVEL & level) {
+
+    archive.value(level._faceCount);
+    archive.value(level._edgeCount);
+    archive.value(level._vertCount);
+    archive.value(level._depth);
+    archive.value(level._maxEdgeFaces);
+    archive.value(level._maxValence);
+
+    archive.array(level._faceVertCountsAndOffsets);
+    archive.array(level._faceVertIndices);
+    archive.array(level._faceEdgeIndices);
+    archive.array(level._faceTags);
+
+    archive.array(level._edgeVertIndices);
+    archive.array(level._edgeFaceCountsAndOffsets);
+    archive.array(level._edgeFaceIndices);
+    archive.array(level._edgeFaceLocalIndices);
+    archive.array(level._edgeSharpness);
+    archive.array(level._edgeTags);
+
+    archive.array(level._vertFaceCountsAndOffsets);
+    archive.array(level._vertFaceIndices);
+    archive.array(level._vertFaceLocalIndices);
+    archive.array(level._vertEdgeCountsAndOffsets);
+    archive.array(level._vertEdgeIndices);
+    archive.array(level._vertEdgeLocalIndices);
+    archive.array(level._vertSharpness);
+    archive.array(level._vertTags);
+
+    int numChannels = (int)level._fvarChannels.size();
+    archive.value(numChannels);
+
+    if (archive.isReading()) {
+        Level * target = readTarget(level);
+        assert(target and target->_fvarChannels.empty());
+        for (int i = 0; i < numChannels; ++i) {
+            target->_fvarChannels.push_back(new FVarLevel(*target));
+        }
+    }
+    for (int i = 0; i < numChannels; ++i) {
+        level._fvarChannels[i]->serialize(archive);
+    }
+}
+
+template <class ARCHIVE>
+void
+FVarLevel::serialize(ARCHIVE & archive) {
+    serializeMembers(archive, *this);
+}
+
+template <class ARCHIVE>
+void
+FVarLevel::serialize(ARCHIVE & archive) const {
+    serializeMembers(archive, *this);
+}
+
+template <class ARCHIVE, class FVAR_LEVEL>
+void
+FVarLevel::serializeMembers(ARCHIVE & archive, FVAR_LEVEL & fvarLevel) {
+
+    //  The options are visited field by field, as the unused bits of their
+    //  bitfields are undefined:
+    Sdc::Options const & options = fvarLevel._options;
+
+    int vtxBoundaryInterpolation  = options.GetVtxBoundaryInterpolation(),
+        fvarLinearInterpolation   = options.GetFVarLinearInterpolation(),
+        creasingMethod            = options.GetCreasingMethod(),
+        triangleSubdivision       = options.GetTriangleSubdivision();
+
+    archive.value(vtxBoundaryInterpolation);
+    archive.value(fvarLinearInterpolation);
+    archive.value(creasingMethod);
+    archive.value(triangleSubdivision);
+
+    if (archive.isReading()) {
+        Sdc::Options & target = readTarget(fvarLevel)->_options;
+        target.SetVtxBoundaryInterpolation(
+            (Sdc::Options::VtxBoundaryInterpolation)vtxBoundaryInterpolation);
+        target.SetFVarLinearInterpolation(
+            (Sdc::Options::FVarLinearInterpolation)fvarLinearInterpolation);
+        target.SetCreasingMethod(
+            (Sdc::Options::CreasingMethod)creasingMethod);
+        target.SetTriangleSubdivision(
+            (Sdc::Options::TriangleSubdivision)triangleSubdivision);
+    }
+
+    archive.value(fvarLevel._isLinear);
+    archive.value(fvarLevel._hasLinearBoundaries);
+    archive.value(fvarLevel._hasDependentSharpness);
+    archive.value(fvarLevel._valueCount);
+
+    archive.array(fvarLevel._faceVertValues);
+    archive.array(fvarLevel._edgeTags);
+
+    archive.array(fvarLevel._vertSiblingCounts);
+    archive.array(fvarLevel._vertSiblingOffsets);
+    archive.array(fvarLevel._vertFaceSiblings);
+
+    archive.array(fvarLevel._vertValueIndices);
+    archive.array(fvarLevel._vertValueTags);
+    archive.array(fvarLevel._vertValueCreaseEnds);
+}
+
+template <class ARCHIVE>
+void
+Refinement::serialize(ARCHIVE & archive) {
+    serializeMembers(archive, *this);
+}
+
+template <class ARCHIVE>
+void
+Refinement::serialize(ARCHIVE & archive) const {
+    serializeMembers(archive, *this);
+}
+
+template <class ARCHIVE, class REFINEMENT>
+void
+Refinement::serializeMembers(ARCHIVE & archive, REFINEMENT & refinement) {
+
+    archive.value(refinement._uniform);
+    archive.value(refinement._faceVertsFirst);
+
+    archive.value(refinement._childFaceFromFaceCount);
+    archive.value(refinement._childEdgeFromFaceCount);
+    archive.value(refinement._childEdgeFromEdgeCount);
+    archive.value(refinement._childVertFromFaceCount);
+    archive.value(refinement._childVertFromEdgeCount);
+    archive.value(refinement._childVertFromVertCount);
+
+    archive.value(refinement._firstChildFaceFromFace);
+    archive.value(refinement._firstChildEdgeFromFace);
+    archive.value(refinement._firstChildEdgeFromEdge);
+    archive.value(refinement._firstChildVertFromFace);
+    archive.value(refinement._firstChildVertFromEdge);
+    archive.value(refinement._firstChildVertFromVert);
+
+    //  The counts and offsets of the child faces and edges of parent faces are
+    //  shared with the parent Level (or local to the subclass), so they are
+    //  restored by the subclass rather than read:
+    if (archive.isReading()) {
+        readTarget(refinement)->allocateParentChildIndices();
+    }
+
+    archive.array(refinement._faceChildFaceIndices);
+    archive.array(refinement._faceChildEdgeIndices);
+    archive.array(refinement._faceChildVertIndex);
+
+    archive.array(refinement._edgeChildEdgeIndices);
+    archive.array(refinement._edgeChildVertIndex);
+
+    archive.array(refinement._vertChildVertIndex);
+
+    archive.array(refinement._childFaceParentIndex);
+    archive.array(refinement._childEdgeParentIndex);
+    archive.array(refinement._childVertexParentIndex);
+
+    archive.array(refinement._childFaceTag);
+    archive.array(refinement._childEdgeTag);
+    archive.array(refinement._childVertexTag);
+
+    archive.array(refinement._parentFaceTag);
+    archive.array(refinement._parentEdgeTag);
+    archive.array(refinement._parentVertexTag);
+
+    //  One FVarRefinement exists for each face-varying channel of the parent:
+    int numChannels = refinement._parent->getNumFVarChannels();
+
+    if (archive.isReading()) {
+        Refinement * target = readTarget(refinement);
+        assert(target->_fvarChannels.empty());
+        assert(target->_child->getNumFVarChannels() == numChannels);
+        for (int i = 0; i < numChannels; ++i) {
+            target->_fvarChannels.push_back(new FVarRefinement(*target,
+                *target->_parent->_fvarChannels[i],
+                *target->_child->_fvarChannels[i]));
+        }
+    }
+    for (int i = 0; i < numChannels; ++i) {
+        refinement._fvarChannels[i]->serialize(archive);
+    }
+}
+
+template <class ARCHIVE>
+void
+FVarRefinement::serialize(ARCHIVE & archive) {
+    archive.array(_childValueParentSource);
+}
+
+template <class ARCHIVE>
+void
+FVarRefinement::serialize(ARCHIVE & archive) const {
+    archive.array(_childValueParentSource);
+}
+
+//
+//  Validation of the indices read:
+//      Components are referred to by the indices of the arrays, and the arrays
+//  by the counts and offsets of the components -- each must lie within the
+//  inventory of the Levels.  Relations that were not generated (e.g. in the
+//  last Level of a uniform refinement) are left empty.  The topology itself
+//  (e.g. the consistency of the relations with one another) is not checked.
+//
+namespace serialization {
+
+    //  Returns true if the indices (or INDEX_INVALID when sparse) are in the
+    //  range [0, size):
+    template <class ARRAY>
+    inline bool
+    areIndicesInRange(ARRAY const & indices, int size, bool sparse = false) {
+        for (int i = 0; i < (int)indices.size(); ++i) {
+            if ((indices[i] < 0 or indices[i] >= size) and
+                    not (sparse and indices[i] == INDEX_INVALID)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //  Returns true if the count and offset pairs of the components select
+    //  indices of an array of the given size:
+    template <class ARRAY>
+    inline bool
+    areCountsAndOffsetsValid(ARRAY const & countsAndOffsets, int numComponents,
+                             int numIndices) {
+        if ((int)countsAndOffsets.size() != 2 * numComponents) {
+            return false;
+        }
+        for (int i = 0; i < numComponents; ++i) {
+            int count = countsAndOffsets[2*i],
+                offset = countsAndOffsets[2*i+1];
+            if (count < 0 or offset < 0 or offset > numIndices - count) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //  Returns true if a relation is either absent (empty) or complete:
+    inline bool
+    isRelationValid(std::vector<Index> const & countsAndOffsets,
+                    std::vector<Index> const & indices, int numComponents,
+                    int numRelated) {
+        if (countsAndOffsets.empty()) {
+            return indices.empty();
+        }
+        return areCountsAndOffsetsValid(countsAndOffsets, numComponents,
+                                        (int)indices.size()) and
+               areIndicesInRange(indices, numRelated);
+    }
+
+    //  Returns true if a per-component array is either absent or sized for the
+    //  components:
+    template <class T>
+    inline bool
+    isSizeValid(std::vector<T> const & values, int size) {
+        return values.empty() or (int)values.size() == size;
+    }
+
+    //  Returns true if the child components [first, first + count) exist
+    //  and have parent indices in [0, numParents):
+    inline bool
+    areParentIndicesValid(std::vector<Index> const & parentIndices,
+                          int first, int count, int numParents) {
+        if (first < 0 or count < 0 or first > (int)parentIndices.size() - count) {
+            return false;
+        }
+        for (int i = first; i < first + count; ++i) {
+            if (parentIndices[i] < 0 or parentIndices[i] >= numParents) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+inline bool
+Level::hasValidIndices() const {
+
+    using namespace serialization;
+
+    if (_faceCount < 0 or _edgeCount < 0 or _vertCount < 0) {
+        return false;
+    }
+
+    //  The face-vertex relation is always present:
+    bool valid =
+        areCountsAndOffsetsValid(_faceVertCountsAndOffsets, _faceCount,
+                                 (int)_faceVertIndices.size()) and
+        areIndicesInRange(_faceVertIndices, _vertCount) and
+        isSizeValid(_faceEdgeIndices, (int)_faceVertIndices.size()) and
+        areIndicesInRange(_faceEdgeIndices, _edgeCount) and
+        isSizeValid(_faceTags, _faceCount);
+
+    valid = valid and
+        isSizeValid(_edgeVertIndices, 2 * _edgeCount) and
+        areIndicesInRange(_edgeVertIndices, _vertCount) and
+        isRelationValid(_edgeFaceCountsAndOffsets, _edgeFaceIndices,
+                        _edgeCount, _faceCount) and
+        isSizeValid(_edgeFaceLocalIndices, (int)_edgeFaceIndices.size()) and
+        isSizeValid(_edgeSharpness, _edgeCount) and
+        isSizeValid(_edgeTags, _edgeCount);
+
+    valid = valid and
+        isRelationValid(_vertFaceCountsAndOffsets, _vertFaceIndices,
+                        _vertCount, _faceCount) and
+        isSizeValid(_vertFaceLocalIndices, (int)_vertFaceIndices.size()) and
+        isRelationValid(_vertEdgeCountsAndOffsets, _vertEdgeIndices,
+                        _vertCount, _edgeCount) and
+        isSizeValid(_vertEdgeLocalIndices, (int)_vertEdgeIndices.size()) and
+        isSizeValid(_vertSharpness, _vertCount) and
+        isSizeValid(_vertTags, _vertCount);
+
+    for (int i = 0; valid and i < (int)_fvarChannels.size(); ++i) {
+        valid = _fvarChannels[i]->hasValidIndices();
+    }
+    return valid;
+}
+
+inline bool
+FVarLevel::hasValidIndices() const {
+
+    using namespace serialization;
+
+    int numVertices = _level.getNumVertices(),
+        numVertValues = (int)_vertValueIndices.size();
+
+    if (_valueCount < 0 or
+            (int)_faceVertValues.size() != _level.getNumFaceVerticesTotal() or
+            not areIndicesInRange(_faceVertValues, _valueCount) or
+            not isSizeValid(_edgeTags, _level.getNumEdges()) or
+            not isSizeValid(_vertFaceSiblings,
+                            _level.getNumVertexFacesTotal())) {
+        return false;
+    }
+
+    //  The siblings of each vertex select its vertex values, which refer to
+    //  the values of the channel:
+    if (not isSizeValid(_vertSiblingCounts, numVertices) or
+            _vertSiblingOffsets.size() != _vertSiblingCounts.size()) {
+        return false;
+    }
+    for (int i = 0; i < (int)_vertSiblingCounts.size(); ++i) {
+        int count = _vertSiblingCounts[i],
+            offset = _vertSiblingOffsets[i];
+        if (offset < 0 or offset > numVertValues - count) {
+            return false;
+        }
+    }
+
+    return areIndicesInRange(_vertValueIndices, _valueCount) and
+           isSizeValid(_vertValueTags, numVertValues) and
+           isSizeValid(_vertValueCreaseEnds, numVertValues);
+}
+
+inline bool
+Refinement::hasValidIndices() const {
+
+    using namespace serialization;
+
+    int numParentFaces = _parent->getNumFaces(),
+        numParentEdges = _parent->getNumEdges(),
+        numParentVerts = _parent->getNumVertices(),
+        numChildFaces  = _child->getNumFaces(),
+        numChildEdges  = _child->getNumEdges(),
+        numChildVerts  = _child->getNumVertices();
+
+    //  Parent to child -- missing children are marked invalid:
+    bool valid =
+        areCountsAndOffsetsValid(_faceChildFaceCountsAndOffsets,
+            numParentFaces, (int)_faceChildFaceIndices.size()) and
+        areIndicesInRange(_faceChildFaceIndices, numChildFaces, true) and
+        areCountsAndOffsetsValid(_faceChildEdgeCountsAndOffsets,
+            numParentFaces, (int)_faceChildEdgeIndices.size()) and
+        areIndicesInRange(_faceChildEdgeIndices, numChildEdges, true) and
+        isSizeValid(_faceChildVertIndex, numParentFaces) and
+        areIndicesInRange(_faceChildVertIndex, numChildVerts, true) and
+        (int)_edgeChildEdgeIndices.size() == 2 * numParentEdges and
+        areIndicesInRange(_edgeChildEdgeIndices, numChildEdges, true) and
+        (int)_edgeChildVertIndex.size() == numParentEdges and
+        areIndicesInRange(_edgeChildVertIndex, numChildVerts, true) and
+        (int)_vertChildVertIndex.size() == numParentVerts and
+        areIndicesInRange(_vertChildVertIndex, numChildVerts, true);
+
+    //  Child to parent -- the parent of each child is of the type given by the
+    //  inventory of the child components:
+    valid = valid and
+        (int)_childFaceParentIndex.size() == numChildFaces and
+        areParentIndicesValid(_childFaceParentIndex,
+            _firstChildFaceFromFace, _childFaceFromFaceCount, numParentFaces) and
+        (int)_childEdgeParentIndex.size() == numChildEdges and
+        areParentIndicesValid(_childEdgeParentIndex,
+            _firstChildEdgeFromFace, _childEdgeFromFaceCount, numParentFaces) and
+        areParentIndicesValid(_childEdgeParentIndex,
+            _firstChildEdgeFromEdge, _childEdgeFromEdgeCount, numParentEdges) and
+        (int)_childVertexParentIndex.size() == numChildVerts and
+        areParentIndicesValid(_childVertexParentIndex,
+            _firstChildVertFromFace, _childVertFromFaceCount, numParentFaces) and
+        areParentIndicesValid(_childVertexParentIndex,
+            _firstChildVertFromEdge, _childVertFromEdgeCount, numParentEdges) and
+        areParentIndicesValid(_childVertexParentIndex,
+            _firstChildVertFromVert, _childVertFromVertCount, numParentVerts);
+
+    valid = valid and
+        isSizeValid(_childFaceTag, numChildFaces) and
+        isSizeValid(_childEdgeTag, numChildEdges) and
+        isSizeValid(_childVertexTag, numChildVerts) and
+        isSizeValid(_parentFaceTag, numParentFaces) and
+        isSizeValid(_parentEdgeTag, numParentEdges) and
+        isSizeValid(_parentVertexTag, numParentVerts);
+
+    for (int i = 0; valid and i < (int)_fvarChannels.size(); ++i) {
+        valid = _fvarChannels[i]->hasValidIndices();
+    }
+    return valid;
+}
+
+inline bool
+FVarRefinement::hasValidIndices() const {
+
+    //  The sources are local to the parent components, one per child value:
+    return (int)_childValueParentSource.size() == _childFVar.getNumValues();
+}
+
+} // end namespace internal
+} // end namespace Vtr
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+} // end namespace OpenSubdiv
+
+#endif /* OPENSUBDIV3_VTR_SERIALIZATION_H */
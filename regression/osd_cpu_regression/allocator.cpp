@@ -0,0 +1,188 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+
+#include "cpu_regression.h"
+
+#include <far/allocator.h>
+#include <osd/bufferDescriptor.h>
+#include <osd/cpuDoubleBufferedVertexBuffer.h>
+#include <osd/cpuEvaluator.h>
+#include <osd/cpuVertexBuffer.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace OpenSubdiv;
+
+static bool
+isAligned(void const * ptr) {
+    return ((size_t)ptr % Far::ALLOCATION_ALIGNMENT) == 0;
+}
+
+//
+// Counting allocation callbacks : the aligned buffers are carved from
+// malloc'ed blocks, the block address being stored before the buffer.
+//
+static int g_numAllocations = 0,
+           g_numFrees = 0;
+
+static void *
+countingAllocate(size_t size, size_t alignment) {
+    char * block = (char *)malloc(size + alignment + sizeof(void *));
+    if (not block) return NULL;
+    size_t address = (size_t)(block + sizeof(void *));
+    char * ptr = block + sizeof(void *) +
+                 (alignment - address % alignment) % alignment;
+    memcpy(ptr - sizeof(void *), &block, sizeof(void *));
+    ++g_numAllocations;
+    return ptr;
+}
+
+static void
+countingFree(void * ptr, size_t /* size */) {
+    char * block;
+    memcpy(&block, (char *)ptr - sizeof(void *), sizeof(void *));
+    free(block);
+    ++g_numFrees;
+}
+
+//------------------------------------------------------------------------------
+// The allocations are aligned with the default and custom callbacks, the
+// buffers are released by the callbacks which allocated them, and the
+// evaluations do not depend on the huge pages mode.
+int
+CheckAllocation() {
+
+    int failures = 0;
+
+    // default allocator, including sizes above the huge page size
+    static const size_t sizes[] = { 1, 3, 64, 1000, 4 << 20, (4 << 20) + 3 };
+    for (int i = 0; i < 6; ++i) {
+        char * ptr = (char *)Far::Allocate(sizes[i]);
+        if (not ptr or not isAligned(ptr)) {
+            printf("  allocation of %d bytes is not aligned\n", (int)sizes[i]);
+            ++failures;
+        }
+        if (ptr) {
+            memset(ptr, 0xff, sizes[i]);
+            Far::Free(ptr);
+        }
+    }
+
+    // buffers allocated with the custom callbacks and released after the
+    // default allocator is restored
+    Far::SetAllocatorCallbacks(countingAllocate, countingFree);
+
+    Osd::CpuVertexBuffer * buffer = Osd::CpuVertexBuffer::Create(3, 101);
+    Osd::CpuDoubleBufferedVertexBuffer * doubleBuffer =
+        Osd::CpuDoubleBufferedVertexBuffer::Create(5, 33);
+
+    Far::SetAllocatorCallbacks(NULL, NULL);
+
+    if (not isAligned(buffer->BindCpuBuffer()) or
+        not isAligned(doubleBuffer->BindCpuBuffer()) or
+        not isAligned(doubleBuffer->BindBackCpuBuffer())) {
+        printf("  vertex buffers are not aligned\n");
+        ++failures;
+    }
+
+    int numAllocations = g_numAllocations;
+    delete buffer;
+    delete doubleBuffer;
+
+    if (numAllocations == 0 or g_numFrees != numAllocations) {
+        printf("  %d allocations with the callbacks, %d releases\n",
+               numAllocations, g_numFrees);
+        ++failures;
+    }
+
+    // default allocator restored
+    buffer = Osd::CpuVertexBuffer::Create(3, 101);
+    delete buffer;
+    if (g_numAllocations != numAllocations) {
+        printf("  the default allocator was not restored\n");
+        ++failures;
+    }
+
+    // stencil tables and buffers created in each huge pages mode
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    ShapeDesc const & shape = shapes[shapes.size() - 2];
+
+    Far::TopologyRefiner * refiner = CreateRefiner(shape, 4, false);
+    Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+    int numControlVertices = table->GetNumControlVertices(),
+        numStencils = table->GetNumStencils();
+
+    std::vector<float> src(numControlVertices * 3), reference;
+    FillBuffer(src, 0);
+
+    Osd::BufferDescriptor desc(0, 3, 3);
+
+    static const Far::HugePagesMode modes[] = {
+        Far::HUGE_PAGES_NONE,
+        Far::HUGE_PAGES_TRANSPARENT,
+        Far::HUGE_PAGES_EXPLICIT };
+
+    for (int m = 0; m < 3; ++m) {
+
+        Far::SetHugePagesMode(modes[m]);
+
+        Far::StencilTable const * modeTable = CreateStencilTable(*refiner);
+
+        Osd::CpuVertexBuffer
+            * srcBuffer = Osd::CpuVertexBuffer::Create(3, numControlVertices),
+            * dstBuffer = Osd::CpuVertexBuffer::Create(3, numStencils);
+        srcBuffer->UpdateData(&src[0], 0, numControlVertices);
+
+        Osd::CpuEvaluator::EvalStencils(srcBuffer, desc, dstBuffer, desc,
+                                        modeTable);
+
+        float const * dst = dstBuffer->BindCpuBuffer();
+        if (m == 0) {
+            reference.assign(dst, dst + numStencils * 3);
+        }
+
+        char test[64];
+        snprintf(test, sizeof(test), "huge pages mode %d", (int)modes[m]);
+        if (Far::GetHugePagesMode() != modes[m]) {
+            printf("  %s : mode not set\n", test);
+            ++failures;
+        }
+        failures += CompareBuffers(test, dst, &reference[0],
+                                   numStencils * 3, 0.0);
+
+        delete srcBuffer;
+        delete dstBuffer;
+        delete modeTable;
+    }
+    Far::SetHugePagesMode(Far::HUGE_PAGES_NONE);
+
+    delete table;
+    delete refiner;
+
+    return failures;
+}
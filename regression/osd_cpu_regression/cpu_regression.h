@@ -0,0 +1,157 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OSD_CPU_REGRESSION_H
+#define OSD_CPU_REGRESSION_H
+
+#include <far/topologyRefiner.h>
+#include <far/stencilTable.h>
+#include <far/patchTableFactory.h>
+#include <far/stencilTableFactory.h>
+#include <osd/cpuKernel.h>
+#include <osd/cpuPatchTable.h>
+#include <osd/types.h>
+
+#include <string>
+#include <vector>
+
+#include "../common/shape_utils.h"
+
+//
+// Regression testing of the CPU evaluation paths : the SIMD, parallel and
+// compact paths are matched against the scalar and serial evaluation of the
+// same stencils and patches.
+//
+
+struct ShapeDesc {
+
+    ShapeDesc(char const * iname, std::string const & idata, Scheme ischeme) :
+        name(iname), data(idata), scheme(ischeme) { }
+
+    std::string name,
+                data;
+    Scheme      scheme;
+};
+
+// The shapes the tests are run on
+std::vector<ShapeDesc> const & GetShapes();
+
+// Returns a refiner for the shape, refined uniformly or adaptively
+OpenSubdiv::Far::TopologyRefiner *
+CreateRefiner(ShapeDesc const & shape, int level, bool adaptive);
+
+// Returns the stencils of the vertices of all the refinement levels
+OpenSubdiv::Far::StencilTable const *
+CreateStencilTable(OpenSubdiv::Far::TopologyRefiner const & refiner);
+
+// Returns the limit stencils of a grid of locations on every ptex face of an
+// adaptively refined refiner
+OpenSubdiv::Far::LimitStencilTable const *
+CreateLimitStencilTable(OpenSubdiv::Far::TopologyRefiner const & refiner,
+    OpenSubdiv::Far::LimitStencilTableFactory::Options options =
+        OpenSubdiv::Far::LimitStencilTableFactory::Options());
+
+typedef OpenSubdiv::Far::PatchTableFactory::Options::EndCapType EndCapType;
+
+//
+// The patches of an adaptively refined shape and a set of coordinates on
+// them, either grouped by patch or shuffled
+//
+struct PatchData {
+
+    PatchData(ShapeDesc const & shape, EndCapType endCapType, bool grouped);
+
+    ~PatchData();
+
+    int GetNumCoords() const {
+        return (int)coords.size();
+    }
+
+    OpenSubdiv::Far::TopologyRefiner * refiner;
+    OpenSubdiv::Far::PatchTable * patchTable;
+    OpenSubdiv::Osd::CpuPatchTable * cpuPatchTable;
+    std::vector<OpenSubdiv::Osd::PatchCoord> coords;
+    int numVertices;
+};
+
+// Returns the highest SIMD level supported by the CPU
+OpenSubdiv::Osd::CpuSimdLevel GetMaxSimdLevel();
+
+// Fills a buffer with reproducible pseudo-random values in [-1, 1]
+void FillBuffer(std::vector<float> & buffer, unsigned int seed);
+void FillBuffer(std::vector<double> & buffer, unsigned int seed);
+
+// Returns the number of values that differ from the reference by more than
+// the tolerance (relative to the reference magnitude), printing the first
+// ones. Comparing no values is a failure.
+template <typename REAL>
+int CompareBuffers(char const * test,
+                   REAL const * result, REAL const * reference, int n,
+                   double tolerance);
+
+//
+// Tests : each returns its number of failures
+//
+
+// allocator.cpp
+int CheckAllocation();
+
+// stats.cpp
+int CheckStats();
+
+// stencils.cpp
+int CheckSimdStencils();
+int CheckHalfStencils();
+int CheckCompressedStencils();
+int CheckReorderedStencils();
+int CheckDirtyStencils();
+int CheckStencilDeltas();
+int CheckInstanceStencils();
+int CheckSoAStencils();
+int CheckFusedDerivativeStencils();
+int CheckMultiBufferStencils();
+int CheckDoubleStencils();
+int CheckSecondDerivativeStencils();
+int CheckHashedStencils();
+
+// patches.cpp
+int CheckBatchedPatches();
+int CheckDoublePatches();
+int CheckSecondDerivativePatches();
+
+// files.cpp
+int CheckStencilTableFiles();
+int CheckPatchTableFiles();
+int CheckTopologyRefinerFiles();
+
+// parallel.cpp
+int CheckPatchNormals();
+int CheckThreadPoolEvaluator();
+int CheckStencilPartitions();
+int CheckOmpEvaluator();
+int CheckNumaStencilTable();
+int CheckAsyncEvaluation();
+int CheckParallelStencilFactory();
+
+#endif // OSD_CPU_REGRESSION_H
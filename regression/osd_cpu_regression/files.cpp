@@ -0,0 +1,1104 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "cpu_regression.h"
+
+#include <far/binaryFile.h>
+#include <far/error.h>
+#include <far/patchMap.h>
+#include <far/primvarRefiner.h>
+#include <far/ptexIndices.h>
+#include <far/topologyRefinerFactory.h>
+#include <far/stencilTableView.h>
+#include <osd/bufferDescriptor.h>
+#include <osd/cpuEvaluator.h>
+#include <osd/cpuPatchTable.h>
+#include <osd/cpuVertexBuffer.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace OpenSubdiv;
+
+//
+// The tables written to files are read back and matched against the tables
+// they were written from : the arrays are expected to be identical, and so
+// are the results of their evaluation.
+//
+
+static char const * g_path = "osd_cpu_regression_file.bin";
+
+// Error callback counting the errors expected from invalid files
+static int g_numErrors = 0;
+
+static void
+countErrors(Far::ErrorType, char const *) {
+    ++g_numErrors;
+}
+
+template <typename T>
+static int
+compareArrays(char const * test, char const * array,
+    T const * result, T const * reference, int n) {
+
+    if (n > 0 and (not result or not reference or
+            memcmp(result, reference, n * sizeof(T)) != 0)) {
+        printf("  %s : the %s differ\n", test, array);
+        return 1;
+    }
+    return 0;
+}
+
+template <typename T>
+static int
+compareArrays(char const * test, char const * array,
+    std::vector<T> const & result, std::vector<T> const & reference) {
+
+    if (result.size() != reference.size()) {
+        printf("  %s : the %s differ in size\n", test, array);
+        return 1;
+    }
+    return compareArrays(test, array, result.empty() ? 0 : &result[0],
+        reference.empty() ? 0 : &reference[0], (int)result.size());
+}
+
+static bool
+fileExists(char const * path) {
+    FILE * file = fopen(path, "rb");
+    if (file) {
+        fclose(file);
+    }
+    return file != 0;
+}
+
+static bool
+readFile(char const * path, std::vector<char> & data) {
+
+    FILE * file = fopen(path, "rb");
+    if (not file) return false;
+    fseek(file, 0, SEEK_END);
+    data.resize(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    bool read = fread(&data[0], 1, data.size(), file) == data.size();
+    fclose(file);
+    return read;
+}
+
+static bool
+writeFile(char const * path, char const * data, size_t size) {
+
+    FILE * file = fopen(path, "wb");
+    if (not file) return false;
+    bool written = fwrite(data, 1, size, file) == size;
+    fclose(file);
+    return written;
+}
+
+// Copies the first bytes of a file to another
+static bool
+truncateFile(char const * srcPath, char const * dstPath, long size) {
+
+    std::vector<char> data;
+    return readFile(srcPath, data) and (long)data.size() >= size and
+        writeFile(dstPath, &data[0], size);
+}
+
+//
+// The headers of the sections of a file (see far/binaryFile.cpp) : the
+// sections are listed after the 64 byte header of the file, which holds
+// their number after the magic and 4 other fields.
+//
+struct SectionHeader {
+    unsigned int tag,
+                 elementSize,
+                 offset,        // in 64 byte blocks
+                 count;
+};
+
+static SectionHeader *
+findSection(std::vector<char> & data, int tag) {
+
+    unsigned int numSections = 0;
+    memcpy(&numSections, &data[24], sizeof(unsigned int));
+
+    SectionHeader * sections = reinterpret_cast<SectionHeader *>(&data[64]);
+    for (unsigned int i = 0; i < numSections; ++i) {
+        if (sections[i].tag == (unsigned int)tag) {
+            return &sections[i];
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Stencil table files
+
+template <typename REAL, class VIEW, class TABLE>
+static int
+compareStencilView(char const * test, VIEW const & view, TABLE const & table) {
+
+    if (view.GetNumStencils() != table.GetNumStencils() or
+        view.GetNumControlVertices() != table.GetNumControlVertices() or
+        view.GetNumWeights() != (int)table.GetControlIndices().size()) {
+        printf("  %s : the counts differ\n", test);
+        return 1;
+    }
+    int numStencils = view.GetNumStencils(),
+        numWeights = view.GetNumWeights();
+
+    int failures = 0;
+    failures += compareArrays(test, "sizes", view.GetSizes(),
+        &table.GetSizes()[0], numStencils);
+    failures += compareArrays(test, "offsets", view.GetOffsets(),
+        &table.GetOffsets()[0], numStencils);
+    failures += compareArrays(test, "indices", view.GetControlIndices(),
+        &table.GetControlIndices()[0], numWeights);
+    failures += compareArrays<REAL>(test, "weights", view.GetWeights(),
+        &table.GetWeights()[0], numWeights);
+    return failures;
+}
+
+template <typename REAL>
+static int
+compareLimitWeights(char const * test, char const * array,
+    REAL const * viewWeights, std::vector<REAL> const & weights, int n) {
+
+    if ((viewWeights == 0) != weights.empty()) {
+        printf("  %s : the %s are %s\n", test, array,
+            viewWeights ? "unexpected" : "missing");
+        return 1;
+    }
+    return weights.empty() ? 0 :
+        compareArrays(test, array, viewWeights, &weights[0], n);
+}
+
+template <typename REAL>
+static int
+checkStencilTableFile(char const * test,
+    Far::StencilTableReal<REAL> const & table) {
+
+    if (not Far::StencilTableViewReal<REAL>::Write(g_path, table)) {
+        printf("  %s : cannot write the file\n", test);
+        return 1;
+    }
+    Far::StencilTableViewReal<REAL> * view =
+        Far::StencilTableViewReal<REAL>::Open(g_path);
+    if (not view) {
+        printf("  %s : cannot open the file\n", test);
+        return 1;
+    }
+    int failures = compareStencilView<REAL>(test, *view, table);
+    delete view;
+    return failures;
+}
+
+template <typename REAL>
+static int
+checkLimitStencilTableFile(char const * test,
+    Far::LimitStencilTableReal<REAL> const & table) {
+
+    if (not Far::LimitStencilTableViewReal<REAL>::Write(g_path, table)) {
+        printf("  %s : cannot write the file\n", test);
+        return 1;
+    }
+    Far::LimitStencilTableViewReal<REAL> * view =
+        Far::LimitStencilTableViewReal<REAL>::Open(g_path);
+    if (not view) {
+        printf("  %s : cannot open the file\n", test);
+        return 1;
+    }
+    int failures = compareStencilView<REAL>(test, *view, table);
+
+    int n = view->GetNumWeights();
+    failures += compareLimitWeights(test, "du weights",
+        view->GetDuWeights(), table.GetDuWeights(), n);
+    failures += compareLimitWeights(test, "dv weights",
+        view->GetDvWeights(), table.GetDvWeights(), n);
+    failures += compareLimitWeights(test, "duu weights",
+        view->GetDuuWeights(), table.GetDuuWeights(), n);
+    failures += compareLimitWeights(test, "duv weights",
+        view->GetDuvWeights(), table.GetDuvWeights(), n);
+    failures += compareLimitWeights(test, "dvv weights",
+        view->GetDvvWeights(), table.GetDvvWeights(), n);
+
+    // the views evaluate as the tables
+    if (failures == 0) {
+        int numControls = table.GetNumControlVertices(),
+            numStencils = table.GetNumStencils();
+
+        std::vector<float> src(numControls * 3);
+        FillBuffer(src, 0);
+
+        Osd::BufferDescriptor srcDesc(0, 3, 3), dstDesc(0, 3, 3);
+        Osd::CpuVertexBuffer * srcBuffer =
+            Osd::CpuVertexBuffer::Create(3, numControls);
+        srcBuffer->UpdateData(&src[0], 0, numControls);
+
+        Osd::CpuVertexBuffer * results[2][3];
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                results[i][j] = Osd::CpuVertexBuffer::Create(3, numStencils);
+            }
+        }
+        Osd::CpuEvaluator::EvalStencils(srcBuffer, srcDesc,
+            results[0][0], dstDesc, results[0][1], dstDesc,
+            results[0][2], dstDesc, view);
+        Osd::CpuEvaluator::EvalStencils(srcBuffer, srcDesc,
+            results[1][0], dstDesc, results[1][1], dstDesc,
+            results[1][2], dstDesc, &table);
+
+        for (int j = 0; j < 3; ++j) {
+            failures += compareArrays(test, "evaluations",
+                results[0][j]->BindCpuBuffer(), results[1][j]->BindCpuBuffer(),
+                numStencils * 3);
+        }
+        for (int i = 0; i < 2; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                delete results[i][j];
+            }
+        }
+        delete srcBuffer;
+    }
+    delete view;
+    return failures;
+}
+
+int
+CheckStencilTableFiles() {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (int s = 0; s < (int)shapes.size(); ++s) {
+
+        // only the Catmark meshes are refined adaptively
+        bool adaptive = shapes[s].scheme == kCatmark;
+
+        Far::TopologyRefiner * refiner =
+            CreateRefiner(shapes[s], 2, adaptive);
+
+        char name[64];
+        snprintf(name, sizeof(name), "%s stencils", shapes[s].name.c_str());
+
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+        failures += checkStencilTableFile(name, *table);
+
+        // tables without offsets are written with them
+        Far::StencilTableFactory::Options options;
+        options.generateOffsets = false;
+        Far::StencilTable const * noOffsetTable =
+            Far::StencilTableFactory::Create(*refiner, options);
+        Far::StencilTableView * view = 0;
+        if (Far::StencilTableView::Write(g_path, *noOffsetTable)) {
+            view = Far::StencilTableView::Open(g_path);
+        }
+        if (not view) {
+            printf("  %s : cannot write a table without offsets\n", name);
+            ++failures;
+        } else {
+            failures += compareStencilView<float>(name, *view, *table);
+        }
+        delete view;
+        delete noOffsetTable;
+
+        Far::StencilTableFactoryReal<double>::Options doubleOptions;
+        doubleOptions.generateIntermediateLevels = true;
+        Far::StencilTableReal<double> const * doubleTable =
+            Far::StencilTableFactoryReal<double>::Create(*refiner,
+                                                         doubleOptions);
+        snprintf(name, sizeof(name), "%s double stencils",
+            shapes[s].name.c_str());
+        failures += checkStencilTableFile(name, *doubleTable);
+        delete doubleTable;
+
+        for (int derivs = 0; adaptive and derivs < 2; ++derivs) {
+            Far::LimitStencilTableFactory::Options limitOptions;
+            limitOptions.generate2ndDerivatives = derivs != 0;
+            Far::LimitStencilTable const * limitTable =
+                CreateLimitStencilTable(*refiner, limitOptions);
+            snprintf(name, sizeof(name), "%s limit stencils (%d)",
+                shapes[s].name.c_str(), derivs);
+            failures += checkLimitStencilTableFile(name, *limitTable);
+            delete limitTable;
+        }
+
+        delete table;
+        delete refiner;
+    }
+
+    // files are replaced while mapped : the views keep the previous tables
+    Far::TopologyRefiner * refiner = CreateRefiner(shapes[1], 2, true),
+                         * otherRefiner = CreateRefiner(shapes[3], 3, true);
+    Far::StencilTable const * table = CreateStencilTable(*refiner),
+                            * otherTable = CreateStencilTable(*otherRefiner);
+
+    Far::StencilTableView * view = 0, * otherView = 0;
+    if (Far::StencilTableView::Write(g_path, *table)) {
+        view = Far::StencilTableView::Open(g_path);
+    }
+    if (view and Far::StencilTableView::Write(g_path, *otherTable)) {
+        otherView = Far::StencilTableView::Open(g_path);
+    }
+    if (not view or not otherView) {
+        printf("  replaced file : cannot write the files\n");
+        ++failures;
+    } else {
+        failures += compareStencilView<float>("replaced file", *view, *table);
+        failures += compareStencilView<float>("replacing file", *otherView,
+                                              *otherTable);
+    }
+    std::string tmpPath = std::string(g_path) + ".tmp";
+    if (fileExists(tmpPath.c_str())) {
+        printf("  replacing file : the temporary file remains\n");
+        ++failures;
+    }
+
+    // invalid files are rejected
+    Far::SetErrorCallback(countErrors);
+    g_numErrors = 0;
+    if (otherView) {
+        if (Far::StencilTableViewReal<double>::Open(g_path) or
+                Far::LimitStencilTableView::Open(g_path)) {
+            printf("  mismatched file : opened\n");
+            ++failures;
+        }
+        if (not truncateFile(g_path, tmpPath.c_str(),
+                (long)otherView->GetMappedSize() / 2) or
+                Far::StencilTableView::Open(tmpPath.c_str())) {
+            printf("  truncated file : opened\n");
+            ++failures;
+        }
+    }
+    if (Far::StencilTableView::Open("osd_cpu_regression_missing.bin")) {
+        printf("  missing file : opened\n");
+        ++failures;
+    }
+    if (g_numErrors != 4) {
+        printf("  invalid files : %d errors reported\n", g_numErrors);
+        ++failures;
+    }
+    Far::SetErrorCallback(0);
+
+    delete view;
+    delete otherView;
+    delete table;
+    delete otherTable;
+    delete refiner;
+    delete otherRefiner;
+
+    remove(tmpPath.c_str());
+    remove(g_path);
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// Patch table files
+
+static int
+compareStencilTables(char const * test, char const * table,
+    Far::StencilTable const * result, Far::StencilTable const * reference) {
+
+    if ((result == 0) != (reference == 0)) {
+        printf("  %s : the %s are %s\n", test, table,
+            result ? "unexpected" : "missing");
+        return 1;
+    }
+    if (not reference) {
+        return 0;
+    }
+    if (result->GetNumControlVertices() !=
+            reference->GetNumControlVertices()) {
+        printf("  %s : the %s differ\n", test, table);
+        return 1;
+    }
+    int numWeights = (int)reference->GetControlIndices().size();
+    return compareArrays(test, table, result->GetSizes(),
+                         reference->GetSizes()) +
+           compareArrays(test, table, result->GetOffsets(),
+                         reference->GetOffsets()) +
+           compareArrays(test, table, result->GetControlIndices(),
+                         reference->GetControlIndices()) +
+           ((int)result->GetWeights().size() < numWeights ? 1 :
+               compareArrays(test, table, &result->GetWeights()[0],
+                             &reference->GetWeights()[0], numWeights));
+}
+
+static int
+comparePatchTables(char const * test, Far::PatchTable const & result,
+    Far::PatchTable const & reference) {
+
+    int numArrays = reference.GetNumPatchArrays(),
+        numChannels = reference.GetNumFVarChannels();
+
+    if (result.GetMaxValence() != reference.GetMaxValence() or
+        result.GetNumPtexFaces() != reference.GetNumPtexFaces() or
+        result.GetNumPatchArrays() != numArrays or
+        result.GetNumFVarChannels() != numChannels) {
+        printf("  %s : the counts differ\n", test);
+        return 1;
+    }
+
+    int failures = 0;
+    for (int i = 0; i < numArrays; ++i) {
+        if (result.GetPatchArrayDescriptor(i).GetType() !=
+                reference.GetPatchArrayDescriptor(i).GetType() or
+            result.GetNumPatches(i) != reference.GetNumPatches(i) or
+            result.GetPatchArrayVertices(i).begin() -
+                &result.GetPatchControlVerticesTable()[0] !=
+            reference.GetPatchArrayVertices(i).begin() -
+                &reference.GetPatchControlVerticesTable()[0]) {
+            printf("  %s : the patch array %d differs\n", test, i);
+            ++failures;
+        }
+    }
+
+    failures += compareArrays(test, "vertices",
+        result.GetPatchControlVerticesTable(),
+        reference.GetPatchControlVerticesTable());
+    failures += compareArrays(test, "patch params",
+        result.GetPatchParamTable(), reference.GetPatchParamTable());
+    failures += compareArrays(test, "quad offsets",
+        result.GetQuadOffsetsTable(), reference.GetQuadOffsetsTable());
+    failures += compareArrays(test, "valences",
+        result.GetVertexValenceTable(), reference.GetVertexValenceTable());
+    failures += compareArrays(test, "sharpness indices",
+        result.GetSharpnessIndexTable(), reference.GetSharpnessIndexTable());
+    failures += compareArrays(test, "sharpness values",
+        result.GetSharpnessValues(), reference.GetSharpnessValues());
+
+    failures += compareStencilTables(test, "local point stencils",
+        result.GetLocalPointStencilTable(),
+        reference.GetLocalPointStencilTable());
+    failures += compareStencilTables(test, "local varying point stencils",
+        result.GetLocalPointVaryingStencilTable(),
+        reference.GetLocalPointVaryingStencilTable());
+
+    for (int c = 0; c < numChannels; ++c) {
+        Far::ConstIndexArray values = result.GetFVarValues(c),
+                             referenceValues = reference.GetFVarValues(c);
+        if (result.GetFVarChannelLinearInterpolation(c) !=
+                reference.GetFVarChannelLinearInterpolation(c) or
+            values.size() != referenceValues.size()) {
+            printf("  %s : the face-varying channel %d differs\n", test, c);
+            ++failures;
+            continue;
+        }
+        failures += compareArrays(test, "face-varying values",
+            &values[0], &referenceValues[0], values.size());
+
+        for (int i = 0; i < numArrays; ++i) {
+            for (int j = 0; j < reference.GetNumPatches(i); ++j) {
+                Far::ConstIndexArray patchValues =
+                    result.GetPatchFVarValues(i, j, c),
+                                     referencePatchValues =
+                    reference.GetPatchFVarValues(i, j, c);
+                if (patchValues.size() != referencePatchValues.size() or
+                    compareArrays(test, "face-varying patch values",
+                        &patchValues[0], &referencePatchValues[0],
+                        patchValues.size())) {
+                    printf("  %s : the face-varying patch %d/%d differs\n",
+                        test, i, j);
+                    return failures + 1;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+static int
+comparePatchMaps(char const * test, Far::PatchMap const & result,
+    Far::PatchMap const & reference, int numPtexFaces) {
+
+    static const int gridSize = 9;
+
+    for (int face = 0; face < numPtexFaces; ++face) {
+        for (int i = 0; i < gridSize * gridSize; ++i) {
+            float s = (float)(i % gridSize) / (float)(gridSize - 1),
+                  t = (float)(i / gridSize) / (float)(gridSize - 1);
+            Far::PatchTable::PatchHandle const
+                * handle = result.FindPatch(face, s, t),
+                * referenceHandle = reference.FindPatch(face, s, t);
+            if ((handle == 0) != (referenceHandle == 0) or (handle and
+                    (handle->arrayIndex != referenceHandle->arrayIndex or
+                     handle->patchIndex != referenceHandle->patchIndex or
+                     handle->vertIndex != referenceHandle->vertIndex))) {
+                printf("  %s : the patch maps differ on face %d\n",
+                    test, face);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int
+checkPatchTableFile(char const * test, Far::PatchTable const & table) {
+
+    Far::PatchMap * patchMap = 0;
+    Far::PatchTable * result = 0;
+    if (Far::PatchTableFactory::Write(g_path, table)) {
+        result = Far::PatchTableFactory::Read(g_path, &patchMap);
+    }
+    if (not result or not patchMap) {
+        printf("  %s : cannot write and read the file\n", test);
+        delete result;
+        delete patchMap;
+        return 1;
+    }
+
+    int failures = comparePatchTables(test, *result, table);
+
+    Far::PatchMap referenceMap(table);
+    failures += comparePatchMaps(test, *patchMap, referenceMap,
+                                 table.GetNumPtexFaces());
+
+    delete patchMap;
+    delete result;
+    return failures;
+}
+
+// Corrupts the first size of the local point stencils of a patch table file,
+// with or without their offsets : the file must be rejected
+static int
+checkCorruptedStencilSizes(char const * test, bool withOffsets) {
+
+    std::vector<char> data;
+    if (not readFile(g_path, data)) {
+        printf("  %s : cannot read the file\n", test);
+        return 1;
+    }
+    SectionHeader
+        * sizes = findSection(data, Far::internal::PATCH_TABLE_LOCAL_POINTS+1),
+        * offsets = findSection(data, Far::internal::PATCH_TABLE_LOCAL_POINTS+2);
+    if (not sizes or not offsets or sizes->count == 0) {
+        printf("  %s : no local point stencils\n", test);
+        return 1;
+    }
+    int * firstSize = reinterpret_cast<int *>(&data[sizes->offset * 64]);
+    ++*firstSize;
+    if (not withOffsets) {
+        offsets->count = 0;
+    }
+
+    std::string path = std::string(g_path) + ".corrupted";
+    Far::PatchTable * table = 0;
+    if (writeFile(path.c_str(), &data[0], data.size())) {
+        table = Far::PatchTableFactory::Read(path.c_str());
+    }
+    remove(path.c_str());
+
+    if (table) {
+        printf("  %s : the corrupted stencils were read\n", test);
+        delete table;
+        return 1;
+    }
+    return 0;
+}
+
+// Overwrites an index of a section of a patch table file with a value out of
+// the range of the table it indexes : the file must be rejected
+static int
+checkCorruptedIndex(char const * test, char const * array, int tag,
+    int index, int value) {
+
+    std::vector<char> data;
+    if (not readFile(g_path, data)) {
+        printf("  %s : cannot read the file\n", test);
+        return 1;
+    }
+    SectionHeader * section = findSection(data, tag);
+    if (not section or (int)section->count <= index) {
+        printf("  %s : no %s\n", test, array);
+        return 1;
+    }
+    memcpy(&data[section->offset * 64 + index * sizeof(int)], &value,
+           sizeof(int));
+
+    std::string path = std::string(g_path) + ".corrupted";
+    Far::PatchTable * table = 0;
+    if (writeFile(path.c_str(), &data[0], data.size())) {
+        table = Far::PatchTableFactory::Read(path.c_str());
+    }
+    remove(path.c_str());
+
+    if (table) {
+        printf("  %s : the corrupted %s were read\n", test, array);
+        delete table;
+        return 1;
+    }
+    return 0;
+}
+
+int
+CheckPatchTableFiles() {
+
+    static const EndCapType endCapTypes[] = {
+        Far::PatchTableFactory::Options::ENDCAP_BSPLINE_BASIS,
+        Far::PatchTableFactory::Options::ENDCAP_GREGORY_BASIS,
+        Far::PatchTableFactory::Options::ENDCAP_LEGACY_GREGORY,
+    };
+
+    int failures = 0,
+        numGregoryFiles = 0,
+        numFVarFiles = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (int s = 0; s < (int)shapes.size(); ++s) {
+
+        char name[128];
+
+        // uniform tables
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 2, false);
+        Far::PatchTable * uniformTable =
+            Far::PatchTableFactory::Create(*refiner);
+        snprintf(name, sizeof(name), "%s uniform", shapes[s].name.c_str());
+        failures += checkPatchTableFile(name, *uniformTable);
+        delete uniformTable;
+        delete refiner;
+
+        if (shapes[s].scheme != kCatmark) continue;
+
+        for (int e = 0; e < 3; ++e) {
+
+            PatchData data(shapes[s], endCapTypes[e], true);
+
+            Far::PatchTableFactory::Options options;
+            options.SetEndCapType(endCapTypes[e]);
+            options.useSingleCreasePatch = true;
+            options.generateFVarTables = true;
+            Far::PatchTable * table =
+                Far::PatchTableFactory::Create(*data.refiner, options);
+
+            snprintf(name, sizeof(name), "%s end cap %d",
+                shapes[s].name.c_str(), e);
+            failures += checkPatchTableFile(name, *table);
+
+            // the quad offsets and face-varying values out of range are
+            // rejected
+            if (Far::PatchTableFactory::Write(g_path, *table)) {
+                Far::SetErrorCallback(countErrors);
+                g_numErrors = 0;
+                int numCorrupted = 0;
+                int numQuadOffsets = (int)table->GetQuadOffsetsTable().size();
+                for (int i = 0; i < table->GetNumPatchArrays(); ++i) {
+                    if (table->GetPatchArrayDescriptor(i).GetType() ==
+                            Far::PatchDescriptor::GREGORY) {
+                        failures += checkCorruptedIndex(name, "quad offsets",
+                            Far::internal::PATCH_TABLE_ARRAYS, 5*i + 4,
+                            numQuadOffsets - 1);
+                        ++numCorrupted;
+                        ++numGregoryFiles;
+                    }
+                }
+                for (int c = 0; c < table->GetNumFVarChannels(); ++c) {
+                    if (table->GetFVarValues(c).size() > 0) {
+                        failures += checkCorruptedIndex(name,
+                            "face-varying values",
+                            Far::internal::PATCH_TABLE_FVAR_CHANNEL_DATA +
+                            3*c + 2, 0,
+                            data.refiner->GetNumFVarValuesTotal(c));
+                        ++numCorrupted;
+                        ++numFVarFiles;
+                    }
+                }
+                if (g_numErrors != numCorrupted) {
+                    printf("  %s : %d errors reported\n", name, g_numErrors);
+                    ++failures;
+                }
+                Far::SetErrorCallback(0);
+            }
+
+            // the tables read evaluate as the tables written
+            Far::PatchTable * result = 0;
+            if (Far::PatchTableFactory::Write(g_path, *data.patchTable)) {
+                result = Far::PatchTableFactory::Read(g_path);
+            }
+            if (not result) {
+                printf("  %s : cannot write and read the file\n", name);
+                ++failures;
+            } else {
+                Osd::CpuPatchTable * cpuPatchTable =
+                    Osd::CpuPatchTable::Create(result);
+
+                int numCoords = data.GetNumCoords();
+
+                Osd::BufferDescriptor desc(0, 3, 3);
+                std::vector<float> src(data.numVertices * 3),
+                                   p(numCoords * 3), du(p), dv(p),
+                                   refP(p), refDu(p), refDv(p);
+                FillBuffer(src, (unsigned int)s);
+
+                Osd::CpuEvaluator::EvalPatches(&src[0], desc,
+                    &p[0], desc, &du[0], desc, &dv[0], desc,
+                    numCoords, &data.coords[0],
+                    cpuPatchTable->GetPatchArrayBuffer(),
+                    cpuPatchTable->GetPatchIndexBuffer(),
+                    cpuPatchTable->GetPatchParamBuffer());
+                Osd::CpuEvaluator::EvalPatches(&src[0], desc,
+                    &refP[0], desc, &refDu[0], desc, &refDv[0], desc,
+                    numCoords, &data.coords[0],
+                    data.cpuPatchTable->GetPatchArrayBuffer(),
+                    data.cpuPatchTable->GetPatchIndexBuffer(),
+                    data.cpuPatchTable->GetPatchParamBuffer());
+
+                failures += compareArrays(name, "evaluations", p, refP);
+                failures += compareArrays(name, "evaluations", du, refDu);
+                failures += compareArrays(name, "evaluations", dv, refDv);
+
+                delete cpuPatchTable;
+                delete result;
+
+                Far::StencilTable const * localPoints =
+                    data.patchTable->GetLocalPointStencilTable();
+                if (localPoints and localPoints->GetNumStencils() > 0) {
+                    Far::SetErrorCallback(countErrors);
+                    g_numErrors = 0;
+                    failures += checkCorruptedStencilSizes(name, true);
+                    failures += checkCorruptedStencilSizes(name, false);
+                    if (g_numErrors != 2) {
+                        printf("  %s : %d errors reported\n", name,
+                            g_numErrors);
+                        ++failures;
+                    }
+                    Far::SetErrorCallback(0);
+                }
+            }
+            delete table;
+        }
+    }
+    if (numGregoryFiles == 0 or numFVarFiles == 0) {
+        printf("  corrupted patch table files : no Gregory or face-varying "
+               "patches\n");
+        ++failures;
+    }
+    remove(g_path);
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// Topology refiner files
+
+static bool
+areArraysEqual(Far::ConstIndexArray a, Far::ConstIndexArray b) {
+    return a.size() == b.size() and
+        (a.size() == 0 or memcmp(&a[0], &b[0], a.size() * sizeof(Far::Index)) == 0);
+}
+
+static bool
+areArraysEqual(Far::ConstLocalIndexArray a, Far::ConstLocalIndexArray b) {
+    return a.size() == b.size() and (a.size() == 0 or
+        memcmp(&a[0], &b[0], a.size() * sizeof(Far::LocalIndex)) == 0);
+}
+
+static int
+compareLevels(char const * test, int levelIndex,
+    Far::TopologyLevel const & level, Far::TopologyLevel const & reference,
+    bool fullTopology) {
+
+    if (level.GetNumFaces() != reference.GetNumFaces() or
+        level.GetNumEdges() != reference.GetNumEdges() or
+        level.GetNumVertices() != reference.GetNumVertices() or
+        level.GetNumFaceVertices() != reference.GetNumFaceVertices() or
+        level.GetNumFVarChannels() != reference.GetNumFVarChannels()) {
+        printf("  %s : the counts of level %d differ\n", test, levelIndex);
+        return 1;
+    }
+
+    bool equal = true;
+    for (int f = 0; equal and f < reference.GetNumFaces(); ++f) {
+        equal = areArraysEqual(level.GetFaceVertices(f),
+                               reference.GetFaceVertices(f)) and
+                level.IsFaceHole(f) == reference.IsFaceHole(f);
+        for (int c = 0; equal and c < reference.GetNumFVarChannels(); ++c) {
+            equal = areArraysEqual(level.GetFaceFVarValues(f, c),
+                                   reference.GetFaceFVarValues(f, c));
+        }
+    }
+    for (int c = 0; equal and c < reference.GetNumFVarChannels(); ++c) {
+        equal = level.GetNumFVarValues(c) == reference.GetNumFVarValues(c);
+    }
+
+    // the other relations are only generated with the full topology
+    for (int f = 0; fullTopology and equal and f < reference.GetNumFaces();
+            ++f) {
+        equal = areArraysEqual(level.GetFaceEdges(f),
+                               reference.GetFaceEdges(f));
+    }
+    for (int e = 0; fullTopology and equal and e < reference.GetNumEdges();
+            ++e) {
+        equal = areArraysEqual(level.GetEdgeVertices(e),
+                               reference.GetEdgeVertices(e)) and
+                areArraysEqual(level.GetEdgeFaces(e),
+                               reference.GetEdgeFaces(e)) and
+                areArraysEqual(level.GetEdgeFaceLocalIndices(e),
+                               reference.GetEdgeFaceLocalIndices(e)) and
+                level.GetEdgeSharpness(e) == reference.GetEdgeSharpness(e);
+    }
+    for (int v = 0; fullTopology and equal and v < reference.GetNumVertices();
+            ++v) {
+        equal = areArraysEqual(level.GetVertexFaces(v),
+                               reference.GetVertexFaces(v)) and
+                areArraysEqual(level.GetVertexEdges(v),
+                               reference.GetVertexEdges(v)) and
+                areArraysEqual(level.GetVertexFaceLocalIndices(v),
+                               reference.GetVertexFaceLocalIndices(v)) and
+                areArraysEqual(level.GetVertexEdgeLocalIndices(v),
+                               reference.GetVertexEdgeLocalIndices(v)) and
+                level.GetVertexSharpness(v) == reference.GetVertexSharpness(v) and
+                level.GetVertexRule(v) == reference.GetVertexRule(v);
+    }
+
+    if (not equal) {
+        printf("  %s : the topology of level %d differs\n", test, levelIndex);
+        return 1;
+    }
+    return 0;
+}
+
+// Vertex of the primvars interpolated by the refiners
+struct Vertex {
+    void Clear() { p[0] = p[1] = p[2] = 0.0f; }
+    void AddWithWeight(Vertex const & src, float weight) {
+        p[0] += weight * src.p[0];
+        p[1] += weight * src.p[1];
+        p[2] += weight * src.p[2];
+    }
+    float p[3];
+};
+
+static void
+interpolateVertices(Far::TopologyRefiner const & refiner,
+    std::vector<float> const & src, std::vector<Vertex> & vertices) {
+
+    vertices.resize(refiner.GetNumVerticesTotal());
+    memcpy(&vertices[0], &src[0], src.size() * sizeof(float));
+
+    Far::PrimvarRefiner primvarRefiner(refiner);
+    Vertex * levelVertices = &vertices[0];
+    for (int i = 1; i < refiner.GetNumLevels(); ++i) {
+        Vertex * dstVertices =
+            levelVertices + refiner.GetLevel(i-1).GetNumVertices();
+        primvarRefiner.Interpolate(i, levelVertices, dstVertices);
+        levelVertices = dstVertices;
+    }
+}
+
+static int
+compareRefiners(char const * test, Far::TopologyRefiner const & refiner,
+    Far::TopologyRefiner const & reference) {
+
+    Sdc::Options options = refiner.GetSchemeOptions(),
+                 referenceOptions = reference.GetSchemeOptions();
+
+    if (refiner.GetSchemeType() != reference.GetSchemeType() or
+        options.GetVtxBoundaryInterpolation() !=
+            referenceOptions.GetVtxBoundaryInterpolation() or
+        options.GetFVarLinearInterpolation() !=
+            referenceOptions.GetFVarLinearInterpolation() or
+        options.GetCreasingMethod() != referenceOptions.GetCreasingMethod() or
+        options.GetTriangleSubdivision() !=
+            referenceOptions.GetTriangleSubdivision() or
+        refiner.IsUniform() != reference.IsUniform() or
+        refiner.GetNumLevels() != reference.GetNumLevels() or
+        refiner.GetMaxLevel() != reference.GetMaxLevel() or
+        refiner.GetMaxValence() != reference.GetMaxValence() or
+        refiner.GetNumVerticesTotal() != reference.GetNumVerticesTotal() or
+        refiner.GetNumEdgesTotal() != reference.GetNumEdgesTotal() or
+        refiner.GetNumFacesTotal() != reference.GetNumFacesTotal() or
+        refiner.GetNumFVarChannels() != reference.GetNumFVarChannels()) {
+        printf("  %s : the refiners differ\n", test);
+        return 1;
+    }
+
+    int failures = 0,
+        numLevels = reference.GetNumLevels();
+    for (int i = 0; i < numLevels; ++i) {
+        bool fullTopology = not reference.IsUniform() or
+            i < numLevels - 1 or
+            reference.GetUniformOptions().fullTopologyInLastLevel;
+        failures += compareLevels(test, i, refiner.GetLevel(i),
+            reference.GetLevel(i), fullTopology);
+    }
+    if (failures) {
+        return failures;
+    }
+
+    // the refiners interpolate the same primvars...
+    std::vector<float> src(reference.GetLevel(0).GetNumVertices() * 3);
+    FillBuffer(src, 0);
+
+    std::vector<Vertex> vertices, referenceVertices;
+    interpolateVertices(refiner, src, vertices);
+    interpolateVertices(reference, src, referenceVertices);
+    failures += compareArrays(test, "interpolated vertices",
+        &vertices[0].p[0], &referenceVertices[0].p[0],
+        (int)vertices.size() * 3);
+
+    // ... and build the same tables
+    Far::StencilTable const * stencils = CreateStencilTable(refiner),
+                            * referenceStencils = CreateStencilTable(reference);
+    failures += compareStencilTables(test, "stencils",
+        stencils, referenceStencils);
+    delete stencils;
+    delete referenceStencils;
+
+    Far::PatchTableFactory::Options patchOptions;
+    patchOptions.generateFVarTables = true;
+    Far::PatchTable * patchTable =
+        Far::PatchTableFactory::Create(refiner, patchOptions);
+    Far::PatchTable * referencePatchTable =
+        Far::PatchTableFactory::Create(reference, patchOptions);
+    failures += comparePatchTables(test, *patchTable, *referencePatchTable);
+    delete patchTable;
+    delete referencePatchTable;
+
+    return failures;
+}
+
+// Corrupts a value of a section of a refiner file : the file must be rejected
+static int
+checkCorruptedRefiner(char const * test, int tag, int index, int value) {
+
+    std::vector<char> data;
+    if (not readFile(g_path, data)) {
+        printf("  %s : cannot read the file\n", test);
+        return 1;
+    }
+    SectionHeader * section = findSection(data, tag);
+    if (not section or (int)section->count <= index) {
+        printf("  %s : no section %d\n", test, tag);
+        return 1;
+    }
+    memcpy(&data[section->offset * 64 + index * section->elementSize],
+        &value, sizeof(int));
+
+    std::string path = std::string(g_path) + ".corrupted";
+    Far::TopologyRefiner * refiner = 0;
+    if (writeFile(path.c_str(), &data[0], data.size())) {
+        refiner = Far::TopologyRefinerFactoryBase::Read(path.c_str());
+    }
+    remove(path.c_str());
+
+    if (refiner) {
+        printf("  %s : the corrupted section %d was read\n", test, tag);
+        delete refiner;
+        return 1;
+    }
+    return 0;
+}
+
+int
+CheckTopologyRefinerFiles() {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (int s = 0; s < (int)shapes.size(); ++s) {
+
+        for (int mode = 0; mode < 4; ++mode) {
+
+            // base mesh, uniform (with and without the full topology of the
+            // last level) and adaptive refinement
+            Far::TopologyRefiner * reference =
+                CreateRefiner(shapes[s], 0, false);
+            if (mode == 1 or mode == 2) {
+                Far::TopologyRefiner::UniformOptions options(3);
+                options.fullTopologyInLastLevel = mode == 2;
+                reference->RefineUniform(options);
+            } else if (mode == 3) {
+                if (shapes[s].scheme != kCatmark) {
+                    delete reference;
+                    continue;
+                }
+                reference->RefineAdaptive(
+                    Far::TopologyRefiner::AdaptiveOptions(3));
+            }
+
+            char name[128];
+            snprintf(name, sizeof(name), "%s refiner (mode %d)",
+                shapes[s].name.c_str(), mode);
+
+            Far::TopologyRefiner * refiner = 0;
+            if (Far::TopologyRefinerFactoryBase::Write(g_path, *reference)) {
+                refiner = Far::TopologyRefinerFactoryBase::Read(g_path);
+            }
+            if (not refiner) {
+                printf("  %s : cannot write and read the file\n", name);
+                ++failures;
+            } else {
+                failures += compareRefiners(name, *refiner, *reference);
+            }
+
+            // out of range indices and layouts of other builds are rejected
+            if (refiner and mode == 3) {
+                Far::SetErrorCallback(countErrors);
+                g_numErrors = 0;
+
+                // the face-vertex counts and offsets and the face-vertex
+                // indices of the base level (see Vtr::internal::Level)
+                static const int countsAndOffsetsTag = 1,
+                                 faceVertsTag = 2;
+                int numVertices = reference->GetLevel(0).GetNumVertices(),
+                    numFaceVerts = reference->GetLevel(0).GetNumFaceVertices();
+                failures += checkCorruptedRefiner(name, faceVertsTag,
+                    numFaceVerts - 1, numVertices);
+                failures += checkCorruptedRefiner(name, faceVertsTag, 0, -1);
+                failures += checkCorruptedRefiner(name, countsAndOffsetsTag,
+                    1, numFaceVerts);
+
+                std::vector<char> data;
+                if (readFile(g_path, data)) {
+                    // the layout follows the magic and the 6 other fields
+                    data[8 + 6 * sizeof(unsigned int)] ^= 1;
+                    std::string path = std::string(g_path) + ".corrupted";
+                    Far::TopologyRefiner * other = 0;
+                    if (writeFile(path.c_str(), &data[0], data.size())) {
+                        other = Far::TopologyRefinerFactoryBase::Read(
+                            path.c_str());
+                    }
+                    remove(path.c_str());
+                    if (other) {
+                        printf("  %s : a file of another layout was read\n",
+                            name);
+                        ++failures;
+                        delete other;
+                    }
+                }
+                if (g_numErrors != 4) {
+                    printf("  %s : %d errors reported\n", name, g_numErrors);
+                    ++failures;
+                }
+                Far::SetErrorCallback(0);
+            }
+
+            delete refiner;
+            delete reference;
+        }
+    }
+    remove(g_path);
+    return failures;
+}
@@ -0,0 +1,93 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "cpu_regression.h"
+
+#include <cstdio>
+
+//
+// Regression testing of the CPU evaluation paths (see cpu_regression.h)
+//
+
+struct Test {
+    char const * name;
+    int (*check)();
+};
+
+static Test g_tests[] = {
+    { "SIMD stencil kernels", CheckSimdStencils },
+    { "fused derivative stencils", CheckFusedDerivativeStencils },
+    { "batched patches", CheckBatchedPatches },
+    { "thread pool evaluator", CheckThreadPoolEvaluator },
+    { "stencil partitions", CheckStencilPartitions },
+    { "OpenMP evaluator", CheckOmpEvaluator },
+    { "asynchronous evaluation", CheckAsyncEvaluation },
+    { "multi-buffer stencils", CheckMultiBufferStencils },
+    { "double precision stencils", CheckDoubleStencils },
+    { "double precision patches", CheckDoublePatches },
+    { "half precision stencils", CheckHalfStencils },
+    { "compressed stencils", CheckCompressedStencils },
+    { "reordered stencils", CheckReorderedStencils },
+    { "dirty stencils", CheckDirtyStencils },
+    { "stencil deltas", CheckStencilDeltas },
+    { "instance stencils", CheckInstanceStencils },
+    { "structure of arrays stencils", CheckSoAStencils },
+    { "allocation", CheckAllocation },
+    { "NUMA stencil tables", CheckNumaStencilTable },
+    { "patch normals", CheckPatchNormals },
+    { "2nd derivative stencils", CheckSecondDerivativeStencils },
+    { "2nd derivative patches", CheckSecondDerivativePatches },
+    { "stats", CheckStats },
+    { "parallel stencil factory", CheckParallelStencilFactory },
+    { "hashed stencils", CheckHashedStencils },
+    { "stencil table files", CheckStencilTableFiles },
+    { "patch table files", CheckPatchTableFiles },
+    { "topology refiner files", CheckTopologyRefinerFiles },
+};
+
+//------------------------------------------------------------------------------
+int
+main(int /* argc */, char ** /* argv */) {
+
+    int total = 0;
+    for (size_t i = 0; i < sizeof(g_tests) / sizeof(Test); ++i) {
+
+        printf("- %s :\n", g_tests[i].name);
+
+        int failures = g_tests[i].check();
+        if (failures) {
+            printf("  %d failures\n", failures);
+        } else {
+            printf("  success !\n");
+        }
+        total += failures;
+    }
+
+    if (total==0) {
+        printf("All tests passed.\n");
+    } else {
+        printf("Total failures : %d\n", total);
+    }
+    return total;
+}
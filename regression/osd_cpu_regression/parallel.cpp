@@ -0,0 +1,749 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "cpu_regression.h"
+
+#include <osd/bufferDescriptor.h>
+#include <osd/cpuEvaluator.h>
+#include <osd/cpuVertexBuffer.h>
+
+#include <osd/cpuKernel.h>
+
+#if defined(OPENSUBDIV_HAS_OPENMP)
+    #include <osd/ompEvaluator.h>
+    #include <omp.h>
+#endif
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+#if defined(OPENSUBDIV_HAS_THREADPOOL)
+    #include <osd/threadPoolEvaluator.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace OpenSubdiv;
+
+//
+// The parallel evaluators are matched against the serial CpuEvaluator : they
+// run the same kernels over partitions of the stencils and coordinates, so
+// their results are expected to match closely.
+//
+
+// Value of the buffer elements that no evaluation should write
+static const float g_sentinel = 1234.5f;
+
+// Primvar layouts (length, padding) the evaluators are exercised with
+static const int g_layouts[][2] = {
+    { 3, 0 }, { 4, 0 }, { 3, 2 }, { 9, 1 },
+};
+
+static const int g_numLayouts = sizeof(g_layouts) / sizeof(g_layouts[0]);
+
+template <class EVALUATOR>
+static int
+checkParallelStencils(char const * name) {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+        int numStencils = table->GetNumStencils();
+
+        for (int l = 0; l < g_numLayouts; ++l) {
+
+            int length = g_layouts[l][0],
+                stride = length + g_layouts[l][1];
+
+            Osd::BufferDescriptor desc(g_layouts[l][1] / 2, length, stride);
+
+            std::vector<float> src(table->GetNumControlVertices() * stride);
+            FillBuffer(src, (unsigned int)(s * g_numLayouts + l));
+
+            // the whole table and a range starting past the first stencil
+            int ranges[2][2] = { { 0, numStencils },
+                                 { numStencils / 3, numStencils } };
+
+            for (int r = 0; r < 2; ++r) {
+
+                std::vector<float> reference(numStencils * stride,
+                                             g_sentinel),
+                                   dst(reference);
+
+                Osd::CpuEvaluator::EvalStencils(
+                    &src[0], desc, &reference[0], desc,
+                    &table->GetSizes()[0], &table->GetOffsets()[0],
+                    &table->GetControlIndices()[0], &table->GetWeights()[0],
+                    ranges[r][0], ranges[r][1]);
+
+                EVALUATOR::EvalStencils(
+                    &src[0], desc, &dst[0], desc,
+                    &table->GetSizes()[0], &table->GetOffsets()[0],
+                    &table->GetControlIndices()[0], &table->GetWeights()[0],
+                    ranges[r][0], ranges[r][1]);
+
+                char test[128];
+                snprintf(test, sizeof(test), "%s %s stencils %d-%d",
+                         name, shapes[s].name.c_str(),
+                         ranges[r][0], ranges[r][1]);
+                failures += CompareBuffers(test, &dst[0], &reference[0],
+                                           (int)dst.size(), 1e-6);
+            }
+        }
+        delete table;
+        delete refiner;
+
+        if (shapes[s].scheme != kCatmark) continue;
+
+        // limit points and derivatives
+        refiner = CreateRefiner(shapes[s], 3, true);
+        Far::LimitStencilTable const * limitTable =
+            CreateLimitStencilTable(*refiner);
+
+        numStencils = limitTable->GetNumStencils();
+
+        Osd::BufferDescriptor desc(0, 3, 3);
+
+        std::vector<float> src(limitTable->GetNumControlVertices() * 3);
+        FillBuffer(src, (unsigned int)s);
+
+        std::vector<float> reference[3], dst[3];
+        for (int i = 0; i < 3; ++i) {
+            reference[i].assign(numStencils * 3, g_sentinel);
+            dst[i].assign(numStencils * 3, g_sentinel);
+        }
+
+        Osd::CpuEvaluator::EvalStencils(&src[0], desc,
+            &reference[0][0], desc, &reference[1][0], desc,
+            &reference[2][0], desc,
+            &limitTable->GetSizes()[0], &limitTable->GetOffsets()[0],
+            &limitTable->GetControlIndices()[0],
+            &limitTable->GetWeights()[0], &limitTable->GetDuWeights()[0],
+            &limitTable->GetDvWeights()[0], 0, numStencils);
+
+        EVALUATOR::EvalStencils(&src[0], desc,
+            &dst[0][0], desc, &dst[1][0], desc, &dst[2][0], desc,
+            &limitTable->GetSizes()[0], &limitTable->GetOffsets()[0],
+            &limitTable->GetControlIndices()[0],
+            &limitTable->GetWeights()[0], &limitTable->GetDuWeights()[0],
+            &limitTable->GetDvWeights()[0], 0, numStencils);
+
+        char test[128];
+        snprintf(test, sizeof(test), "%s %s limit stencils",
+                 name, shapes[s].name.c_str());
+        for (int i = 0; i < 3; ++i) {
+            failures += CompareBuffers(test, &dst[i][0], &reference[i][0],
+                                       (int)dst[i].size(), 1e-6);
+        }
+
+        delete limitTable;
+        delete refiner;
+    }
+    return failures;
+}
+
+template <class EVALUATOR>
+static int
+checkParallelPatches(char const * name) {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        if (shapes[s].scheme != kCatmark) continue;
+
+        PatchData data(shapes[s],
+            Far::PatchTableFactory::Options::ENDCAP_GREGORY_BASIS, false);
+
+        Osd::PatchArray const * patchArrays =
+            data.cpuPatchTable->GetPatchArrayBuffer();
+        int const * patchIndices =
+            data.cpuPatchTable->GetPatchIndexBuffer();
+        Osd::PatchParam const * patchParams =
+            data.cpuPatchTable->GetPatchParamBuffer();
+
+        int numCoords = data.GetNumCoords();
+
+        Osd::BufferDescriptor desc(0, 3, 3);
+
+        std::vector<float> src(data.numVertices * 3);
+        FillBuffer(src, (unsigned int)s);
+
+        std::vector<float> reference[3], dst[3];
+        for (int i = 0; i < 3; ++i) {
+            reference[i].assign(numCoords * 3, g_sentinel);
+            dst[i].assign(numCoords * 3, g_sentinel);
+        }
+
+        Osd::CpuEvaluator::EvalPatches(&src[0], desc,
+            &reference[0][0], desc, &reference[1][0], desc,
+            &reference[2][0], desc, numCoords, &data.coords[0],
+            patchArrays, patchIndices, patchParams);
+
+        EVALUATOR::EvalPatches(&src[0], desc,
+            &dst[0][0], desc, &dst[1][0], desc, &dst[2][0], desc,
+            numCoords, &data.coords[0],
+            patchArrays, patchIndices, patchParams);
+
+        char test[128];
+        snprintf(test, sizeof(test), "%s %s patches",
+                 name, shapes[s].name.c_str());
+        for (int i = 0; i < 3; ++i) {
+            failures += CompareBuffers(test, &dst[i][0], &reference[i][0],
+                                       (int)dst[i].size(), 1e-6);
+        }
+
+        // points only
+        std::vector<float> points(numCoords * 3, g_sentinel);
+        EVALUATOR::EvalPatches(&src[0], desc, &points[0], desc,
+            numCoords, &data.coords[0],
+            patchArrays, patchIndices, patchParams);
+        failures += CompareBuffers(test, &points[0], &reference[0][0],
+                                   (int)points.size(), 1e-6);
+    }
+    return failures;
+}
+
+template <class EVALUATOR>
+static int
+checkPatchNormals(char const * name) {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        if (shapes[s].scheme != kCatmark) continue;
+
+        PatchData data(shapes[s],
+            Far::PatchTableFactory::Options::ENDCAP_GREGORY_BASIS, false);
+
+        Osd::PatchArray const * patchArrays =
+            data.cpuPatchTable->GetPatchArrayBuffer();
+        int const * patchIndices =
+            data.cpuPatchTable->GetPatchIndexBuffer();
+        Osd::PatchParam const * patchParams =
+            data.cpuPatchTable->GetPatchParamBuffer();
+
+        int numCoords = data.GetNumCoords();
+
+        // the normals are interleaved with another primvar, and computed
+        // from the first three elements of a longer source primvar
+        Osd::BufferDescriptor srcDesc(0, 4, 4),
+                              dstDesc(0, 4, 4),
+                              normalDesc(1, 3, 5);
+
+        std::vector<float> src(data.numVertices * 4);
+        FillBuffer(src, (unsigned int)s);
+
+        std::vector<float> points(numCoords * 4, g_sentinel),
+                           du(numCoords * 4, g_sentinel),
+                           dv(numCoords * 4, g_sentinel);
+
+        Osd::CpuEvaluator::EvalPatches(&src[0], srcDesc,
+            &points[0], dstDesc, &du[0], dstDesc, &dv[0], dstDesc,
+            numCoords, &data.coords[0],
+            patchArrays, patchIndices, patchParams);
+
+        std::vector<float> reference(numCoords * 5, g_sentinel);
+        for (int i = 0; i < numCoords; ++i) {
+            float const * u = &du[i * 4],
+                        * v = &dv[i * 4];
+            double n[3] = { (double)u[1]*v[2] - (double)u[2]*v[1],
+                            (double)u[2]*v[0] - (double)u[0]*v[2],
+                            (double)u[0]*v[1] - (double)u[1]*v[0] };
+            double len = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+            for (int e = 0; e < 3; ++e) {
+                reference[i * 5 + 1 + e] =
+                    len > 0 ? (float)(n[e] / len) : 0.0f;
+            }
+        }
+
+        char test[128];
+        snprintf(test, sizeof(test), "%s %s patch normals",
+                 name, shapes[s].name.c_str());
+
+        // with and without the limit points
+        for (int withPoints = 0; withPoints < 2; ++withPoints) {
+
+            std::vector<float> dst(numCoords * 4, g_sentinel),
+                               normals(numCoords * 5, g_sentinel);
+
+            if (not EVALUATOR::EvalPatchNormals(&src[0], srcDesc,
+                    withPoints ? &dst[0] : 0, dstDesc,
+                    &normals[0], normalDesc, numCoords, &data.coords[0],
+                    patchArrays, patchIndices, patchParams)) {
+                printf("  %s : evaluation failed\n", test);
+                ++failures;
+                continue;
+            }
+
+            failures += CompareBuffers(test, &normals[0], &reference[0],
+                                       (int)normals.size(), 1e-4);
+            if (withPoints) {
+                failures += CompareBuffers(test, &dst[0], &points[0],
+                                           (int)dst.size(), 1e-6);
+            }
+        }
+    }
+    return failures;
+}
+
+// Thread counts the evaluators are run with, including more threads than
+// the number of cores of most test machines
+static const int g_numThreads[] = { 1, 2, 3, 16 };
+
+//------------------------------------------------------------------------------
+int
+CheckPatchNormals() {
+
+    return checkPatchNormals<Osd::CpuEvaluator>("CPU");
+}
+
+//------------------------------------------------------------------------------
+int
+CheckThreadPoolEvaluator() {
+
+    int failures = 0;
+#if defined(OPENSUBDIV_HAS_THREADPOOL)
+    for (int i = 0; i < 4; ++i) {
+
+        Osd::ThreadPoolEvaluator::SetNumThreads(g_numThreads[i]);
+
+        char name[64];
+        snprintf(name, sizeof(name), "thread pool (%d threads)",
+                 g_numThreads[i]);
+        failures += checkParallelStencils<Osd::ThreadPoolEvaluator>(name);
+        failures += checkParallelPatches<Osd::ThreadPoolEvaluator>(name);
+        failures += checkPatchNormals<Osd::ThreadPoolEvaluator>(name);
+    }
+    Osd::ThreadPoolEvaluator::SetNumThreads(0);
+#endif
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// The partitions of the parallel stencil kernels must cover the stencil range
+// in order, each holding at most one stencil more than its share of weights.
+int
+CheckStencilPartitions() {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 4, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+        int const * sizes = &table->GetSizes()[0],
+                  * offsets = &table->GetOffsets()[0];
+
+        int numStencils = table->GetNumStencils(),
+            maxSize = *std::max_element(table->GetSizes().begin(),
+                                        table->GetSizes().end());
+
+        int ranges[3][2] = { { 0, numStencils },
+                             { numStencils / 3, numStencils },
+                             { numStencils / 2, numStencils / 2 + 1 } };
+
+        static const int minPartitions[] = { 1, 4, 64 };
+
+        for (int r = 0; r < 3; ++r) {
+            int start = ranges[r][0],
+                end = ranges[r][1],
+                numWeights = offsets[end-1] + sizes[end-1] - offsets[start];
+
+            for (int m = 0; m < 3; ++m) {
+
+                int numPartitions = Osd::CpuGetNumStencilPartitions(
+                    sizes, offsets, start, end, minPartitions[m]);
+
+                bool valid = numPartitions >= 1 and
+                    numPartitions <= end - start and
+                    numPartitions >= std::min(minPartitions[m], end - start);
+
+                int maxWeights = numWeights / numPartitions + maxSize + 1,
+                    last = start;
+                for (int p = 0; p <= numPartitions; ++p) {
+                    int first = Osd::CpuGetStencilPartitionStart(sizes,
+                        offsets, start, end, p, numPartitions);
+                    if (p == 0) {
+                        valid = valid and first == start;
+                    } else {
+                        int partitionWeights = (first < end ?
+                            offsets[first] : offsets[end-1] + sizes[end-1]) -
+                            offsets[last];
+                        valid = valid and first >= last and
+                                partitionWeights <= maxWeights;
+                    }
+                    last = first;
+                }
+                valid = valid and last == end;
+
+                if (not valid) {
+                    printf("  %s : invalid partitions of %d-%d (%d min)\n",
+                           shapes[s].name.c_str(), start, end,
+                           minPartitions[m]);
+                    ++failures;
+                }
+            }
+        }
+        delete table;
+        delete refiner;
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+int
+CheckOmpEvaluator() {
+
+    int failures = 0;
+#if defined(OPENSUBDIV_HAS_OPENMP)
+    int defaultNumThreads = omp_get_max_threads();
+    for (int i = 0; i < 4; ++i) {
+
+        Osd::OmpEvaluator::SetNumThreads(g_numThreads[i]);
+
+        char name[64];
+        snprintf(name, sizeof(name), "OpenMP (%d threads)", g_numThreads[i]);
+        failures += checkParallelStencils<Osd::OmpEvaluator>(name);
+        failures += checkParallelPatches<Osd::OmpEvaluator>(name);
+        failures += checkPatchNormals<Osd::OmpEvaluator>(name);
+    }
+    Osd::OmpEvaluator::SetNumThreads(defaultNumThreads);
+#endif
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+#if defined(OPENSUBDIV_HAS_OPENMP)
+// Builds the stencils of the refiner with the given number of OpenMP threads
+template <typename REAL>
+static Far::StencilTableReal<REAL> const *
+createStencilTable(Far::TopologyRefiner const & refiner,
+    typename Far::StencilTableFactoryReal<REAL>::Options const & options,
+        int numThreads) {
+
+    int defaultNumThreads = omp_get_max_threads();
+    omp_set_num_threads(numThreads);
+    Far::StencilTableReal<REAL> const * table =
+        Far::StencilTableFactoryReal<REAL>::Create(refiner, options);
+    omp_set_num_threads(defaultNumThreads);
+    return table;
+}
+
+template <typename REAL>
+static int
+compareStencilTables(char const * test,
+    Far::StencilTableReal<REAL> const & table,
+        Far::StencilTableReal<REAL> const & reference) {
+
+    if (table.GetNumStencils() != reference.GetNumStencils() or
+        table.GetNumControlVertices() != reference.GetNumControlVertices() or
+        table.GetSizes() != reference.GetSizes() or
+        table.GetOffsets() != reference.GetOffsets() or
+        table.GetControlIndices() != reference.GetControlIndices() or
+        table.GetWeights() != reference.GetWeights()) {
+        printf("  %s : the stencils differ from the serial ones\n", test);
+        return 1;
+    }
+    return 0;
+}
+
+template <typename REAL>
+static int
+checkParallelStencilFactory(char const * precision) {
+
+    static const int numThreads[] = { 2, 3, 8 };
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (int i = 0; i < (int)shapes.size(); ++i) {
+
+        // refine deep enough for the last parent level to be split in chunks
+        Far::TopologyRefiner * refiner = 0;
+        for (int level = 5; level <= 7; ++level) {
+            delete refiner;
+            refiner = CreateRefiner(shapes[i], level, false);
+            if (refiner->GetLevel(level-1).GetNumEdges() >= 2048) break;
+        }
+        int maxLevel = refiner->GetMaxLevel();
+        if (refiner->GetLevel(maxLevel-1).GetNumEdges() < 2048) {
+            printf("  %s : too few edges to build the stencils in parallel\n",
+                shapes[i].name.c_str());
+            ++failures;
+        }
+
+        for (int mode = 0; mode < 3; ++mode) {
+
+            typename Far::StencilTableFactoryReal<REAL>::Options options;
+            options.generateIntermediateLevels = mode != 0;
+            options.factorizeIntermediateLevels = mode != 2;
+
+            Far::StencilTableReal<REAL> const * reference =
+                createStencilTable<REAL>(*refiner, options, 1);
+
+            for (int j = 0; j < 3; ++j) {
+                Far::StencilTableReal<REAL> const * table =
+                    createStencilTable<REAL>(*refiner, options, numThreads[j]);
+
+                char name[128];
+                snprintf(name, sizeof(name),
+                    "%s %s stencils (mode %d, %d threads)",
+                    shapes[i].name.c_str(), precision, mode, numThreads[j]);
+                failures += compareStencilTables(name, *table, *reference);
+
+                delete table;
+            }
+            delete reference;
+        }
+        delete refiner;
+    }
+    return failures;
+}
+#endif
+
+int
+CheckParallelStencilFactory() {
+
+    int failures = 0;
+#if defined(OPENSUBDIV_HAS_OPENMP)
+    failures += checkParallelStencilFactory<float>("float");
+    failures += checkParallelStencilFactory<double>("double");
+#endif
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+int
+CheckNumaStencilTable() {
+
+    int failures = 0;
+#if defined(OPENSUBDIV_HAS_OPENMP)
+#if defined(__linux__)
+    cpu_set_t affinity;
+    CPU_ZERO(&affinity);
+    sched_getaffinity(0, sizeof(affinity), &affinity);
+#endif
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+        Osd::OmpNumaStencilTable numaTable(table);
+
+        int numStencils = table->GetNumStencils();
+
+        for (int l = 0; l < g_numLayouts; ++l) {
+
+            int length = g_layouts[l][0],
+                stride = length + g_layouts[l][1];
+
+            Osd::BufferDescriptor desc(g_layouts[l][1] / 2, length, stride);
+
+            std::vector<float> src(table->GetNumControlVertices() * stride);
+            FillBuffer(src, (unsigned int)(s * g_numLayouts + l));
+
+            // the padding stands for other interleaved primvars, which
+            // neither the touch nor the evaluation may write
+            std::vector<float> reference(numStencils * stride, g_sentinel),
+                               dst(reference);
+            for (int i = 0; i < numStencils; ++i) {
+                std::fill(&reference[i * stride + desc.offset],
+                          &reference[i * stride + desc.offset] + length,
+                          0.0f);
+            }
+
+            numaTable.TouchDestination(&dst[0], desc);
+
+            char test[128];
+            snprintf(test, sizeof(test), "NUMA %s touch layout %d",
+                     shapes[s].name.c_str(), l);
+            failures += CompareBuffers(test, &dst[0], &reference[0],
+                                       (int)dst.size(), 0.0);
+
+            Osd::CpuEvaluator::EvalStencils(
+                &src[0], desc, &reference[0], desc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                0, numStencils);
+
+            if (not numaTable.EvalStencils(&src[0], desc, &dst[0], desc)) {
+                printf("  NUMA %s stencils : evaluation failed\n",
+                       shapes[s].name.c_str());
+                ++failures;
+                continue;
+            }
+
+            snprintf(test, sizeof(test), "NUMA %s stencils layout %d",
+                     shapes[s].name.c_str(), l);
+            failures += CompareBuffers(test, &dst[0], &reference[0],
+                                       (int)dst.size(), 1e-6);
+        }
+        delete table;
+        delete refiner;
+    }
+
+#if defined(__linux__)
+    // the calling thread must not be left pinned to a node
+    cpu_set_t current;
+    CPU_ZERO(&current);
+    sched_getaffinity(0, sizeof(current), &current);
+    if (not CPU_EQUAL(&current, &affinity)) {
+        printf("  NUMA : the affinity of the calling thread changed\n");
+        ++failures;
+    }
+#endif
+#endif
+    return failures;
+}
+
+// Table without any stencil
+class EmptyStencilTable : public Far::StencilTable {
+public:
+    EmptyStencilTable() : Far::StencilTable(0) { }
+};
+
+//------------------------------------------------------------------------------
+// Asynchronous evaluations run in order : the second evaluation of each chain
+// reads the results of the first one as its control values. The chains are
+// matched against synchronous evaluations.
+template <class EVALUATOR>
+static int
+checkAsyncEvaluation(char const * name) {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+        int numControlVertices = table->GetNumControlVertices(),
+            numStencils = table->GetNumStencils();
+
+        Osd::BufferDescriptor desc(0, 3, 3);
+
+        std::vector<float> src(numControlVertices * 3),
+                           first(numStencils * 3, g_sentinel),
+                           second(first),
+                           firstReference(first),
+                           secondReference(first);
+        FillBuffer(src, (unsigned int)s);
+
+        Osd::AsyncEvaluation evaluations[2] = {
+            EVALUATOR::EvalStencilsAsync(&src[0], desc, &first[0], desc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                0, numStencils),
+            EVALUATOR::EvalStencilsAsync(&first[0], desc, &second[0], desc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                0, numStencils) };
+
+        Osd::CpuEvaluator::EvalStencils(&src[0], desc,
+            &firstReference[0], desc,
+            &table->GetSizes()[0], &table->GetOffsets()[0],
+            &table->GetControlIndices()[0], &table->GetWeights()[0],
+            0, numStencils);
+        Osd::CpuEvaluator::EvalStencils(&firstReference[0], desc,
+            &secondReference[0], desc,
+            &table->GetSizes()[0], &table->GetOffsets()[0],
+            &table->GetControlIndices()[0], &table->GetWeights()[0],
+            0, numStencils);
+
+        char test[128];
+        snprintf(test, sizeof(test), "%s %s", name, shapes[s].name.c_str());
+
+        if (not evaluations[1].Wait() or not evaluations[0].IsComplete() or
+            not evaluations[0].Wait()) {
+            printf("  %s : evaluation failed\n", test);
+            ++failures;
+        }
+        failures += CompareBuffers(test, &first[0], &firstReference[0],
+                                   (int)first.size(), 1e-6);
+        failures += CompareBuffers(test, &second[0], &secondReference[0],
+                                   (int)second.size(), 1e-5);
+
+        delete table;
+        delete refiner;
+    }
+
+    // handles released before completion, waited for by Synchronize()
+    std::vector<float> src(3, 1.0f), dst(3, g_sentinel);
+    int size = 1, offset = 0, index = 0;
+    float weight = 2.0f;
+    for (int i = 0; i < 256; ++i) {
+        EVALUATOR::EvalStencilsAsync(&src[0], Osd::BufferDescriptor(0, 3, 3),
+            &dst[0], Osd::BufferDescriptor(0, 3, 3),
+            &size, &offset, &index, &weight, 0, 1);
+    }
+
+    // an empty table launches nothing : its handle is complete at once,
+    // while the evaluations above are pending
+    {
+        EmptyStencilTable table;
+        Osd::CpuVertexBuffer * buffer = Osd::CpuVertexBuffer::Create(3, 1);
+        Osd::AsyncEvaluation evaluation = EVALUATOR::EvalStencilsAsync(
+            buffer, Osd::BufferDescriptor(0, 3, 3),
+            buffer, Osd::BufferDescriptor(0, 3, 3), &table);
+        if (not evaluation.IsComplete() or not evaluation.Wait()) {
+            printf("  %s : the evaluation of an empty table is pending\n",
+                   name);
+            ++failures;
+        }
+        delete buffer;
+    }
+
+    EVALUATOR::Synchronize(NULL);
+    std::vector<float> expected(3, 2.0f);
+    failures += CompareBuffers(name, &dst[0], &expected[0], 3, 0.0);
+
+    return failures;
+}
+
+int
+CheckAsyncEvaluation() {
+
+    int failures = checkAsyncEvaluation<Osd::CpuEvaluator>("cpu");
+#if defined(OPENSUBDIV_HAS_THREADPOOL)
+    failures += checkAsyncEvaluation<Osd::ThreadPoolEvaluator>("thread pool");
+#endif
+    return failures;
+}
@@ -0,0 +1,380 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "cpu_regression.h"
+
+#include <osd/bufferDescriptor.h>
+#include <osd/cpuEvaluator.h>
+
+#include <cstdio>
+
+using namespace OpenSubdiv;
+
+// Value of the buffer elements that no evaluation should write
+static const float g_sentinel = 1234.5f;
+
+//
+// Reference evaluation of the patches : the basis of each coordinate is
+// evaluated with the Far patch table and applied to the primvars in double
+// precision. The outputs use the element layout of dstDesc, and the 2nd
+// derivatives are only evaluated if requested.
+//
+template <typename REAL>
+static void
+evalReference(PatchData const & data,
+              std::vector<Osd::PatchCoordReal<REAL> > const & coords,
+              REAL const * src, Osd::BufferDescriptor const & srcDesc,
+              REAL * dst, REAL * du, REAL * dv,
+              Osd::BufferDescriptor const & dstDesc,
+              REAL * duu = 0, REAL * duv = 0, REAL * dvv = 0) {
+
+    bool secondDerivs = (duu or duv or dvv);
+
+    for (size_t i = 0; i < coords.size(); ++i) {
+
+        Osd::PatchCoordReal<REAL> const & coord = coords[i];
+
+        REAL wP[20], wDs[20], wDt[20], wDss[20], wDst[20], wDtt[20];
+        data.patchTable->EvaluateBasis(coord.handle, coord.s, coord.t,
+                                       wP, wDs, wDt,
+                                       secondDerivs ? wDss : 0,
+                                       secondDerivs ? wDst : 0,
+                                       secondDerivs ? wDtt : 0);
+
+        Far::ConstIndexArray cvs =
+            data.patchTable->GetPatchVertices(coord.handle);
+
+        for (int k = 0; k < srcDesc.length; ++k) {
+            double p = 0, ds = 0, dt = 0, dss = 0, dsdt = 0, dtt = 0;
+            for (int j = 0; j < cvs.size(); ++j) {
+                double v = src[srcDesc.offset + cvs[j] * srcDesc.stride + k];
+                p  += v * wP[j];
+                ds += v * wDs[j];
+                dt += v * wDt[j];
+                if (secondDerivs) {
+                    dss  += v * wDss[j];
+                    dsdt += v * wDst[j];
+                    dtt  += v * wDtt[j];
+                }
+            }
+            int element = dstDesc.offset + (int)i * dstDesc.stride + k;
+            if (dst) dst[element] = (REAL)p;
+            if (du)  du[element]  = (REAL)ds;
+            if (dv)  dv[element]  = (REAL)dt;
+            if (duu) duu[element] = (REAL)dss;
+            if (duv) duv[element] = (REAL)dsdt;
+            if (dvv) dvv[element] = (REAL)dtt;
+        }
+    }
+}
+
+// Primvar layouts (length, padding) the patches are evaluated with
+static const int g_layouts[][2] = {
+    { 1, 0 }, { 3, 0 }, { 3, 1 }, { 4, 0 }, { 7, 2 },
+};
+
+static const int g_numLayouts = sizeof(g_layouts) / sizeof(g_layouts[0]);
+
+static const EndCapType g_endCapTypes[] = {
+    Far::PatchTableFactory::Options::ENDCAP_BSPLINE_BASIS,
+    Far::PatchTableFactory::Options::ENDCAP_GREGORY_BASIS,
+};
+
+//------------------------------------------------------------------------------
+// The batched evaluation of the points and derivatives is matched against the
+// evaluation of each coordinate with the Far patch basis, for coordinates
+// grouped by patch and shuffled ones, which the evaluation bins by patch.
+int
+CheckBatchedPatches() {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        if (shapes[s].scheme != kCatmark) continue;
+
+        for (int e = 0; e < 2; ++e) {
+            for (int grouped = 0; grouped < 2; ++grouped) {
+
+                PatchData data(shapes[s], g_endCapTypes[e], grouped != 0);
+
+                int numCoords = data.GetNumCoords();
+
+                for (int l = 0; l < g_numLayouts; ++l) {
+
+                    int length = g_layouts[l][0],
+                        stride = length + g_layouts[l][1];
+
+                    Osd::BufferDescriptor desc(g_layouts[l][1] / 2,
+                                               length, stride);
+
+                    std::vector<float> src(data.numVertices * stride);
+                    FillBuffer(src, (unsigned int)(s * g_numLayouts + l));
+
+                    std::vector<float> refP(numCoords * stride, g_sentinel),
+                                       refDu(refP), refDv(refP);
+                    evalReference(data, data.coords, &src[0], desc,
+                                  &refP[0], &refDu[0], &refDv[0], desc);
+
+                    std::vector<float> p(refP.size(), g_sentinel),
+                                       du(p), dv(p), pOnly(p);
+
+                    Osd::CpuEvaluator::EvalPatches(&src[0], desc,
+                        &p[0], desc, &du[0], desc, &dv[0], desc,
+                        numCoords, &data.coords[0],
+                        data.cpuPatchTable->GetPatchArrayBuffer(),
+                        data.cpuPatchTable->GetPatchIndexBuffer(),
+                        data.cpuPatchTable->GetPatchParamBuffer());
+
+                    Osd::CpuEvaluator::EvalPatches(&src[0], desc,
+                        &pOnly[0], desc,
+                        numCoords, &data.coords[0],
+                        data.cpuPatchTable->GetPatchArrayBuffer(),
+                        data.cpuPatchTable->GetPatchIndexBuffer(),
+                        data.cpuPatchTable->GetPatchParamBuffer());
+
+                    char test[128];
+                    snprintf(test, sizeof(test),
+                             "%s end cap %d grouped %d length %d",
+                             shapes[s].name.c_str(), e, grouped, length);
+                    failures += CompareBuffers(test, &p[0], &refP[0],
+                                               (int)p.size(), 1e-5);
+                    failures += CompareBuffers(test, &du[0], &refDu[0],
+                                               (int)du.size(), 1e-4);
+                    failures += CompareBuffers(test, &dv[0], &refDv[0],
+                                               (int)dv.size(), 1e-4);
+                    failures += CompareBuffers(test, &pOnly[0], &refP[0],
+                                               (int)pOnly.size(), 1e-5);
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// The double precision evaluation is matched against the reference evaluation
+// in double precision. The coordinates are moved by less than the float
+// precision so that they are only matched if evaluated in double precision.
+int
+CheckDoublePatches() {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        if (shapes[s].scheme != kCatmark) continue;
+
+        for (int e = 0; e < 2; ++e) {
+
+            PatchData data(shapes[s], g_endCapTypes[e], false);
+
+            int numCoords = data.GetNumCoords();
+
+            std::vector<Osd::PatchCoordReal<double> > coords(numCoords);
+            for (int i = 0; i < numCoords; ++i) {
+                coords[i] = Osd::PatchCoordReal<double>(
+                    data.coords[i].handle,
+                    data.coords[i].s * (1.0 - 1e-9),
+                    data.coords[i].t * (1.0 - 1e-9));
+            }
+
+            Osd::BufferDescriptor desc(0, 3, 3);
+
+            std::vector<double> src(data.numVertices * 3);
+            FillBuffer(src, (unsigned int)s);
+
+            std::vector<double> refP(numCoords * 3), refDu(refP), refDv(refP);
+            evalReference(data, coords, &src[0], desc,
+                          &refP[0], &refDu[0], &refDv[0], desc);
+
+            std::vector<double> p(refP.size()), du(p), dv(p), pOnly(p);
+
+            Osd::CpuEvaluator::EvalPatches(&src[0], desc,
+                &p[0], desc, &du[0], desc, &dv[0], desc,
+                numCoords, &coords[0],
+                data.cpuPatchTable->GetPatchArrayBuffer(),
+                data.cpuPatchTable->GetPatchIndexBuffer(),
+                data.cpuPatchTable->GetPatchParamBuffer());
+
+            Osd::CpuEvaluator::EvalPatches(&src[0], desc, &pOnly[0], desc,
+                numCoords, &coords[0],
+                data.cpuPatchTable->GetPatchArrayBuffer(),
+                data.cpuPatchTable->GetPatchIndexBuffer(),
+                data.cpuPatchTable->GetPatchParamBuffer());
+
+            char test[128];
+            snprintf(test, sizeof(test), "%s end cap %d double",
+                     shapes[s].name.c_str(), e);
+            failures += CompareBuffers(test, &p[0], &refP[0],
+                                       (int)p.size(), 1e-12);
+            failures += CompareBuffers(test, &du[0], &refDu[0],
+                                       (int)du.size(), 1e-11);
+            failures += CompareBuffers(test, &dv[0], &refDv[0],
+                                       (int)dv.size(), 1e-11);
+            failures += CompareBuffers(test, &pOnly[0], &refP[0],
+                                       (int)pOnly.size(), 1e-12);
+        }
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// The 2nd derivatives are matched against the reference evaluation, in single
+// and double precision. With B-spline end caps, they are also matched against
+// the central differences of the 1st derivatives (the derivatives of the
+// Gregory patches hold their rational blending constant, and so are not the
+// derivatives of each other).
+int
+CheckSecondDerivativePatches() {
+
+    int failures = 0;
+
+    static const double h = 1e-5;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        if (shapes[s].scheme != kCatmark) continue;
+
+        for (int e = 0; e < 2; ++e) {
+
+            PatchData data(shapes[s], g_endCapTypes[e], false);
+
+            int numCoords = data.GetNumCoords();
+
+            std::vector<Osd::PatchCoordReal<double> > coords(numCoords);
+            for (int i = 0; i < numCoords; ++i) {
+                coords[i] = Osd::PatchCoordReal<double>(data.coords[i].handle,
+                    data.coords[i].s, data.coords[i].t);
+            }
+
+            Osd::BufferDescriptor desc(0, 3, 3);
+
+            std::vector<double> src(data.numVertices * 3);
+            FillBuffer(src, (unsigned int)s);
+
+            std::vector<double> refDuu(numCoords * 3), refDuv(refDuu),
+                                refDvv(refDuu);
+            evalReference(data, coords, &src[0], desc,
+                          (double *)0, (double *)0, (double *)0, desc,
+                          &refDuu[0], &refDuv[0], &refDvv[0]);
+
+            std::vector<double> duu(refDuu.size()), duv(duu), dvv(duu);
+
+            Osd::CpuEvaluator::EvalPatches(&src[0], desc,
+                (double *)0, desc, (double *)0, desc, (double *)0, desc,
+                &duu[0], desc, &duv[0], desc, &dvv[0], desc,
+                numCoords, &coords[0],
+                data.cpuPatchTable->GetPatchArrayBuffer(),
+                data.cpuPatchTable->GetPatchIndexBuffer(),
+                data.cpuPatchTable->GetPatchParamBuffer());
+
+            char test[128];
+            snprintf(test, sizeof(test), "%s end cap %d 2nd derivatives",
+                     shapes[s].name.c_str(), e);
+            failures += CompareBuffers(test, &duu[0], &refDuu[0],
+                                       (int)duu.size(), 1e-11);
+            failures += CompareBuffers(test, &duv[0], &refDuv[0],
+                                       (int)duv.size(), 1e-11);
+            failures += CompareBuffers(test, &dvv[0], &refDvv[0],
+                                       (int)dvv.size(), 1e-11);
+
+            std::vector<float> floatSrc(src.begin(), src.end()),
+                               floatDuu(duu.size(), g_sentinel),
+                               floatDuv(floatDuu), floatDvv(floatDuu);
+
+            Osd::CpuEvaluator::EvalPatches(&floatSrc[0], desc,
+                (float *)0, desc, (float *)0, desc, (float *)0, desc,
+                &floatDuu[0], desc, &floatDuv[0], desc, &floatDvv[0], desc,
+                numCoords, &data.coords[0],
+                data.cpuPatchTable->GetPatchArrayBuffer(),
+                data.cpuPatchTable->GetPatchIndexBuffer(),
+                data.cpuPatchTable->GetPatchParamBuffer());
+
+            std::vector<float> refFloat(duu.begin(), duu.end());
+            failures += CompareBuffers(test, &floatDuu[0], &refFloat[0],
+                                       (int)floatDuu.size(), 1e-4);
+            refFloat.assign(duv.begin(), duv.end());
+            failures += CompareBuffers(test, &floatDuv[0], &refFloat[0],
+                                       (int)floatDuv.size(), 1e-4);
+            refFloat.assign(dvv.begin(), dvv.end());
+            failures += CompareBuffers(test, &floatDvv[0], &refFloat[0],
+                                       (int)floatDvv.size(), 1e-4);
+
+            if (g_endCapTypes[e] !=
+                Far::PatchTableFactory::Options::ENDCAP_BSPLINE_BASIS) {
+                continue;
+            }
+
+            // the 1st derivatives at +/- h in s and t
+            std::vector<Osd::PatchCoordReal<double> > shifted[4];
+            for (int i = 0; i < numCoords; ++i) {
+                Osd::PatchCoordReal<double> const & c = coords[i];
+                shifted[0].push_back(Osd::PatchCoordReal<double>(
+                    c.handle, c.s + h, c.t));
+                shifted[1].push_back(Osd::PatchCoordReal<double>(
+                    c.handle, c.s - h, c.t));
+                shifted[2].push_back(Osd::PatchCoordReal<double>(
+                    c.handle, c.s, c.t + h));
+                shifted[3].push_back(Osd::PatchCoordReal<double>(
+                    c.handle, c.s, c.t - h));
+            }
+
+            std::vector<double> du[4], dv[4];
+            for (int i = 0; i < 4; ++i) {
+                du[i].resize(numCoords * 3);
+                dv[i].resize(numCoords * 3);
+                evalReference(data, shifted[i], &src[0], desc,
+                              (double *)0, &du[i][0], &dv[i][0], desc);
+            }
+
+            for (int i = 0; i < numCoords; ++i) {
+                // the derivatives are scaled by the depth of the patch, which
+                // counts the sub-faces of non-quad faces as a level : their
+                // derivatives with respect to the ptex coordinates are scaled
+                // once more
+                Far::PatchParam param =
+                    data.patchTable->GetPatchParam(coords[i].handle);
+                double scale = (double)(1 << param.GetDepth()) *
+                               param.GetParamFraction();
+
+                for (int k = i * 3; k < i * 3 + 3; ++k) {
+                    refDuu[k] = (du[0][k] - du[1][k]) / (2.0 * h) * scale;
+                    refDuv[k] = (du[2][k] - du[3][k]) / (2.0 * h) * scale;
+                    refDvv[k] = (dv[2][k] - dv[3][k]) / (2.0 * h) * scale;
+                }
+            }
+            failures += CompareBuffers(test, &duu[0], &refDuu[0],
+                                       (int)duu.size(), 1e-4);
+            failures += CompareBuffers(test, &duv[0], &refDuv[0],
+                                       (int)duv.size(), 1e-4);
+            failures += CompareBuffers(test, &dvv[0], &refDvv[0],
+                                       (int)dvv.size(), 1e-4);
+        }
+    }
+    return failures;
+}
@@ -0,0 +1,476 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "cpu_regression.h"
+
+#include <far/compressedStencilTable.h>
+#include <far/stats.h>
+#include <far/transposedStencilTable.h>
+#include <osd/bufferDescriptor.h>
+#include <osd/cpuEvaluator.h>
+#include <osd/cpuPatchTable.h>
+
+#if defined(OPENSUBDIV_HAS_OPENMP)
+    #include <osd/ompEvaluator.h>
+#endif
+
+#if defined(OPENSUBDIV_HAS_THREADPOOL)
+    #include <osd/threadPoolEvaluator.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace OpenSubdiv;
+
+//
+// Recording callback : the records may be reported from the threads of the
+// asynchronous dispatcher
+//
+struct Record {
+    std::string name;
+    Far::Stats stats;
+};
+
+static std::mutex g_recordsMutex;
+static std::vector<Record> g_records;
+
+static void
+recordStats(Far::Stats const & stats, void * clientData) {
+    std::lock_guard<std::mutex> lock(g_recordsMutex);
+    Record record;
+    record.name = stats.name;
+    record.stats = stats;
+    static_cast<std::vector<Record> *>(clientData)->push_back(record);
+}
+
+// Checks that a single record of the given name was reported since the
+// records were cleared, with the given counts (the bytes read by the
+// evaluators are only checked to be counted, as their estimate depends on
+// the table layout)
+static int
+checkRecord(char const * test, char const * name,
+            size_t numItems, size_t numWeights, size_t bytesWritten,
+            bool clear = true) {
+
+    std::lock_guard<std::mutex> lock(g_recordsMutex);
+
+    int failures = 0, numRecords = 0;
+    for (size_t i = 0; i < g_records.size(); ++i) {
+        Far::Stats const & stats = g_records[i].stats;
+        if (g_records[i].name != name) continue;
+
+        ++numRecords;
+        if (stats.numItems != numItems or
+            stats.numWeights != numWeights or
+            stats.bytesWritten != bytesWritten or
+            (strncmp(name, "Osd::", 5) == 0 and numWeights > 0 and
+             stats.bytesRead == 0) or
+            stats.wallTime < 0.0 or stats.numThreads < 1) {
+            printf("  %s : %s counted %d items, %d weights, %d bytes "
+                   "written, expected %d, %d, %d\n", test, name,
+                   (int)stats.numItems, (int)stats.numWeights,
+                   (int)stats.bytesWritten, (int)numItems, (int)numWeights,
+                   (int)bytesWritten);
+            ++failures;
+        }
+    }
+    if (numRecords != 1) {
+        printf("  %s : %d records of %s\n", test, numRecords, name);
+        ++failures;
+    }
+    if (clear) {
+        g_records.clear();
+    }
+    return failures;
+}
+
+// Checks the counts of the evaluations of an evaluator that leave some of
+// their outputs out : only the outputs given are counted, with the layout of
+// one of them (the descriptors of the missing outputs are half precision
+// ones, which are not to be counted)
+template <class EVALUATOR>
+static int
+checkEvaluatorStats(char const * evaluator,
+                    char const * stencilsName,
+                    char const * patchesName,
+                    char const * normalsName,
+                    Far::StencilTable const & table,
+                    PatchData const & data) {
+
+    int failures = 0;
+
+    int numStencils = table.GetNumStencils(),
+        numWeights = (int)table.GetControlIndices().size();
+
+    int const * sizes = &table.GetSizes()[0],
+              * offsets = &table.GetOffsets()[0],
+              * indices = &table.GetControlIndices()[0];
+    float const * weights = &table.GetWeights()[0];
+
+    Osd::BufferDescriptor desc(0, 3, 8),
+                          halfDesc(0, 3, 8, Osd::BufferDescriptor::FLOAT16);
+
+    std::vector<float> src(table.GetNumControlVertices() * 8),
+                       dst(numStencils * 8),
+                       du(dst.size()),
+                       dv(dst.size());
+    FillBuffer(src, 1);
+
+    size_t written = (size_t)numStencils * 3 * sizeof(float);
+
+    char test[128];
+
+    snprintf(test, sizeof(test), "%s point and du", evaluator);
+    EVALUATOR::EvalStencils(&src[0], desc, &dst[0], desc,
+        &du[0], desc, NULL, halfDesc,
+        sizes, offsets, indices, weights, weights, NULL, 0, numStencils);
+    failures += checkRecord(test, stencilsName,
+                            numStencils, 2 * numWeights, 2 * written);
+
+    snprintf(test, sizeof(test), "%s derivatives only", evaluator);
+    EVALUATOR::EvalStencils(&src[0], desc, NULL, halfDesc,
+        &du[0], desc, &dv[0], desc,
+        sizes, offsets, indices, weights, weights, weights, 0, numStencils);
+    failures += checkRecord(test, stencilsName,
+                            numStencils, 2 * numWeights, 2 * written);
+
+    // the stencils are applied once to both buffers
+    {
+        float const * srcs[2] = { &src[0], &src[0] + 3 };
+        float * dsts[2] = { &dst[0], &dst[0] + 3 };
+        Osd::BufferDescriptor descs[2] = { desc, desc };
+
+        snprintf(test, sizeof(test), "%s multiple buffers", evaluator);
+        EVALUATOR::EvalStencils(2, srcs, descs, dsts, descs,
+            sizes, offsets, indices, weights, 0, numStencils);
+        failures += checkRecord(test, stencilsName,
+                                numStencils, numWeights, 2 * written);
+    }
+
+    // the normals are computed from the first 3 elements of 4
+    {
+        Osd::PatchArray const * patchArrays =
+            data.cpuPatchTable->GetPatchArrayBuffer();
+        int const * patchIndices =
+            data.cpuPatchTable->GetPatchIndexBuffer();
+        Osd::PatchParam const * patchParams =
+            data.cpuPatchTable->GetPatchParamBuffer();
+
+        int numCoords = data.GetNumCoords();
+
+        size_t numCVs = 0;
+        for (int i = 0; i < numCoords; ++i) {
+            numCVs += patchArrays[data.coords[i].handle.arrayIndex].
+                GetDescriptor().GetNumControlVertices();
+        }
+
+        Osd::BufferDescriptor srcDesc(0, 4, 4),
+                              duDesc(0, 4, 4),
+                              halfDesc4(0, 4, 4,
+                                        Osd::BufferDescriptor::FLOAT16),
+                              normalDesc(1, 3, 5);
+
+        std::vector<float> patchSrc(data.numVertices * 4),
+                           patchDu(numCoords * 4),
+                           normals(numCoords * 5);
+        FillBuffer(patchSrc, 2);
+
+        snprintf(test, sizeof(test), "%s patch du", evaluator);
+        EVALUATOR::EvalPatches(&patchSrc[0], srcDesc, NULL, halfDesc4,
+            &patchDu[0], duDesc, NULL, halfDesc4,
+            numCoords, &data.coords[0],
+            patchArrays, patchIndices, patchParams);
+        failures += checkRecord(test, patchesName, numCoords, numCVs,
+                                numCoords * 4 * sizeof(float));
+
+        snprintf(test, sizeof(test), "%s patch normals", evaluator);
+        EVALUATOR::EvalPatchNormals(&patchSrc[0], srcDesc, NULL, srcDesc,
+            &normals[0], normalDesc,
+            numCoords, &data.coords[0],
+            patchArrays, patchIndices, patchParams);
+        failures += checkRecord(test, normalsName, numCoords, numCVs,
+                                numCoords * 3 * sizeof(float));
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// The evaluations are reported only while a callback is set, once per call,
+// with the number of stencils and weights they evaluated and the bytes they
+// wrote to the destination primvars.
+int
+CheckStats() {
+
+    int failures = 0;
+
+    Far::TopologyRefiner * refiner = CreateRefiner(GetShapes()[0], 3, false);
+
+    Far::SetStatsCallback(recordStats, &g_records);
+    Far::StencilTable const * table = CreateStencilTable(*refiner);
+    Far::SetStatsCallback(0);
+
+    int numStencils = table->GetNumStencils(),
+        numWeights = (int)table->GetControlIndices().size();
+
+    // the factory writes the sizes, offsets, indices and weights
+    failures += checkRecord("factory", "Far::StencilTableFactory::Create",
+        numStencils, numWeights,
+        numStencils * 2 * sizeof(int) +
+        numWeights * (sizeof(int) + sizeof(float)));
+
+    int const * sizes = &table->GetSizes()[0],
+              * offsets = &table->GetOffsets()[0],
+              * indices = &table->GetControlIndices()[0];
+    float const * weights = &table->GetWeights()[0];
+
+    // 2 primvars of 3 elements, followed by padding, so that the multiple
+    // buffer and instance evaluations can run on the same buffers
+    Osd::BufferDescriptor srcDesc(0, 3, 8),
+                          dstDesc(0, 3, 8),
+                          halfDesc(0, 3, 8, Osd::BufferDescriptor::FLOAT16);
+
+    std::vector<float> src(table->GetNumControlVertices() * 8),
+                       dst(numStencils * 8);
+    FillBuffer(src, 0);
+
+    // nothing is reported without a callback
+    if (Far::IsStatsEnabled()) {
+        printf("  stats enabled without a callback\n");
+        ++failures;
+    }
+    Osd::CpuEvaluator::EvalStencils(&src[0], srcDesc, &dst[0], dstDesc,
+        sizes, offsets, indices, weights, 0, numStencils);
+    if (not g_records.empty()) {
+        printf("  stats reported without a callback\n");
+        g_records.clear();
+        ++failures;
+    }
+
+    Far::SetStatsCallback(recordStats, &g_records);
+
+    size_t written = (size_t)numStencils * 3 * sizeof(float);
+
+    Osd::CpuEvaluator::EvalStencils(&src[0], srcDesc, &dst[0], dstDesc,
+        sizes, offsets, indices, weights, 0, numStencils);
+    failures += checkRecord("stencils", "Osd::CpuEvaluator::EvalStencils",
+                            numStencils, numWeights, written);
+
+    // half precision destination
+    Osd::CpuEvaluator::EvalStencils(&src[0], srcDesc, &dst[0], halfDesc,
+        sizes, offsets, indices, weights, 0, numStencils);
+    failures += checkRecord("half stencils",
+                            "Osd::CpuEvaluator::EvalStencils",
+                            numStencils, numWeights, written / 2);
+
+    // point and derivatives
+    std::vector<float> du(dst.size()), dv(dst.size());
+    Osd::CpuEvaluator::EvalStencils(&src[0], srcDesc, &dst[0], dstDesc,
+        &du[0], dstDesc, &dv[0], dstDesc,
+        sizes, offsets, indices, weights, weights, weights, 0, numStencils);
+    failures += checkRecord("derivatives", "Osd::CpuEvaluator::EvalStencils",
+                            numStencils, 3 * numWeights, 3 * written);
+
+    // the stencils are applied once to both buffers
+    {
+        float const * srcs[2] = { &src[0], &src[0] + 3 };
+        float * dsts[2] = { &dst[0], &dst[0] + 3 };
+        Osd::BufferDescriptor descs[2] = { srcDesc, srcDesc };
+        Osd::CpuEvaluator::EvalStencils(2, srcs, descs, dsts, descs,
+            sizes, offsets, indices, weights, 0, numStencils);
+        failures += checkRecord("multiple buffers",
+                                "Osd::CpuEvaluator::EvalStencils",
+                                numStencils, numWeights, 2 * written);
+    }
+
+    Osd::CpuEvaluator::EvalInstanceStencils(2, &src[0], srcDesc,
+        &dst[0], dstDesc, sizes, offsets, indices, weights, 0, numStencils);
+    failures += checkRecord("instances",
+                            "Osd::CpuEvaluator::EvalInstanceStencils",
+                            numStencils, numWeights, 2 * written);
+
+    {
+        // planes of the 3 elements of the primvar
+        std::vector<float> soaSrc(table->GetNumControlVertices() * 3),
+                           soaDst(numStencils * 3);
+        Osd::SoABufferDescriptor soaSrcDesc(0, 3,
+                                            table->GetNumControlVertices()),
+                                 soaDstDesc(0, 3, numStencils);
+        Osd::CpuEvaluator::EvalStencils(&soaSrc[0], soaSrcDesc,
+            &soaDst[0], soaDstDesc,
+            sizes, offsets, indices, weights, 0, numStencils);
+        failures += checkRecord("structure of arrays",
+                                "Osd::CpuEvaluator::EvalStencils",
+                                numStencils, numWeights, written);
+    }
+
+    {
+        // every other stencil
+        std::vector<int> stencils;
+        size_t listWeights = 0;
+        for (int i = 0; i < numStencils; i += 2) {
+            stencils.push_back(i);
+            listWeights += sizes[i];
+        }
+        Osd::CpuEvaluator::EvalStencilList(&src[0], srcDesc,
+            &dst[0], dstDesc, sizes, offsets, indices, weights,
+            &stencils[0], (int)stencils.size());
+        failures += checkRecord("stencil list",
+                                "Osd::CpuEvaluator::EvalStencilList",
+                                stencils.size(), listWeights,
+                                stencils.size() * 3 * sizeof(float));
+    }
+
+    {
+        Far::SetStatsCallback(0);
+        Far::CompressedStencilTable const * compressed =
+            Far::CompressedStencilTableFactory::Create(*table);
+        Far::SetStatsCallback(recordStats, &g_records);
+
+        Osd::CpuEvaluator::EvalStencils(&src[0], srcDesc, &dst[0], dstDesc,
+            &compressed->GetSizes()[0], &compressed->GetScales()[0],
+            &compressed->GetBlockIndexOffsets()[0],
+            &compressed->GetBlockWeightOffsets()[0],
+            &compressed->GetControlIndices()[0],
+            &compressed->GetWeights()[0], 0, numStencils);
+        failures += checkRecord("compressed stencils",
+                                "Osd::CpuEvaluator::EvalStencils",
+                                numStencils, numWeights, written);
+        delete compressed;
+    }
+
+    {
+        // the launch, then the evaluation on the dispatcher thread
+        Osd::AsyncEvaluation evaluation =
+            Osd::CpuEvaluator::EvalStencilsAsync(&src[0], srcDesc,
+                &dst[0], dstDesc,
+                sizes, offsets, indices, weights, 0, numStencils);
+        evaluation.Wait();
+
+        failures += checkRecord("asynchronous stencils",
+                                "Osd::CpuEvaluator::EvalStencilsAsync",
+                                numStencils, 0, 0, false);
+        failures += checkRecord("asynchronous stencils",
+                                "Osd::CpuEvaluator::EvalStencils",
+                                numStencils, numWeights, written);
+    }
+
+    {
+        // the weights of the edited vertices are scattered to the stencils
+        Far::SetStatsCallback(0);
+        Far::TransposedStencilTable transposed(*table);
+        Far::SetStatsCallback(recordStats, &g_records);
+
+        std::vector<int> deltaVertices;
+        size_t deltaWeights = 0;
+        for (int i = 0; i < table->GetNumControlVertices(); i += 3) {
+            deltaVertices.push_back(i);
+            deltaWeights += transposed.GetStencils(i).size();
+        }
+        std::vector<float> deltas(deltaVertices.size() * 8);
+        FillBuffer(deltas, 3);
+
+        Osd::CpuEvaluator::EvalStencilDeltas(&deltas[0], srcDesc,
+            &deltaVertices[0], (int)deltaVertices.size(), &dst[0], dstDesc,
+            &transposed.GetOffsets()[0], &transposed.GetStencilIndices()[0],
+            &transposed.GetWeights()[0]);
+        failures += checkRecord("stencil deltas",
+                                "Osd::CpuEvaluator::EvalStencilDeltas",
+                                deltaVertices.size(), deltaWeights,
+                                deltaWeights * 3 * sizeof(float));
+    }
+
+    // the evaluations missing some of their outputs, and the multiple
+    // buffers, of each evaluator
+    {
+        ShapeDesc const * shape = 0;
+        for (size_t s = 0; not shape and s < GetShapes().size(); ++s) {
+            if (GetShapes()[s].scheme == kCatmark) shape = &GetShapes()[s];
+        }
+
+        Far::SetStatsCallback(0);
+        PatchData data(*shape,
+            Far::PatchTableFactory::Options::ENDCAP_GREGORY_BASIS, false);
+        Far::SetStatsCallback(recordStats, &g_records);
+
+        failures += checkEvaluatorStats<Osd::CpuEvaluator>("CPU",
+            "Osd::CpuEvaluator::EvalStencils",
+            "Osd::CpuEvaluator::EvalPatches",
+            "Osd::CpuEvaluator::EvalPatchNormals", *table, data);
+#if defined(OPENSUBDIV_HAS_OPENMP)
+        failures += checkEvaluatorStats<Osd::OmpEvaluator>("OpenMP",
+            "Osd::OmpEvaluator::EvalStencils",
+            "Osd::OmpEvaluator::EvalPatches",
+            "Osd::OmpEvaluator::EvalPatches", *table, data);
+#endif
+#if defined(OPENSUBDIV_HAS_THREADPOOL)
+        failures += checkEvaluatorStats<Osd::ThreadPoolEvaluator>(
+            "thread pool",
+            "Osd::ThreadPoolEvaluator::EvalStencils",
+            "Osd::ThreadPoolEvaluator::EvalPatches",
+            "Osd::ThreadPoolEvaluator::EvalPatches", *table, data);
+#endif
+    }
+
+#if defined(OPENSUBDIV_HAS_OPENMP)
+    {
+        Far::SetStatsCallback(0);
+        Osd::OmpNumaStencilTable numaTable(table);
+        Far::SetStatsCallback(recordStats, &g_records);
+
+        numaTable.EvalStencils(&src[0], srcDesc, &dst[0], dstDesc);
+        failures += checkRecord("NUMA stencils",
+                                "Osd::OmpEvaluator::EvalStencils",
+                                numStencils, numWeights, written);
+    }
+#endif
+
+#if defined(OPENSUBDIV_HAS_THREADPOOL)
+    {
+        Osd::AsyncEvaluation evaluation =
+            Osd::ThreadPoolEvaluator::EvalStencilsAsync(&src[0], srcDesc,
+                &dst[0], dstDesc,
+                sizes, offsets, indices, weights, 0, numStencils);
+        evaluation.Wait();
+
+        failures += checkRecord("thread pool asynchronous stencils",
+                                "Osd::ThreadPoolEvaluator::EvalStencilsAsync",
+                                numStencils, 0, 0, false);
+        failures += checkRecord("thread pool asynchronous stencils",
+                                "Osd::ThreadPoolEvaluator::EvalStencils",
+                                numStencils, numWeights, written);
+    }
+#endif
+
+    Far::SetStatsCallback(0);
+    g_records.clear();
+
+    delete table;
+    delete refiner;
+
+    return failures;
+}
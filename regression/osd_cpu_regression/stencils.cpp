@@ -0,0 +1,1475 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "cpu_regression.h"
+
+#include <far/compressedStencilTable.h>
+#include <far/primvarRefiner.h>
+#include <far/ptexIndices.h>
+#include <osd/bufferDescriptor.h>
+#include <osd/cpuEvaluator.h>
+#include <osd/cpuKernel.h>
+#include <osd/cpuVertexBuffer.h>
+
+#if defined(OPENSUBDIV_HAS_OPENMP)
+    #include <osd/ompEvaluator.h>
+#endif
+
+#if defined(OPENSUBDIV_HAS_THREADPOOL)
+    #include <osd/threadPoolEvaluator.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+
+#include "../shapes/catmark_pole64.h"
+#include "../shapes/loop_pole64.h"
+
+using namespace OpenSubdiv;
+
+// Value of the buffer elements that no evaluation should write
+static const float g_sentinel = 1234.5f;
+
+// Primvar layouts (length, destination length, padding) the kernels are
+// exercised with : the SIMD kernels have separate paths for the lengths
+// below, at and above their register widths
+struct Layout {
+    int length,
+        dstLength,
+        padding;
+};
+
+static const Layout g_layouts[] = {
+    {  1,  1, 0 }, {  2,  2, 1 }, {  3,  3, 0 }, {  3,  3, 2 },
+    {  4,  4, 0 }, {  4,  4, 3 }, {  5,  5, 0 }, {  7,  7, 1 },
+    {  8,  8, 0 }, {  9,  9, 0 }, { 12, 12, 4 }, { 16, 16, 0 },
+    { 17, 17, 1 }, { 32, 32, 0 }, { 33, 33, 2 },
+    // the destination primvar is shorter than the source one
+    {  4,  3, 0 }, {  9,  8, 0 }, { 17, 16, 1 },
+};
+
+static const int g_numLayouts = sizeof(g_layouts) / sizeof(Layout);
+
+//------------------------------------------------------------------------------
+// The SIMD kernels of each level supported by the CPU are matched against the
+// portable kernels, including the elements outside of the destination
+// primvars which must not be written.
+int
+CheckSimdStencils() {
+
+    Osd::CpuSimdLevel defaultLevel = Osd::CpuGetSimdLevel(),
+                      maxLevel = GetMaxSimdLevel();
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+        int numControlVertices = table->GetNumControlVertices(),
+            numStencils = table->GetNumStencils();
+
+        for (int l = 0; l < g_numLayouts; ++l) {
+
+            Layout const & layout = g_layouts[l];
+
+            int srcStride = layout.length + layout.padding,
+                dstStride = layout.dstLength + layout.padding,
+                offset = layout.padding / 2;
+
+            Osd::BufferDescriptor srcDesc(offset, layout.length, srcStride),
+                                  dstDesc(offset, layout.dstLength, dstStride);
+
+            std::vector<float> src(numControlVertices * srcStride),
+                reference(numStencils * dstStride, g_sentinel);
+            FillBuffer(src, (unsigned int)(s * g_numLayouts + l));
+
+            Osd::CpuSetSimdLevel(Osd::CPU_SIMD_NONE);
+            Osd::CpuEvalStencils(&src[0], srcDesc, &reference[0], dstDesc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                0, numStencils);
+
+            for (int level = Osd::CPU_SIMD_SSE; level <= maxLevel; ++level) {
+
+                // evaluate the two halves separately to also exercise a
+                // non-zero first stencil
+                std::vector<float> dst(reference.size(), g_sentinel);
+                Osd::CpuSetSimdLevel((Osd::CpuSimdLevel)level);
+                for (int half = 0; half < 2; ++half) {
+                    int start = half * numStencils / 2,
+                        end = (half + 1) * numStencils / 2;
+                    Osd::CpuEvalStencils(&src[0], srcDesc, &dst[0], dstDesc,
+                        &table->GetSizes()[0], &table->GetOffsets()[0],
+                        &table->GetControlIndices()[0],
+                        &table->GetWeights()[0], start, end);
+                }
+
+                char test[128];
+                snprintf(test, sizeof(test), "%s level %d length %d/%d",
+                         shapes[s].name.c_str(), level,
+                         layout.length, layout.dstLength);
+                failures += CompareBuffers(test, &dst[0], &reference[0],
+                                           (int)dst.size(), 1e-5);
+            }
+        }
+        delete table;
+        delete refiner;
+    }
+
+    Osd::CpuSetSimdLevel(defaultLevel);
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// Half precision primvars : the source primvars are generated from half
+// floats so that the single precision evaluation of their decoded values is
+// the exact reference, the destination ones are matched within the half
+// precision.
+static float
+halfToFloat(unsigned short h) {
+    unsigned int sign = (unsigned int)(h & 0x8000) << 16,
+                 exponent = (h >> 10) & 0x1f,
+                 mantissa = h & 0x3ff,
+                 bits = sign;
+    if (exponent != 0) {
+        bits |= ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float f;
+    memcpy(&f, &bits, sizeof(float));
+    return f;
+}
+
+// Truncating conversion : only used with normal values in the half range
+static unsigned short
+floatToHalf(float f) {
+    unsigned int bits;
+    memcpy(&bits, &f, sizeof(float));
+    unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+    int exponent = (int)((bits >> 23) & 0xff) - 112;
+    if (exponent <= 0) return sign;
+    return sign | (unsigned short)((exponent << 10) | ((bits >> 13) & 0x3ff));
+}
+
+int
+CheckHalfStencils() {
+
+    Osd::CpuSimdLevel defaultLevel = Osd::CpuGetSimdLevel(),
+                      maxLevel = GetMaxSimdLevel();
+
+    unsigned short halfSentinel = floatToHalf(g_sentinel);
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+        int numControlVertices = table->GetNumControlVertices(),
+            numStencils = table->GetNumStencils();
+
+        for (int l = 0; l < g_numLayouts; ++l) {
+
+            Layout const & layout = g_layouts[l];
+
+            int srcStride = layout.length + layout.padding,
+                dstStride = layout.dstLength + layout.padding,
+                offset = layout.padding / 2;
+
+            Osd::BufferDescriptor srcDesc(offset, layout.length, srcStride),
+                                  dstDesc(offset, layout.dstLength, dstStride),
+                                  srcHalfDesc(srcDesc),
+                                  dstHalfDesc(dstDesc);
+            srcHalfDesc.elementType = Osd::BufferDescriptor::FLOAT16;
+            dstHalfDesc.elementType = Osd::BufferDescriptor::FLOAT16;
+
+            std::vector<float> src(numControlVertices * srcStride);
+            FillBuffer(src, (unsigned int)(s * g_numLayouts + l));
+
+            std::vector<unsigned short> srcHalf(src.size());
+            for (size_t i = 0; i < src.size(); ++i) {
+                srcHalf[i] = floatToHalf(src[i]);
+                src[i] = halfToFloat(srcHalf[i]);
+            }
+
+            std::vector<float> reference(numStencils * dstStride,
+                                         halfToFloat(halfSentinel));
+
+            Osd::CpuSetSimdLevel(Osd::CPU_SIMD_NONE);
+            Osd::CpuEvalStencils(&src[0], srcDesc, &reference[0], dstDesc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                0, numStencils);
+
+            for (int level = Osd::CPU_SIMD_NONE; level <= maxLevel; ++level) {
+
+                Osd::CpuSetSimdLevel((Osd::CpuSimdLevel)level);
+
+                // half source, half and single precision destinations
+                for (int dstType = 0; dstType < 3; ++dstType) {
+
+                    bool halfSrc = (dstType != 2),
+                         halfDst = (dstType != 0);
+
+                    std::vector<float> dst(reference.size(),
+                                           halfToFloat(halfSentinel));
+                    std::vector<unsigned short> dstHalf(reference.size(),
+                                                        halfSentinel);
+
+                    Osd::CpuEvalStencils(
+                        halfSrc ? (float const *)&srcHalf[0] : &src[0],
+                        halfSrc ? srcHalfDesc : srcDesc,
+                        halfDst ? (float *)&dstHalf[0] : &dst[0],
+                        halfDst ? dstHalfDesc : dstDesc,
+                        &table->GetSizes()[0], &table->GetOffsets()[0],
+                        &table->GetControlIndices()[0],
+                        &table->GetWeights()[0], 0, numStencils);
+
+                    if (halfDst) {
+                        for (size_t i = 0; i < dst.size(); ++i) {
+                            dst[i] = halfToFloat(dstHalf[i]);
+                        }
+                    }
+
+                    char test[128];
+                    snprintf(test, sizeof(test),
+                             "%s level %d length %d/%d half %s%s",
+                             shapes[s].name.c_str(), level,
+                             layout.length, layout.dstLength,
+                             halfSrc ? "src" : "", halfDst ? "dst" : "");
+                    failures += CompareBuffers(test, &dst[0], &reference[0],
+                        (int)dst.size(), halfDst ? 1e-3 : 1e-5);
+                }
+            }
+        }
+        delete table;
+        delete refiner;
+    }
+
+    Osd::CpuSetSimdLevel(defaultLevel);
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// Compressed stencils are matched against the stencils they were compressed
+// from, within the error bound of the compression. Some of the stencils are
+// emptied, including the first and last ones of the blocks, as those are
+// encoded without any control vertex index. Tables without stencils, or
+// with empty stencils only, are evaluated as well.
+class EmptiedStencilTable : public Far::StencilTable {
+public:
+    EmptiedStencilTable(Far::StencilTable const & table, bool all = false) :
+        Far::StencilTable(table.GetNumControlVertices(), table.GetOffsets(),
+                          emptySizes(table.GetSizes(), all),
+                          table.GetControlIndices(), table.GetWeights(),
+                          false, 0) { }
+
+private:
+    static std::vector<int> emptySizes(std::vector<int> sizes, bool all) {
+        size_t block = Far::CompressedStencilTable::BLOCK_SIZE;
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            if (all or i % 7 == 3 or i % block == 0 or
+                i % block == block - 1) {
+                sizes[i] = 0;
+            }
+        }
+        return sizes;
+    }
+};
+
+class EmptyStencilTable : public Far::StencilTable {
+public:
+    EmptyStencilTable() : Far::StencilTable(0) { }
+};
+
+// Evaluates a compressed table through the buffer template : its results
+// must match those of the table it was compressed from
+static int
+checkCompressedTemplate(char const * test, Far::StencilTable const & table) {
+
+    Far::CompressedStencilTable const * compressed =
+        Far::CompressedStencilTableFactory::Create(table);
+
+    int numControlVertices = std::max(table.GetNumControlVertices(), 1),
+        numStencils = table.GetNumStencils();
+
+    Osd::BufferDescriptor desc(0, 3, 3);
+
+    std::vector<float> values(numControlVertices * 3),
+                       reference(std::max(numStencils, 1) * 3, g_sentinel);
+    FillBuffer(values, 0);
+    if (numStencils > 0) {
+        Osd::CpuEvalStencils(&values[0], desc, &reference[0], desc,
+            &table.GetSizes()[0], &table.GetOffsets()[0],
+            &table.GetControlIndices()[0], &table.GetWeights()[0],
+            0, numStencils);
+    }
+
+    Osd::CpuVertexBuffer * src =
+        Osd::CpuVertexBuffer::Create(3, numControlVertices);
+    Osd::CpuVertexBuffer * dst =
+        Osd::CpuVertexBuffer::Create(3, std::max(numStencils, 1));
+    src->UpdateData(&values[0], 0, numControlVertices);
+    std::vector<float> sentinels(reference.size(), g_sentinel);
+    dst->UpdateData(&sentinels[0], 0, std::max(numStencils, 1));
+
+    int failures = 0;
+    if (not Osd::CpuEvaluator::EvalStencils(src, desc, dst, desc,
+                                            compressed)) {
+        printf("  %s : evaluation failed\n", test);
+        ++failures;
+    } else {
+        failures += CompareBuffers(test, dst->BindCpuBuffer(),
+                                   &reference[0], (int)reference.size(), 0.0);
+    }
+
+    delete src;
+    delete dst;
+    delete compressed;
+    return failures;
+}
+
+int
+CheckCompressedStencils() {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * fullTable = CreateStencilTable(*refiner);
+        EmptiedStencilTable table(*fullTable);
+
+        Far::CompressedStencilTable const * compressed =
+            Far::CompressedStencilTableFactory::Create(table);
+
+        int numControlVertices = table.GetNumControlVertices(),
+            numStencils = table.GetNumStencils();
+
+        // the control values are within [-1, 1]
+        double tolerance = compressed->GetMaxStencilError() + 1e-5;
+
+        for (int l = 0; l < g_numLayouts; ++l) {
+
+            Layout const & layout = g_layouts[l];
+
+            // the compressed stencils require primvars of the same length
+            if (layout.length != layout.dstLength) continue;
+
+            int srcStride = layout.length + layout.padding,
+                dstStride = layout.dstLength + layout.padding,
+                offset = layout.padding / 2;
+
+            Osd::BufferDescriptor srcDesc(offset, layout.length, srcStride),
+                                  dstDesc(offset, layout.dstLength, dstStride);
+
+            std::vector<float> src(numControlVertices * srcStride),
+                reference(numStencils * dstStride, g_sentinel);
+            FillBuffer(src, (unsigned int)(s * g_numLayouts + l));
+
+            Osd::CpuEvalStencils(&src[0], srcDesc, &reference[0], dstDesc,
+                &table.GetSizes()[0], &table.GetOffsets()[0],
+                &table.GetControlIndices()[0], &table.GetWeights()[0],
+                0, numStencils);
+
+            // evaluate the whole table, then ranges starting within blocks
+            for (int split = 1; split < 4; ++split) {
+
+                std::vector<float> dst(reference.size(), g_sentinel);
+                for (int range = 0; range < split; ++range) {
+                    int start = range * numStencils / split,
+                        end = (range + 1) * numStencils / split;
+                    Osd::CpuEvaluator::EvalStencils(&src[0], srcDesc,
+                        &dst[0], dstDesc,
+                        &compressed->GetSizes()[0],
+                        &compressed->GetScales()[0],
+                        &compressed->GetBlockIndexOffsets()[0],
+                        &compressed->GetBlockWeightOffsets()[0],
+                        &compressed->GetControlIndices()[0],
+                        &compressed->GetWeights()[0], start, end);
+                }
+
+                char test[128];
+                snprintf(test, sizeof(test), "%s length %d/%d ranges %d",
+                         shapes[s].name.c_str(),
+                         layout.length, layout.dstLength, split);
+                failures += CompareBuffers(test, &dst[0], &reference[0],
+                                           (int)dst.size(), tolerance);
+            }
+        }
+        delete compressed;
+
+        std::string test = shapes[s].name + " empty stencils";
+        failures += checkCompressedTemplate(test.c_str(),
+            EmptiedStencilTable(*fullTable, true));
+
+        delete fullTable;
+        delete refiner;
+    }
+    failures += checkCompressedTemplate("no stencils", EmptyStencilTable());
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// Reordered stencil tables evaluated on the reordered control values must
+// match the original tables exactly, once their results are permuted back.
+// Limit stencil tables must keep their derivative weights.
+static int
+checkReorderedStencils(char const * name,
+                       Far::StencilTableReal<float> const & table,
+                       std::vector<float> const * const * weights,
+                       int numWeights, bool reorderVertices,
+                       bool reorderStencils) {
+
+    std::vector<Far::Index> cvOrder, stencilOrder;
+
+    Far::StencilTableReal<float> const * reordered =
+        Far::StencilTableFactoryReal<float>::ReorderStencilTable(table,
+            reorderVertices ? &cvOrder : 0, reorderStencils ? &stencilOrder : 0);
+    if (not reordered) {
+        printf("  %s : not reordered\n", name);
+        return 1;
+    }
+
+    int numControlVertices = table.GetNumControlVertices(),
+        numStencils = table.GetNumStencils();
+
+    std::vector<float> const * reorderedWeights[3] = {
+        &reordered->GetWeights(), 0, 0 };
+    if (numWeights > 1) {
+        Far::LimitStencilTableReal<float> const * limitTable =
+            dynamic_cast<Far::LimitStencilTableReal<float> const *>(reordered);
+        if (not limitTable) {
+            printf("  %s : not a limit stencil table\n", name);
+            delete reordered;
+            return 1;
+        }
+        reorderedWeights[1] = &limitTable->GetDuWeights();
+        reorderedWeights[2] = &limitTable->GetDvWeights();
+    }
+
+    Osd::BufferDescriptor desc(0, 3, 3);
+
+    std::vector<float> src(numControlVertices * 3),
+                       reorderedSrc(src.size());
+    FillBuffer(src, (unsigned int)numStencils);
+    for (int i = 0; i < numControlVertices; ++i) {
+        int cv = reorderVertices ? cvOrder[i] : i;
+        for (int k = 0; k < 3; ++k) {
+            reorderedSrc[i * 3 + k] = src[cv * 3 + k];
+        }
+    }
+
+    int failures = 0;
+    for (int w = 0; w < numWeights; ++w) {
+
+        std::vector<float> reference(numStencils * 3),
+                           dst(reference.size()),
+                           result(reference.size());
+
+        Osd::CpuEvalStencils(&src[0], desc, &reference[0], desc,
+            &table.GetSizes()[0], &table.GetOffsets()[0],
+            &table.GetControlIndices()[0], &(*weights[w])[0],
+            0, numStencils);
+
+        Osd::CpuEvalStencils(&reorderedSrc[0], desc, &dst[0], desc,
+            &reordered->GetSizes()[0], &reordered->GetOffsets()[0],
+            &reordered->GetControlIndices()[0], &(*reorderedWeights[w])[0],
+            0, numStencils);
+
+        for (int i = 0; i < numStencils; ++i) {
+            int stencil = reorderStencils ? stencilOrder[i] : i;
+            for (int k = 0; k < 3; ++k) {
+                result[stencil * 3 + k] = dst[i * 3 + k];
+            }
+        }
+
+        char test[128];
+        snprintf(test, sizeof(test), "%s weights %d order %d%d",
+                 name, w, reorderVertices, reorderStencils);
+        failures += CompareBuffers(test, &result[0], &reference[0],
+                                   (int)result.size(), 0.0);
+    }
+    delete reordered;
+    return failures;
+}
+
+int
+CheckReorderedStencils() {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        char const * name = shapes[s].name.c_str();
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+        std::vector<float> const * weights[1] = { &table->GetWeights() };
+        for (int order = 0; order < 4; ++order) {
+            failures += checkReorderedStencils(name, *table, weights, 1,
+                                               (order & 1) != 0,
+                                               (order & 2) != 0);
+        }
+        delete table;
+        delete refiner;
+
+        if (shapes[s].scheme != kCatmark) continue;
+
+        refiner = CreateRefiner(shapes[s], 3, true);
+        Far::LimitStencilTable const * limitTable =
+            CreateLimitStencilTable(*refiner);
+
+        std::vector<float> const * limitWeights[3] = {
+            &limitTable->GetWeights(),
+            &limitTable->GetDuWeights(),
+            &limitTable->GetDvWeights() };
+        failures += checkReorderedStencils(name, *limitTable, limitWeights, 3,
+                                           true, true);
+        delete limitTable;
+        delete refiner;
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// The update of the stencils supported by edited control vertices must match
+// a full evaluation of the table exactly, and must not write the padding of
+// the destination buffer.
+int
+CheckDirtyStencils() {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+        Far::TransposedStencilTable transposed(*table);
+
+        int numControlVertices = table->GetNumControlVertices(),
+            numStencils = table->GetNumStencils();
+
+        Osd::BufferDescriptor desc(1, 3, 5);
+
+        std::vector<float> src(numControlVertices * desc.stride),
+                           dst(numStencils * desc.stride, g_sentinel);
+        FillBuffer(src, (unsigned int)s);
+
+        Osd::CpuVertexBuffer
+            * srcBuffer = Osd::CpuVertexBuffer::Create(desc.stride,
+                                                       numControlVertices),
+            * dstBuffer = Osd::CpuVertexBuffer::Create(desc.stride,
+                                                       numStencils),
+            * refBuffer = Osd::CpuVertexBuffer::Create(desc.stride,
+                                                       numStencils);
+        srcBuffer->UpdateData(&src[0], 0, numControlVertices);
+        dstBuffer->UpdateData(&dst[0], 0, numStencils);
+        refBuffer->UpdateData(&dst[0], 0, numStencils);
+
+        Osd::CpuEvaluator::EvalStencils(srcBuffer, desc, dstBuffer, desc,
+                                        table);
+
+        // successive edits of growing sets of control vertices
+        static const int numEdits[] = { 1, 7, 40 };
+        for (int e = 0; e < 3; ++e) {
+
+            std::vector<Far::Index> dirtyVertices;
+            for (int i = 0; i < numEdits[e]; ++i) {
+                Far::Index cv = (Far::Index)((i * 97 + e) % numControlVertices);
+                dirtyVertices.push_back(cv);
+                for (int k = 0; k < desc.length; ++k) {
+                    src[cv * desc.stride + desc.offset + k] += 0.25f;
+                }
+            }
+            srcBuffer->UpdateData(&src[0], 0, numControlVertices);
+
+            Osd::CpuEvaluator::EvalDirtyStencils(srcBuffer, desc,
+                dstBuffer, desc, table, &transposed,
+                (int)dirtyVertices.size(), &dirtyVertices[0]);
+
+            Osd::CpuEvaluator::EvalStencils(srcBuffer, desc, refBuffer, desc,
+                                            table);
+
+            char test[128];
+            snprintf(test, sizeof(test), "%s %d edits",
+                     shapes[s].name.c_str(), numEdits[e]);
+            failures += CompareBuffers(test, dstBuffer->BindCpuBuffer(),
+                refBuffer->BindCpuBuffer(), numStencils * desc.stride, 0.0);
+        }
+        delete srcBuffer;
+        delete dstBuffer;
+        delete refBuffer;
+        delete table;
+        delete refiner;
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// The stencils of sparse control value deltas accumulated into a previous
+// evaluation must match the evaluation of the edited control values,
+// including deltas applied several times to the same control vertex.
+int
+CheckStencilDeltas() {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+        Far::TransposedStencilTable transposed(*table);
+
+        int numControlVertices = table->GetNumControlVertices(),
+            numStencils = table->GetNumStencils();
+
+        for (int length = 3; length <= 4; ++length) {
+
+            Osd::BufferDescriptor srcDesc(0, length, length),
+                                  dstDesc(1, length, length + 2),
+                                  deltaDesc(1, length, length + 1);
+
+            std::vector<float> src(numControlVertices * srcDesc.stride),
+                               dst(numStencils * dstDesc.stride, g_sentinel),
+                               reference(dst);
+            FillBuffer(src, (unsigned int)(s * 2 + length));
+
+            Osd::CpuEvalStencils(&src[0], srcDesc, &dst[0], dstDesc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                0, numStencils);
+
+            // the last delta edits the same vertex as the first one
+            int numDeltas = std::min(numControlVertices, 12) + 1;
+
+            std::vector<Far::Index> deltaVertices(numDeltas);
+            std::vector<float> deltas(numDeltas * deltaDesc.stride);
+            FillBuffer(deltas, (unsigned int)s);
+
+            for (int i = 0; i < numDeltas; ++i) {
+                deltaVertices[i] = (i < numDeltas - 1) ?
+                    (Far::Index)((i * 13) % numControlVertices) :
+                    deltaVertices[0];
+                for (int k = 0; k < length; ++k) {
+                    src[deltaVertices[i] * srcDesc.stride + k] +=
+                        deltas[i * deltaDesc.stride + deltaDesc.offset + k];
+                }
+            }
+
+            Osd::CpuEvaluator::EvalStencilDeltas(&deltas[0], deltaDesc,
+                &deltaVertices[0], numDeltas, &dst[0], dstDesc,
+                &transposed.GetOffsets()[0],
+                &transposed.GetStencilIndices()[0],
+                &transposed.GetWeights()[0]);
+
+            Osd::CpuEvalStencils(&src[0], srcDesc, &reference[0], dstDesc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                0, numStencils);
+
+            char test[128];
+            snprintf(test, sizeof(test), "%s length %d",
+                     shapes[s].name.c_str(), length);
+            failures += CompareBuffers(test, &dst[0], &reference[0],
+                                       (int)dst.size(), 1e-5);
+        }
+        delete table;
+        delete refiner;
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// The batched evaluation of instance-interleaved primvars is matched against
+// the evaluation of each instance separately.
+int
+CheckInstanceStencils() {
+
+    int failures = 0;
+
+    static const int numInstances[] = { 1, 3, 8, 17 };
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+        int numControlVertices = table->GetNumControlVertices(),
+            numStencils = table->GetNumStencils();
+
+        for (int n = 0; n < 4; ++n) {
+
+            int length = 3,
+                stride = numInstances[n] * length + 2;
+
+            Osd::BufferDescriptor desc(1, length, stride);
+
+            std::vector<float> src(numControlVertices * stride),
+                               dst(numStencils * stride, g_sentinel),
+                               reference(dst);
+            FillBuffer(src, (unsigned int)(s * 4 + n));
+
+            Osd::CpuEvaluator::EvalInstanceStencils(numInstances[n],
+                &src[0], desc, &dst[0], desc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                0, numStencils);
+
+            for (int k = 0; k < numInstances[n]; ++k) {
+                Osd::BufferDescriptor instanceDesc(
+                    desc.offset + k * length, length, stride);
+                Osd::CpuEvalStencils(&src[0], instanceDesc,
+                    &reference[0], instanceDesc,
+                    &table->GetSizes()[0], &table->GetOffsets()[0],
+                    &table->GetControlIndices()[0], &table->GetWeights()[0],
+                    0, numStencils);
+            }
+
+            char test[128];
+            snprintf(test, sizeof(test), "%s %d instances",
+                     shapes[s].name.c_str(), numInstances[n]);
+            failures += CompareBuffers(test, &dst[0], &reference[0],
+                                       (int)dst.size(), 1e-6);
+        }
+        delete table;
+        delete refiner;
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// Primvars stored as structure of arrays are matched against the same
+// primvars stored as array of structures, over a range of stencils which
+// must be the only values written in the destination planes.
+int
+CheckSoAStencils() {
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+        int numControlVertices = table->GetNumControlVertices(),
+            numStencils = table->GetNumStencils(),
+            start = numStencils / 5,
+            end = numStencils - numStencils / 7;
+
+        for (int length = 1; length <= 9; ++length) {
+
+            Osd::BufferDescriptor desc(0, length, length);
+
+            std::vector<float> src(numControlVertices * length),
+                               reference(numStencils * length, g_sentinel);
+            FillBuffer(src, (unsigned int)(s * 9 + length));
+
+            Osd::CpuEvalStencils(&src[0], desc, &reference[0], desc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                start, end);
+
+            // planes padded with a few values, at an offset
+            Osd::SoABufferDescriptor
+                srcDesc(2, length, numControlVertices + 3),
+                dstDesc(1, length, numStencils + 5);
+
+            std::vector<float> srcPlanes(srcDesc.offset +
+                                         length * srcDesc.planeStride),
+                               dstPlanes(dstDesc.offset +
+                                         length * dstDesc.planeStride,
+                                         g_sentinel);
+            for (int i = 0; i < numControlVertices; ++i) {
+                for (int k = 0; k < length; ++k) {
+                    srcPlanes[srcDesc.offset + k * srcDesc.planeStride + i] =
+                        src[i * length + k];
+                }
+            }
+
+            Osd::CpuEvaluator::EvalStencils(&srcPlanes[0], srcDesc,
+                &dstPlanes[0], dstDesc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                start, end);
+
+            // back to array of structures, the planes' padding included
+            std::vector<float> dst(reference.size());
+            for (int i = 0; i < numStencils; ++i) {
+                for (int k = 0; k < length; ++k) {
+                    dst[i * length + k] =
+                        dstPlanes[dstDesc.offset + k * dstDesc.planeStride + i];
+                }
+            }
+            int numPadded = 0;
+            for (int k = 0; k < length; ++k) {
+                for (int i = numStencils; i < dstDesc.planeStride; ++i) {
+                    numPadded += dstPlanes[dstDesc.offset +
+                        k * dstDesc.planeStride + i] != g_sentinel;
+                }
+            }
+            numPadded += dstPlanes[0] != g_sentinel;
+
+            char test[128];
+            snprintf(test, sizeof(test), "%s length %d",
+                     shapes[s].name.c_str(), length);
+            failures += CompareBuffers(test, &dst[0], &reference[0],
+                                       (int)dst.size(), 1e-6);
+            if (numPadded) {
+                printf("  %s : %d padding values written\n", test, numPadded);
+                failures += numPadded;
+            }
+        }
+        delete table;
+        delete refiner;
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// The fused evaluation of the limit points and derivatives is matched against
+// separate evaluations of each weight array with the portable kernels.
+int
+CheckFusedDerivativeStencils() {
+
+    Osd::CpuSimdLevel defaultLevel = Osd::CpuGetSimdLevel(),
+                      maxLevel = GetMaxSimdLevel();
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        // limit stencils require patches
+        if (shapes[s].scheme != kCatmark) continue;
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, true);
+        Far::LimitStencilTable const * table =
+            CreateLimitStencilTable(*refiner);
+
+        int numControlVertices = table->GetNumControlVertices(),
+            numStencils = table->GetNumStencils();
+
+        for (int l = 0; l < g_numLayouts; ++l) {
+
+            Layout const & layout = g_layouts[l];
+            if (layout.length != layout.dstLength) continue;
+
+            int stride = layout.length + layout.padding;
+            Osd::BufferDescriptor desc(layout.padding / 2,
+                                       layout.length, stride);
+
+            std::vector<float> src(numControlVertices * stride);
+            FillBuffer(src, (unsigned int)(s * g_numLayouts + l));
+
+            std::vector<float> reference[3];
+            std::vector<float> const * weights[3] = {
+                &table->GetWeights(),
+                &table->GetDuWeights(),
+                &table->GetDvWeights() };
+
+            Osd::CpuSetSimdLevel(Osd::CPU_SIMD_NONE);
+            for (int i = 0; i < 3; ++i) {
+                reference[i].assign(numStencils * stride, g_sentinel);
+                Osd::CpuEvaluator::EvalStencils(
+                    &src[0], desc, &reference[i][0], desc,
+                    &table->GetSizes()[0], &table->GetOffsets()[0],
+                    &table->GetControlIndices()[0], &(*weights[i])[0],
+                    0, numStencils);
+            }
+
+            for (int level = Osd::CPU_SIMD_NONE; level <= maxLevel; ++level) {
+
+                std::vector<float> dst(numStencils * stride, g_sentinel),
+                                   du(dst), dv(dst);
+
+                Osd::CpuSetSimdLevel((Osd::CpuSimdLevel)level);
+                Osd::CpuEvaluator::EvalStencils(&src[0], desc,
+                    &dst[0], desc, &du[0], desc, &dv[0], desc,
+                    &table->GetSizes()[0], &table->GetOffsets()[0],
+                    &table->GetControlIndices()[0],
+                    &table->GetWeights()[0],
+                    &table->GetDuWeights()[0],
+                    &table->GetDvWeights()[0], 0, numStencils);
+
+                char test[128];
+                snprintf(test, sizeof(test), "%s level %d length %d",
+                         shapes[s].name.c_str(), level, layout.length);
+                failures += CompareBuffers(test, &dst[0],
+                    &reference[0][0], (int)dst.size(), 1e-5);
+                failures += CompareBuffers(test, &du[0],
+                    &reference[1][0], (int)du.size(), 1e-5);
+                failures += CompareBuffers(test, &dv[0],
+                    &reference[2][0], (int)dv.size(), 1e-5);
+            }
+        }
+        delete table;
+        delete refiner;
+    }
+
+    Osd::CpuSetSimdLevel(defaultLevel);
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// A single pass over the stencils for several buffers is matched against the
+// evaluation of each buffer on its own.
+template <class EVALUATOR>
+static int
+checkMultiBufferStencils(char const * name) {
+
+    static const int numBuffers = 3;
+
+    // buffers of different lengths, strides and offsets
+    Osd::BufferDescriptor descs[numBuffers] = {
+        Osd::BufferDescriptor(0, 3, 3),
+        Osd::BufferDescriptor(1, 2, 4),
+        Osd::BufferDescriptor(0, 9, 9) };
+
+    int failures = 0;
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+        Far::StencilTable const * table = CreateStencilTable(*refiner);
+
+        int numStencils = table->GetNumStencils();
+
+        std::vector<float> src[numBuffers], dst[numBuffers],
+                           reference[numBuffers];
+        float const * srcs[numBuffers];
+        float * dsts[numBuffers];
+
+        for (int i = 0; i < numBuffers; ++i) {
+            src[i].resize(table->GetNumControlVertices() * descs[i].stride);
+            FillBuffer(src[i], (unsigned int)(s * numBuffers + i));
+            dst[i].assign(numStencils * descs[i].stride, g_sentinel);
+            reference[i] = dst[i];
+
+            Osd::CpuEvaluator::EvalStencils(&src[i][0], descs[i],
+                &reference[i][0], descs[i],
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                0, numStencils);
+
+            srcs[i] = &src[i][0];
+            dsts[i] = &dst[i][0];
+        }
+
+        EVALUATOR::EvalStencils(numBuffers, srcs, descs, dsts, descs, table);
+
+        for (int i = 0; i < numBuffers; ++i) {
+            char test[128];
+            snprintf(test, sizeof(test), "%s %s buffer %d",
+                     name, shapes[s].name.c_str(), i);
+            failures += CompareBuffers(test, &dst[i][0], &reference[i][0],
+                                       (int)dst[i].size(), 1e-6);
+        }
+        delete table;
+        delete refiner;
+    }
+    return failures;
+}
+
+int
+CheckMultiBufferStencils() {
+
+    int failures = checkMultiBufferStencils<Osd::CpuEvaluator>("CPU");
+#if defined(OPENSUBDIV_HAS_OPENMP)
+    failures += checkMultiBufferStencils<Osd::OmpEvaluator>("OpenMP");
+#endif
+#if defined(OPENSUBDIV_HAS_THREADPOOL)
+    failures += checkMultiBufferStencils<Osd::ThreadPoolEvaluator>(
+        "thread pool");
+#endif
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// Double precision stencil tables and evaluation are matched against the
+// stencils applied in double precision to the same primvars, and against the
+// single precision ones within the float precision.
+template <typename REAL, class TABLE>
+static void
+applyStencils(TABLE const & table, std::vector<REAL> const & weights,
+              std::vector<double> const & src, int length,
+              std::vector<double> & dst) {
+
+    dst.assign(table.GetNumStencils() * length, 0.0);
+    for (int i = 0; i < table.GetNumStencils(); ++i) {
+        int offset = table.GetOffsets()[i];
+        for (int j = 0; j < table.GetSizes()[i]; ++j) {
+            int index = table.GetControlIndices()[offset + j];
+            for (int k = 0; k < length; ++k) {
+                dst[i * length + k] +=
+                    src[index * length + k] * (double)weights[offset + j];
+            }
+        }
+    }
+}
+
+int
+CheckDoubleStencils() {
+
+    int failures = 0;
+
+    Osd::BufferDescriptor desc(0, 3, 3);
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, false);
+
+        Far::StencilTableFactoryReal<double>::Options options;
+        options.generateIntermediateLevels = true;
+        options.generateOffsets = true;
+        Far::StencilTableReal<double> const * table =
+            Far::StencilTableFactoryReal<double>::Create(*refiner, options);
+        Far::StencilTable const * floatTable = CreateStencilTable(*refiner);
+
+        int numStencils = table->GetNumStencils();
+
+        std::vector<double> src(table->GetNumControlVertices() * 3),
+                            reference, floatReference,
+                            dst(numStencils * 3);
+        FillBuffer(src, (unsigned int)s);
+
+        applyStencils(*table, table->GetWeights(), src, 3, reference);
+        applyStencils(*floatTable, floatTable->GetWeights(), src, 3,
+                      floatReference);
+
+        Osd::CpuEvaluator::EvalStencils(&src[0], desc, &dst[0], desc,
+            &table->GetSizes()[0], &table->GetOffsets()[0],
+            &table->GetControlIndices()[0], &table->GetWeights()[0],
+            0, numStencils);
+
+        char test[128];
+        snprintf(test, sizeof(test), "%s double", shapes[s].name.c_str());
+        failures += CompareBuffers(test, &dst[0], &reference[0],
+                                   (int)dst.size(), 1e-12);
+        failures += CompareBuffers(test, &dst[0], &floatReference[0],
+                                   (int)dst.size(), 1e-5);
+
+        delete floatTable;
+        delete table;
+        delete refiner;
+
+        if (shapes[s].scheme != kCatmark) continue;
+
+        // limit points and derivatives
+        refiner = CreateRefiner(shapes[s], 3, true);
+
+        double sCoords[16], tCoords[16];
+        for (int i = 0; i < 16; ++i) {
+            sCoords[i] = (double)(i % 4) / 3.0;
+            tCoords[i] = (double)(i / 4) / 3.0;
+        }
+        Far::LimitStencilTableFactoryReal<double>::LocationArrayVec
+            locations(refiner->GetLevel(0).GetNumFaces());
+        for (size_t i = 0; i < locations.size(); ++i) {
+            locations[i].ptexIdx = (int)i;
+            locations[i].numLocations = 16;
+            locations[i].s = sCoords;
+            locations[i].t = tCoords;
+        }
+
+        Far::LimitStencilTableReal<double> const * limitTable =
+            Far::LimitStencilTableFactoryReal<double>::Create(*refiner,
+                                                              locations);
+
+        numStencils = limitTable->GetNumStencils();
+        src.resize(limitTable->GetNumControlVertices() * 3);
+        FillBuffer(src, (unsigned int)s);
+
+        std::vector<double> const * weights[3] = {
+            &limitTable->GetWeights(),
+            &limitTable->GetDuWeights(),
+            &limitTable->GetDvWeights() };
+
+        std::vector<double> outputs[3];
+        for (int i = 0; i < 3; ++i) {
+            outputs[i].resize(numStencils * 3);
+        }
+        Osd::CpuEvaluator::EvalStencils(&src[0], desc,
+            &outputs[0][0], desc, &outputs[1][0], desc, &outputs[2][0], desc,
+            &limitTable->GetSizes()[0], &limitTable->GetOffsets()[0],
+            &limitTable->GetControlIndices()[0],
+            &limitTable->GetWeights()[0], &limitTable->GetDuWeights()[0],
+            &limitTable->GetDvWeights()[0], 0, numStencils);
+
+        snprintf(test, sizeof(test), "%s double limit",
+                 shapes[s].name.c_str());
+        for (int i = 0; i < 3; ++i) {
+            applyStencils(*limitTable, *weights[i], src, 3, reference);
+            failures += CompareBuffers(test, &outputs[i][0], &reference[0],
+                                       (int)reference.size(), 1e-12);
+        }
+
+        delete limitTable;
+        delete refiner;
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// The 1st and 2nd derivative limit stencils are evaluated together and
+// matched against the stencils applied one weight array at a time. Tables
+// generated with either kind of derivatives only must leave the other weight
+// arrays empty, and evaluating those outputs from them must fail.
+int
+CheckSecondDerivativeStencils() {
+
+    int failures = 0;
+
+    Osd::BufferDescriptor desc(0, 3, 3);
+
+    std::vector<ShapeDesc> const & shapes = GetShapes();
+    for (size_t s = 0; s < shapes.size(); ++s) {
+
+        if (shapes[s].scheme != kCatmark) continue;
+
+        Far::TopologyRefiner * refiner = CreateRefiner(shapes[s], 3, true);
+
+        Far::LimitStencilTableFactory::Options options;
+        options.generate2ndDerivatives = true;
+        Far::LimitStencilTable const * table =
+            CreateLimitStencilTable(*refiner, options);
+
+        int numStencils = table->GetNumStencils();
+
+        std::vector<double> src(table->GetNumControlVertices() * 3),
+                            reference;
+        FillBuffer(src, (unsigned int)s);
+
+        std::vector<float> floatSrc(src.begin(), src.end());
+
+        std::vector<float> const * weights[6] = {
+            &table->GetWeights(),
+            &table->GetDuWeights(),    &table->GetDvWeights(),
+            &table->GetDuuWeights(),   &table->GetDuvWeights(),
+            &table->GetDvvWeights() };
+
+        std::vector<float> outputs[6];
+        for (int i = 0; i < 6; ++i) {
+            outputs[i].assign(numStencils * 3, g_sentinel);
+        }
+        Osd::CpuEvaluator::EvalStencils(&floatSrc[0], desc,
+            &outputs[0][0], desc, &outputs[1][0], desc, &outputs[2][0], desc,
+            &outputs[3][0], desc, &outputs[4][0], desc, &outputs[5][0], desc,
+            &table->GetSizes()[0], &table->GetOffsets()[0],
+            &table->GetControlIndices()[0], &table->GetWeights()[0],
+            &table->GetDuWeights()[0], &table->GetDvWeights()[0],
+            &table->GetDuuWeights()[0], &table->GetDuvWeights()[0],
+            &table->GetDvvWeights()[0], 0, numStencils);
+
+        char test[128];
+        snprintf(test, sizeof(test), "%s 2nd derivatives",
+                 shapes[s].name.c_str());
+
+        std::vector<float> references[6];
+        for (int i = 0; i < 6; ++i) {
+            applyStencils(*table, *weights[i], src, 3, reference);
+            references[i].assign(reference.begin(), reference.end());
+            failures += CompareBuffers(test, &outputs[i][0],
+                                       &references[i][0],
+                                       (int)references[i].size(), 1e-4);
+        }
+        delete table;
+
+        // 2nd derivatives only
+        options.generate1stDerivatives = false;
+        table = CreateLimitStencilTable(*refiner, options);
+
+        if (table->GetNumStencils() != numStencils or
+            not table->GetDuWeights().empty() or
+            not table->GetDvWeights().empty() or
+            table->GetDuuWeights().empty()) {
+            printf("  %s : unexpected weights without 1st derivatives\n",
+                   test);
+            ++failures;
+        } else {
+            for (int i = 3; i < 6; ++i) {
+                outputs[i].assign(numStencils * 3, g_sentinel);
+            }
+            Osd::CpuEvaluator::EvalStencils(&floatSrc[0], desc,
+                &outputs[0][0], desc, 0, desc, 0, desc,
+                &outputs[3][0], desc, &outputs[4][0], desc,
+                &outputs[5][0], desc,
+                &table->GetSizes()[0], &table->GetOffsets()[0],
+                &table->GetControlIndices()[0], &table->GetWeights()[0],
+                0, 0, &table->GetDuuWeights()[0],
+                &table->GetDuvWeights()[0], &table->GetDvvWeights()[0],
+                0, numStencils);
+            for (int i = 3; i < 6; ++i) {
+                failures += CompareBuffers(test, &outputs[i][0],
+                                           &references[i][0],
+                                           (int)references[i].size(), 1e-4);
+            }
+
+            // the buffer entry points pass the missing weights as NULL
+            Osd::CpuVertexBuffer * srcBuffer =
+                Osd::CpuVertexBuffer::Create(3, table->GetNumControlVertices());
+            Osd::CpuVertexBuffer * dstBuffer =
+                Osd::CpuVertexBuffer::Create(3, numStencils);
+            srcBuffer->UpdateData(&floatSrc[0], 0,
+                                  table->GetNumControlVertices());
+
+            if (Osd::CpuEvaluator::EvalStencils(srcBuffer, desc,
+                    dstBuffer, desc, dstBuffer, desc, dstBuffer, desc,
+                    table)) {
+                printf("  %s : 1st derivatives evaluated without weights\n",
+                       test);
+                ++failures;
+            }
+            delete srcBuffer;
+            delete dstBuffer;
+        }
+        delete table;
+
+        // 1st derivatives only
+        options.generate1stDerivatives = true;
+        options.generate2ndDerivatives = false;
+        table = CreateLimitStencilTable(*refiner, options);
+
+        if (table->GetDuWeights().empty() or
+            not table->GetDuuWeights().empty() or
+            not table->GetDuvWeights().empty() or
+            not table->GetDvvWeights().empty()) {
+            printf("  %s : unexpected weights without 2nd derivatives\n",
+                   test);
+            ++failures;
+        }
+        delete table;
+        delete refiner;
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// The sources of the stencils around high valence vertices are merged through
+// a hash table : the stencils of the poles are matched against the primvars
+// refined and projected to the limit by the PrimvarRefiner, and each of their
+// sources is expected to appear only once.
+namespace {
+struct Point3 {
+    void Clear() { p[0] = p[1] = p[2] = 0.0; }
+    void AddWithWeight(Point3 const & src, double weight) {
+        p[0] += weight * src.p[0];
+        p[1] += weight * src.p[1];
+        p[2] += weight * src.p[2];
+    }
+    double p[3];
+};
+} // end namespace
+
+template <class TABLE>
+static int
+checkMergedSources(char const * test, TABLE const & table, int minSize) {
+
+    int maxSize = 0;
+    for (int i = 0; i < table.GetNumStencils(); ++i) {
+        int size = table.GetSizes()[i],
+            offset = table.GetOffsets()[i];
+        std::set<int> sources(&table.GetControlIndices()[offset],
+                              &table.GetControlIndices()[offset] + size);
+        if ((int)sources.size() != size) {
+            printf("  %s : stencil %d has duplicate sources\n", test, i);
+            return 1;
+        }
+        maxSize = std::max(maxSize, size);
+    }
+    if (maxSize < minSize) {
+        printf("  %s : the largest stencil has only %d sources\n",
+            test, maxSize);
+        return 1;
+    }
+    return 0;
+}
+
+static int
+checkPoleLimitStencils(ShapeDesc const & shape, int level,
+    std::vector<Point3> const & points, int minSize) {
+
+    static const double cornerCoords[4][2] = {
+        { 0.0, 0.0 }, { 1.0, 0.0 }, { 1.0, 1.0 }, { 0.0, 1.0 } };
+
+    // the limit masks apply to quads : the reference limit of the pole is
+    // projected from its first level of refinement
+    Far::TopologyRefiner * baseRefiner = CreateRefiner(shape, 0, false);
+    Far::TopologyRefiner::UniformOptions uniformOptions(1);
+    uniformOptions.fullTopologyInLastLevel = true;
+    baseRefiner->RefineUniform(uniformOptions);
+
+    Far::TopologyLevel const & base = baseRefiner->GetLevel(0),
+                             & child = baseRefiner->GetLevel(1);
+
+    std::vector<Point3> childPoints(child.GetNumVertices()),
+                        limits(child.GetNumVertices());
+    Point3 const * basePoints = &points[0];
+    Point3 * levelPoints = &childPoints[0];
+    Far::PrimvarRefiner primvarRefiner(*baseRefiner);
+    primvarRefiner.Interpolate(1, basePoints, levelPoints);
+    Point3 * limitPoints = &limits[0];
+    primvarRefiner.Limit(levelPoints, limitPoints);
+
+    int pole = 0, childPole = 0;
+    for (int i = 1; i < base.GetNumVertices(); ++i) {
+        if (base.GetVertexFaces(i).size() > base.GetVertexFaces(pole).size()) {
+            pole = i;
+        }
+    }
+    for (int i = 1; i < child.GetNumVertices(); ++i) {
+        if (child.GetVertexFaces(i).size() >
+            child.GetVertexFaces(childPole).size()) {
+            childPole = i;
+        }
+    }
+
+    // the pole is at the origin of the sub-faces of the non-quads
+    Far::PtexIndices ptexIndices(*baseRefiner);
+    Far::LimitStencilTableFactoryReal<double>::LocationArrayVec locations;
+    for (int i = 0; i < base.GetNumFaces(); ++i) {
+        Far::ConstIndexArray verts = base.GetFaceVertices(i);
+        int corner = verts.FindIndex(pole);
+        if (corner < 0) continue;
+
+        bool quad = verts.size() == 4;
+
+        Far::LimitStencilTableFactoryReal<double>::LocationArray location;
+        location.ptexIdx = ptexIndices.GetFaceId(i) + (quad ? 0 : corner);
+        location.numLocations = 1;
+        location.s = &cornerCoords[quad ? corner : 0][0];
+        location.t = &cornerCoords[quad ? corner : 0][1];
+        locations.push_back(location);
+    }
+    if (locations.empty()) {
+        printf("  %s : no face around the pole\n", shape.name.c_str());
+        delete baseRefiner;
+        return 1;
+    }
+
+    Far::TopologyRefiner * refiner = CreateRefiner(shape, level, true);
+    Far::LimitStencilTableReal<double> const * table =
+        Far::LimitStencilTableFactoryReal<double>::Create(*refiner, locations);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s limit stencils", shape.name.c_str());
+    int failures = checkMergedSources(name, *table, minSize);
+
+    std::vector<double> src(&points[0].p[0],
+                            &points[0].p[0] + base.GetNumVertices() * 3),
+                        result,
+                        reference;
+    for (int i = 0; i < table->GetNumStencils(); ++i) {
+        reference.insert(reference.end(),
+                         limits[childPole].p, limits[childPole].p + 3);
+    }
+    applyStencils(*table, table->GetWeights(), src, 3, result);
+    failures += CompareBuffers(name, &result[0], &reference[0],
+        (int)result.size(), 1e-6);
+
+    delete table;
+    delete refiner;
+    delete baseRefiner;
+    return failures;
+}
+
+int
+CheckHashedStencils() {
+
+    // the size from which the sources of a stencil are hashed
+    static const int hashedSize = 32;
+
+    ShapeDesc shapes[] = {
+        ShapeDesc("catmark_pole64", catmark_pole64, kCatmark),
+        ShapeDesc("loop_pole64", loop_pole64, kLoop),
+    };
+
+    int failures = 0;
+    for (int s = 0; s < 2; ++s) {
+
+        static const int level = 3;
+
+        Far::TopologyRefiner * refiner =
+            CreateRefiner(shapes[s], level, false);
+        Far::PrimvarRefiner primvarRefiner(*refiner);
+
+        int numPoints = refiner->GetNumVerticesTotal();
+        std::vector<double> src(refiner->GetLevel(0).GetNumVertices() * 3);
+        FillBuffer(src, (unsigned int)s);
+
+        std::vector<Point3> points(numPoints);
+        memcpy(&points[0], &src[0], src.size() * sizeof(double));
+        Point3 * levelPoints = &points[0];
+        for (int i = 1; i <= level; ++i) {
+            Point3 * dstPoints =
+                levelPoints + refiner->GetLevel(i-1).GetNumVertices();
+            primvarRefiner.Interpolate(i, levelPoints, dstPoints);
+            levelPoints = dstPoints;
+        }
+
+        // stencils of the last level, factorized down to the control points
+        Far::StencilTableFactoryReal<double>::Options options;
+        options.generateIntermediateLevels = false;
+        Far::StencilTableReal<double> const * table =
+            Far::StencilTableFactoryReal<double>::Create(*refiner, options);
+
+        char name[64];
+        snprintf(name, sizeof(name), "%s stencils", shapes[s].name.c_str());
+        failures += checkMergedSources(name, *table, hashedSize);
+
+        std::vector<double> result, reference(&levelPoints[0].p[0],
+            &levelPoints[0].p[0] + table->GetNumStencils() * 3);
+        applyStencils(*table, table->GetWeights(), src, 3, result);
+        failures += CompareBuffers(name, &result[0], &reference[0],
+            (int)result.size(), 1e-12);
+        delete table;
+
+        // limit stencils at the pole corner of each base face, matched
+        // against the limit position of the pole (the Gregory end caps are
+        // computed in single precision, and only Catmark meshes are refined
+        // adaptively)
+        if (shapes[s].scheme == kCatmark) {
+            failures += checkPoleLimitStencils(shapes[s], level, points,
+                                               hashedSize);
+        }
+        delete refiner;
+    }
+    return failures;
+}
@@ -0,0 +1,244 @@
+//
+//   Copyright 2015 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "cpu_regression.h"
+
+#include "../common/far_utils.h"
+
+#include <far/patchMap.h>
+#include <far/ptexIndices.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "../shapes/bilinear_cube.h"
+#include "../shapes/catmark_cube_creases1.h"
+#include "../shapes/catmark_gregory_test2.h"
+#include "../shapes/catmark_pyramid_creases1.h"
+#include "../shapes/catmark_torus_creases0.h"
+#include "../shapes/loop_cube_creases1.h"
+
+using namespace OpenSubdiv;
+
+std::vector<ShapeDesc> const &
+GetShapes() {
+
+    static std::vector<ShapeDesc> shapes;
+    if (shapes.empty()) {
+        shapes.push_back(ShapeDesc("bilinear_cube",
+                                   bilinear_cube, kBilinear));
+        shapes.push_back(ShapeDesc("catmark_cube_creases1",
+                                   catmark_cube_creases1, kCatmark));
+        shapes.push_back(ShapeDesc("catmark_gregory_test2",
+                                   catmark_gregory_test2, kCatmark));
+        shapes.push_back(ShapeDesc("catmark_pyramid_creases1",
+                                   catmark_pyramid_creases1, kCatmark));
+        shapes.push_back(ShapeDesc("catmark_torus_creases0",
+                                   catmark_torus_creases0, kCatmark));
+        shapes.push_back(ShapeDesc("loop_cube_creases1",
+                                   loop_cube_creases1, kLoop));
+    }
+    return shapes;
+}
+
+Far::TopologyRefiner *
+CreateRefiner(ShapeDesc const & desc, int level, bool adaptive) {
+
+    Shape * shape = Shape::parseObj(desc.data.c_str(), desc.scheme);
+
+    Sdc::SchemeType type = GetSdcType(*shape);
+    Sdc::Options options = GetSdcOptions(*shape);
+
+    Far::TopologyRefiner * refiner =
+        Far::TopologyRefinerFactory<Shape>::Create(*shape,
+            Far::TopologyRefinerFactory<Shape>::Options(type, options));
+    delete shape;
+
+    if (not refiner) return 0;
+
+    if (adaptive) {
+        refiner->RefineAdaptive(
+            Far::TopologyRefiner::AdaptiveOptions(level));
+    } else {
+        refiner->RefineUniform(
+            Far::TopologyRefiner::UniformOptions(level));
+    }
+    return refiner;
+}
+
+Far::StencilTable const *
+CreateStencilTable(Far::TopologyRefiner const & refiner) {
+
+    Far::StencilTableFactory::Options options;
+    options.generateIntermediateLevels = true;
+    options.generateOffsets = true;
+    return Far::StencilTableFactory::Create(refiner, options);
+}
+
+Far::LimitStencilTable const *
+CreateLimitStencilTable(Far::TopologyRefiner const & refiner,
+                        Far::LimitStencilTableFactory::Options options) {
+
+    static const int gridSize = 5;
+
+    std::vector<float> s(gridSize * gridSize),
+                       t(gridSize * gridSize);
+    for (int i = 0; i < gridSize; ++i) {
+        for (int j = 0; j < gridSize; ++j) {
+            s[i * gridSize + j] = (float)i / (float)(gridSize - 1);
+            t[i * gridSize + j] = (float)j / (float)(gridSize - 1);
+        }
+    }
+
+    Far::PtexIndices ptexIndices(refiner);
+
+    Far::LimitStencilTableFactory::LocationArrayVec
+        locations(ptexIndices.GetNumFaces());
+    for (size_t i = 0; i < locations.size(); ++i) {
+        locations[i].ptexIdx = (int)i;
+        locations[i].numLocations = gridSize * gridSize;
+        locations[i].s = &s[0];
+        locations[i].t = &t[0];
+    }
+    return Far::LimitStencilTableFactory::Create(refiner, locations,
+                                                 0, 0, options);
+}
+
+PatchData::PatchData(ShapeDesc const & shape, EndCapType endCapType,
+                     bool grouped) {
+
+    refiner = CreateRefiner(shape, 2, true);
+
+    Far::PatchTableFactory::Options options;
+    options.SetEndCapType(endCapType);
+    patchTable = Far::PatchTableFactory::Create(*refiner, options);
+
+    cpuPatchTable = Osd::CpuPatchTable::Create(patchTable);
+
+    numVertices = refiner->GetNumVerticesTotal() +
+                  patchTable->GetNumLocalPoints();
+
+    // a few locations per patch on every face
+    static const int coordsPerFace = 64;
+
+    Far::PtexIndices ptexIndices(*refiner);
+    Far::PatchMap patchMap(*patchTable);
+
+    int numFaces = ptexIndices.GetNumFaces();
+
+    std::vector<float> st(2 * numFaces * coordsPerFace);
+    FillBuffer(st, (unsigned int)numFaces);
+
+    for (int i = 0; i < numFaces * coordsPerFace; ++i) {
+        float s = 0.5f * (st[2*i] + 1.0f),
+              t = 0.5f * (st[2*i+1] + 1.0f);
+        Far::PatchTable::PatchHandle const * handle =
+            patchMap.FindPatch(i / coordsPerFace, s, t);
+        if (handle) {
+            coords.push_back(Osd::PatchCoord(*handle, s, t));
+        }
+    }
+
+    if (not grouped) {
+        // a reproducible shuffle
+        unsigned int seed = 1;
+        for (int i = (int)coords.size() - 1; i > 0; --i) {
+            seed = seed * 1664525u + 1013904223u;
+            std::swap(coords[i], coords[(seed >> 8) % (i + 1)]);
+        }
+    }
+}
+
+PatchData::~PatchData() {
+
+    delete cpuPatchTable;
+    delete patchTable;
+    delete refiner;
+}
+
+Osd::CpuSimdLevel
+GetMaxSimdLevel() {
+
+    // the level set is clamped to the levels supported by the CPU
+    Osd::CpuSimdLevel level = Osd::CpuGetSimdLevel();
+    Osd::CpuSetSimdLevel(Osd::CPU_SIMD_AVX512);
+    Osd::CpuSimdLevel maxLevel = Osd::CpuGetSimdLevel();
+    Osd::CpuSetSimdLevel(level);
+    return maxLevel;
+}
+
+template <typename REAL>
+static void
+fillBuffer(std::vector<REAL> & buffer, unsigned int seed) {
+
+    // a linear congruential generator gives the same values on every platform
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        buffer[i] = (REAL)((seed >> 8) & 0xffff) / (REAL)0x7fff - (REAL)1;
+    }
+}
+
+void
+FillBuffer(std::vector<float> & buffer, unsigned int seed) {
+    fillBuffer(buffer, seed);
+}
+
+void
+FillBuffer(std::vector<double> & buffer, unsigned int seed) {
+    fillBuffer(buffer, seed);
+}
+
+template <typename REAL>
+int
+CompareBuffers(char const * test,
+               REAL const * result, REAL const * reference, int n,
+               double tolerance) {
+
+    // an empty comparison would hide a failure to build the data
+    if (n <= 0) {
+        printf("  %s : no values\n", test);
+        return 1;
+    }
+
+    int failures = 0;
+    for (int i = 0; i < n; ++i) {
+        double magnitude = std::max(1.0, std::fabs((double)reference[i])),
+               delta = std::fabs((double)result[i] - (double)reference[i]);
+        // the comparison also fails on NaN results
+        if (not (delta <= tolerance * magnitude)) {
+            if (failures < 4) {
+                printf("  %s : value %d is %.9g, expected %.9g\n",
+                       test, i, (double)result[i], (double)reference[i]);
+            }
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+template int CompareBuffers<float>(char const *,
+    float const *, float const *, int, double);
+template int CompareBuffers<double>(char const *,
+    double const *, double const *, int, double);